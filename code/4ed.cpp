@@ -735,6 +735,27 @@ App_Step_Sig(app_step){
         }
     }
     
+    // NOTE: Drop the snapshot copies that haven't been needed for a while.  Buffers
+    // that are being edited and lexed keep theirs, so each new snapshot only copies what
+    // changed.
+    {
+        Working_Set *working_set = &models->working_set;
+        u64 now = system_now_time();
+        for (Node *node = working_set->snapshot_cache_sentinel.next, *next = 0;
+             node != &working_set->snapshot_cache_sentinel;
+             node = next){
+            next = node->next;
+            Editing_File *file = CastFromMember(Editing_File, snapshot_cache_node, node);
+            Gap_Buffer *buffer = &file->state.buffer;
+            if (now - file->snapshot_cache_time >= SNAPSHOT_CACHE_KEEP_TIME &&
+                !buffer_snapshot_cache_in_use(&buffer->snapshot_cache)){
+                buffer_snapshot_cache_drop(buffer);
+                dll_remove(node);
+                block_zero_struct(node);
+            }
+        }
+    }
+    
     // NOTE(allen): if the exit signal has been sent, run the exit hook.
     if (!models->keep_playing || input->trying_to_kill){
         co_send_core_event(tctx, models, CoreCode_TryExit);
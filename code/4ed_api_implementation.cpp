@@ -86,6 +86,18 @@ global_set_setting(Application_Links *app, Global_Setting_ID setting, i64 value)
         {
             models->settings.lctrl_lalt_is_altgr = (b32)(value != 0);
         }break;
+        case GlobalSetting_CompactHistory:
+        {
+            models->global_history.compact = (b32)(value != 0);
+        }break;
+        case GlobalSetting_HistoryBufferBudget:
+        {
+            models->global_history.buffer_budget = (u64)clamp_bot(0, value);
+        }break;
+        case GlobalSetting_HistoryGlobalBudget:
+        {
+            models->global_history.global_budget = (u64)clamp_bot(0, value);
+        }break;
         default:
         {
             result = false;
@@ -238,6 +250,49 @@ buffer_read_range(Application_Links *app, Buffer_ID buffer_id, Range_i64 range,
     return(result);
 }
 
+api(custom) function Buffer_Snapshot*
+buffer_snapshot_acquire(Application_Links *app, Buffer_ID buffer_id)
+{
+    Models *models = (Models*)app->cmd_context;
+    Editing_File *file = imp_get_file(models, buffer_id);
+    Buffer_Snapshot *result = 0;
+    if (api_check_buffer(file)){
+        Scratch_Block scratch(app);
+        result = buffer_snapshot_acquire(scratch, &file->state.buffer);
+        file->snapshot_cache_time = system_now_time();
+        if (file->snapshot_cache_node.next == 0){
+            dll_insert_back(&models->working_set.snapshot_cache_sentinel, &file->snapshot_cache_node);
+        }
+    }
+    return(result);
+}
+
+api(custom) function void
+buffer_snapshot_release(Application_Links *app, Buffer_Snapshot *snapshot)
+{
+    buffer_snapshot_release(snapshot);
+}
+
+api(custom) function i64
+buffer_snapshot_size(Application_Links *app, Buffer_Snapshot *snapshot)
+{
+    i64 result = 0;
+    if (snapshot != 0){
+        result = snapshot->size;
+    }
+    return(result);
+}
+
+api(custom) function b32
+buffer_snapshot_read_range(Application_Links *app, Buffer_Snapshot *snapshot, Range_i64 range, u8 *out)
+{
+    b32 result = false;
+    if (snapshot != 0){
+        result = buffer_snapshot_read_range(snapshot, range, out);
+    }
+    return(result);
+}
+
 function Edit_Behaviors
 get_active_edit_behaviors(Models *models, Editing_File *file){
     Panel *panel = layout_get_active_panel(&models->layout);
@@ -298,7 +353,6 @@ buffer_seek_string(Application_Links *app, Buffer_ID buffer, String_Const_u8 nee
             Scratch_Block scratch(app);
             Gap_Buffer *gap_buffer = &file->state.buffer;
             i64 size = buffer_size(gap_buffer);
-            List_String_Const_u8 chunks = buffer_get_chunks(scratch, gap_buffer);
             Range_i64 range = {};
             if (direction == Scan_Forward){
                 i64 adjusted_pos = start_pos + 1;
@@ -310,7 +364,7 @@ buffer_seek_string(Application_Links *app, Buffer_ID buffer, String_Const_u8 nee
                 start_pos = clamp_bot(0, adjusted_pos);
                 range = Ii64(0, adjusted_pos);
             }
-            buffer_chunks_clamp(&chunks, range);
+            List_String_Const_u8 chunks = buffer_get_chunks(scratch, gap_buffer, range);
             if (chunks.first != 0){
                 u64_Array jump_table = string_compute_needle_jump_table(scratch, needle, direction);
                 Character_Predicate dummy = {};
@@ -350,8 +404,8 @@ buffer_seek_character_class(Application_Links *app, Buffer_ID buffer, Character_
             // really tedious stuff.  Anyway, this is all just to say, cleaning this up would be really nice, but
             // there are almost certainly lower hanging fruit with higher payoffs elsewhere... unless need to change
             // this anyway or whatever.
-            String_Const_u8 chunk_mem[3] = {};
-            String_Const_u8_Array chunks = {chunk_mem};
+            String_Const_u8_Array chunks = {};
+            chunks.vals = push_array(scratch, String_Const_u8, chunks_list.node_count);
             for (Node_String_Const_u8 *node = chunks_list.first;
                  node != 0;
                  node = node->next){
@@ -750,6 +804,11 @@ buffer_get_setting(Application_Links *app, Buffer_ID buffer_id, Buffer_Setting_I
                 *value_out = history_is_activated(&file->state.history);
             }break;
             
+            case BufferSetting_PieceTreeStorage:
+            {
+                *value_out = (file->state.buffer.storage_kind == BufferStorage_PieceTree);
+            }break;
+            
             default:
             {
                 result = false;
@@ -802,6 +861,13 @@ buffer_set_setting(Application_Links *app, Buffer_ID buffer_id, Buffer_Setting_I
                 }
             }break;
             
+            case BufferSetting_PieceTreeStorage:
+            {
+                Scratch_Block scratch(app);
+                Buffer_Storage_Kind storage_kind = (value != 0)?BufferStorage_PieceTree:BufferStorage_Gap;
+                buffer_set_storage_kind(scratch, &file->state.buffer, storage_kind);
+            }break;
+            
             default:
             {
                 result = 0;
@@ -849,6 +915,18 @@ create_buffer(Application_Links *app, String_Const_u8 file_name, Buffer_Create_F
     return(result);
 }
 
+api(custom) function Buffer_ID
+create_buffer_from_data(Application_Links *app, String_Const_u8 file_name, String_Const_u8 data, File_Attributes attributes, Buffer_Create_Flag flags)
+{
+    Models *models = (Models*)app->cmd_context;
+    Editing_File *new_file = create_file(app->tctx, models, file_name, flags, &data, attributes);
+    Buffer_ID result = 0;
+    if (new_file != 0){
+        result = new_file->id;
+    }
+    return(result);
+}
+
 api(custom) function b32
 buffer_save(Application_Links *app, Buffer_ID buffer_id, String_Const_u8 file_name, Buffer_Save_Flag flags)
 {
@@ -956,59 +1034,51 @@ buffer_reopen(Application_Links *app, Buffer_ID buffer_id, Buffer_Reopen_Flag fl
             Plat_Handle handle = {};
             if (system_load_handle(scratch, (char*)file->canon.name_space, &handle)){
                 File_Attributes attributes = system_load_attributes(handle);
+                File_Contents contents = file_load_contents(tctx->allocator, handle, attributes.size);
+                system_load_close(handle);
                 
-                char *file_memory = push_array(scratch, char, (i32)attributes.size);
-                
-                if (file_memory != 0){
-                    if (system_load_file(handle, file_memory, (i32)attributes.size)){
-                        system_load_close(handle);
-                        
-                        // TODO(allen): try(perform a diff maybe apply edits in reopen)
-                        
-                        i32 line_numbers[16];
-                        i32 column_numbers[16];
-                        View *vptrs[16];
-                        i32 vptr_count = 0;
-                        
-                        Layout *layout = &models->layout;
-                        for (Panel *panel = layout_get_first_open_panel(layout);
-                             panel != 0;
-                             panel = layout_get_next_open_panel(layout, panel)){
-                            View *view_it = panel->view;
-                            if (view_it->file == file){
-                                vptrs[vptr_count] = view_it;
-                                File_Edit_Positions edit_pos = view_get_edit_pos(view_it);
-                                Buffer_Cursor cursor = file_compute_cursor(view_it->file, seek_pos(edit_pos.cursor_pos));
-                                line_numbers[vptr_count]   = (i32)cursor.line;
-                                column_numbers[vptr_count] = (i32)cursor.col;
-                                view_it->file = models->scratch_buffer;
-                                ++vptr_count;
-                            }
+                if (contents.is_loaded){
+                    // TODO(allen): try(perform a diff maybe apply edits in reopen)
+                    
+                    i32 line_numbers[16];
+                    i32 column_numbers[16];
+                    View *vptrs[16];
+                    i32 vptr_count = 0;
+                    
+                    Layout *layout = &models->layout;
+                    for (Panel *panel = layout_get_first_open_panel(layout);
+                         panel != 0;
+                         panel = layout_get_next_open_panel(layout, panel)){
+                        View *view_it = panel->view;
+                        if (view_it->file == file){
+                            vptrs[vptr_count] = view_it;
+                            File_Edit_Positions edit_pos = view_get_edit_pos(view_it);
+                            Buffer_Cursor cursor = file_compute_cursor(view_it->file, seek_pos(edit_pos.cursor_pos));
+                            line_numbers[vptr_count]   = (i32)cursor.line;
+                            column_numbers[vptr_count] = (i32)cursor.col;
+                            view_it->file = models->scratch_buffer;
+                            ++vptr_count;
                         }
-                        
-                        Working_Set *working_set = &models->working_set;
-                        file_free(tctx, models, file);
-                        working_set_file_default_settings(working_set, file);
-                        file_create_from_string(tctx, models, file, SCu8(file_memory, attributes.size), attributes);
-                        
-                        for (i32 i = 0; i < vptr_count; ++i){
-                            view_set_file(tctx, models, vptrs[i], file);
-                            
-                            vptrs[i]->file = file;
-                            i64 line = line_numbers[i];
-                            i64 col = column_numbers[i];
-                            Buffer_Cursor cursor = file_compute_cursor(file, seek_line_col(line, col));
-                            view_set_cursor(tctx, models, vptrs[i], cursor.pos);
-                        }
-                        result = BufferReopenResult_Reopened;
                     }
-                    else{
-                        system_load_close(handle);
+                    
+                    Working_Set *working_set = &models->working_set;
+                    file_free(tctx, models, file);
+                    working_set_file_default_settings(working_set, file);
+                    file_create_from_string(tctx, models, file, contents.data, attributes);
+                    
+                    for (i32 i = 0; i < vptr_count; ++i){
+                        view_set_file(tctx, models, vptrs[i], file);
+                        
+                        vptrs[i]->file = file;
+                        i64 line = line_numbers[i];
+                        i64 col = column_numbers[i];
+                        Buffer_Cursor cursor = file_compute_cursor(file, seek_line_col(line, col));
+                        view_set_cursor(tctx, models, vptrs[i], cursor.pos);
                     }
+                    result = BufferReopenResult_Reopened;
                 }
-                else{
-                    system_load_close(handle);
-                }
+                
+                file_free_contents(tctx->allocator, &contents);
             }
         }
     }
@@ -2033,7 +2103,11 @@ alloc_buffer_markers_on_buffer(Application_Links *app, Buffer_ID buffer_id, i32
     Dynamic_Workspace *workspace = get_dynamic_workspace(models, markers_scope);
     Managed_Object result = 0;
     if (workspace != 0){
-        result = managed_object_alloc_buffer_markers(workspace, buffer_id, count, 0);
+        Buffer_Marker_Index *index = 0;
+        if (file != 0){
+            index = &file->state.markers;
+        }
+        result = managed_object_alloc_buffer_markers(workspace, buffer_id, index, count, 0);
     }
     return(result);
 }
@@ -2083,6 +2157,9 @@ managed_object_get_pointer(Application_Links *app, Managed_Object object)
 {
     Models *models = (Models*)app->cmd_context;
     Managed_Object_Ptr_And_Workspace object_ptrs = get_dynamic_object_ptrs(models, object);
+    if (object_ptrs.header != 0 && object_ptrs.header->type == ManagedObjectType_Markers){
+        buffer_markers_make_raw((Managed_Buffer_Markers_Header*)object_ptrs.header);
+    }
     return(get_dynamic_object_memory_ptr(object_ptrs.header));
 }
 
@@ -2138,7 +2215,12 @@ managed_object_store_data(Application_Links *app, Managed_Object object, u32 fir
         u32 item_count = object_ptrs.header->count;
         if (0 <= first_index && first_index + count <= item_count){
             u32 item_size = object_ptrs.header->item_size;
-            block_copy(ptr + first_index*item_size, mem, count*item_size);
+            if (object_ptrs.header->type == ManagedObjectType_Markers){
+                buffer_markers_store((Managed_Buffer_Markers_Header*)object_ptrs.header, first_index, count, (Marker*)mem);
+            }
+            else{
+                block_copy(ptr + first_index*item_size, mem, count*item_size);
+            }
             heap_assert_good(&object_ptrs.workspace->heap);
             result = true;
         }
@@ -2157,6 +2239,9 @@ managed_object_load_data(Application_Links *app, Managed_Object object, u32 firs
         u32 item_count = object_ptrs.header->count;
         if (0 <= first_index && first_index + count <= item_count){
             u32 item_size = object_ptrs.header->item_size;
+            if (object_ptrs.header->type == ManagedObjectType_Markers){
+                buffer_markers_sync((Managed_Buffer_Markers_Header*)object_ptrs.header, first_index, count);
+            }
             block_copy(mem_out, ptr + first_index*item_size, count*item_size);
             heap_assert_good(&object_ptrs.workspace->heap);
             result = true;
@@ -2476,16 +2561,19 @@ buffer_history_get_max_record_index(Application_Links *app, Buffer_ID buffer_id)
     return(result);
 }
 
+// NOTE: Strings that have to be decoded go in the history's info arena, which is
+// cleared on every call, so they only last until the next record info call on the buffer.
 function void
-buffer_history__fill_record_info(Record *record, Record_Info *out){
+buffer_history__fill_record_info(History *history, Record *record, Record_Info *out){
+    linalloc_clear(&history->info_arena);
     out->kind = record->kind;
     out->pos_before_edit = record->pos_before_edit;
     out->edit_number = record->edit_number;
     switch (out->kind){
         case RecordKind_Single:
         {
-            out->single_string_forward  = record->single.forward_text ;
-            out->single_string_backward = record->single.backward_text;
+            out->single_string_forward  = history_get_forward_text(&history->info_arena, history, record);
+            out->single_string_backward = history_get_backward_text(&history->info_arena, history, record);
             out->single_first = record->single.first;
         }break;
         case RecordKind_Group:
@@ -2511,7 +2599,7 @@ buffer_history_get_record_info(Application_Links *app, Buffer_ID buffer_id, Hist
             if (0 <= index && index <= max_index){
                 if (0 < index){
                     Record *record = history_get_record(history, index);
-                    buffer_history__fill_record_info(record, &result);
+                    buffer_history__fill_record_info(history, record, &result);
                 }
                 else{
                     result.error = RecordError_InitialStateDummyRecord;
@@ -2544,9 +2632,9 @@ buffer_history_get_group_sub_record(Application_Links *app, Buffer_ID buffer_id,
                 if (0 < index){
                     Record *record = history_get_record(history, index);
                     if (record->kind == RecordKind_Group){
-                        record = history_get_sub_record(record, sub_index + 1);
+                        record = history_get_sub_record(history, record, sub_index + 1);
                         if (record != 0){
-                            buffer_history__fill_record_info(record, &result);
+                            buffer_history__fill_record_info(history, record, &result);
                         }
                         else{
                             result.error = RecordError_SubIndexOutOfBounds;
@@ -3177,8 +3265,7 @@ buffer_find_all_matches(Application_Links *app, Arena *arena, Buffer_ID buffer,
     if (api_check_buffer(file)){
         if (needle.size > 0){
             Scratch_Block scratch(app, arena);
-            List_String_Const_u8 chunks = buffer_get_chunks(scratch, &file->state.buffer);
-            buffer_chunks_clamp(&chunks, range);
+            List_String_Const_u8 chunks = buffer_get_chunks(scratch, &file->state.buffer, range);
             if (chunks.node_count > 0){
                 u64_Array jump_table = string_compute_needle_jump_table(arena, needle, direction);
                 Character_Predicate dummy = {};
@@ -3194,6 +3281,35 @@ buffer_find_all_matches(Application_Links *app, Arena *arena, Buffer_ID buffer,
     return(list);
 }
 
+api(custom) function String_Match_List
+buffer_find_all_matches_parallel(Application_Links *app, Arena *arena,
+                                 Buffer_ID *buffers, i32 buffer_count,
+                                 String_Const_u8_Array needles, Character_Predicate *predicate,
+                                 String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags,
+                                 i32 thread_count){
+    Models *models = (Models*)app->cmd_context;
+    String_Match_List list = {};
+    if (buffer_count > 0 && needles.count > 0){
+        ProfileTLScope(app->tctx, &models->profile_list, "find all matches parallel");
+        Scratch_Block scratch(app, arena);
+        Match_Search_Buffer *search_buffers = push_array_zero(scratch, Match_Search_Buffer, buffer_count);
+        i32 search_count = 0;
+        for (i32 i = 0; i < buffer_count; i += 1){
+            Editing_File *file = imp_get_file(models, buffers[i]);
+            if (api_check_buffer(file)){
+                Match_Search_Buffer *search_buffer = &search_buffers[search_count];
+                search_count += 1;
+                search_buffer->buffer = buffers[i];
+                search_buffer->chunks = buffer_get_chunks(scratch, &file->state.buffer);
+            }
+        }
+        list = find_all_matches_parallel(scratch, arena, search_buffers, search_count,
+                                         needles, predicate, must_have_flags, must_not_have_flags,
+                                         thread_count);
+    }
+    return(list);
+}
+
 ////////////////////////////////
 
 api(custom) function Profile_Global_List*
@@ -172,41 +172,723 @@ buffer_update_cursors_lean_r(Cursor_With_Index *sorted_positions, i32 count,
 
 //////////////////////////////////////
 
+internal u32
+piece__random(Piece_Tree *tree){
+    u32 x = tree->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    tree->random_state = x;
+    return(x);
+}
+
+internal i64
+piece__subtree_size(Piece_Node *node){
+    return((node != 0)?(node->subtree_size):(0));
+}
+
+internal void
+piece__update(Piece_Node *node){
+    node->subtree_size = piece__subtree_size(node->left) + node->size + piece__subtree_size(node->right);
+}
+
+internal Piece_Node*
+piece__alloc_node(Piece_Tree *tree, u8 *str, i64 size, u32 priority){
+    Piece_Node *node = tree->free_nodes;
+    if (node != 0){
+        tree->free_nodes = node->left;
+    }
+    else{
+        node = push_array(&tree->node_arena, Piece_Node, 1);
+    }
+    block_zero_struct(node);
+    node->str = str;
+    node->size = size;
+    node->subtree_size = size;
+    node->priority = priority;
+    tree->piece_count += 1;
+    return(node);
+}
+
+internal void
+piece__free_subtree(Piece_Tree *tree, Piece_Node *node){
+    if (node != 0){
+        piece__free_subtree(tree, node->left);
+        piece__free_subtree(tree, node->right);
+        node->left = tree->free_nodes;
+        tree->free_nodes = node;
+        tree->piece_count -= 1;
+    }
+}
+
+internal Piece_Node*
+piece__merge(Piece_Node *a, Piece_Node *b){
+    Piece_Node *result = 0;
+    if (a == 0){
+        result = b;
+    }
+    else if (b == 0){
+        result = a;
+    }
+    else if (a->priority >= b->priority){
+        a->right = piece__merge(a->right, b);
+        piece__update(a);
+        result = a;
+    }
+    else{
+        b->left = piece__merge(a, b->left);
+        piece__update(b);
+        result = b;
+    }
+    return(result);
+}
+
+// NOTE: Splits the tree so that the left side holds exactly the first pos bytes.
+// A piece that straddles pos is cut in two; the tail inherits the priority of the head
+// so the heap property still holds over the tail's (former) right subtree.
+internal void
+piece__split(Piece_Tree *tree, Piece_Node *node, i64 pos, Piece_Node **l_out, Piece_Node **r_out){
+    if (node == 0){
+        *l_out = 0;
+        *r_out = 0;
+    }
+    else{
+        i64 left_size = piece__subtree_size(node->left);
+        if (pos <= left_size){
+            piece__split(tree, node->left, pos, l_out, &node->left);
+            piece__update(node);
+            *r_out = node;
+        }
+        else if (pos >= left_size + node->size){
+            piece__split(tree, node->right, pos - left_size - node->size, &node->right, r_out);
+            piece__update(node);
+            *l_out = node;
+        }
+        else{
+            i64 cut = pos - left_size;
+            Piece_Node *tail = piece__alloc_node(tree, node->str + cut, node->size - cut, node->priority);
+            tail->right = node->right;
+            piece__update(tail);
+            node->size = cut;
+            node->right = 0;
+            piece__update(node);
+            *l_out = node;
+            *r_out = tail;
+        }
+    }
+}
+
+internal u8*
+piece__push_add_text(Piece_Tree *tree, Base_Allocator *allocator, String_Const_u8 text){
+    Piece_Add_Block *block = tree->add_block;
+    if (block == 0 || block->pos + (i64)text.size > block->max){
+        i64 max = clamp_bot(KB(64), round_up_i64(text.size, KB(4)));
+        String_Const_u8 memory = base_allocate(allocator, sizeof(Piece_Add_Block) + max);
+        block = (Piece_Add_Block*)memory.str;
+        block->data = (u8*)(block + 1);
+        block->pos = 0;
+        block->max = max;
+        sll_stack_push(tree->add_block, block);
+    }
+    u8 *result = block->data + block->pos;
+    block_copy(result, text.str, text.size);
+    block->pos += text.size;
+    return(result);
+}
+
+// NOTE: Typing appends to the add block right after the previous insertion, so in the
+// common case the new text can just extend the last piece on the left instead of adding a node.
+internal b32
+piece__try_extend_rightmost(Piece_Node *node, u8 *str, i64 size){
+    b32 result = false;
+    if (node != 0){
+        Piece_Node *rightmost = node;
+        for (;rightmost->right != 0; rightmost = rightmost->right);
+        if (rightmost->str + rightmost->size == str){
+            rightmost->size += size;
+            for (Piece_Node *it = node; it != 0; it = it->right){
+                it->subtree_size += size;
+            }
+            result = true;
+        }
+    }
+    return(result);
+}
+
+internal void
+piece_tree_init(Piece_Tree *tree, Base_Allocator *allocator, u8 *data, i64 size){
+    block_zero_struct(tree);
+    tree->node_arena = make_arena(allocator, KB(16));
+    tree->random_state = 0x2545F491;
+    if (size > 0){
+        String_Const_u8 memory = base_allocate(allocator, size);
+        tree->original = (u8*)memory.str;
+        block_copy(tree->original, data, size);
+        tree->root = piece__alloc_node(tree, tree->original, size, piece__random(tree));
+    }
+}
+
+internal void
+piece_tree_free(Piece_Tree *tree, Base_Allocator *allocator){
+    for (Piece_Add_Block *block = tree->add_block, *next = 0;
+         block != 0;
+         block = next){
+        next = block->next;
+        base_free(allocator, block);
+    }
+    if (tree->original != 0){
+        base_free(allocator, tree->original);
+    }
+    linalloc_clear(&tree->node_arena);
+    block_zero_struct(tree);
+}
+
+internal void
+piece_tree_replace_range(Piece_Tree *tree, Base_Allocator *allocator, Range_i64 range, String_Const_u8 text){
+    Piece_Node *left = 0;
+    Piece_Node *middle = 0;
+    Piece_Node *right = 0;
+    piece__split(tree, tree->root, range.first, &left, &right);
+    piece__split(tree, right, range.one_past_last - range.first, &middle, &right);
+    piece__free_subtree(tree, middle);
+    if (text.size > 0){
+        u8 *str = piece__push_add_text(tree, allocator, text);
+        if (!piece__try_extend_rightmost(left, str, text.size)){
+            Piece_Node *node = piece__alloc_node(tree, str, text.size, piece__random(tree));
+            left = piece__merge(left, node);
+        }
+    }
+    tree->root = piece__merge(left, right);
+}
+
+internal void
+piece_tree_push_chunks(Arena *arena, List_String_Const_u8 *list, Piece_Node *node, i64 base, Range_i64 range){
+    if (node != 0){
+        i64 left_size = piece__subtree_size(node->left);
+        i64 node_first = base + left_size;
+        i64 node_opl = node_first + node->size;
+        if (range.first < node_first){
+            piece_tree_push_chunks(arena, list, node->left, base, range);
+        }
+        if (range.first < node_opl && node_first < range.one_past_last){
+            i64 first = Max(node_first, range.first) - node_first;
+            i64 one_past_last = Min(node_opl, range.one_past_last) - node_first;
+            u8 *str = node->str + first;
+            i64 size = one_past_last - first;
+            Node_String_Const_u8 *last = list->last;
+            if (last != 0 && last->string.str + last->string.size == str){
+                last->string.size += size;
+                list->total_size += size;
+            }
+            else{
+                string_list_push(arena, list, SCu8(str, size));
+            }
+        }
+        if (node_opl < range.one_past_last){
+            piece_tree_push_chunks(arena, list, node->right, node_opl, range);
+        }
+    }
+}
+
+//////////////////////////////////////
+
+internal void
+line_index__tree_add(i64 *tree, i64 block_count, i64 block_index, i64 delta){
+    for (i64 i = block_index + 1; i <= block_count; i += (i & -i)){
+        tree[i] += delta;
+    }
+}
+
+internal i64
+line_index__tree_prefix(i64 *tree, i64 block_index){
+    i64 result = 0;
+    for (i64 i = block_index; i > 0; i -= (i & -i)){
+        result += tree[i];
+    }
+    return(result);
+}
+
+// NOTE: Finds the block containing the (0 based) value 'target' in the running sum
+// of the tree; writes the sum of all blocks before it to 'before_out'.
+internal i64
+line_index__tree_find(i64 *tree, i64 block_count, i64 target, i64 *before_out){
+    i64 index = 0;
+    i64 before = 0;
+    i64 step = 1;
+    for (;(step << 1) <= block_count; step <<= 1);
+    for (;step > 0; step >>= 1){
+        i64 next = index + step;
+        if (next <= block_count && before + tree[next] <= target){
+            index = next;
+            before += tree[next];
+        }
+    }
+    *before_out = before;
+    return(index);
+}
+
+internal void
+line_index__rebuild_trees(Line_Index *index){
+    i64 block_count = index->block_count;
+    i64 *count_tree = index->count_tree;
+    i64 *size_tree = index->size_tree;
+    count_tree[0] = 0;
+    size_tree[0] = 0;
+    for (i64 i = 1; i <= block_count; i += 1){
+        Line_Index_Block *block = index->blocks[i - 1];
+        count_tree[i] = block->count;
+        size_tree[i] = block->size;
+    }
+    for (i64 i = 1; i <= block_count; i += 1){
+        i64 parent = i + (i & -i);
+        if (parent <= block_count){
+            count_tree[parent] += count_tree[i];
+            size_tree[parent] += size_tree[i];
+        }
+    }
+}
+
+internal void
+line_index__ensure_block_max(Base_Allocator *allocator, Line_Index *index, i64 block_max){
+    if (block_max > index->block_max){
+        i64 new_max = round_up_i64(block_max*2, 64);
+        String_Const_u8 memory = base_allocate(allocator, (sizeof(Line_Index_Block*) + 2*sizeof(i64))*(new_max + 1));
+        Line_Index_Block **new_blocks = (Line_Index_Block**)memory.str;
+        i64 *new_count_tree = (i64*)(new_blocks + new_max + 1);
+        i64 *new_size_tree = new_count_tree + new_max + 1;
+        block_copy_dynamic_array(new_blocks, index->blocks, index->block_count);
+        if (index->blocks != 0){
+            base_free(allocator, index->blocks);
+        }
+        index->blocks = new_blocks;
+        index->count_tree = new_count_tree;
+        index->size_tree = new_size_tree;
+        index->block_max = new_max;
+    }
+}
+
+internal Line_Index_Block*
+line_index__alloc_block(Base_Allocator *allocator){
+    String_Const_u8 memory = base_allocate(allocator, sizeof(Line_Index_Block));
+    Line_Index_Block *block = (Line_Index_Block*)memory.str;
+    block->count = 0;
+    block->size = 0;
+    return(block);
+}
+
+internal void
+line_index_free(Base_Allocator *allocator, Line_Index *index){
+    for (i64 i = 0; i < index->block_count; i += 1){
+        base_free(allocator, index->blocks[i]);
+    }
+    if (index->blocks != 0){
+        base_free(allocator, index->blocks);
+    }
+    block_zero_struct(index);
+}
+
+internal void
+line_index_clear(Base_Allocator *allocator, Line_Index *index){
+    for (i64 i = 0; i < index->block_count; i += 1){
+        base_free(allocator, index->blocks[i]);
+    }
+    index->block_count = 0;
+    index->line_count = 0;
+    index->total_size = 0;
+}
+
+// NOTE: Appends without maintaining the trees; call line_index__rebuild_trees
+// after a run of appends.
+internal void
+line_index__append(Base_Allocator *allocator, Line_Index *index, i64 length){
+    Line_Index_Block *block = 0;
+    if (index->block_count > 0){
+        block = index->blocks[index->block_count - 1];
+    }
+    if (block == 0 || block->count == LINE_INDEX_BLOCK_CAP){
+        line_index__ensure_block_max(allocator, index, index->block_count + 1);
+        block = line_index__alloc_block(allocator);
+        index->blocks[index->block_count] = block;
+        index->block_count += 1;
+    }
+    block->lengths[block->count] = length;
+    block->count += 1;
+    block->size += length;
+    index->line_count += 1;
+    index->total_size += length;
+}
+
+internal i64
+line_index_first_pos(Line_Index *index, i64 line){
+    i64 result = 0;
+    if (line >= index->line_count){
+        result = index->total_size;
+    }
+    else if (line > 0){
+        i64 lines_before = 0;
+        i64 block_index = line_index__tree_find(index->count_tree, index->block_count, line, &lines_before);
+        Line_Index_Block *block = index->blocks[block_index];
+        result = line_index__tree_prefix(index->size_tree, block_index);
+        i64 *lengths = block->lengths;
+        i64 opl = line - lines_before;
+        for (i64 i = 0; i < opl; i += 1){
+            result += lengths[i];
+        }
+    }
+    return(result);
+}
+
+internal i64
+line_index_line_from_pos(Line_Index *index, i64 pos){
+    i64 result = 0;
+    if (pos >= index->total_size){
+        result = index->line_count - 1;
+    }
+    else if (pos > 0){
+        i64 size_before = 0;
+        i64 block_index = line_index__tree_find(index->size_tree, index->block_count, pos, &size_before);
+        Line_Index_Block *block = index->blocks[block_index];
+        result = line_index__tree_prefix(index->count_tree, block_index);
+        i64 *lengths = block->lengths;
+        i64 p = size_before;
+        for (i64 i = 0; i < block->count; i += 1){
+            p += lengths[i];
+            if (p > pos){
+                break;
+            }
+            result += 1;
+        }
+    }
+    return(result);
+}
+
+internal i64
+line_index_line_length(Line_Index *index, i64 line){
+    i64 result = 0;
+    if (0 <= line && line < index->line_count){
+        i64 lines_before = 0;
+        i64 block_index = line_index__tree_find(index->count_tree, index->block_count, line, &lines_before);
+        result = index->blocks[block_index]->lengths[line - lines_before];
+    }
+    return(result);
+}
+
+// NOTE: Replaces the lengths of lines [first_line, first_line + removed_count)
+// with new_lengths.  When the change stays inside one block only that block and the
+// trees are touched; otherwise the blocks the change spans are re-packed half full.
+internal void
+line_index_replace_lines(Arena *scratch, Base_Allocator *allocator, Line_Index *index,
+                         i64 first_line, i64 removed_count, i64 *new_lengths, i64 new_count){
+    Assert(0 <= first_line && first_line + removed_count <= index->line_count);
+    
+    i64 lines_before = 0;
+    i64 block_index = 0;
+    if (index->block_count > 0){
+        block_index = line_index__tree_find(index->count_tree, index->block_count, first_line, &lines_before);
+        block_index = clamp_top(block_index, index->block_count - 1);
+        lines_before = line_index__tree_prefix(index->count_tree, block_index);
+    }
+    
+    i64 new_size = 0;
+    for (i64 i = 0; i < new_count; i += 1){
+        new_size += new_lengths[i];
+    }
+    
+    Line_Index_Block *block = (index->block_count > 0)?index->blocks[block_index]:0;
+    i64 offset = first_line - lines_before;
+    if (block != 0 &&
+        offset + removed_count <= block->count &&
+        block->count - removed_count + new_count <= LINE_INDEX_BLOCK_CAP &&
+        block->count - removed_count + new_count > 0){
+        i64 *lengths = block->lengths;
+        i64 removed_size = 0;
+        for (i64 i = 0; i < removed_count; i += 1){
+            removed_size += lengths[offset + i];
+        }
+        i64 tail_first = offset + removed_count;
+        i64 tail_count = block->count - tail_first;
+        block_copy_dynamic_array(lengths + offset + new_count, lengths + tail_first, tail_count);
+        block_copy_dynamic_array(lengths + offset, new_lengths, new_count);
+        
+        i64 count_delta = new_count - removed_count;
+        i64 size_delta = new_size - removed_size;
+        block->count += count_delta;
+        block->size += size_delta;
+        line_index__tree_add(index->count_tree, index->block_count, block_index, count_delta);
+        line_index__tree_add(index->size_tree, index->block_count, block_index, size_delta);
+        index->line_count += count_delta;
+        index->total_size += size_delta;
+    }
+    else{
+        Temp_Memory temp = begin_temp(scratch);
+        
+        // NOTE: gather the spanned blocks with the edit spliced in
+        i64 last_block_index = block_index;
+        i64 span_line_count = (block != 0)?block->count:0;
+        for (;lines_before + span_line_count < first_line + removed_count;){
+            last_block_index += 1;
+            span_line_count += index->blocks[last_block_index]->count;
+        }
+        i64 gathered_count = span_line_count - removed_count + new_count;
+        i64 *gathered = push_array(scratch, i64, gathered_count);
+        i64 *ptr = gathered;
+        i64 removed_size = 0;
+        i64 line = lines_before;
+        for (i64 i = block_index; i <= last_block_index && block != 0; i += 1){
+            Line_Index_Block *span_block = index->blocks[i];
+            for (i64 j = 0; j < span_block->count; j += 1, line += 1){
+                if (line == first_line){
+                    block_copy_dynamic_array(ptr, new_lengths, new_count);
+                    ptr += new_count;
+                }
+                if (first_line <= line && line < first_line + removed_count){
+                    removed_size += span_block->lengths[j];
+                }
+                else{
+                    *ptr = span_block->lengths[j];
+                    ptr += 1;
+                }
+            }
+        }
+        if (line == first_line){
+            block_copy_dynamic_array(ptr, new_lengths, new_count);
+            ptr += new_count;
+        }
+        Assert(ptr == gathered + gathered_count);
+        
+        // NOTE: re-pack them into half full blocks
+        i64 per_block = LINE_INDEX_BLOCK_CAP/2;
+        i64 old_span_blocks = (block != 0)?(last_block_index - block_index + 1):0;
+        i64 new_span_blocks = clamp_bot(1, (gathered_count + per_block - 1)/per_block);
+        i64 new_block_count = index->block_count - old_span_blocks + new_span_blocks;
+        line_index__ensure_block_max(allocator, index, new_block_count);
+        
+        for (i64 i = 0; i < old_span_blocks; i += 1){
+            base_free(allocator, index->blocks[block_index + i]);
+        }
+        i64 after_first = block_index + old_span_blocks;
+        block_copy_dynamic_array(index->blocks + block_index + new_span_blocks,
+                                 index->blocks + after_first,
+                                 index->block_count - after_first);
+        index->block_count = new_block_count;
+        
+        ptr = gathered;
+        for (i64 i = 0; i < new_span_blocks; i += 1){
+            Line_Index_Block *new_block = line_index__alloc_block(allocator);
+            i64 count = gathered_count/new_span_blocks + ((i < gathered_count%new_span_blocks)?1:0);
+            block_copy_dynamic_array(new_block->lengths, ptr, count);
+            new_block->count = count;
+            for (i64 j = 0; j < count; j += 1){
+                new_block->size += ptr[j];
+            }
+            ptr += count;
+            index->blocks[block_index + i] = new_block;
+        }
+        
+        index->line_count += new_count - removed_count;
+        index->total_size += new_size - removed_size;
+        line_index__rebuild_trees(index);
+        
+        end_temp(temp);
+    }
+}
+
+//////////////////////////////////////
+
+// NOTE: The last release of a snapshot can happen on any thread, so snapshots and
+// their blocks always come from the system allocator.
+internal Buffer_Snapshot_Block*
+buffer_snapshot__alloc_block(i64 size){
+    String_Const_u8 memory = base_allocate(get_base_allocator_system(), sizeof(Buffer_Snapshot_Block) + size);
+    Buffer_Snapshot_Block *block = (Buffer_Snapshot_Block*)memory.str;
+    block->ref_count = 1;
+    block->size = size;
+    block->data = (u8*)(block + 1);
+    return(block);
+}
+
+internal void
+buffer_snapshot__release_block(Buffer_Snapshot_Block *block){
+    if (block != 0 && atomic_add_i32(&block->ref_count, -1) == 1){
+        base_free(get_base_allocator_system(), block);
+    }
+}
+
+internal void
+buffer_snapshot_release(Buffer_Snapshot *snapshot){
+    if (snapshot != 0 && atomic_add_i32(&snapshot->ref_count, -1) == 1){
+        for (i64 i = 0; i < snapshot->block_count; i += 1){
+            buffer_snapshot__release_block(snapshot->blocks[i]);
+        }
+        base_free(get_base_allocator_system(), snapshot);
+    }
+}
+
+internal void
+buffer_snapshot_cache_free(Base_Allocator *allocator, Buffer_Snapshot_Cache *cache){
+    buffer_snapshot_release(cache->snapshot);
+    for (i64 i = 0; i < cache->count; i += 1){
+        buffer_snapshot__release_block(cache->slots[i].block);
+    }
+    if (cache->slots != 0){
+        base_free(allocator, cache->slots);
+    }
+    block_zero_struct(cache);
+}
+
+// NOTE: Only called with the buffer locked, and a snapshot can only be acquired
+// with the buffer locked, so a cache that isn't in use can't come into use during the call.
+internal b32
+buffer_snapshot_cache_in_use(Buffer_Snapshot_Cache *cache){
+    b32 result = false;
+    if (cache->snapshot != 0){
+        result = (atomic_add_i32(&cache->snapshot->ref_count, 0) > 1);
+    }
+    return(result);
+}
+
+internal void
+buffer_snapshot_cache_drop(Gap_Buffer *buffer){
+    buffer_snapshot_cache_free(buffer->allocator, &buffer->snapshot_cache);
+}
+
+// NOTE: Every slot that an edit touches, including the ones that only border it,
+// becomes part of a hole.  So a hole always spans at least one old block and typing doesn't
+// break the cache up into tiny blocks.  The batch is sorted, so this is one walk over both.
+internal void
+buffer_snapshot_cache_edit(Buffer_Snapshot_Cache *cache, Batch_Edit *batch){
+    buffer_snapshot_release(cache->snapshot);
+    cache->snapshot = 0;
+    
+    // NOTE: edit is the first edit that can still touch the current slot, uncounted
+    // is the first edit whose shift hasn't gone into a hole yet.
+    Batch_Edit *edit = batch;
+    Batch_Edit *uncounted = batch;
+    b32 in_hole = false;
+    i64 write_count = 0;
+    i64 pos = 0;
+    for (i64 i = 0; i < cache->count; i += 1){
+        Buffer_Snapshot_Slot slot = cache->slots[i];
+        i64 slot_opl = pos + slot.size;
+        b32 touched = (edit != 0 && edit->edit.range.first <= slot_opl);
+        i64 shift = 0;
+        for (;uncounted != 0 && uncounted->edit.range.first <= slot_opl;
+             uncounted = uncounted->next){
+            shift += replace_range_shift(uncounted->edit.range, (i64)uncounted->edit.text.size);
+        }
+        for (;edit != 0 && edit->edit.range.one_past_last < slot_opl;
+             edit = edit->next);
+        if (touched){
+            buffer_snapshot__release_block(slot.block);
+            if (!in_hole){
+                cache->slots[write_count].block = 0;
+                cache->slots[write_count].size = 0;
+                write_count += 1;
+                in_hole = true;
+            }
+            cache->slots[write_count - 1].size += slot.size + shift;
+        }
+        else{
+            cache->slots[write_count] = slot;
+            write_count += 1;
+            in_hole = (slot.block == 0);
+        }
+        pos = slot_opl;
+    }
+    cache->count = write_count;
+}
+
+//////////////////////////////////////
+
 internal b32
 buffer_good(Gap_Buffer *buffer){
-    return(buffer->data != 0);
+    return(buffer->data != 0 || buffer->storage_kind == BufferStorage_PieceTree);
 }
 
 internal i64
 buffer_size(Gap_Buffer *buffer){
-    return(buffer->size1 + buffer->size2);
+    i64 result = 0;
+    switch (buffer->storage_kind){
+        case BufferStorage_Gap:
+        {
+            result = buffer->size1 + buffer->size2;
+        }break;
+        case BufferStorage_PieceTree:
+        {
+            result = piece__subtree_size(buffer->piece_tree.root);
+        }break;
+    }
+    return(result);
 }
 
 internal i64
 buffer_line_count(Gap_Buffer *buffer){
-    return(buffer->line_start_count - 1);
+    return(buffer->line_index.line_count);
 }
 
 internal void
-buffer_init(Gap_Buffer *buffer, u8 *data, u64 size, Base_Allocator *allocator){
+buffer_init(Gap_Buffer *buffer, u8 *data, u64 size, Base_Allocator *allocator, Buffer_Storage_Kind storage_kind){
     block_zero_struct(buffer);
     
     buffer->allocator = allocator;
+    buffer->storage_kind = storage_kind;
     
-    u64 capacity = round_up_u64(size*2, KB(4));
-    String_Const_u8 memory = base_allocate(allocator, capacity);
-    buffer->data = (u8*)memory.str;
-    buffer->size1 = size/2;
-    buffer->gap_size = capacity - size;
-    buffer->size2 = size - buffer->size1;
-    buffer->max = capacity;
-    
-    block_copy(buffer->data, data, buffer->size1);
-    block_copy(buffer->data + buffer->size1 + buffer->gap_size, data + buffer->size1, buffer->size2);
+    switch (storage_kind){
+        case BufferStorage_Gap:
+        {
+            u64 capacity = round_up_u64(size*2, KB(4));
+            String_Const_u8 memory = base_allocate(allocator, capacity);
+            buffer->data = (u8*)memory.str;
+            buffer->size1 = size/2;
+            buffer->gap_size = capacity - size;
+            buffer->size2 = size - buffer->size1;
+            buffer->max = capacity;
+            
+            block_copy(buffer->data, data, buffer->size1);
+            block_copy(buffer->data + buffer->size1 + buffer->gap_size, data + buffer->size1, buffer->size2);
+        }break;
+        
+        case BufferStorage_PieceTree:
+        {
+            piece_tree_init(&buffer->piece_tree, allocator, data, (i64)size);
+        }break;
+    }
+}
+
+internal void
+buffer_init(Gap_Buffer *buffer, u8 *data, u64 size, Base_Allocator *allocator){
+    buffer_init(buffer, data, size, allocator, BufferStorage_Gap);
+}
+
+internal void
+buffer__free_text(Gap_Buffer *buffer){
+    switch (buffer->storage_kind){
+        case BufferStorage_Gap:
+        {
+            if (buffer->data != 0){
+                base_free(buffer->allocator, buffer->data);
+            }
+        }break;
+        case BufferStorage_PieceTree:
+        {
+            piece_tree_free(&buffer->piece_tree, buffer->allocator);
+        }break;
+    }
+    buffer->data = 0;
+}
+
+internal void
+buffer_free(Gap_Buffer *buffer){
+    if (buffer->allocator != 0){
+        buffer__free_text(buffer);
+        line_index_free(buffer->allocator, &buffer->line_index);
+        buffer_snapshot_cache_free(buffer->allocator, &buffer->snapshot_cache);
+    }
+    block_zero_struct(buffer);
 }
 
 internal b32
-buffer_replace_range(Gap_Buffer *buffer, Range_i64 range, String_Const_u8 text, i64 shift_amount){
+buffer__gap_replace_range(Gap_Buffer *buffer, Range_i64 range, String_Const_u8 text, i64 shift_amount){
     i64 size = buffer_size(buffer);
     Assert(0 <= range.start);
     Assert(range.start <= range.end);
@@ -258,21 +940,111 @@ buffer_replace_range(Gap_Buffer *buffer, Range_i64 range, String_Const_u8 text,
     return(result);
 }
 
-////////////////////////////////
+internal b32
+buffer_replace_range(Gap_Buffer *buffer, Range_i64 range, String_Const_u8 text, i64 shift_amount){
+    b32 result = false;
+    
+    Batch_Edit batch = {};
+    batch.edit.text = text;
+    batch.edit.range = range;
+    buffer_snapshot_cache_edit(&buffer->snapshot_cache, &batch);
+    
+    switch (buffer->storage_kind){
+        case BufferStorage_Gap:
+        {
+            result = buffer__gap_replace_range(buffer, range, text, shift_amount);
+        }break;
+        
+        case BufferStorage_PieceTree:
+        {
+            Assert(0 <= range.start);
+            Assert(range.start <= range.end);
+            Assert(range.end <= buffer_size(buffer));
+            piece_tree_replace_range(&buffer->piece_tree, buffer->allocator, range, text);
+        }break;
+    }
+    return(result);
+}
 
-internal List_String_Const_u8
-buffer_get_chunks(Arena *arena, Gap_Buffer *buffer){
-    List_String_Const_u8 list = {};
-    if (buffer->size1 > 0){
-        string_list_push(arena, &list, SCu8(buffer->data, buffer->size1));
+internal u8*
+buffer__gap_copy_range(Gap_Buffer *buffer, Range_i64 range, u8 *dst){
+    if (range.first < buffer->size1){
+        i64 one_past_last = Min(range.one_past_last, buffer->size1);
+        block_copy(dst, buffer->data + range.first, one_past_last - range.first);
+        dst += one_past_last - range.first;
+        range.first = one_past_last;
     }
-    if (buffer->size2 > 0){
-        u64 gap_2_pos = buffer->size1 + buffer->gap_size;
-        string_list_push(arena, &list, SCu8(buffer->data + gap_2_pos, buffer->size2));
+    if (range.first < range.one_past_last){
+        u8 *data2 = buffer->data + buffer->gap_size;
+        block_copy(dst, data2 + range.first, range.one_past_last - range.first);
+        dst += range.one_past_last - range.first;
+    }
+    return(dst);
+}
+
+// NOTE: The batch is sorted and its ranges are all in the coordinates from before
+// the batch.  A gap buffer is rebuilt in one sweep over the old text and the inserted
+// strings, instead of moving the gap once per edit; the new text ends up all in front of
+// the gap.  Pieces are cheap to split, so a piece tree just takes the edits in order.
+internal void
+buffer_replace_batch(Gap_Buffer *buffer, Batch_Edit *batch){
+    buffer_snapshot_cache_edit(&buffer->snapshot_cache, batch);
+    
+    switch (buffer->storage_kind){
+        case BufferStorage_Gap:
+        {
+            i64 size = buffer_size(buffer);
+            i64 new_size = size;
+            for (Batch_Edit *edit = batch;
+                 edit != 0;
+                 edit = edit->next){
+                Assert(0 <= edit->edit.range.first);
+                Assert(edit->edit.range.first <= edit->edit.range.one_past_last);
+                Assert(edit->edit.range.one_past_last <= size);
+                new_size += replace_range_shift(edit->edit.range, (i64)edit->edit.text.size);
+            }
+            
+            i64 new_max = clamp_bot(KB(4), round_up_i64(new_size*2, KB(4)));
+            String_Const_u8 new_memory = base_allocate(buffer->allocator, new_max);
+            u8 *ptr = new_memory.str;
+            i64 pos = 0;
+            for (Batch_Edit *edit = batch;
+                 edit != 0;
+                 edit = edit->next){
+                ptr = buffer__gap_copy_range(buffer, Ii64(pos, edit->edit.range.first), ptr);
+                block_copy(ptr, edit->edit.text.str, edit->edit.text.size);
+                ptr += edit->edit.text.size;
+                pos = edit->edit.range.one_past_last;
+            }
+            ptr = buffer__gap_copy_range(buffer, Ii64(pos, size), ptr);
+            Assert(ptr == new_memory.str + new_size);
+            
+            base_free(buffer->allocator, buffer->data);
+            buffer->data = new_memory.str;
+            buffer->size1 = new_size;
+            buffer->gap_size = new_max - new_size;
+            buffer->size2 = 0;
+            buffer->max = new_max;
+        }break;
+        
+        case BufferStorage_PieceTree:
+        {
+            i64 shift = 0;
+            for (Batch_Edit *edit = batch;
+                 edit != 0;
+                 edit = edit->next){
+                Range_i64 range = edit->edit.range;
+                range.first += shift;
+                range.one_past_last += shift;
+                piece_tree_replace_range(&buffer->piece_tree, buffer->allocator, range, edit->edit.text);
+                shift += replace_range_shift(edit->edit.range, (i64)edit->edit.text.size);
+            }
+        }break;
     }
-    return(list);
 }
 
+////////////////////////////////
+
 internal void
 buffer_chunks_clamp(List_String_Const_u8 *chunks, Range_i64 range){
     i64 p = 0;
@@ -296,17 +1068,211 @@ buffer_chunks_clamp(List_String_Const_u8 *chunks, Range_i64 range){
     *chunks = list;
 }
 
+internal List_String_Const_u8
+buffer_get_chunks(Arena *arena, Gap_Buffer *buffer, Range_i64 range){
+    List_String_Const_u8 list = {};
+    switch (buffer->storage_kind){
+        case BufferStorage_Gap:
+        {
+            if (buffer->size1 > 0){
+                string_list_push(arena, &list, SCu8(buffer->data, buffer->size1));
+            }
+            if (buffer->size2 > 0){
+                u64 gap_2_pos = buffer->size1 + buffer->gap_size;
+                string_list_push(arena, &list, SCu8(buffer->data + gap_2_pos, buffer->size2));
+            }
+            buffer_chunks_clamp(&list, range);
+        }break;
+        
+        case BufferStorage_PieceTree:
+        {
+            piece_tree_push_chunks(arena, &list, buffer->piece_tree.root, 0, range);
+        }break;
+    }
+    return(list);
+}
+
+internal List_String_Const_u8
+buffer_get_chunks(Arena *arena, Gap_Buffer *buffer){
+    return(buffer_get_chunks(arena, buffer, Ii64(0, buffer_size(buffer))));
+}
+
 internal String_Const_u8
 buffer_stringify(Arena *arena, Gap_Buffer *buffer, Range_i64 range){
-    List_String_Const_u8 list = buffer_get_chunks(arena, buffer);
-    buffer_chunks_clamp(&list, range);
+    List_String_Const_u8 list = buffer_get_chunks(arena, buffer, range);
     return(string_list_flatten(arena, list, StringFill_NullTerminate));
 }
 
+internal i64
+buffer_snapshot__hole_block_count(i64 run_size){
+    return((run_size + BUFFER_SNAPSHOT_BLOCK_SIZE - 1)/BUFFER_SNAPSHOT_BLOCK_SIZE);
+}
+
+internal void
+buffer_snapshot__fill_hole(Arena *scratch, Gap_Buffer *buffer, Buffer_Snapshot_Slot *slots, i64 *count, i64 run_first, i64 run_size){
+    i64 block_count = buffer_snapshot__hole_block_count(run_size);
+    i64 pos = run_first;
+    for (i64 i = 0; i < block_count; i += 1){
+        i64 size = run_size/block_count + ((i < run_size%block_count)?1:0);
+        Buffer_Snapshot_Block *block = buffer_snapshot__alloc_block(size);
+        Temp_Memory temp = begin_temp(scratch);
+        List_String_Const_u8 chunks = buffer_get_chunks(scratch, buffer, Ii64(pos, pos + size));
+        u8 *ptr = block->data;
+        for (Node_String_Const_u8 *node = chunks.first;
+             node != 0;
+             node = node->next){
+            block_copy(ptr, node->string.str, node->string.size);
+            ptr += node->string.size;
+        }
+        end_temp(temp);
+        slots[*count].block = block;
+        slots[*count].size = size;
+        *count += 1;
+        pos += size;
+    }
+}
+
+// NOTE: Must be called with the buffer locked, the snapshot it returns can then be
+// read and released from any thread.
+internal Buffer_Snapshot*
+buffer_snapshot_acquire(Arena *scratch, Gap_Buffer *buffer){
+    Buffer_Snapshot_Cache *cache = &buffer->snapshot_cache;
+    if (cache->snapshot == 0){
+        Base_Allocator *allocator = buffer->allocator;
+        i64 size = buffer_size(buffer);
+        
+        if (cache->count == 0 && size > 0){
+            if (cache->max == 0){
+                cache->slots = base_array(allocator, Buffer_Snapshot_Slot, 1);
+                cache->max = 1;
+            }
+            cache->slots[0].block = 0;
+            cache->slots[0].size = size;
+            cache->count = 1;
+        }
+        
+        // NOTE: Count first, then copy each run of holes into new blocks.
+        i64 new_count = 0;
+        {
+            i64 run_size = 0;
+            for (i64 i = 0; i < cache->count; i += 1){
+                Buffer_Snapshot_Slot *slot = &cache->slots[i];
+                if (slot->block == 0){
+                    run_size += slot->size;
+                }
+                else{
+                    new_count += buffer_snapshot__hole_block_count(run_size) + 1;
+                    run_size = 0;
+                }
+            }
+            new_count += buffer_snapshot__hole_block_count(run_size);
+        }
+        
+        Buffer_Snapshot_Slot *new_slots = 0;
+        if (new_count > 0){
+            new_slots = base_array(allocator, Buffer_Snapshot_Slot, new_count);
+        }
+        i64 fill_count = 0;
+        {
+            i64 pos = 0;
+            i64 run_first = 0;
+            i64 run_size = 0;
+            for (i64 i = 0; i < cache->count; i += 1){
+                Buffer_Snapshot_Slot *slot = &cache->slots[i];
+                if (slot->block == 0){
+                    run_size += slot->size;
+                }
+                else{
+                    buffer_snapshot__fill_hole(scratch, buffer, new_slots, &fill_count, run_first, run_size);
+                    new_slots[fill_count] = *slot;
+                    fill_count += 1;
+                    run_first = pos + slot->size;
+                    run_size = 0;
+                }
+                pos += slot->size;
+            }
+            buffer_snapshot__fill_hole(scratch, buffer, new_slots, &fill_count, run_first, run_size);
+            Assert(pos == size);
+        }
+        Assert(fill_count == new_count);
+        
+        if (cache->slots != 0){
+            base_free(allocator, cache->slots);
+        }
+        cache->slots = new_slots;
+        cache->count = new_count;
+        cache->max = new_count;
+        
+        u64 memory_size = sizeof(Buffer_Snapshot) + new_count*(sizeof(Buffer_Snapshot_Block*) + sizeof(i64));
+        String_Const_u8 memory = base_allocate(get_base_allocator_system(), memory_size);
+        Buffer_Snapshot *snapshot = (Buffer_Snapshot*)memory.str;
+        snapshot->ref_count = 1;
+        snapshot->size = size;
+        snapshot->block_count = new_count;
+        snapshot->blocks = (Buffer_Snapshot_Block**)(snapshot + 1);
+        snapshot->block_first = (i64*)(snapshot->blocks + new_count);
+        i64 pos = 0;
+        for (i64 i = 0; i < new_count; i += 1){
+            Buffer_Snapshot_Block *block = new_slots[i].block;
+            atomic_add_i32(&block->ref_count, 1);
+            snapshot->blocks[i] = block;
+            snapshot->block_first[i] = pos;
+            pos += block->size;
+        }
+        cache->snapshot = snapshot;
+    }
+    atomic_add_i32(&cache->snapshot->ref_count, 1);
+    return(cache->snapshot);
+}
+
+internal b32
+buffer_snapshot_read_range(Buffer_Snapshot *snapshot, Range_i64 range, u8 *out){
+    b32 result = false;
+    if (0 <= range.min && range.min <= range.max && range.max <= snapshot->size){
+        i64 index = 0;
+        i64 one_past_last = snapshot->block_count;
+        for (;index + 1 < one_past_last;){
+            i64 mid = (index + one_past_last)/2;
+            if (snapshot->block_first[mid] <= range.min){
+                index = mid;
+            }
+            else{
+                one_past_last = mid;
+            }
+        }
+        u8 *ptr = out;
+        for (i64 pos = range.min; pos < range.max; index += 1){
+            Buffer_Snapshot_Block *block = snapshot->blocks[index];
+            i64 first = pos - snapshot->block_first[index];
+            i64 size = Min(block->size - first, range.max - pos);
+            block_copy(ptr, block->data + first, size);
+            ptr += size;
+            pos += size;
+        }
+        result = true;
+    }
+    return(result);
+}
+
+internal void
+buffer_set_storage_kind(Arena *scratch, Gap_Buffer *buffer, Buffer_Storage_Kind storage_kind){
+    if (buffer->storage_kind != storage_kind){
+        Temp_Memory temp = begin_temp(scratch);
+        String_Const_u8 text = buffer_stringify(scratch, buffer, Ii64(0, buffer_size(buffer)));
+        Line_Index line_index = buffer->line_index;
+        Buffer_Snapshot_Cache snapshot_cache = buffer->snapshot_cache;
+        Base_Allocator *allocator = buffer->allocator;
+        buffer__free_text(buffer);
+        buffer_init(buffer, text.str, text.size, allocator, storage_kind);
+        buffer->line_index = line_index;
+        buffer->snapshot_cache = snapshot_cache;
+        end_temp(temp);
+    }
+}
+
 internal String_Const_u8
 buffer_eol_convert_out(Arena *arena, Gap_Buffer *buffer, Range_i64 range){
-    List_String_Const_u8 list = buffer_get_chunks(arena, buffer);
-    buffer_chunks_clamp(&list, range);
+    List_String_Const_u8 list = buffer_get_chunks(arena, buffer, range);
     u64 cap = list.total_size*2;
     u8 *memory = push_array(arena, u8, cap);
     u8 *memory_opl = memory + cap;
@@ -360,198 +1326,258 @@ buffer_count_newlines(Arena *scratch, Gap_Buffer *buffer, i64 start, i64 end){
 }
 #endif
 
-internal void
-buffer_starts__ensure_max_size(Gap_Buffer *buffer, i64 max_size){
-    if (max_size > buffer->line_start_max){
-        i64 new_max = round_up_i64(max_size*2, KB(1));
-        String_Const_u8 memory = base_allocate(buffer->allocator, sizeof(*buffer->line_starts)*new_max);
-        i64 *new_line_starts = (i64*)memory.str;
-        block_copy_dynamic_array(new_line_starts, buffer->line_starts, buffer->line_start_count);
-        buffer->line_start_max = new_max;
-        base_free(buffer->allocator, buffer->line_starts);
-        buffer->line_starts = new_line_starts;
+internal i64
+count_lines__scalar(u8 *str, u64 size){
+    i64 result = 0;
+    for (u64 i = 0; i < size; i += 1){
+        if (str[i] == '\n'){
+            result += 1;
+        }
     }
+    return(result);
 }
 
-internal void
-buffer_measure_starts__write(Gap_Buffer *buffer, i64 pos){
-    buffer_starts__ensure_max_size(buffer, buffer->line_start_count + 1);
-    buffer->line_starts[buffer->line_start_count] = pos;
-    buffer->line_start_count += 1;
+internal i64
+fill_line_starts__scalar(i64 *line_starts, u8 *str, u64 size, i64 text_base){
+    i64 *ptr = line_starts;
+    for (u64 i = 0; i < size; i += 1){
+        if (str[i] == '\n'){
+            *ptr = text_base + i + 1;
+            ptr += 1;
+        }
+    }
+    return(ptr - line_starts);
 }
 
-internal void
-buffer_measure_starts(Arena *scratch, Gap_Buffer *buffer){
-    Temp_Memory temp = begin_temp(scratch);
-    List_String_Const_u8 list = buffer_get_chunks(scratch, buffer);
-    buffer->line_start_count = 0;
-    buffer_measure_starts__write(buffer, 0);
-    i64 index = 0;
-    for (Node_String_Const_u8 *node = list.first;
-         node != 0;
-         node = node->next){
-        u8 *byte = node->string.str;
-        u8 *byte_opl = byte + node->string.size;
-        for (;byte < byte_opl; byte += 1){
-            index += 1;
-            if (*byte == '\n'){
-                buffer_measure_starts__write(buffer, index);
-            }
+#if ARCH_HAS_X86_SIMD
+// NOTE: The counting kernels subtract the compare masks (0 or -1) into byte lanes,
+// which overflow after 255 rounds, so they fold the lanes into the total with a SAD
+// against zero at least that often.
+internal TARGET_SSE2 i64
+count_lines__sse2(u8 *str, u64 size){
+    i64 result = 0;
+    u64 i = 0;
+    u64 vector_opl = size - size%16;
+    __m128i newline = _mm_set1_epi8('\n');
+    __m128i zero = _mm_setzero_si128();
+    for (;i < vector_opl;){
+        u64 round_opl = Min(vector_opl, i + 255*16);
+        __m128i counts = zero;
+        for (;i < round_opl; i += 16){
+            __m128i v = _mm_loadu_si128((__m128i*)(str + i));
+            counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(v, newline));
         }
+        __m128i sums = _mm_sad_epu8(counts, zero);
+        result += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
     }
-    buffer_measure_starts__write(buffer, buffer_size(buffer));
-    end_temp(temp);
+    result += count_lines__scalar(str + i, size - i);
+    return(result);
 }
 
-internal i64
-buffer_get_line_index(Gap_Buffer *buffer, i64 pos){
-    i64 i = 0;
-    if (buffer->line_start_count > 2){
-        i64 start = 0;
-        i64 one_past_last = buffer->line_start_count - 1;
-        i64 *array = buffer->line_starts;
-        pos = clamp_bot(0, pos);
-        for (;;){
-            i = (start + one_past_last) >> 1;
-            if (array[i] < pos){
-                start = i;
-            }
-            else if (array[i] > pos){
-                one_past_last = i;
-            }
-            else{
-                break;
-            }
-            if (start + 1 >= one_past_last){
-                i = start;
-                break;
-            }
+internal TARGET_AVX2 i64
+count_lines__avx2(u8 *str, u64 size){
+    i64 result = 0;
+    u64 i = 0;
+    u64 vector_opl = size - size%32;
+    __m256i newline = _mm256_set1_epi8('\n');
+    __m256i zero = _mm256_setzero_si256();
+    for (;i < vector_opl;){
+        u64 round_opl = Min(vector_opl, i + 255*32);
+        __m256i counts = zero;
+        for (;i < round_opl; i += 32){
+            __m256i v = _mm256_loadu_si256((__m256i*)(str + i));
+            counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(v, newline));
         }
+        u64 lanes[4];
+        _mm256_storeu_si256((__m256i*)lanes, _mm256_sad_epu8(counts, zero));
+        result += lanes[0] + lanes[1] + lanes[2] + lanes[3];
     }
-    return(i);
+    result += count_lines__scalar(str + i, size - i);
+    return(result);
 }
 
-Line_Move*
-push_line_move(Arena *arena, Line_Move *moves, i64 new_line_first,
-               i64 old_line_first, i64 old_line_opl, i64 text_shift){
-    Line_Move *move = push_array(arena, Line_Move, 1);
-    move->next = moves;
-    move->kind = LineMove_ShiftOldValues;
-    move->new_line_first = new_line_first;
-    move->old_line_first = old_line_first;
-    move->old_line_opl = old_line_opl;
-    move->text_shift = text_shift;
-    return(move);
+internal TARGET_SSE2 i64
+fill_line_starts__sse2(i64 *line_starts, u8 *str, u64 size, i64 text_base){
+    i64 *ptr = line_starts;
+    u64 i = 0;
+    u64 vector_opl = size - size%16;
+    __m128i newline = _mm_set1_epi8('\n');
+    for (;i < vector_opl; i += 16){
+        __m128i v = _mm_loadu_si128((__m128i*)(str + i));
+        u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        for (;mask != 0; mask &= mask - 1){
+            *ptr = text_base + i + bit_scan_forward_u32(mask) + 1;
+            ptr += 1;
+        }
+    }
+    ptr += fill_line_starts__scalar(ptr, str + i, size - i, text_base + i);
+    return(ptr - line_starts);
 }
 
-Line_Move*
-push_line_move(Arena *arena, Line_Move *moves, i64 new_line_first,
-               String_Const_u8 string, i64 text_base){
-    Line_Move *move = push_array(arena, Line_Move, 1);
-    move->next = moves;
-    move->kind = LineMove_MeasureString;
-    move->new_line_first = new_line_first;
-    move->string = string;
-    move->text_base = text_base;
-    return(move);
+internal TARGET_AVX2 i64
+fill_line_starts__avx2(i64 *line_starts, u8 *str, u64 size, i64 text_base){
+    i64 *ptr = line_starts;
+    u64 i = 0;
+    u64 vector_opl = size - size%32;
+    __m256i newline = _mm256_set1_epi8('\n');
+    for (;i < vector_opl; i += 32){
+        __m256i v = _mm256_loadu_si256((__m256i*)(str + i));
+        u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        for (;mask != 0; mask &= mask - 1){
+            *ptr = text_base + i + bit_scan_forward_u32(mask) + 1;
+            ptr += 1;
+        }
+    }
+    ptr += fill_line_starts__scalar(ptr, str + i, size - i, text_base + i);
+    return(ptr - line_starts);
 }
+#endif
 
 function i64
 count_lines(String_Const_u8 string){
     i64 result = 0;
-    for (u64 i = 0; i < string.size; i += 1){
-        if (string.str[i] == '\n'){
-            result += 1;
-        }
+#if ARCH_HAS_X86_SIMD
+    if (cpu_has_feature(CPUFeature_AVX2)){
+        result = count_lines__avx2(string.str, string.size);
+    }
+    else if (cpu_has_feature(CPUFeature_SSE2)){
+        result = count_lines__sse2(string.str, string.size);
+    }
+    else
+#endif
+    {
+        result = count_lines__scalar(string.str, string.size);
     }
     return(result);
 }
 
-function void
-fill_line_starts(i64 *lines_starts, String_Const_u8 string, i64 text_base){
-    i64 *ptr = lines_starts;
-    for (u64 i = 0; i < string.size; i += 1){
-        if (string.str[i] == '\n'){
-            *ptr = text_base + i + 1;
-            ptr += 1;
-        }
+// NOTE: Writes the position after each newline in string, offset by text_base, and
+// returns how many were written; line_starts must have room for count_lines(string).
+function i64
+fill_line_starts(i64 *line_starts, String_Const_u8 string, i64 text_base){
+    i64 result = 0;
+#if ARCH_HAS_X86_SIMD
+    if (cpu_has_feature(CPUFeature_AVX2)){
+        result = fill_line_starts__avx2(line_starts, string.str, string.size, text_base);
+    }
+    else if (cpu_has_feature(CPUFeature_SSE2)){
+        result = fill_line_starts__sse2(line_starts, string.str, string.size, text_base);
     }
+    else
+#endif
+    {
+        result = fill_line_starts__scalar(line_starts, string.str, string.size, text_base);
+    }
+    return(result);
 }
 
-function void
-buffer_remeasure_starts(Thread_Context *tctx, Gap_Buffer *buffer, Batch_Edit *batch){
-    Scratch_Block scratch(tctx);
-    
-    i64 line_start_count = buffer_line_count(buffer) + 1;
+internal void
+buffer_measure_starts(Arena *scratch, Gap_Buffer *buffer){
+    Temp_Memory temp = begin_temp(scratch);
+    Base_Allocator *allocator = buffer->allocator;
+    Line_Index *index = &buffer->line_index;
+    line_index_clear(allocator, index);
+    List_String_Const_u8 list = buffer_get_chunks(scratch, buffer);
     
-    Line_Move *moves = 0;
-    i64 current_line = 0;
-    i64 text_shift = 0;
-    i64 line_shift = 0;
-    for (Batch_Edit *node = batch;
+    // NOTE: size the block table once up front instead of growing it per line
+    i64 line_count = 1;
+    for (Node_String_Const_u8 *node = list.first;
          node != 0;
          node = node->next){
-        i64 first_line = buffer_get_line_index(buffer, node->edit.range.first);
-        i64 opl_line = buffer_get_line_index(buffer, node->edit.range.one_past_last);
-        i64 new_line_count = count_lines(node->edit.text);
-        i64 deleted_line_count = opl_line - first_line;
-        
-        Assert(first_line <= opl_line);
-        Assert(opl_line <= line_start_count);
-        
-        if (current_line <= first_line &&
-            (text_shift != 0 || line_shift != 0)){
-            moves = push_line_move(scratch, moves, current_line + line_shift,
-                                   current_line, first_line + 1, text_shift);
-        }
-        
-        if (new_line_count != 0){
-            moves = push_line_move(scratch, moves, first_line + 1 + line_shift,
-                                   node->edit.text, node->edit.range.first + text_shift);
-        }
-        
-        text_shift += node->edit.text.size - range_size(node->edit.range);
-        line_shift += new_line_count - deleted_line_count;
-        current_line = opl_line + 1;
+        line_count += count_lines(node->string);
     }
+    line_index__ensure_block_max(allocator, index,
+                                 (line_count + LINE_INDEX_BLOCK_CAP - 1)/LINE_INDEX_BLOCK_CAP);
     
-    moves = push_line_move(scratch, moves, current_line + line_shift,
-                           current_line, line_start_count, text_shift);
-    line_start_count = line_start_count + line_shift;
-    
-    buffer_starts__ensure_max_size(buffer, line_start_count + 1);
-    buffer->line_start_count = line_start_count;
-    
-    i64 *array = buffer->line_starts;
-    
-    for (Line_Move *node = moves;
+    u64 slice_size = KB(64);
+    i64 *starts = push_array(scratch, i64, slice_size);
+    i64 line_start = 0;
+    i64 pos = 0;
+    for (Node_String_Const_u8 *node = list.first;
          node != 0;
          node = node->next){
-        if (node->kind == LineMove_ShiftOldValues){
-            i64 line_index_shift = node->new_line_first - node->old_line_first;
-            i64 move_text_shift = node->text_shift;
-            if (line_index_shift > 0){
-                for (i64 i = node->old_line_opl - 1;
-                     i >= node->old_line_first;
-                     i -= 1){
-                    array[i + line_index_shift] = array[i] + move_text_shift;
-                }
-            }
-            else{
-                for (i64 i = node->old_line_first;
-                     i < node->old_line_opl;
-                     i += 1){
-                    array[i + line_index_shift] = array[i] + move_text_shift;
-                }
+        String_Const_u8 string = node->string;
+        for (u64 i = 0; i < string.size; i += slice_size){
+            String_Const_u8 slice = string_substring(string, Ii64((i64)i, (i64)Min(i + slice_size, string.size)));
+            i64 count = fill_line_starts(starts, slice, pos);
+            for (i64 j = 0; j < count; j += 1){
+                line_index__append(allocator, index, starts[j] - line_start);
+                line_start = starts[j];
             }
+            pos += slice.size;
         }
     }
+    line_index__append(allocator, index, pos - line_start);
+    line_index__rebuild_trees(index);
+    end_temp(temp);
+}
+
+internal i64
+buffer_get_line_index(Gap_Buffer *buffer, i64 pos){
+    pos = clamp_bot(0, pos);
+    return(line_index_line_from_pos(&buffer->line_index, pos));
+}
+
+// NOTE: Called after the batch has been applied to the text but before anything
+// else reads the line index, so every lookup here still sees the pre-edit lines.  The
+// edits are sorted and do not overlap, so applying them in order with a running shift
+// keeps each range valid against the partially updated index.
+function void
+buffer_remeasure_starts(Thread_Context *tctx, Gap_Buffer *buffer, Batch_Edit *batch){
+    Scratch_Block scratch(tctx);
+    Line_Index *index = &buffer->line_index;
     
-    for (Line_Move *node = moves;
+    // NOTE: Once there are about as many edits as line blocks nearly every block is
+    // rewritten anyway, so one measuring pass over the new text is cheaper.
+    i64 edit_count = 0;
+    for (Batch_Edit *node = batch;
          node != 0;
          node = node->next){
-        if (node->kind == LineMove_MeasureString){
-            fill_line_starts(array + node->new_line_first, node->string, node->text_base);
+        edit_count += 1;
+    }
+    if (edit_count > 1 && edit_count*LINE_INDEX_BLOCK_CAP >= index->line_count){
+        buffer_measure_starts(scratch, buffer);
+    }
+    else{
+        i64 text_shift = 0;
+        for (Batch_Edit *node = batch;
+             node != 0;
+             node = node->next){
+            Temp_Memory temp = begin_temp(scratch);
+            
+            String_Const_u8 text = node->edit.text;
+            Range_i64 range = node->edit.range;
+            range.first += text_shift;
+            range.one_past_last += text_shift;
+            
+            i64 first_line = line_index_line_from_pos(index, range.first);
+            i64 last_line = line_index_line_from_pos(index, range.one_past_last);
+            Assert(first_line <= last_line);
+            i64 head_size = range.first - line_index_first_pos(index, first_line);
+            i64 tail_size = (line_index_first_pos(index, last_line) + line_index_line_length(index, last_line) -
+                             range.one_past_last);
+            
+            i64 new_line_count = count_lines(text);
+            i64 *new_lengths = push_array(scratch, i64, new_line_count + 1);
+            if (new_line_count == 0){
+                new_lengths[0] = head_size + text.size + tail_size;
+            }
+            else{
+                i64 *starts = push_array(scratch, i64, new_line_count);
+                fill_line_starts(starts, text, 0);
+                new_lengths[0] = head_size + starts[0];
+                for (i64 i = 1; i < new_line_count; i += 1){
+                    new_lengths[i] = starts[i] - starts[i - 1];
+                }
+                new_lengths[new_line_count] = (text.size - starts[new_line_count - 1]) + tail_size;
+            }
+            
+            line_index_replace_lines(scratch, buffer->allocator, index,
+                                     first_line, last_line - first_line + 1,
+                                     new_lengths, new_line_count + 1);
+            
+            text_shift += text.size - range_size(node->edit.range);
+            end_temp(temp);
         }
     }
 }
@@ -559,9 +1585,9 @@ buffer_remeasure_starts(Thread_Context *tctx, Gap_Buffer *buffer, Batch_Edit *ba
 internal Range_i64
 buffer_get_pos_range_from_line_number(Gap_Buffer *buffer, i64 line_number){
     Range_i64 result = {};
-    if (1 <= line_number && line_number < buffer->line_start_count){
-        result.first = buffer->line_starts[line_number - 1];
-        result.one_past_last = buffer->line_starts[line_number];
+    if (1 <= line_number && line_number <= buffer_line_count(buffer)){
+        result.first = line_index_first_pos(&buffer->line_index, line_number - 1);
+        result.one_past_last = result.first + line_index_line_length(&buffer->line_index, line_number - 1);
     }
     return(result);
 }
@@ -572,11 +1598,11 @@ buffer_get_first_pos_from_line_number(Gap_Buffer *buffer, i64 line_number){
     if (line_number < 1){
         result = 0;
     }
-    else if (line_number >= buffer->line_start_count){
+    else if (line_number > buffer_line_count(buffer)){
         result = buffer_size(buffer);
     }
     else{
-        result = buffer->line_starts[line_number - 1];
+        result = line_index_first_pos(&buffer->line_index, line_number - 1);
     }
     return(result);
 }
@@ -587,11 +1613,11 @@ buffer_get_last_pos_from_line_number(Gap_Buffer *buffer, i64 line_number){
     if (line_number < 1){
         result = 0;
     }
-    else if (line_number >= buffer->line_start_count - 1){
+    else if (line_number >= buffer_line_count(buffer)){
         result = buffer_size(buffer);
     }
     else{
-        result = buffer->line_starts[line_number] - 1;
+        result = line_index_first_pos(&buffer->line_index, line_number) - 1;
     }
     return(result);
 }
@@ -605,7 +1631,7 @@ buffer_cursor_from_pos(Gap_Buffer *buffer, i64 pos){
     Buffer_Cursor result = {};
     result.pos = pos;
     result.line = line_index + 1;
-    result.col = pos - buffer->line_starts[line_index] + 1;
+    result.col = pos - line_index_first_pos(&buffer->line_index, line_index) + 1;
     return(result);
 }
 
@@ -616,8 +1642,8 @@ buffer_cursor_from_line_col(Gap_Buffer *buffer, i64 line, i64 col){
     i64 line_count = buffer_line_count(buffer);
     line_index = clamp(0, line_index, line_count - 1);
     
-    i64 this_start = buffer->line_starts[line_index];
-    i64 max_col = (buffer->line_starts[line_index + 1] - this_start);
+    i64 this_start = line_index_first_pos(&buffer->line_index, line_index);
+    i64 max_col = line_index_line_length(&buffer->line_index, line_index);
     if (line_index + 1 == line_count){
         max_col += 1;
     }
@@ -17,22 +17,116 @@ struct Cursor_With_Index{
     i32 index;
 };
 
+typedef i32 Buffer_Storage_Kind;
+enum{
+    BufferStorage_Gap,
+    BufferStorage_PieceTree,
+};
+
+// NOTE: The piece tree is a treap of pieces keyed implicitly by byte offset.
+// Each piece points either into the original text or into an append-only add block,
+// so an edit anywhere in the buffer is a couple of splits and merges instead of a gap move.
+struct Piece_Node{
+    Piece_Node *left;
+    Piece_Node *right;
+    u8 *str;
+    i64 size;
+    i64 subtree_size;
+    u32 priority;
+};
+
+struct Piece_Add_Block{
+    Piece_Add_Block *next;
+    u8 *data;
+    i64 pos;
+    i64 max;
+};
+
+struct Piece_Tree{
+    Arena node_arena;
+    Piece_Node *root;
+    Piece_Node *free_nodes;
+    Piece_Add_Block *add_block;
+    u8 *original;
+    i64 piece_count;
+    u32 random_state;
+};
+
+// NOTE: The line index stores the length of every line (including its newline)
+// in fixed size blocks, with two Fenwick trees over the blocks for line counts and byte
+// sizes.  Line lookups descend the trees and then scan one block, and an edit only
+// touches the blocks it lands in, so typing near the top of a huge file does not shift
+// every later line start.
+#define LINE_INDEX_BLOCK_CAP 256
+struct Line_Index_Block{
+    i64 count;
+    i64 size;
+    i64 lengths[LINE_INDEX_BLOCK_CAP];
+};
+
+struct Line_Index{
+    Line_Index_Block **blocks;
+    i64 block_count;
+    i64 block_max;
+    i64 *count_tree;
+    i64 *size_tree;
+    i64 line_count;
+    i64 total_size;
+};
+
+// NOTE: Snapshots read the text through immutable, reference counted blocks, so
+// a task can hold on to one and read it without the frame mutex.  The buffer keeps the
+// blocks of its last snapshot in the cache; an edit only drops the blocks it touches
+// and leaves a hole there, and the next snapshot copies just the holes.  The cache is a
+// second copy of the text, so the frame loop drops it once no snapshot of the buffer
+// has been alive for a while (see SNAPSHOT_CACHE_KEEP_TIME).
+#define BUFFER_SNAPSHOT_BLOCK_SIZE KB(64)
+#define SNAPSHOT_CACHE_KEEP_TIME Million(1)
+struct Buffer_Snapshot_Block{
+    i32 ref_count;
+    i64 size;
+    u8 *data;
+};
+
+struct Buffer_Snapshot{
+    i32 ref_count;
+    i64 size;
+    i64 block_count;
+    Buffer_Snapshot_Block **blocks;
+    i64 *block_first;
+};
+
+// NOTE: Slots cover the whole buffer in order, a slot without a block is a hole.
+struct Buffer_Snapshot_Slot{
+    Buffer_Snapshot_Block *block;
+    i64 size;
+};
+
+struct Buffer_Snapshot_Cache{
+    Buffer_Snapshot_Slot *slots;
+    i64 count;
+    i64 max;
+    Buffer_Snapshot *snapshot;
+};
+
 struct Gap_Buffer{
     Base_Allocator *allocator;
     
+    // NOTE: When storage_kind is BufferStorage_PieceTree the text lives in
+    // piece_tree and data, size1, gap_size, size2, and max are unused.
+    Buffer_Storage_Kind storage_kind;
+    Piece_Tree piece_tree;
+    
     u8 *data;
     i64 size1;
     i64 gap_size;
     i64 size2;
     i64 max;
     
-    // NOTE(allen): If there are N lines I store N + 1 slots in this array with
-    // line_starts[N] = size of the buffer.
-    //    The variable line_start_count stores N + 1; call buffer_line_count(buffer)
-    // to get "N" the actual number of lines.
-    i64 *line_starts;
-    i64 line_start_count;
-    i64 line_start_max;
+    // NOTE: A buffer with N newlines has N + 1 lines; the last line has no newline.
+    Line_Index line_index;
+    
+    Buffer_Snapshot_Cache snapshot_cache;
 };
 
 struct Buffer_Chunk_Position{
@@ -41,28 +135,6 @@ struct Buffer_Chunk_Position{
     i64 chunk_index;
 };
 
-typedef i32 Line_Move_Kind;
-enum{
-    LineMove_ShiftOldValues,
-    LineMove_MeasureString,
-};
-struct Line_Move{
-    Line_Move *next;
-    Line_Move_Kind kind;
-    i64 new_line_first;
-    union{
-        struct{
-            i64 old_line_first;
-            i64 old_line_opl;
-            i64 text_shift;
-        };
-        struct{
-            String_Const_u8 string;
-            i64 text_base;
-        };
-    };
-};
-
 #endif
 
 // BOTTOM
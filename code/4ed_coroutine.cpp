@@ -3,12 +3,14 @@
  *
  * 19.07.2017
  *
- * Coroutine implementation from thread+mutex+cv
+ * Coroutine implementation from thread+mutex+cv or from stack switching
  *
  */
 
 // TOP
 
+#if FRED_COROUTINE_THREADS
+
 internal void
 coroutine__pass_control(Coroutine *me, Coroutine *other,
                         Coroutine_State my_new_state, Coroutine_Pass_Control control){
@@ -80,25 +82,151 @@ coroutine_sub_init(Coroutine *co, Coroutine_Group *sys){
     }
 }
 
+#else
+
+// NOTE: coroutine__switch pushes the callee saved registers and the SSE and x87
+// control words, stores the stack pointer through save_sp, then pops the same things
+// off load_sp and returns into whatever was suspended there.  A fresh stack is laid out
+// as if it had been suspended right before coroutine__start, which calls r13(r12).
+extern "C" void coroutine__switch(void **save_sp, void *load_sp) __asm__("fred_coroutine_switch");
+extern "C" void coroutine__start(void) __asm__("fred_coroutine_start");
+
+__asm__(
+".text\n"
+".p2align 4\n"
+"fred_coroutine_switch:\n"
+"    pushq %rbp\n"
+"    pushq %rbx\n"
+"    pushq %r12\n"
+"    pushq %r13\n"
+"    pushq %r14\n"
+"    pushq %r15\n"
+"    subq $8, %rsp\n"
+"    stmxcsr (%rsp)\n"
+"    fnstcw 4(%rsp)\n"
+"    movq %rsp, (%rdi)\n"
+"    movq %rsi, %rsp\n"
+"    ldmxcsr (%rsp)\n"
+"    fldcw 4(%rsp)\n"
+"    addq $8, %rsp\n"
+"    popq %r15\n"
+"    popq %r14\n"
+"    popq %r13\n"
+"    popq %r12\n"
+"    popq %rbx\n"
+"    popq %rbp\n"
+"    ret\n"
+".p2align 4\n"
+"fred_coroutine_start:\n"
+"    movq %r12, %rdi\n"
+"    callq *%r13\n"
+"    ud2\n"
+);
+
+internal void
+coroutine__pass_control(Coroutine *me, Coroutine *other,
+                        Coroutine_State my_new_state, Coroutine_Pass_Control control){
+    Assert(me->state == CoroutineState_Active);
+    Assert(me->sys == other->sys);
+    
+    me->state = my_new_state;
+    other->state = CoroutineState_Active;
+    me->sys->active = other;
+    // NOTE: Even when the caller is exiting its stack is saved here, a dead
+    // coroutine picks up from this point the next time it is run.
+    coroutine__switch(&me->stack_pointer, other->stack_pointer);
+}
+
+internal void
+coroutine_main(Coroutine *me){
+    Thread_Context_Extra_Info tctx_info = {};
+    tctx_info.coroutine = me;
+    
+    Thread_Context tctx_ = {};
+    thread_ctx_init(&tctx_, ThreadKind_MainCoroutine,
+                    get_base_allocator_system(), get_base_allocator_system());
+    tctx_.user_data = &tctx_info;
+    // NOTE: All coroutines share the main thread, give each its own profile thread.
+    tctx_.prof_thread_id = -me->id;
+    me->tctx = &tctx_;
+    
+    for (;;){
+        Assert(me->state == CoroutineState_Active);
+        Assert(me->type != CoroutineType_Root);
+        Assert(me->yield_ctx != 0);
+        Assert(me->func != 0);
+        
+        me->func(me);
+        
+        // NOTE(allen): Wake up the caller and set this coroutine back to being dead.
+        Coroutine *other = me->yield_ctx;
+        Assert(other != 0);
+        Assert(other->state == CoroutineState_Waiting);
+        
+        me->func = 0;
+        coroutine__pass_control(me, other, CoroutineState_Dead, CoroutinePassControl_ExitMe);
+    }
+}
+
+internal void
+coroutine_sub_init(Coroutine *co, Coroutine_Group *sys){
+    block_zero_struct(co);
+    co->sys = sys;
+    co->state = CoroutineState_Dead;
+    co->type = CoroutineType_Sub;
+    sys->sub_count += 1;
+    co->id = sys->sub_count;
+    
+    // NOTE: The stack grows down toward a page with no access, so running off the
+    // end faults right away instead of writing over whatever memory is below it.
+    co->stack_memory_size = COROUTINE_STACK_SIZE + COROUTINE_GUARD_SIZE*2;
+    co->stack_memory = (u8*)system_memory_allocate(co->stack_memory_size, string_u8_litexpr(file_name_line_number));
+    u8 *guard = (u8*)round_up_u64(PtrAsInt(co->stack_memory), COROUTINE_GUARD_SIZE);
+    system_memory_set_protection(guard, COROUTINE_GUARD_SIZE, 0);
+    
+    u32 control_words[2] = {};
+    __asm__ volatile("stmxcsr %0\n\tfnstcw %1" : "=m"(control_words[0]), "=m"(control_words[1]));
+    
+    u64 *top = (u64*)(PtrAsInt(co->stack_memory + co->stack_memory_size) & ~(u64)15);
+    u64 *sp = top - 8;
+    sp[0] = control_words[0] | ((u64)control_words[1] << 32);
+    sp[1] = 0;
+    sp[2] = 0;
+    sp[3] = (u64)coroutine_main;
+    sp[4] = (u64)PtrAsInt(co);
+    sp[5] = 0;
+    sp[6] = 0;
+    sp[7] = (u64)coroutine__start;
+    co->stack_pointer = sp;
+}
+
+#endif
+
 internal void
 coroutine_system_init(Coroutine_Group *sys){
     sys->arena = make_arena_system();
     
     Coroutine *root = &sys->root;
     
+#if FRED_COROUTINE_THREADS
     sys->lock = system_mutex_make();
     sys->init_cv = system_condition_variable_make();
+#endif
     sys->active = root;
     
     block_zero_struct(root);
     root->sys = sys;
     root->state = CoroutineState_Active;
     root->type = CoroutineType_Root;
+#if FRED_COROUTINE_THREADS
     root->cv = system_condition_variable_make();
+#endif
     
     sys->unused = 0;
     
+#if FRED_COROUTINE_THREADS
     system_mutex_acquire(sys->lock);
+#endif
 }
 
 internal Coroutine*
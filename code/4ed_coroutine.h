@@ -3,7 +3,7 @@
  *
  * 03.08.2019
  *
- * Coroutine implementation from thread+mutex+cv
+ * Coroutine implementation from thread+mutex+cv or from stack switching
  *
  */
 
@@ -12,6 +12,21 @@
 #if !defined(FRED_COROUTINE_H)
 #define FRED_COROUTINE_H
 
+// NOTE: Where it is supported coroutines switch stacks on the calling thread, so
+// passing control costs a few dozen instructions instead of two trips through the
+// kernel.  Build with FRED_COROUTINE_THREADS defined to 1 to give every coroutine its
+// own thread again.
+#if !defined(FRED_COROUTINE_THREADS)
+# if ARCH_X64 && (OS_LINUX || OS_MAC)
+#  define FRED_COROUTINE_THREADS 0
+# else
+#  define FRED_COROUTINE_THREADS 1
+# endif
+#endif
+
+#define COROUTINE_STACK_SIZE MB(8)
+#define COROUTINE_GUARD_SIZE KB(4)
+
 typedef void Coroutine_Function(struct Coroutine *head);
 
 typedef u32 Coroutine_State;
@@ -34,8 +49,15 @@ struct Coroutine{
     Thread_Context *tctx;
     void *in;
     void *out;
+#if FRED_COROUTINE_THREADS
     System_Thread thread;
     System_Condition_Variable cv;
+#else
+    void *stack_pointer;
+    u8 *stack_memory;
+    u64 stack_memory_size;
+    i32 id;
+#endif
     struct Coroutine_Group *sys;
     Coroutine_Function *func;
     Coroutine *yield_ctx;
@@ -46,9 +68,13 @@ struct Coroutine{
 
 struct Coroutine_Group{
     Arena arena;
+#if FRED_COROUTINE_THREADS
     System_Mutex lock;
     System_Condition_Variable init_cv;
     b32 did_init;
+#else
+    i32 sub_count;
+#endif
     Coroutine *active;
     Coroutine *unused;
     Coroutine root;
@@ -118,6 +118,288 @@ dynamic_variable_erase(Dynamic_Variable_Block *block, Managed_ID id){
 
 ////////////////////////////////
 
+internal void
+marker_index__push_shift(Marker_Node *node){
+    if (node->shift != 0){
+        node->pos += node->shift;
+        if (node->left != 0){
+            node->left->shift += node->shift;
+        }
+        if (node->right != 0){
+            node->right->shift += node->shift;
+        }
+        node->shift = 0;
+    }
+}
+
+internal void
+marker_index__push_path(Marker_Node *node){
+    if (node->parent != 0){
+        marker_index__push_path(node->parent);
+    }
+    marker_index__push_shift(node);
+}
+
+// NOTE: Splits into nodes before pos and nodes at or after pos, or with
+// inclusive set, nodes at or before pos and nodes after pos.
+internal void
+marker_index__split(Marker_Node *node, i64 pos, b32 inclusive, Marker_Node **l_out, Marker_Node **r_out){
+    if (node == 0){
+        *l_out = 0;
+        *r_out = 0;
+    }
+    else{
+        marker_index__push_shift(node);
+        node->parent = 0;
+        if (node->pos < pos || (inclusive && node->pos == pos)){
+            marker_index__split(node->right, pos, inclusive, &node->right, r_out);
+            if (node->right != 0){
+                node->right->parent = node;
+            }
+            *l_out = node;
+        }
+        else{
+            marker_index__split(node->left, pos, inclusive, l_out, &node->left);
+            if (node->left != 0){
+                node->left->parent = node;
+            }
+            *r_out = node;
+        }
+    }
+}
+
+internal Marker_Node*
+marker_index__merge(Marker_Node *a, Marker_Node *b){
+    Marker_Node *result = 0;
+    if (a == 0){
+        result = b;
+    }
+    else if (b == 0){
+        result = a;
+    }
+    else if (a->priority > b->priority){
+        marker_index__push_shift(a);
+        a->right = marker_index__merge(a->right, b);
+        a->right->parent = a;
+        result = a;
+    }
+    else{
+        marker_index__push_shift(b);
+        b->left = marker_index__merge(a, b->left);
+        b->left->parent = b;
+        result = b;
+    }
+    return(result);
+}
+
+internal void
+marker_index__assign(Marker_Node *node, i64 pos){
+    if (node != 0){
+        node->pos = pos;
+        node->shift = 0;
+        marker_index__assign(node->left, pos);
+        marker_index__assign(node->right, pos);
+    }
+}
+
+internal i64
+marker_index__node_pos(Marker_Node *node){
+    i64 result = node->pos;
+    for (Marker_Node *n = node; n != 0; n = n->parent){
+        result += n->shift;
+    }
+    return(result);
+}
+
+internal void
+marker_index__insert(Buffer_Marker_Index *index, Marker_Node *node, i64 pos, b32 lean_right){
+    u32 x = index->priority_state;
+    if (x == 0){
+        x = 0x9E3779B9;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    index->priority_state = x;
+    
+    block_zero_struct(node);
+    node->pos = pos;
+    node->priority = x;
+    node->placed = true;
+    
+    Marker_Node **root = &index->root[lean_right?1:0];
+    Marker_Node *l = 0;
+    Marker_Node *r = 0;
+    marker_index__split(*root, pos, true, &l, &r);
+    *root = marker_index__merge(marker_index__merge(l, node), r);
+    (*root)->parent = 0;
+}
+
+internal void
+marker_index__remove(Buffer_Marker_Index *index, Marker_Node *node){
+    marker_index__push_path(node);
+    Marker_Node *parent = node->parent;
+    Marker_Node *sub = marker_index__merge(node->left, node->right);
+    if (sub != 0){
+        sub->parent = parent;
+    }
+    if (parent == 0){
+        if (index->root[0] == node){
+            index->root[0] = sub;
+        }
+        else{
+            Assert(index->root[1] == node);
+            index->root[1] = sub;
+        }
+    }
+    else if (parent->left == node){
+        parent->left = sub;
+    }
+    else{
+        parent->right = sub;
+    }
+    block_zero_struct(node);
+}
+
+// NOTE: Mirrors buffer_update_cursors_lean_l/_r.  The batch's ranges are all in the
+// coordinates from before the batch, so each tree is cut into the markers already
+// moved (done) and the ones still in old coordinates (rest).  Each edit moves the
+// markers before its range and the ones inside it from rest to done, so a marker
+// is only ever matched against the first edit that reaches it.
+internal void
+marker_index_apply_batch(Buffer_Marker_Index *index, Batch_Edit *batch){
+    for (i32 lean_right = 0; lean_right < 2; lean_right += 1){
+        Marker_Node *done = 0;
+        Marker_Node *rest = index->root[lean_right];
+        i64 shift_amount = 0;
+        for (Batch_Edit *edit = batch; edit != 0 && rest != 0; edit = edit->next){
+            Range_i64 range = edit->edit.range;
+            i64 len = edit->edit.text.size;
+            Marker_Node *before = 0;
+            Marker_Node *inside = 0;
+            Marker_Node *after = 0;
+            marker_index__split(rest, range.first, false, &before, &after);
+            marker_index__split(after, range.one_past_last, !lean_right, &inside, &rest);
+            if (before != 0){
+                before->shift += shift_amount;
+            }
+            marker_index__assign(inside, range.first + shift_amount + (lean_right?len:0));
+            done = marker_index__merge(marker_index__merge(done, before), inside);
+            shift_amount += len - (range.one_past_last - range.first);
+        }
+        if (rest != 0){
+            rest->shift += shift_amount;
+        }
+        Marker_Node *root = marker_index__merge(done, rest);
+        if (root != 0){
+            root->parent = 0;
+        }
+        index->root[lean_right] = root;
+    }
+    index->edit_counter += 1;
+}
+
+////////////////////////////////
+
+internal Marker*
+buffer_markers_get_markers(Managed_Buffer_Markers_Header *header){
+    return((Marker*)(header + 1));
+}
+
+internal Marker_Node*
+buffer_markers_get_nodes(Managed_Buffer_Markers_Header *header){
+    Marker *markers = buffer_markers_get_markers(header);
+    return((Marker_Node*)(markers + header->std_header.count));
+}
+
+internal b32
+buffer_markers_is_indexed(Managed_Buffer_Markers_Header *header){
+    return(header->index != 0 && !header->is_raw);
+}
+
+internal void
+buffer_markers_sync(Managed_Buffer_Markers_Header *header, u32 first_index, u32 count){
+    if (buffer_markers_is_indexed(header) &&
+        header->synced_edit_counter != header->index->edit_counter){
+        Marker *markers = buffer_markers_get_markers(header);
+        Marker_Node *nodes = buffer_markers_get_nodes(header);
+        for (u32 i = first_index; i < first_index + count; i += 1){
+            if (nodes[i].placed){
+                markers[i].pos = marker_index__node_pos(&nodes[i]);
+            }
+        }
+        if (first_index == 0 && count == header->std_header.count){
+            header->synced_edit_counter = header->index->edit_counter;
+        }
+    }
+}
+
+internal void
+buffer_markers_store(Managed_Buffer_Markers_Header *header, u32 first_index, u32 count, Marker *src){
+    Marker *markers = buffer_markers_get_markers(header);
+    block_copy_dynamic_array(markers + first_index, src, count);
+    if (buffer_markers_is_indexed(header)){
+        Buffer_Marker_Index *index = header->index;
+        Marker_Node *nodes = buffer_markers_get_nodes(header);
+        for (u32 i = first_index; i < first_index + count; i += 1){
+            if (nodes[i].placed){
+                marker_index__remove(index, &nodes[i]);
+            }
+            marker_index__insert(index, &nodes[i], markers[i].pos, markers[i].lean_right);
+        }
+    }
+}
+
+internal void
+buffer_markers__unplace_all(Managed_Buffer_Markers_Header *header){
+    Buffer_Marker_Index *index = header->index;
+    Marker_Node *nodes = buffer_markers_get_nodes(header);
+    u32 count = header->std_header.count;
+    for (u32 i = 0; i < count; i += 1){
+        if (nodes[i].placed){
+            marker_index__remove(index, &nodes[i]);
+        }
+    }
+}
+
+internal void
+buffer_markers_make_raw(Managed_Buffer_Markers_Header *header){
+    if (buffer_markers_is_indexed(header)){
+        Buffer_Marker_Index *index = header->index;
+        buffer_markers_sync(header, 0, header->std_header.count);
+        buffer_markers__unplace_all(header);
+        header->is_raw = true;
+        zdll_push_back_NP_(index->first_raw, index->last_raw, header, raw_next, raw_prev);
+        index->raw_marker_count += header->std_header.count;
+    }
+}
+
+internal void
+buffer_markers_release(Managed_Buffer_Markers_Header *header){
+    Buffer_Marker_Index *index = header->index;
+    if (index != 0){
+        if (header->is_raw){
+            zdll_remove_NP_(index->first_raw, index->last_raw, header, raw_next, raw_prev);
+            index->raw_marker_count -= header->std_header.count;
+        }
+        else{
+            buffer_markers__unplace_all(header);
+        }
+        header->index = 0;
+    }
+}
+
+internal void
+dynamic_workspace__release_buffer_markers(Dynamic_Workspace *workspace){
+    for (Managed_Buffer_Markers_Header *node = workspace->buffer_markers_list.first;
+         node != 0;
+         node = node->next){
+        buffer_markers_release(node);
+    }
+}
+
+////////////////////////////////
+
 internal void
 lifetime_allocator_init(Base_Allocator *base_allocator, Lifetime_Allocator *lifetime_allocator){
     block_zero_struct(lifetime_allocator);
@@ -149,12 +431,14 @@ dynamic_workspace_init(Lifetime_Allocator *lifetime_allocator, i32 user_type, vo
 
 internal void
 dynamic_workspace_free(Lifetime_Allocator *lifetime_allocator, Dynamic_Workspace *workspace){
+    dynamic_workspace__release_buffer_markers(workspace);
     table_erase(&lifetime_allocator->scope_id_to_scope_ptr_table, workspace->scope_id);
     heap_free_all(&workspace->heap);
 }
 
 internal void
 dynamic_workspace_clear_contents(Dynamic_Workspace *workspace){
+    dynamic_workspace__release_buffer_markers(workspace);
     Base_Allocator *base_allocator = heap_get_base_allocator(&workspace->heap);
     heap_free_all(&workspace->heap);
     heap_init(&workspace->heap, base_allocator);
@@ -485,10 +769,11 @@ managed_object_alloc_managed_memory(Dynamic_Workspace *workspace, i32 item_size,
 }
 
 internal Managed_Object
-managed_object_alloc_buffer_markers(Dynamic_Workspace *workspace, Buffer_ID buffer_id, i32 count, Marker **markers_out){
-    i32 size = count*sizeof(Marker);
+managed_object_alloc_buffer_markers(Dynamic_Workspace *workspace, Buffer_ID buffer_id, Buffer_Marker_Index *index, i32 count, Marker **markers_out){
+    i32 size = count*(sizeof(Marker) + sizeof(Marker_Node));
     String_Const_u8 new_memory = base_allocate(&workspace->heap_wrapper, size + sizeof(Managed_Buffer_Markers_Header));
     void *ptr = new_memory.str;
+    block_zero(ptr, size + sizeof(Managed_Buffer_Markers_Header));
     Managed_Buffer_Markers_Header *header = (Managed_Buffer_Markers_Header*)ptr;
     header->std_header.type = ManagedObjectType_Markers;
     header->std_header.item_size = sizeof(Marker);
@@ -497,6 +782,10 @@ managed_object_alloc_buffer_markers(Dynamic_Workspace *workspace, Buffer_ID buff
     workspace->buffer_markers_list.count += 1;
     workspace->total_marker_count += count;
     header->buffer_id = buffer_id;
+    header->index = index;
+    if (index != 0){
+        header->synced_edit_counter = index->edit_counter;
+    }
     if (markers_out != 0){
         *markers_out = (Marker*)get_dynamic_object_memory_ptr(&header->std_header);
     }
@@ -515,6 +804,7 @@ managed_object_free(Dynamic_Workspace *workspace, Managed_Object object){
             case ManagedObjectType_Markers:
             {
                 Managed_Buffer_Markers_Header *header = (Managed_Buffer_Markers_Header*)object_ptr;
+                buffer_markers_release(header);
                 workspace->total_marker_count -= header->std_header.count;
                 zdll_remove(workspace->buffer_markers_list.first, workspace->buffer_markers_list.last, header);
                 workspace->buffer_markers_list.count -= 1;
@@ -25,11 +25,44 @@ struct Managed_Memory_Header{
     Managed_Object_Standard_Header std_header;
 };
 
+// NOTE: Every marker on a buffer owns a node in one of the buffer's two
+// treaps (one per lean direction), ordered by position.  A node's true position
+// is its pos plus the shift of itself and every ancestor, so an edit only has to
+// split out the markers inside the edited range and add one shift to the root of
+// everything after it.
+struct Marker_Node{
+    Marker_Node *parent;
+    Marker_Node *left;
+    Marker_Node *right;
+    i64 pos;
+    i64 shift;
+    u32 priority;
+    b32 placed;
+};
+
+struct Managed_Buffer_Markers_Header;
+
+// NOTE: Marker objects handed out by pointer can be written at any time,
+// so they leave the treaps and go back to being sorted and shifted on each edit.
+struct Buffer_Marker_Index{
+    Marker_Node *root[2];
+    u32 priority_state;
+    u64 edit_counter;
+    Managed_Buffer_Markers_Header *first_raw;
+    Managed_Buffer_Markers_Header *last_raw;
+    i32 raw_marker_count;
+};
+
 struct Managed_Buffer_Markers_Header{
     Managed_Object_Standard_Header std_header;
     Managed_Buffer_Markers_Header *next;
     Managed_Buffer_Markers_Header *prev;
     Buffer_ID buffer_id;
+    b32 is_raw;
+    Buffer_Marker_Index *index;
+    Managed_Buffer_Markers_Header *raw_next;
+    Managed_Buffer_Markers_Header *raw_prev;
+    u64 synced_edit_counter;
 };
 
 struct Managed_Arena_Header{
@@ -35,14 +35,13 @@ post_edit_call_hook(Thread_Context *tctx, Models *models, Editing_File *file,
 }
 
 function void
-edit_fix_markers__write_workspace_markers(Dynamic_Workspace *workspace, Buffer_ID buffer_id,
-                                          Cursor_With_Index *cursors, Cursor_With_Index *r_cursors,
-                                          i32 *cursor_count, i32 *r_cursor_count){
-    for (Managed_Buffer_Markers_Header *node = workspace->buffer_markers_list.first;
+edit_fix_markers__write_raw_markers(Buffer_Marker_Index *index,
+                                    Cursor_With_Index *cursors, Cursor_With_Index *r_cursors,
+                                    i32 *cursor_count, i32 *r_cursor_count){
+    for (Managed_Buffer_Markers_Header *node = index->first_raw;
          node != 0;
-         node = node->next){
-        if (node->buffer_id != buffer_id) continue;
-        Marker *markers = (Marker*)(node + 1);
+         node = node->raw_next){
+        Marker *markers = buffer_markers_get_markers(node);
         Assert(sizeof(*markers) == node->std_header.item_size);
         i32 count = node->std_header.count;
         for (i32 i = 0; i < count; i += 1){
@@ -57,13 +56,13 @@ edit_fix_markers__write_workspace_markers(Dynamic_Workspace *workspace, Buffer_I
 }
 
 function void
-edit_fix_markers__read_workspace_markers(Dynamic_Workspace *workspace, Buffer_ID buffer_id,
-                                         Cursor_With_Index *cursors, Cursor_With_Index *r_cursors, i32 *cursor_count, i32 *r_cursor_count){
-    for (Managed_Buffer_Markers_Header *node = workspace->buffer_markers_list.first;
+edit_fix_markers__read_raw_markers(Buffer_Marker_Index *index,
+                                   Cursor_With_Index *cursors, Cursor_With_Index *r_cursors,
+                                   i32 *cursor_count, i32 *r_cursor_count){
+    for (Managed_Buffer_Markers_Header *node = index->first_raw;
          node != 0;
-         node = node->next){
-        if (node->buffer_id != buffer_id) continue;
-        Marker *markers = (Marker*)(node + 1);
+         node = node->raw_next){
+        Marker *markers = buffer_markers_get_markers(node);
         Assert(sizeof(*markers) == node->std_header.item_size);
         i32 count = node->std_header.count;
         for (i32 i = 0; i < count; i += 1){
@@ -93,29 +92,13 @@ function void
 edit_fix_markers(Thread_Context *tctx, Models *models, Editing_File *file, Batch_Edit *batch){
     Layout *layout = &models->layout;
     
-    Lifetime_Object *file_lifetime_object = file->lifetime_object;
-    Buffer_ID file_id = file->id;
-    Assert(file_lifetime_object != 0);
+    // NOTE: Indexed markers only pay for the ranges this batch touches;
+    // view cursors and markers handed out by pointer still go through the sort.
+    Buffer_Marker_Index *marker_index = &file->state.markers;
+    marker_index_apply_batch(marker_index, batch);
     
     i32 cursor_max = layout_get_open_panel_count(layout)*4;
-    i32 total_marker_count = 0;
-    {
-        total_marker_count += file_lifetime_object->workspace.total_marker_count;
-        
-        i32 key_count = file_lifetime_object->key_count;
-        i32 key_index = 0;
-        for (Lifetime_Key_Ref_Node *key_node = file_lifetime_object->key_node_first;
-             key_node != 0;
-             key_node = key_node->next){
-            i32 count = clamp_top(lifetime_key_reference_per_node, key_count - key_index);
-            for (i32 i = 0; i < count; i += 1){
-                Lifetime_Key *key = key_node->keys[i];
-                total_marker_count += key->dynamic_workspace.total_marker_count;
-            }
-            key_index += count;
-        }
-    }
-    cursor_max += total_marker_count;
+    cursor_max += marker_index->raw_marker_count;
     
     Scratch_Block scratch(tctx);
     
@@ -141,22 +124,7 @@ edit_fix_markers(Thread_Context *tctx, Models *models, Editing_File *file, Batch
         }
     }
     
-    edit_fix_markers__write_workspace_markers(&file_lifetime_object->workspace, file_id, cursors, r_cursors, &cursor_count, &r_cursor_count);
-    
-    {
-        i32 key_count = file_lifetime_object->key_count;
-        i32 key_index = 0;
-        for (Lifetime_Key_Ref_Node *key_node = file_lifetime_object->key_node_first;
-             key_node != 0;
-             key_node = key_node->next){
-            i32 count = clamp_top(lifetime_key_reference_per_node, key_count - key_index);
-            for (i32 i = 0; i < count; i += 1){
-                Lifetime_Key *key = key_node->keys[i];
-                edit_fix_markers__write_workspace_markers(&key->dynamic_workspace, file_id, cursors, r_cursors, &cursor_count, &r_cursor_count);
-            }
-            key_index += count;
-        }
-    }
+    edit_fix_markers__write_raw_markers(marker_index, cursors, r_cursors, &cursor_count, &r_cursor_count);
     
     buffer_remeasure_starts(tctx, &file->state.buffer, batch);
     
@@ -194,20 +162,7 @@ edit_fix_markers(Thread_Context *tctx, Models *models, Editing_File *file, Batch
             }
         }
         
-        edit_fix_markers__read_workspace_markers(&file_lifetime_object->workspace, file_id, cursors, r_cursors, &cursor_count, &r_cursor_count);
-        
-        i32 key_count = file_lifetime_object->key_count;
-        i32 key_index = 0;
-        for (Lifetime_Key_Ref_Node *key_node = file_lifetime_object->key_node_first;
-             key_node != 0;
-             key_node = key_node->next){
-            i32 count = clamp_top(lifetime_key_reference_per_node, key_count - key_index);
-            for (i32 i = 0; i < count; i += 1){
-                Lifetime_Key *key = key_node->keys[i];
-                edit_fix_markers__read_workspace_markers(&key->dynamic_workspace, file_id, cursors, r_cursors, &cursor_count, &r_cursor_count);
-            }
-            key_index += count;
-        }
+        edit_fix_markers__read_raw_markers(marker_index, cursors, r_cursors, &cursor_count, &r_cursor_count);
     }
 }
 
@@ -244,6 +199,15 @@ edit__apply(Thread_Context *tctx, Models *models, Editing_File *file, Range_i64
             history_get_record_count(&file->state.history);
     }
     
+    // NOTE: layout cache update
+    if (file->state.cached_layout_count > 0){
+        ProfileTLBlock(tctx, &models->profile_list, "edit apply layout cache");
+        i64 first_line = buffer_get_line_index(buffer, edit.range.first) + 1;
+        i64 last_line = buffer_get_line_index(buffer, edit.range.one_past_last) + 1;
+        i64 line_shift = count_lines(edit.text) - (last_line - first_line);
+        file_shift_layout_cache(file, first_line, last_line, line_shift);
+    }
+    
     {
         ProfileTLBlock(tctx, &models->profile_list, "edit apply replace range");
         i64 shift_amount = replace_range_shift(edit.range, (i64)edit.text.size);
@@ -263,8 +227,6 @@ edit_single(Thread_Context *tctx, Models *models, Editing_File *file,
     
     edit__apply(tctx, models, file, range, string, behaviors);
     
-    file_clear_layout_cache(file);
-    
     Batch_Edit batch = {};
     batch.edit.text = string;
     batch.edit.range = range;
@@ -273,6 +235,155 @@ edit_single(Thread_Context *tctx, Models *models, Editing_File *file,
     post_edit_call_hook(tctx, models, file, Ii64_size(range.first, string.size), cursor_range);
 }
 
+function b32
+edit_batch_check(Thread_Context *tctx, Profile_Global_List *list, Batch_Edit *batch){
+    ProfileTLScope(tctx, list, "batch check");
+    b32 result = true;
+    Range_i64 prev_range = Ii64(-1, 0);
+    for (;batch != 0;
+         batch = batch->next){
+        if (batch->edit.range.first < prev_range.one_past_last ||
+            batch->edit.range.first > batch->edit.range.one_past_last){
+            result = false;
+            break;
+        }
+        prev_range = batch->edit.range;
+    }
+    return(result);
+}
+
+// NOTE: A batch lands in one pass: the history gets one group record, the layout
+// cache is shifted once, the buffer is rebuilt in one sweep, and the line index and the
+// markers are updated once for the whole batch.
+function b32
+edit_batch(Thread_Context *tctx, Models *models, Editing_File *file,
+           Batch_Edit *batch, Edit_Behaviors behaviors){
+    b32 result = true;
+    if (batch != 0){
+        Gap_Buffer *buffer = &file->state.buffer;
+        
+        i32 batch_count = 0;
+        Batch_Edit *last = batch;
+        for (Batch_Edit *edit = batch;
+             edit != 0;
+             edit = edit->next){
+            batch_count += 1;
+            last = edit;
+        }
+        
+        if (!edit_batch_check(tctx, &models->profile_list, batch) ||
+            last->edit.range.one_past_last > buffer_size(buffer)){
+            result = false;
+        }
+        else{
+            ProfileTLScope(tctx, &models->profile_list, "batch apply");
+            Scratch_Block scratch(tctx);
+            
+            pre_edit_state_change(models, file);
+            pre_edit_history_prep(file, behaviors);
+            
+            Range_i64 old_range = Ii64(batch->edit.range.min, last->edit.range.max);
+            Range_Cursor cursor_range = {};
+            cursor_range.min = file_compute_cursor(file, seek_pos(old_range.min));
+            cursor_range.max = file_compute_cursor(file, seek_pos(old_range.max));
+            
+            Range_i64 new_range = Ii64_neg_inf;
+            {
+                i64 shift = 0;
+                for (Batch_Edit *edit = batch;
+                     edit != 0;
+                     edit = edit->next){
+                    i64 new_first = edit->edit.range.first + shift;
+                    new_range.min = Min(new_range.min, new_first);
+                    new_range.max = Max(new_range.max, new_first + (i64)edit->edit.text.size);
+                    shift += replace_range_shift(edit->edit.range, (i64)edit->edit.text.size);
+                }
+            }
+            
+            if (!behaviors.do_not_post_to_history){
+                ProfileTLBlock(tctx, &models->profile_list, "batch history");
+                if (batch_count == 1){
+                    history_record_edit(&models->global_history, &file->state.history, buffer,
+                                        behaviors.pos_before_edit, batch->edit);
+                }
+                else{
+                    history_record_batch(scratch, &models->global_history, &file->state.history, buffer,
+                                         behaviors.pos_before_edit, batch);
+                }
+                file->state.current_record_index =
+                    history_get_record_count(&file->state.history);
+            }
+            
+            if (file->state.cached_layout_count > 0){
+                ProfileTLBlock(tctx, &models->profile_list, "batch layout cache");
+                Temp_Memory temp = begin_temp(scratch);
+                Layout_Cache_Shift *shifts = push_array(scratch, Layout_Cache_Shift, batch_count);
+                i64 total_shift = 0;
+                i32 i = 0;
+                for (Batch_Edit *edit = batch;
+                     edit != 0;
+                     edit = edit->next, i += 1){
+                    Layout_Cache_Shift *shift = &shifts[i];
+                    shift->first_line = buffer_get_line_index(buffer, edit->edit.range.first) + 1;
+                    shift->last_line = buffer_get_line_index(buffer, edit->edit.range.one_past_last) + 1;
+                    total_shift += count_lines(edit->edit.text) - (shift->last_line - shift->first_line);
+                    shift->total_shift = total_shift;
+                }
+                file_shift_layout_cache(file, shifts, batch_count);
+                end_temp(temp);
+            }
+            
+            {
+                ProfileTLBlock(tctx, &models->profile_list, "batch replace");
+                buffer_replace_batch(buffer, batch);
+            }
+            
+            edit_fix_markers(tctx, models, file, batch);
+            
+            post_edit_call_hook(tctx, models, file, new_range, cursor_range);
+        }
+    }
+    
+    return(result);
+}
+
+// NOTE: A group of single edits where each one lands at or after the text of the
+// one before it is a sorted batch, so it can be replayed in one pass.  Returns zero for
+// any other group.
+function Batch_Edit*
+edit__batch_from_group(Arena *arena, History *history, Record *record, b32 forward){
+    Batch_Edit *first = 0;
+    Batch_Edit *last = 0;
+    b32 is_sorted = true;
+    i64 shift = 0;
+    i64 prev_end = 0;
+    for (i32 i = 1; i <= record->group.count; i += 1){
+        Record *sub_record = history_get_sub_record(history, record, i);
+        if (sub_record->kind != RecordKind_Single || sub_record->single.first < prev_end){
+            is_sorted = false;
+            break;
+        }
+        i64 forward_size = (i64)sub_record->single.forward_text.size;
+        i64 backward_size = (i64)sub_record->single.backward_text.size;
+        Batch_Edit *edit = push_array_zero(arena, Batch_Edit, 1);
+        if (forward){
+            edit->edit.range = Ii64_size(sub_record->single.first - shift, backward_size);
+            edit->edit.text = history_get_forward_text(arena, history, sub_record);
+        }
+        else{
+            edit->edit.range = Ii64_size(sub_record->single.first, forward_size);
+            edit->edit.text = history_get_backward_text(arena, history, sub_record);
+        }
+        sll_queue_push(first, last, edit);
+        prev_end = sub_record->single.first + forward_size;
+        shift += forward_size - backward_size;
+    }
+    if (!is_sorted){
+        first = 0;
+    }
+    return(first);
+}
+
 function void
 edit__apply_record_forward(Thread_Context *tctx, Models *models, Editing_File *file, Record *record, Edit_Behaviors behaviors_prototype){
     // NOTE(allen): // NOTE(allen): // NOTE(allen): // NOTE(allen): // NOTE(allen):
@@ -281,19 +392,24 @@ edit__apply_record_forward(Thread_Context *tctx, Models *models, Editing_File *f
     switch (record->kind){
         case RecordKind_Single:
         {
-            String_Const_u8 str = record->single.forward_text;
+            Scratch_Block scratch(tctx);
+            String_Const_u8 str = history_get_forward_text(scratch, &file->state.history, record);
             Range_i64 range = Ii64(record->single.first, record->single.first + record->single.backward_text.size);
             edit_single(tctx, models, file, range, str, behaviors_prototype);
         }break;
         
         case RecordKind_Group:
         {
-            Node *sentinel = &record->group.children;
-            for (Node *node = sentinel->next;
-                 node != sentinel;
-                 node = node->next){
-                Record *sub_record = CastFromMember(Record, node, node);
-                edit__apply_record_forward(tctx, models, file, sub_record, behaviors_prototype);
+            Scratch_Block scratch(tctx);
+            Batch_Edit *batch = edit__batch_from_group(scratch, &file->state.history, record, true);
+            if (batch != 0){
+                edit_batch(tctx, models, file, batch, behaviors_prototype);
+            }
+            else{
+                for (i32 i = 1; i <= record->group.count; i += 1){
+                    Record *sub_record = history_get_sub_record(&file->state.history, record, i);
+                    edit__apply_record_forward(tctx, models, file, sub_record, behaviors_prototype);
+                }
             }
         }break;
         
@@ -312,19 +428,24 @@ edit__apply_record_backward(Thread_Context *tctx, Models *models, Editing_File *
     switch (record->kind){
         case RecordKind_Single:
         {
-            String_Const_u8 str = record->single.backward_text;
+            Scratch_Block scratch(tctx);
+            String_Const_u8 str = history_get_backward_text(scratch, &file->state.history, record);
             Range_i64 range = Ii64(record->single.first, record->single.first + record->single.forward_text.size);
             edit_single(tctx, models, file, range, str, behaviors_prototype);
         }break;
         
         case RecordKind_Group:
         {
-            Node *sentinel = &record->group.children;
-            for (Node *node = sentinel->prev;
-                 node != sentinel;
-                 node = node->prev){
-                Record *sub_record = CastFromMember(Record, node, node);
-                edit__apply_record_backward(tctx, models, file, sub_record, behaviors_prototype);
+            Scratch_Block scratch(tctx);
+            Batch_Edit *batch = edit__batch_from_group(scratch, &file->state.history, record, false);
+            if (batch != 0){
+                edit_batch(tctx, models, file, batch, behaviors_prototype);
+            }
+            else{
+                for (i32 i = record->group.count; i > 0; i -= 1){
+                    Record *sub_record = history_get_sub_record(&file->state.history, record, i);
+                    edit__apply_record_backward(tctx, models, file, sub_record, behaviors_prototype);
+                }
             }
         }break;
         
@@ -339,12 +460,9 @@ function void
 edit_change_current_history_state(Thread_Context *tctx, Models *models, Editing_File *file, i32 target_index){
     History *history = &file->state.history;
     if (history->activated && file->state.current_record_index != target_index){
-        Assert(0 <= target_index && target_index <= history->record_count);
+        Assert(0 <= target_index && target_index <= history_get_record_count(history));
         
         i32 current = file->state.current_record_index;
-        Record *record = history_get_record(history, current);
-        Assert(record != 0);
-        Record *dummy_record = history_get_dummy_record(history);
         
         Edit_Behaviors behaviors_prototype = {};
         behaviors_prototype.do_not_post_to_history = true;
@@ -353,17 +471,17 @@ edit_change_current_history_state(Thread_Context *tctx, Models *models, Editing_
         if (current < target_index){
             do{
                 current += 1;
-                record = CastFromMember(Record, node, record->node.next);
-                Assert(record != dummy_record);
+                Record *record = history_get_record(history, current);
+                Assert(record != 0);
                 edit__apply_record_forward(tctx, models, file, record, behaviors_prototype);
             } while (current != target_index);
         }
         else{
             do{
-                Assert(record != dummy_record);
+                Record *record = history_get_record(history, current);
+                Assert(record != 0);
                 edit__apply_record_backward(tctx, models, file, record, behaviors_prototype);
                 current -= 1;
-                record = CastFromMember(Record, node, record->node.prev);
             } while (current != target_index);
         }
         
@@ -419,119 +537,17 @@ edit_merge_history_range(Thread_Context *tctx, Models *models, Editing_File *fil
     return(result);
 }
 
-function b32
-edit_batch_check(Thread_Context *tctx, Profile_Global_List *list, Batch_Edit *batch){
-    ProfileTLScope(tctx, list, "batch check");
-    b32 result = true;
-    Range_i64 prev_range = Ii64(-1, 0);
-    for (;batch != 0;
-         batch = batch->next){
-        if (batch->edit.range.first <= prev_range.first ||
-            batch->edit.range.first < prev_range.one_past_last){
-            result = false;
-            break;
-        }
-    }
-    return(result);
-}
-
-function b32
-edit_batch(Thread_Context *tctx, Models *models, Editing_File *file,
-           Batch_Edit *batch, Edit_Behaviors behaviors){
-    b32 result = true;
-    if (batch != 0){
-        if (!edit_batch_check(tctx, &models->profile_list, batch)){
-            result = false;
-        }
-        else{
-            ProfileTLScope(tctx, &models->profile_list, "batch apply");
-            
-            pre_edit_state_change(models, file);
-            pre_edit_history_prep(file, behaviors);
-            
-            History_Record_Index start_index = 0;
-            if (history_is_activated(&file->state.history)){
-                start_index = file->state.current_record_index;
-            }
-            
-            ProfileTLBlockNamed(tctx, &models->profile_list, "batch text edits", profile_edits);
-            
-            Range_i64 old_range = {};
-            old_range.min = batch->edit.range.min;
-            for (Batch_Edit *edit = batch;
-                 edit != 0;
-                 edit = edit->next){
-                if (edit->next == 0){
-                    old_range.max = edit->edit.range.max;
-                }
-            }
-            Range_Cursor cursor_range = {};
-            cursor_range.min = file_compute_cursor(file, seek_pos(old_range.min));
-            cursor_range.max = file_compute_cursor(file, seek_pos(old_range.max));
-            
-            Range_i64 new_range = Ii64_neg_inf;
-            Gap_Buffer *buffer = &file->state.buffer;
-            
-            i32 batch_count = 0;
-            i64 shift = 0;
-            for (Batch_Edit *edit = batch;
-                 edit != 0;
-                 edit = edit->next){
-                String_Const_u8 insert_string = edit->edit.text;
-                
-                Range_i64 edit_range = edit->edit.range;
-                edit_range.first += shift;
-                edit_range.one_past_last += shift;
-                
-                new_range.min = Min(new_range.min, edit_range.min);
-                i64 new_max = (i64)(edit_range.min + insert_string.size);
-                new_range.max = Max(new_range.max, new_max);
-                
-                i64 size = buffer_size(buffer);
-                if (0 <= edit_range.first &&
-                    edit_range.first <= edit_range.one_past_last &&
-                    edit_range.one_past_last <= size){
-                    edit__apply(tctx, models, file, edit_range, insert_string,
-                                behaviors);
-                    shift += replace_range_shift(edit_range, insert_string.size);
-                    batch_count += 1;
-                }
-                else{
-                    result = false;
-                    break;
-                }
-            }
-            ProfileCloseNow(profile_edits);
-            
-            if (history_is_activated(&file->state.history)){
-                History_Record_Index last_index = file->state.current_record_index;
-                if (start_index + 1 < last_index){
-                    edit_merge_history_range(tctx, models, file,
-                                             start_index + 1, last_index,
-                                             RecordMergeFlag_StateInRange_ErrorOut);
-                }
-            }
-            
-            file_clear_layout_cache(file);
-            
-            edit_fix_markers(tctx, models, file, batch);
-            
-            post_edit_call_hook(tctx, models, file, new_range, cursor_range);
-        }
-    }
-    
-    return(result);
-}
-
 ////////////////////////////////
 
+// NOTE: With preloaded set the file's contents were already read by the caller,
+// the file system is only asked for the canonical name.
 function Editing_File*
-create_file(Thread_Context *tctx, Models *models, String_Const_u8 file_name, Buffer_Create_Flag flags){
+create_file(Thread_Context *tctx, Models *models, String_Const_u8 file_name, Buffer_Create_Flag flags,
+            String_Const_u8 *preloaded, File_Attributes preloaded_attributes){
     Editing_File *result = 0;
     
     if (file_name.size > 0){
         Working_Set *working_set = &models->working_set;
-        Heap *heap = &models->heap;
         
         Scratch_Block scratch(tctx);
         
@@ -568,6 +584,9 @@ create_file(Thread_Context *tctx, Models *models, String_Const_u8 file_name, Buf
                 if ((flags & BufferCreate_AlwaysNew) != 0){
                     do_empty_buffer = true;
                 }
+                else if (preloaded != 0){
+                    // NOTE: nothing to open
+                }
                 else{
                     if (!system_load_handle(scratch, (char*)canon.name_space, &handle)){
                         do_empty_buffer = true;
@@ -593,35 +612,33 @@ create_file(Thread_Context *tctx, Models *models, String_Const_u8 file_name, Buf
                     }
                 }
             }
+            else if (preloaded != 0){
+                file = working_set_allocate_file(working_set, &models->lifetime_allocator);
+                if (file != 0){
+                    file_bind_file_name(working_set, file, string_from_file_name(&canon));
+                    String_Const_u8 front = string_front_of_path(file_name);
+                    buffer_bind_name(tctx, models, scratch, working_set, file, front);
+                    file_create_from_string(tctx, models, file, *preloaded, preloaded_attributes);
+                    result = file;
+                }
+            }
             else{
                 File_Attributes attributes = system_load_attributes(handle);
-                b32 in_heap_mem = false;
-                char *buffer = push_array(scratch, char, (i32)attributes.size);
-                
-                if (buffer == 0){
-                    buffer = heap_array(heap, char, (i32)attributes.size);
-                    Assert(buffer != 0);
-                    in_heap_mem = true;
-                }
+                File_Contents contents = file_load_contents(tctx->allocator, handle, attributes.size);
+                system_load_close(handle);
                 
-                if (system_load_file(handle, buffer, (i32)attributes.size)){
-                    system_load_close(handle);
+                if (contents.is_loaded){
                     file = working_set_allocate_file(working_set, &models->lifetime_allocator);
                     if (file != 0){
                         file_bind_file_name(working_set, file, string_from_file_name(&canon));
                         String_Const_u8 front = string_front_of_path(file_name);
                         buffer_bind_name(tctx, models, scratch, working_set, file, front);
-                        file_create_from_string(tctx, models, file, SCu8(buffer, (i32)attributes.size), attributes);
+                        file_create_from_string(tctx, models, file, contents.data, attributes);
                         result = file;
                     }
                 }
-                else{
-                    system_load_close(handle);
-                }
                 
-                if (in_heap_mem){
-                    heap_free(heap, buffer);
-                }
+                file_free_contents(tctx->allocator, &contents);
             }
         }
         else{
@@ -656,5 +673,11 @@ create_file(Thread_Context *tctx, Models *models, String_Const_u8 file_name, Buf
     return(result);
 }
 
+function Editing_File*
+create_file(Thread_Context *tctx, Models *models, String_Const_u8 file_name, Buffer_Create_Flag flags){
+    File_Attributes attributes = {};
+    return(create_file(tctx, models, file_name, flags, 0, attributes));
+}
+
 // BOTTOM
 
@@ -152,9 +152,10 @@ save_file_to_name(Thread_Context *tctx, Models *models, Editing_File *file, u8 *
             }
         }
         
-        String_Const_u8 saveable_string = buffer_stringify(scratch, buffer, Ii64(0, buffer_size(buffer)));
+        // NOTE: The platform layer writes the chunks straight out of the buffer.
+        List_String_Const_u8 chunks = buffer_get_chunks(scratch, buffer);
         
-        File_Attributes new_attributes = system_save_file(scratch, (char*)file_name, saveable_string);
+        File_Attributes new_attributes = system_save_file(scratch, (char*)file_name, chunks);
         if (new_attributes.last_write_time > 0 &&
             using_actual_file_name){
             file->state.saved_record_index = file->state.current_record_index;
@@ -188,11 +189,328 @@ file_compute_cursor(Editing_File *file, Buffer_Seek seek){
 
 ////////////////////////////////
 
+internal void
+file__layout_push_shift(Line_Layout_Node *node){
+    if (node->shift != 0){
+        node->key.line_number += node->shift;
+        if (node->left != 0){
+            node->left->shift += node->shift;
+        }
+        if (node->right != 0){
+            node->right->shift += node->shift;
+        }
+        node->shift = 0;
+    }
+}
+
+internal void
+file__layout_push_path(Line_Layout_Node *node){
+    if (node->parent != 0){
+        file__layout_push_path(node->parent);
+    }
+    file__layout_push_shift(node);
+}
+
+// NOTE: Splits into layouts of lines before line_number and layouts of lines at
+// or after line_number.
+internal void
+file__layout_split(Line_Layout_Node *node, i64 line_number, Line_Layout_Node **l_out, Line_Layout_Node **r_out){
+    if (node == 0){
+        *l_out = 0;
+        *r_out = 0;
+    }
+    else{
+        file__layout_push_shift(node);
+        node->parent = 0;
+        if (node->key.line_number < line_number){
+            file__layout_split(node->right, line_number, &node->right, r_out);
+            if (node->right != 0){
+                node->right->parent = node;
+            }
+            *l_out = node;
+        }
+        else{
+            file__layout_split(node->left, line_number, l_out, &node->left);
+            if (node->left != 0){
+                node->left->parent = node;
+            }
+            *r_out = node;
+        }
+    }
+}
+
+internal Line_Layout_Node*
+file__layout_merge(Line_Layout_Node *a, Line_Layout_Node *b){
+    Line_Layout_Node *result = 0;
+    if (a == 0){
+        result = b;
+    }
+    else if (b == 0){
+        result = a;
+    }
+    else if (a->priority > b->priority){
+        file__layout_push_shift(a);
+        a->right = file__layout_merge(a->right, b);
+        a->right->parent = a;
+        result = a;
+    }
+    else{
+        file__layout_push_shift(b);
+        b->left = file__layout_merge(a, b->left);
+        b->left->parent = b;
+        result = b;
+    }
+    return(result);
+}
+
+internal void
+file__layout_set_root(Editing_File *file, Line_Layout_Node *root){
+    file->state.layout_root = root;
+    if (root != 0){
+        root->parent = 0;
+    }
+}
+
+internal b32
+file__layout_key_match(Line_Layout_Key *a, Line_Layout_Key *b){
+    return(a->face_id == b->face_id &&
+           a->face_version_number == b->face_version_number &&
+           a->width == b->width &&
+           a->line_number == b->line_number);
+}
+
+// NOTE: Layouts of one line at different widths or faces share a line number, so
+// a match can be on either side of a node with the same line.
+internal Line_Layout_Node*
+file__layout_find(Line_Layout_Node *node, Line_Layout_Key *key){
+    Line_Layout_Node *result = 0;
+    if (node != 0){
+        file__layout_push_shift(node);
+        if (key->line_number < node->key.line_number){
+            result = file__layout_find(node->left, key);
+        }
+        else if (key->line_number > node->key.line_number){
+            result = file__layout_find(node->right, key);
+        }
+        else if (file__layout_key_match(&node->key, key)){
+            result = node;
+        }
+        else{
+            result = file__layout_find(node->left, key);
+            if (result == 0){
+                result = file__layout_find(node->right, key);
+            }
+        }
+    }
+    return(result);
+}
+
+internal void
+file__layout_insert(Editing_File *file, Line_Layout_Node *node){
+    u32 x = file->state.layout_priority_state;
+    if (x == 0){
+        x = 0x9E3779B9;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    file->state.layout_priority_state = x;
+    
+    node->parent = 0;
+    node->left = 0;
+    node->right = 0;
+    node->shift = 0;
+    node->priority = x;
+    
+    Line_Layout_Node *l = 0;
+    Line_Layout_Node *r = 0;
+    file__layout_split(file->state.layout_root, node->key.line_number, &l, &r);
+    file__layout_set_root(file, file__layout_merge(file__layout_merge(l, node), r));
+}
+
+internal void
+file__layout_remove(Editing_File *file, Line_Layout_Node *node){
+    file__layout_push_path(node);
+    Line_Layout_Node *parent = node->parent;
+    Line_Layout_Node *sub = file__layout_merge(node->left, node->right);
+    if (sub != 0){
+        sub->parent = parent;
+    }
+    if (parent == 0){
+        Assert(file->state.layout_root == node);
+        file->state.layout_root = sub;
+    }
+    else if (parent->left == node){
+        parent->left = sub;
+    }
+    else{
+        parent->right = sub;
+    }
+}
+
+internal void
+file__free_line_layout(Editing_File *file, Line_Layout_Node *node){
+    dll_remove(node);
+    linalloc_clear(&node->arena);
+    sll_stack_push(file->state.free_layouts, node);
+    file->state.cached_layout_count -= 1;
+}
+
+internal void
+file__free_line_layout_tree(Editing_File *file, Line_Layout_Node *node){
+    if (node != 0){
+        file__free_line_layout_tree(file, node->left);
+        file__free_line_layout_tree(file, node->right);
+        file__free_line_layout(file, node);
+    }
+}
+
+internal Line_Layout_Node*
+file__alloc_line_layout(Editing_File *file){
+    if (file->state.cached_layout_count >= LINE_LAYOUT_CACHE_MAX){
+        Line_Layout_Node *lru = file->state.cached_layouts.prev;
+        file__layout_remove(file, lru);
+        file__free_line_layout(file, lru);
+    }
+    Line_Layout_Node *node = file->state.free_layouts;
+    if (node != 0){
+        sll_stack_pop(file->state.free_layouts);
+    }
+    else{
+        node = push_array(&file->state.cached_layouts_arena, Line_Layout_Node, 1);
+        node->arena = make_arena(file->state.cached_layouts_arena.base_allocator, KB(4));
+    }
+    dll_insert(&file->state.cached_layouts, node);
+    file->state.cached_layout_count += 1;
+    return(node);
+}
+
+internal Layout_Item_List
+file_get_line_layout(Thread_Context *tctx, Models *models, Editing_File *file,
+                     Layout_Function *layout_func, f32 width, Face *face, i64 line_number){
+    Layout_Item_List result = {};
+    
+    i64 line_count = buffer_line_count(&file->state.buffer);
+    if (1 <= line_number && line_number <= line_count){
+        Line_Layout_Key key = {};
+        key.face_id = face->id;
+        key.face_version_number = face->version_number;
+        key.width = width;
+        key.line_number = line_number;
+        
+        Line_Layout_Node *node = file__layout_find(file->state.layout_root, &key);
+        if (node != 0){
+            dll_remove(node);
+            dll_insert(&file->state.cached_layouts, node);
+        }
+        else{
+            node = file__alloc_line_layout(file);
+            node->key = key;
+            Range_i64 line_range = buffer_get_pos_range_from_line_number(&file->state.buffer, line_number);
+            
+            Application_Links app = {};
+            app.tctx = tctx;
+            app.cmd_context = models;
+            node->list = layout_func(&app, &node->arena,
+                                     file->id, line_range, face->id, width);
+            file__layout_insert(file, node);
+        }
+        block_copy_struct(&result, &node->list);
+    }
+    
+    return(result);
+}
+
+internal void
+file_clear_layout_cache(Editing_File *file){
+    Line_Layout_Node *sentinel = &file->state.cached_layouts;
+    for (Line_Layout_Node *node = sentinel->next, *next = 0;
+         node != sentinel;
+         node = next){
+        next = node->next;
+        file__free_line_layout(file, node);
+    }
+    file->state.layout_root = 0;
+}
+
+// NOTE: Called before the text of a batch lands.  The shifts are sorted; going from
+// the last edit back to the first keeps the lines before each edit in their old numbers,
+// so each edit drops the layouts of its old lines and adds its own shift to everything
+// after them.
+internal void
+file_shift_layout_cache(Editing_File *file, Layout_Cache_Shift *shifts, i64 count){
+    for (i64 i = count - 1; i >= 0; i -= 1){
+        Layout_Cache_Shift *shift = &shifts[i];
+        i64 own_shift = shift->total_shift;
+        if (i > 0){
+            own_shift -= shifts[i - 1].total_shift;
+        }
+        Line_Layout_Node *l = 0;
+        Line_Layout_Node *m = 0;
+        Line_Layout_Node *r = 0;
+        Line_Layout_Node *mr = 0;
+        file__layout_split(file->state.layout_root, shift->first_line, &l, &mr);
+        file__layout_split(mr, shift->last_line + 1, &m, &r);
+        file__free_line_layout_tree(file, m);
+        if (r != 0){
+            r->shift += own_shift;
+        }
+        file__layout_set_root(file, file__layout_merge(l, r));
+    }
+}
+
+internal void
+file_shift_layout_cache(Editing_File *file, i64 first_line, i64 last_line, i64 line_shift){
+    Layout_Cache_Shift shift = {first_line, last_line, line_shift};
+    file_shift_layout_cache(file, &shift, 1);
+}
+
+////////////////////////////////
+
 function Layout_Function*
 file_get_layout_func(Editing_File *file){
     return(file->settings.layout_func);
 }
 
+internal File_Contents
+file_load_contents(Base_Allocator *allocator, Plat_Handle handle, u64 size){
+    File_Contents result = {};
+    if (size == 0){
+        result.is_loaded = true;
+    }
+    else{
+        result.data = system_load_map(handle, size);
+        if (result.data.str != 0){
+            result.is_loaded = true;
+            result.is_mapped = true;
+        }
+        else{
+            String_Const_u8 memory = base_allocate(allocator, size);
+            if (memory.str != 0){
+                if (system_load_file(handle, (char*)memory.str, size)){
+                    result.data = SCu8(memory.str, size);
+                    result.is_loaded = true;
+                }
+                else{
+                    base_free(allocator, memory.str);
+                }
+            }
+        }
+    }
+    return(result);
+}
+
+internal void
+file_free_contents(Base_Allocator *allocator, File_Contents *contents){
+    if (contents->is_mapped){
+        system_load_unmap(contents->data);
+    }
+    else if (contents->data.str != 0){
+        base_free(allocator, contents->data.str);
+    }
+    block_zero_struct(contents);
+}
+
 internal void
 file_create_from_string(Thread_Context *tctx, Models *models, Editing_File *file, String_Const_u8 val, File_Attributes attributes){
     Scratch_Block scratch(tctx);
@@ -216,7 +534,7 @@ file_create_from_string(Thread_Context *tctx, Models *models, Editing_File *file
     history_init(tctx, models, &file->state.history);
     
     file->state.cached_layouts_arena = make_arena(allocator);
-    file->state.line_layout_table = make_table_Data_u64(allocator, 500);
+    dll_init_sentinel(&file->state.cached_layouts);
     
     file->settings.is_initialized = true;
     
@@ -247,16 +565,12 @@ file_free(Thread_Context *tctx, Models *models, Editing_File *file){
     
     lifetime_free_object(lifetime_allocator, file->lifetime_object);
     
-    Gap_Buffer *buffer = &file->state.buffer;
-    if (buffer->data){
-        base_free(buffer->allocator, buffer->data);
-        base_free(buffer->allocator, buffer->line_starts);
-    }
+    buffer_free(&file->state.buffer);
     
     history_free(tctx, &file->state.history);
     
+    file_clear_layout_cache(file);
     linalloc_clear(&file->state.cached_layouts_arena);
-    table_free(&file->state.line_layout_table);
 }
 
 ////////////////////////////////
@@ -278,53 +592,6 @@ file_get_managed_scope(Editing_File *file){
 
 ////////////////////////////////
 
-internal Layout_Item_List
-file_get_line_layout(Thread_Context *tctx, Models *models, Editing_File *file,
-                     Layout_Function *layout_func, f32 width, Face *face, i64 line_number){
-    Layout_Item_List result = {};
-    
-    i64 line_count = buffer_line_count(&file->state.buffer);
-    if (1 <= line_number && line_number <= line_count){
-        Line_Layout_Key key = {};
-        key.face_id = face->id;
-        key.face_version_number = face->version_number;
-        key.width = width;
-        key.line_number = line_number;
-        
-        String_Const_u8 key_data = make_data_struct(&key);
-        
-        Layout_Item_List *list = 0;
-        
-        Table_Lookup lookup = table_lookup(&file->state.line_layout_table, key_data);
-        if (lookup.found_match){
-            u64 val = 0;
-            table_read(&file->state.line_layout_table, lookup, &val);
-            list = (Layout_Item_List*)IntAsPtr(val);
-        }
-        else{
-            list = push_array(&file->state.cached_layouts_arena, Layout_Item_List, 1);
-            Range_i64 line_range = buffer_get_pos_range_from_line_number(&file->state.buffer, line_number);
-            
-            Application_Links app = {};
-            app.tctx = tctx;
-            app.cmd_context = models;
-            *list = layout_func(&app, &file->state.cached_layouts_arena,
-                                file->id, line_range, face->id, width);
-            key_data = push_data_copy(&file->state.cached_layouts_arena, key_data);
-            table_insert(&file->state.line_layout_table, key_data, (u64)PtrAsInt(list));
-        }
-        block_copy_struct(&result, list);
-    }
-    
-    return(result);
-}
-
-internal void
-file_clear_layout_cache(Editing_File *file){
-    linalloc_clear(&file->state.cached_layouts_arena);
-    table_clear(&file->state.line_layout_table);
-}
-
 internal Line_Shift_Vertical
 file_line_shift_y(Thread_Context *tctx, Models *models, Editing_File *file,
                   Layout_Function *layout_func, f32 width, Face *face,
@@ -42,12 +42,49 @@ struct Line_Layout_Key{
     i64 line_number;
 };
 
+// NOTE: Cached layouts sit in the LRU list and in a treap ordered by line number.
+// A node's true line number is its key's plus the shift of itself and every ancestor,
+// so an edit drops the layouts of the lines it touches and adds one shift to the root
+// of everything after it, instead of re-keying every layout in the cache.
+struct Line_Layout_Node{
+    Line_Layout_Node *next;
+    Line_Layout_Node *prev;
+    Line_Layout_Node *parent;
+    Line_Layout_Node *left;
+    Line_Layout_Node *right;
+    i64 shift;
+    u32 priority;
+    Line_Layout_Key key;
+    Arena arena;
+    Layout_Item_List list;
+};
+
+// NOTE: One edit of a batch in the line numbers from before the batch, total_shift
+// is how far every line after it moves once it and all the edits before it land.
+struct Layout_Cache_Shift{
+    i64 first_line;
+    i64 last_line;
+    i64 total_shift;
+};
+
+// NOTE: Upper bound on cached line layouts per file; the least recently
+// used layouts are recycled past this point.
+#define LINE_LAYOUT_CACHE_MAX 4096
+
 typedef i32 File_Save_State;
 enum{
     FileSaveState_Normal,
     FileSaveState_SavedWaitingForNotification,
 };
 
+typedef i32 File_Watch_State;
+enum{
+    FileWatchState_None,
+    FileWatchState_Pending,
+    FileWatchState_Watched,
+    FileWatchState_Polled,
+};
+
 struct Editing_File_State{
     Gap_Buffer buffer;
     
@@ -64,8 +101,14 @@ struct Editing_File_State{
     
     Child_Process_ID attached_child_process;
     
+    Buffer_Marker_Index markers;
+    
     Arena cached_layouts_arena;
-    Table_Data_u64 line_layout_table;
+    Line_Layout_Node *layout_root;
+    u32 layout_priority_state;
+    Line_Layout_Node cached_layouts;
+    Line_Layout_Node *free_layouts;
+    i32 cached_layout_count;
 };
 
 struct Editing_File_Name{
@@ -80,6 +123,11 @@ struct Editing_File{
     };
     Node touch_node;
     Node external_mod_node;
+    Node snapshot_cache_node;
+    u64 snapshot_cache_time;
+    Node watch_node;
+    File_Watch_State watch_state;
+    Node base_name_node;
     Buffer_ID id;
     Editing_File_Settings settings;
     Editing_File_State state;
@@ -90,6 +138,15 @@ struct Editing_File{
     Editing_File_Name canon;
 };
 
+// NOTE: The contents of a file on disk, mapped when the platform can map it and
+// read into the allocator otherwise.  Either way they are only held until the buffer has
+// copied them.
+struct File_Contents{
+    String_Const_u8 data;
+    b32 is_loaded;
+    b32 is_mapped;
+};
+
 struct Buffer_Point_Delta{
     Buffer_Point new_point;
     f32 y_shift;
@@ -0,0 +1,128 @@
+/*
+ * 4coder font cache
+ *
+ * On disk cache of the measurements a font provider makes for a face.
+ *
+ */
+
+// TOP
+
+internal u64
+font_cache_hash_data(String_Const_u8 data){
+    u64 word_count = data.size/8;
+    u64 hash = table_hash_u64((u64*)data.str, word_count);
+    hash ^= table_hash_u8(data.str + word_count*8, data.size - word_count*8);
+    return(hash);
+}
+
+internal char*
+font_cache_file_name(Arena *arena, String_Const_u8 cache_dir, Font_Cache_Key *key){
+    u64 hash = table_hash_u64((u64*)key, sizeof(*key)/8);
+    String_Const_u8 name = push_u8_stringf(arena, "%.*s%016llx.4fc",
+                                           string_expand(cache_dir), hash);
+    return((char*)name.str);
+}
+
+internal b32
+font_cache_read(Arena *arena, String_Const_u8 cache_dir, Font_Cache_Key *key, Face *face){
+    b32 result = false;
+    if (cache_dir.size > 0){
+        Temp_Memory temp = begin_temp(arena);
+        char *file_name = font_cache_file_name(arena, cache_dir, key);
+        Plat_Handle handle = {};
+        b32 has_handle = system_load_handle(arena, file_name, &handle);
+        end_temp(temp);
+        
+        if (has_handle){
+            File_Attributes attributes = system_load_attributes(handle);
+            String_Const_u8 data = {};
+            if (attributes.size >= sizeof(Font_Cache_Header)){
+                data = system_load_map(handle, attributes.size);
+            }
+            system_load_close(handle);
+            
+            if (data.str != 0){
+                Font_Cache_Header *header = (Font_Cache_Header*)data.str;
+                u64 expected_size = (sizeof(*header) +
+                                     header->index_count*sizeof(f32) +
+                                     header->slot_count*(sizeof(u32) + sizeof(u16)));
+                if (header->magic == FONT_CACHE_MAGIC &&
+                    header->version == FONT_CACHE_VERSION &&
+                    block_match_struct(&header->key, key) &&
+                    header->index_count <= max_u16 &&
+                    header->used_count <= header->slot_count &&
+                    header->dirty_count <= header->slot_count &&
+                    expected_size == data.size){
+                    f32 *advance = (f32*)(header + 1);
+                    u32 *keys = (u32*)(advance + header->index_count);
+                    u16 *vals = (u16*)(keys + header->slot_count);
+                    
+                    face->metrics = header->metrics;
+                    
+                    Face_Advance_Map *map = &face->advance_map;
+                    map->index_count = (u16)header->index_count;
+                    map->advance = push_array_write(arena, f32, header->index_count, advance);
+                    
+                    // NOTE: The table is copied slot for slot, so it doesn't have
+                    // to be rehashed.
+                    Codepoint_Index_Map *index_map = &map->codepoint_to_index;
+                    index_map->has_zero_index = header->has_zero_index;
+                    index_map->zero_index = (u16)header->zero_index;
+                    index_map->max_index = (u16)header->max_index;
+                    index_map->table = make_table_u32_u16(arena->base_allocator, header->slot_count);
+                    Table_u32_u16 *table = &index_map->table;
+                    if (table->slot_count == header->slot_count){
+                        block_copy_dynamic_array(table->keys, keys, header->slot_count);
+                        block_copy_dynamic_array(table->vals, vals, header->slot_count);
+                        table->used_count = header->used_count;
+                        table->dirty_count = header->dirty_count;
+                        result = true;
+                    }
+                    else{
+                        table_free(table);
+                    }
+                }
+                system_load_unmap(data);
+            }
+        }
+    }
+    return(result);
+}
+
+internal void
+font_cache_write(Arena *arena, String_Const_u8 cache_dir, Font_Cache_Key *key, Face *face){
+    if (cache_dir.size > 0){
+        Temp_Memory temp = begin_temp(arena);
+        
+        Face_Advance_Map *map = &face->advance_map;
+        Codepoint_Index_Map *index_map = &map->codepoint_to_index;
+        Table_u32_u16 *table = &index_map->table;
+        
+        Font_Cache_Header *header = push_array_zero(arena, Font_Cache_Header, 1);
+        header->magic = FONT_CACHE_MAGIC;
+        header->version = FONT_CACHE_VERSION;
+        header->key = *key;
+        header->metrics = face->metrics;
+        header->has_zero_index = index_map->has_zero_index;
+        header->zero_index = index_map->zero_index;
+        header->max_index = index_map->max_index;
+        header->index_count = map->index_count;
+        header->slot_count = table->slot_count;
+        header->used_count = table->used_count;
+        header->dirty_count = table->dirty_count;
+        
+        List_String_Const_u8 list = {};
+        string_list_push(arena, &list, SCu8((u8*)header, sizeof(*header)));
+        string_list_push(arena, &list, SCu8((u8*)map->advance, map->index_count*sizeof(f32)));
+        string_list_push(arena, &list, SCu8((u8*)table->keys, table->slot_count*sizeof(u32)));
+        string_list_push(arena, &list, SCu8((u8*)table->vals, table->slot_count*sizeof(u16)));
+        
+        char *file_name = font_cache_file_name(arena, cache_dir, key);
+        system_save_file(arena, file_name, list);
+        
+        end_temp(temp);
+    }
+}
+
+// BOTTOM
+
@@ -0,0 +1,47 @@
+/*
+ * 4coder font cache
+ *
+ * On disk cache of the measurements a font provider makes for a face.
+ *
+ */
+
+// TOP
+
+#if !defined(FCODER_FONT_CACHE_H)
+#define FCODER_FONT_CACHE_H
+
+// NOTE: A cache file holds everything a face needs before its first glyph is drawn:
+// the metrics, the codepoint to index table and the advances.  Files are named by a hash of
+// their key and the key is repeated in the header to catch collisions.  The arrays follow
+// the header in this order:
+//   f32 advance[index_count];
+//   u32 keys[slot_count];
+//   u16 vals[slot_count];
+#define FONT_CACHE_MAGIC 0x43463446
+#define FONT_CACHE_VERSION 1
+
+struct Font_Cache_Key{
+    u64 font_hash;
+    u64 font_size;
+    u32 pt_size;
+    b32 hinting;
+};
+
+struct Font_Cache_Header{
+    u32 magic;
+    u32 version;
+    Font_Cache_Key key;
+    Face_Metrics metrics;
+    b32 has_zero_index;
+    u32 zero_index;
+    u32 max_index;
+    u32 index_count;
+    u32 slot_count;
+    u32 used_count;
+    u32 dirty_count;
+};
+
+#endif
+
+// BOTTOM
+
@@ -30,6 +30,52 @@ struct Glyph_Bounds{
     Rect_f32 xy_off;
 };
 
+// NOTE: A glyph is rasterized by the face's provider the first time it is drawn
+// and packed into the face's atlas, a texture array of FACE_ATLAS_PAGE_DIM square pages.
+// The atlas grows by doubling its page count up to FACE_ATLAS_MAX_PAGES, past that the
+// least recently drawn page that wasn't drawn in the current frame is emptied for reuse.
+// If every page was drawn in a frame the glyphs that didn't fit are skipped, and the next
+// frame starts by emptying the page that the last frame drew the least from.  The atlas
+// keeps a copy of its pages in memory to fill the bigger texture when it grows.
+#define FACE_ATLAS_PAGE_DIM 1024
+#define FACE_ATLAS_MAX_PAGES 16
+
+typedef u8 Face_Glyph_State;
+enum{
+    FaceGlyphState_Unloaded,
+    FaceGlyphState_Resident,
+    FaceGlyphState_Empty,
+};
+
+struct Glyph_Bitmap{
+    Vec2_i32 dim;
+    u8 *data;
+    Rect_f32 xy_off;
+};
+
+struct Face_Atlas_Page{
+    i32 last_used_frame;
+    i32 use_count;
+    i32 x;
+    i32 y;
+    i32 line_h;
+};
+
+struct Face_Atlas{
+    Arena scratch;
+    u8 *pixels;
+    i32 page_count;
+    i32 page_max;
+    i32 current_page;
+    i32 frame_index;
+    b32 had_miss;
+    Face_Atlas_Page pages[FACE_ATLAS_MAX_PAGES];
+};
+
+struct Face;
+typedef b32 Font_Rasterize_Glyph_Function(Face *face, u16 index, Arena *arena, Glyph_Bitmap *bitmap_out);
+typedef void Font_Release_Face_Function(Face *face);
+
 struct Face{
     Face_Description description;
     Face_ID id;
@@ -41,11 +87,18 @@ struct Face{
     // NOTE(allen): Glyph data
     Face_Advance_Map advance_map;
     Glyph_Bounds *bounds;
+    Face_Glyph_State *glyph_states;
     Glyph_Bounds white;
+    Face_Atlas atlas;
     
     Texture_Kind texture_kind;
     u32 texture;
     Vec3_f32 texture_dim;
+    
+    // NOTE: Provider
+    void *provider_data;
+    Font_Rasterize_Glyph_Function *rasterize_glyph;
+    Font_Release_Face_Function *release_face;
 };
 
 ////////////////////////////////
@@ -100,294 +100,266 @@ ft__get_codepoint_index_map(Base_Allocator *base_allocator, FT_Face face){
     return(map);
 }
 
-struct Bad_Rect_Pack{
-    Vec2_i32 max_dim;
-    Vec3_i32 dim;
-    Vec3_i32 p;
-    i32 current_line_h;
+struct FT_Face_Data{
+    FT_Library ft;
+    FT_Face ft_face;
+    b32 open_failed;
+    String_Const_u8 font_data;
+    b32 font_data_is_mapped;
+    u32 pt_size;
+    u32 load_flags;
+    b32 aa_1bit_mono;
 };
 
-internal void
-ft__bad_rect_pack_init(Bad_Rect_Pack *pack, Vec2_i32 max_dim){
-    pack->max_dim = max_dim;
-    pack->dim = V3i32(0, 0, 1);
-    pack->p = V3i32(0, 0, 0);
-    pack->current_line_h = 0;
+internal b32
+ft__load_font_data(Arena *arena, String_Const_u8 file_name, FT_Face_Data *data){
+    b32 result = false;
+    Plat_Handle handle = {};
+    if (system_load_handle(arena, (char*)file_name.str, &handle)){
+        File_Attributes attributes = system_load_attributes(handle);
+        if (attributes.size > 0){
+            data->font_data = system_load_map(handle, attributes.size);
+            if (data->font_data.str != 0){
+                data->font_data_is_mapped = true;
+                result = true;
+            }
+            else{
+                u8 *memory = push_array(arena, u8, attributes.size);
+                if (system_load_file(handle, (char*)memory, attributes.size)){
+                    data->font_data = SCu8(memory, attributes.size);
+                    result = true;
+                }
+            }
+        }
+        system_load_close(handle);
+    }
+    return(result);
 }
 
-internal void
-ft__bad_rect_pack_end_line(Bad_Rect_Pack *pack){
-    pack->p.y += pack->current_line_h;
-    pack->dim.y = Max(pack->dim.y, pack->p.y);
-    pack->current_line_h = 0;
-    pack->p.x = 0;
+// NOTE: A face that came out of the cache doesn't open its FT_Face until the first
+// glyph is rasterized.
+internal b32
+ft__open_face(FT_Face_Data *data){
+    if (data->ft_face == 0 && !data->open_failed){
+        data->open_failed = true;
+        if (FT_Init_FreeType(&data->ft) == 0){
+            FT_Error error = FT_New_Memory_Face(data->ft, data->font_data.str, (FT_Long)data->font_data.size, 0, &data->ft_face);
+            if (error == 0){
+                FT_Size_RequestRec_ size = {};
+                size.type   = FT_SIZE_REQUEST_TYPE_NOMINAL;
+                size.height = (data->pt_size << 6);
+                FT_Request_Size(data->ft_face, &size);
+                data->open_failed = false;
+            }
+            else{
+                data->ft_face = 0;
+                FT_Done_FreeType(data->ft);
+                data->ft = 0;
+            }
+        }
+    }
+    return(data->ft_face != 0);
 }
 
-internal Vec3_i32
-ft__bad_rect_pack_next(Bad_Rect_Pack *pack, Vec2_i32 dim){
-    
-    Vec3_i32 result = { };
+internal b32
+ft__rasterize_glyph(Face *face, u16 index, Arena *arena, Glyph_Bitmap *bitmap_out){
+    FT_Face_Data *data = (FT_Face_Data*)face->provider_data;
+    b32 result = false;
     
-    // NOTE(simon, 28/02/24): Does this character fit in the texture if it's the only character ?
-    if ( dim.x <= pack->max_dim.x && dim.y <= pack->max_dim.y ){
-        
-        b8 end_line = false;
-        
-        if ( pack->p.x + dim.x > pack->max_dim.x ) {
-            // NOTE(simon, 28/02/24): Can't fit the character horizontally.
-            end_line = true;
-        }
-        
-        if ( pack->current_line_h < dim.y && pack->p.y + dim.y > pack->max_dim.y ) {
-            // NOTE(simon, 28/02/24): Character doesn't fit in the current line height, AND we
-            // can't grow the line height.
-            end_line = true;
-        }
+    FT_Error error = 1;
+    if (ft__open_face(data)){
+        error = FT_Load_Glyph(data->ft_face, index, data->load_flags);
+    }
+    if (error == 0){
+        FT_GlyphSlot ft_glyph = data->ft_face->glyph;
+        Vec2_i32 dim = V2i32(ft_glyph->bitmap.width, ft_glyph->bitmap.rows);
+        bitmap_out->dim = dim;
+        bitmap_out->data = push_array(arena, u8, dim.x*dim.y);
         
-        if ( end_line ) {
-            ft__bad_rect_pack_end_line( pack );
-        }
+        bitmap_out->xy_off.x0 = (f32)(ft_glyph->bitmap_left);
+        bitmap_out->xy_off.y0 = (f32)(face->metrics.ascent - ft_glyph->bitmap_top);
+        bitmap_out->xy_off.x1 = (f32)(bitmap_out->xy_off.x0 + dim.x);
+        bitmap_out->xy_off.y1 = (f32)(bitmap_out->xy_off.y0 + dim.y);
         
-        if ( pack->p.y + dim.y > pack->max_dim.y ) {
-            Assert( end_line );
-            // NOTE(simon, 28/02/24): We ended a line. There isn't enough space on a new line to
-            // fit the character vertically. We need to go to the next texture in the array.
-            // In a new texture the character is guaranteed to fit, because of the outer most if.
-            pack->p.y = 0;
-            pack->dim.z += 1;
-            pack->p.z += 1;
+        switch (ft_glyph->bitmap.pixel_mode){
+            case FT_PIXEL_MODE_MONO:
+            {
+                NotImplemented;
+            }break;
             
-            // NOTE(simon, 28/02/24): There are no checks on the z axis range, but texture arrays
-            // have a limit. At the moment it's 2048 on both OpenGL and DirectX.
+            case FT_PIXEL_MODE_GRAY:
+            {
+                b32 aa_1bit_mono = data->aa_1bit_mono;
+                
+                u8 *src_line = ft_glyph->bitmap.buffer;
+                if (ft_glyph->bitmap.pitch < 0){
+                    src_line = ft_glyph->bitmap.buffer + (-ft_glyph->bitmap.pitch)*(dim.y - 1);
+                }
+                u8 *dst = bitmap_out->data;
+                for (i32 y = 0; y < dim.y; y += 1){
+                    u8 *src_pixel = src_line;
+                    for (i32 x = 0; x < dim.x; x += 1){
+                        if (aa_1bit_mono){
+                            u8 s = *src_pixel;
+                            if (s > 0){
+                                s = 255;
+                            }
+                            *dst = s;
+                        }
+                        else{
+                            *dst = *src_pixel;
+                        }
+                        dst += 1;
+                        src_pixel += 1;
+                    }
+                    src_line += ft_glyph->bitmap.pitch;
+                }
+                result = true;
+            }break;
+            
+            default:
+            {
+                NotImplemented;
+            }break;
         }
-        
-        // NOTE(simon, 28/02/24): We are now sure that the character will fit.
-        pack->current_line_h = Max(pack->current_line_h, dim.y);
-        
-        result = pack->p;
-        pack->p.x += dim.x;
-        pack->dim.x = Max( pack->dim.x, pack->p.x );
     }
     
     return(result);
 }
 
 internal void
-ft__bad_rect_store_finish(Bad_Rect_Pack *pack){
-    ft__bad_rect_pack_end_line(pack);
+ft__release_face(Face *face){
+    FT_Face_Data *data = (FT_Face_Data*)face->provider_data;
+    if (data != 0){
+        if (data->ft_face != 0){
+            FT_Done_Face(data->ft_face);
+            FT_Done_FreeType(data->ft);
+        }
+        if (data->font_data_is_mapped){
+            system_load_unmap(data->font_data);
+        }
+        face->provider_data = 0;
+    }
 }
 
 internal void
-ft__glyph_bounds_store_uv_raw(Vec3_i32 p, Vec2_i32 dim, Glyph_Bounds *bounds){
-    bounds->uv = Rf32((f32)p.x, (f32)p.y, (f32)dim.x, (f32)dim.y);
-    bounds->w = (f32)p.z;
+ft__measure_face(Arena *arena, Face *face, FT_Face ft_face, u32 load_flags){
+    Face_Metrics *met = &face->metrics;
+    
+    met->max_advance = f32_ceil32(ft_face->size->metrics.max_advance/64.f);
+    met->ascent      = f32_ceil32(ft_face->size->metrics.ascender/64.f);
+    met->descent     = f32_floor32(ft_face->size->metrics.descender/64.f);
+    met->text_height = f32_ceil32(ft_face->size->metrics.height/64.f);
+    met->line_skip   = met->text_height - (met->ascent - met->descent);
+    met->line_skip   = clamp_bot(1.f, met->line_skip);
+    met->line_height = met->text_height + met->line_skip;
+    
+    {
+        f32 real_over_notional = met->line_height/(f32)ft_face->height;
+        f32 relative_center = -1.f*real_over_notional*ft_face->underline_position;
+        f32 relative_thickness = real_over_notional*ft_face->underline_thickness;
+        
+        f32 center    = f32_floor32(met->ascent + relative_center);
+        f32 thickness = clamp_bot(1.f, relative_thickness);
+        
+        met->underline_yoff1 = center - thickness*0.5f;
+        met->underline_yoff2 = center + thickness*0.5f;
+    }
+    
+    face->advance_map.codepoint_to_index =
+        ft__get_codepoint_index_map(arena->base_allocator, ft_face);
+    u16 index_count =
+        codepoint_index_map_count(&face->advance_map.codepoint_to_index);
+    face->advance_map.index_count = index_count;
+    face->advance_map.advance = push_array_zero(arena, f32, index_count);
+    
+    // NOTE: Only the advances are needed up front.  Loading the outline gives
+    // exactly the advance the rendered glyph has, without rasterizing it.
+    u32 advance_load_flags = (load_flags & ~FT_LOAD_RENDER);
+    for (u16 i = 0; i < index_count; i += 1){
+        FT_Error error = FT_Load_Glyph(ft_face, i, advance_load_flags);
+        if (error == 0){
+            face->advance_map.advance[i] = f32_ceil32(ft_face->glyph->advance.x/64.0f);
+        }
+    }
+    
+    {
+        Face_Advance_Map *advance_map = &face->advance_map;
+        
+        met->space_advance = font_get_glyph_advance(advance_map, met, ' ', 0);
+        met->decimal_digit_advance =
+            font_get_max_glyph_advance_range(advance_map, met, '0', '9', 0);
+        met->hex_digit_advance =
+            font_get_max_glyph_advance_range(advance_map, met, 'A', 'F', 0);
+        met->hex_digit_advance =
+            Max(met->hex_digit_advance, met->decimal_digit_advance);
+        met->byte_sub_advances[0] =
+            font_get_glyph_advance(advance_map, met, '\\', 0);
+        met->byte_sub_advances[1] = met->hex_digit_advance;
+        met->byte_sub_advances[2] = met->hex_digit_advance;
+        met->byte_advance =
+            met->byte_sub_advances[0] +
+            met->byte_sub_advances[1] +
+            met->byte_sub_advances[2];
+        met->normal_lowercase_advance =
+            font_get_average_glyph_advance_range(advance_map, met, 'a', 'z', 0);
+        met->normal_uppercase_advance =
+            font_get_average_glyph_advance_range(advance_map, met, 'A', 'Z', 0);
+        met->normal_advance = (26*met->normal_lowercase_advance +
+                               26*met->normal_uppercase_advance +
+                               10*met->decimal_digit_advance)/62.f;
+    }
 }
 
 internal Face*
-ft__font_make_face(Arena *arena, Face_Description *description, f32 scale_factor){
+ft__font_make_face(Arena *arena, Face_Description *description, f32 scale_factor, String_Const_u8 cache_dir){
     String_Const_u8 file_name = push_string_copy(arena, description->font.file_name);
     
-    FT_Library ft;
-    FT_Init_FreeType(&ft);
+    u32 pt_size_unscaled = Max(description->parameters.pt_size, 8);
+    u32 pt_size = (u32)(pt_size_unscaled*scale_factor);
+    b32 hinting = description->parameters.hinting;
     
-    FT_Face ft_face;
-    FT_Error error = FT_New_Face(ft, (char*)file_name.str, 0, &ft_face);
+    FT_Face_Data *data = push_array_zero(arena, FT_Face_Data, 1);
+    data->pt_size = pt_size;
+    data->load_flags = ft__load_flags(hinting);
+    data->aa_1bit_mono = (description->parameters.aa_mode == FaceAntialiasingMode_1BitMono);
     
     Face *face = 0;
-    if (error == 0){
+    if (ft__load_font_data(arena, file_name, data)){
         face = push_array_zero(arena, Face, 1);
-        
-        u32 pt_size_unscaled = Max(description->parameters.pt_size, 8);
-        u32 pt_size = (u32)(pt_size_unscaled*scale_factor);
-        b32 hinting = description->parameters.hinting;
-        
-        FT_Size_RequestRec_ size = {};
-        size.type   = FT_SIZE_REQUEST_TYPE_NOMINAL;
-        size.height = (pt_size << 6);
-        FT_Request_Size(ft_face, &size);
-        
         face->description.font.file_name = file_name;
         face->description.parameters = description->parameters;
+        face->provider_data = data;
+        face->rasterize_glyph = ft__rasterize_glyph;
+        face->release_face = ft__release_face;
         
-        Face_Metrics *met = &face->metrics;
-        
-        met->max_advance = f32_ceil32(ft_face->size->metrics.max_advance/64.f);
-        met->ascent      = f32_ceil32(ft_face->size->metrics.ascender/64.f);
-        met->descent     = f32_floor32(ft_face->size->metrics.descender/64.f);
-        met->text_height = f32_ceil32(ft_face->size->metrics.height/64.f);
-        met->line_skip   = met->text_height - (met->ascent - met->descent);
-        met->line_skip   = clamp_bot(1.f, met->line_skip);
-        met->line_height = met->text_height + met->line_skip;
-        
-        {
-            f32 real_over_notional = met->line_height/(f32)ft_face->height;
-            f32 relative_center = -1.f*real_over_notional*ft_face->underline_position;
-            f32 relative_thickness = real_over_notional*ft_face->underline_thickness;
-            
-            f32 center    = f32_floor32(met->ascent + relative_center);
-            f32 thickness = clamp_bot(1.f, relative_thickness);
-            
-            met->underline_yoff1 = center - thickness*0.5f;
-            met->underline_yoff2 = center + thickness*0.5f;
-        }
-        
-        face->advance_map.codepoint_to_index =
-            ft__get_codepoint_index_map(arena->base_allocator, ft_face);
-        u16 index_count =
-            codepoint_index_map_count(&face->advance_map.codepoint_to_index);
-        face->advance_map.index_count = index_count;
-        face->advance_map.advance = push_array_zero(arena, f32, index_count);
-        face->bounds = push_array(arena, Glyph_Bounds, index_count);
-        
-        Temp_Memory_Block temp_memory(arena);
-        struct Bitmap{
-            Vec2_i32 dim;
-            u8 *data;
-        };
-        Bitmap *glyph_bitmaps = push_array(arena, Bitmap, index_count);
-        
-        u32 load_flags = ft__load_flags(hinting);
-        for (u16 i = 0; i < index_count; i += 1){
-            Bitmap *bitmap = &glyph_bitmaps[i];
-            
-            error = FT_Load_Glyph(ft_face, i, load_flags);
-            if (error == 0){
-                FT_GlyphSlot ft_glyph = ft_face->glyph;
-                Vec2_i32 dim = V2i32(ft_glyph->bitmap.width, ft_glyph->bitmap.rows);
-                bitmap->dim = dim;
-                bitmap->data = push_array(arena, u8, dim.x*dim.y);
-                
-                face->bounds[i].xy_off.x0 = (f32)(ft_face->glyph->bitmap_left);
-                face->bounds[i].xy_off.y0 = (f32)(met->ascent - ft_face->glyph->bitmap_top);
-                face->bounds[i].xy_off.x1 = (f32)(face->bounds[i].xy_off.x0 + dim.x);
-                face->bounds[i].xy_off.y1 = (f32)(face->bounds[i].xy_off.y0 + dim.y);
-                
-                switch (ft_glyph->bitmap.pixel_mode){
-                    case FT_PIXEL_MODE_MONO:
-                    {
-                        NotImplemented;
-                    }break;
-                    
-                    case FT_PIXEL_MODE_GRAY:
-                    {
-                        b32 aa_1bit_mono = (description->parameters.aa_mode == FaceAntialiasingMode_1BitMono);
-                        
-                        u8 *src_line = ft_glyph->bitmap.buffer;
-                        if (ft_glyph->bitmap.pitch < 0){
-                            src_line = ft_glyph->bitmap.buffer + (-ft_glyph->bitmap.pitch)*(dim.y - 1);
-                        }
-                        u8 *dst = bitmap->data;
-                        for (i32 y = 0; y < dim.y; y += 1){
-                            u8 *src_pixel = src_line;
-                            for (i32 x = 0; x < dim.x; x += 1){
-                                if (aa_1bit_mono){
-                                    u8 s = *src_pixel;
-                                    if (s > 0){
-                                        s = 255;
-                                    }
-                                    *dst = s;
-                                }
-                                else{
-                                    *dst = *src_pixel;
-                                }
-                                dst += 1;
-                                src_pixel += 1;
-                            }
-                            src_line += ft_glyph->bitmap.pitch;
-                        }
-                    }break;
-                    
-                    default:
-                    {
-                        NotImplemented;
-                    }break;
-                }
-                
-                face->advance_map.advance[i] = f32_ceil32(ft_glyph->advance.x/64.0f);
-            }
-        }
-        
-        u8 white_data[16] = {
-            0xFF, 0xFF, 0xFF, 0xFF,
-            0xFF, 0xFF, 0xFF, 0xFF,
-            0xFF, 0xFF, 0xFF, 0xFF,
-            0xFF, 0xFF, 0xFF, 0xFF,
-        };
+        // NOTE: The measurements only depend on the font file, the size in pixels
+        // and the hinting, so every face that agrees on those shares a cache file.
+        Font_Cache_Key key = {};
+        key.font_hash = font_cache_hash_data(data->font_data);
+        key.font_size = data->font_data.size;
+        key.pt_size = pt_size;
+        key.hinting = hinting;
         
-        Bitmap white = {};
-        white.dim = V2i32(4, 4);
-        white.data = white_data;
-        
-        Bad_Rect_Pack pack = {};
-        ft__bad_rect_pack_init(&pack, V2i32(1024, 1024));
-        ft__glyph_bounds_store_uv_raw(ft__bad_rect_pack_next(&pack, white.dim), white.dim, &face->white);
-        for (u16 i = 0; i < index_count; i += 1){
-            Vec2_i32 dim = glyph_bitmaps[i].dim;
-            ft__glyph_bounds_store_uv_raw(ft__bad_rect_pack_next(&pack, dim), dim, &face->bounds[i]);
-        }
-        ft__bad_rect_store_finish(&pack);
-        
-        Texture_Kind texture_kind = TextureKind_Mono;
-        u32 texture = graphics_get_texture(pack.dim, texture_kind);
-        face->texture_kind = texture_kind;
-        face->texture = texture;
-        
-        Vec3_f32 texture_dim = V3f32(pack.dim);
-        face->texture_dim = texture_dim;
-        
-        {
-            Vec3_i32 p = V3i32((i32)face->white.uv.x0, (i32)face->white.uv.y0, (i32)face->white.w);
-            Vec3_i32 dim = V3i32(white.dim.x, white.dim.y, 1);
-            graphics_fill_texture(texture_kind, texture, p, dim, white.data);
-            face->white.uv.x1 = (face->white.uv.x0 + face->white.uv.x1)/texture_dim.x;
-            face->white.uv.y1 = (face->white.uv.y0 + face->white.uv.y1)/texture_dim.y;
-            face->white.uv.x0 =  face->white.uv.x0/texture_dim.x;
-            face->white.uv.y0 =  face->white.uv.y0/texture_dim.y;
-            face->white.w /= texture_dim.z;
+        b32 is_measured = font_cache_read(arena, cache_dir, &key, face);
+        if (!is_measured && ft__open_face(data)){
+            ft__measure_face(arena, face, data->ft_face, data->load_flags);
+            font_cache_write(arena, cache_dir, &key, face);
+            is_measured = true;
         }
         
-        for (u16 i = 0; i < index_count; i += 1){
-            Vec3_i32 p = V3i32((i32)face->bounds[i].uv.x0, (i32)face->bounds[i].uv.y0, (i32)face->bounds[i].w);
-            Vec3_i32 dim = V3i32(glyph_bitmaps[i].dim.x, glyph_bitmaps[i].dim.y, 1);
-            graphics_fill_texture(texture_kind, texture, p, dim, glyph_bitmaps[i].data);
-            face->bounds[i].uv.x1 = (face->bounds[i].uv.x0 + face->bounds[i].uv.x1)/texture_dim.x;
-            face->bounds[i].uv.y1 = (face->bounds[i].uv.y0 + face->bounds[i].uv.y1)/texture_dim.y;
-            face->bounds[i].uv.x0 =  face->bounds[i].uv.x0/texture_dim.x;
-            face->bounds[i].uv.y0 =  face->bounds[i].uv.y0/texture_dim.y;
+        if (is_measured){
+            u16 index_count = face->advance_map.index_count;
+            face->bounds = push_array_zero(arena, Glyph_Bounds, index_count);
+            face->glyph_states = push_array_zero(arena, Face_Glyph_State, index_count);
         }
-        
-        {
-            Face_Advance_Map *advance_map = &face->advance_map;
-            
-            met->space_advance = font_get_glyph_advance(advance_map, met, ' ', 0);
-            met->decimal_digit_advance =
-                font_get_max_glyph_advance_range(advance_map, met, '0', '9', 0);
-            met->hex_digit_advance =
-                font_get_max_glyph_advance_range(advance_map, met, 'A', 'F', 0);
-            met->hex_digit_advance =
-                Max(met->hex_digit_advance, met->decimal_digit_advance);
-            met->byte_sub_advances[0] =
-                font_get_glyph_advance(advance_map, met, '\\', 0);
-            met->byte_sub_advances[1] = met->hex_digit_advance;
-            met->byte_sub_advances[2] = met->hex_digit_advance;
-            met->byte_advance =
-                met->byte_sub_advances[0] +
-                met->byte_sub_advances[1] +
-                met->byte_sub_advances[2];
-            met->normal_lowercase_advance =
-                font_get_average_glyph_advance_range(advance_map, met, 'a', 'z', 0);
-            met->normal_uppercase_advance =
-                font_get_average_glyph_advance_range(advance_map, met, 'A', 'Z', 0);
-            met->normal_advance = (26*met->normal_lowercase_advance +
-                                   26*met->normal_uppercase_advance +
-                                   10*met->decimal_digit_advance)/62.f;
+        else{
+            ft__release_face(face);
+            face = 0;
         }
     }
     
-    FT_Done_FreeType(ft);
-    
     return(face);
 }
 
 // BOTTOM
-
@@ -9,6 +9,271 @@
 
 // TOP
 
+// NOTE: Glyphs keep an empty row and column on their bottom and right so filtering
+// never picks up their neighbors.
+#define FACE_ATLAS_WHITE_DIM 4
+
+internal u8*
+face_atlas__page_pixels(Face_Atlas *atlas, i32 page){
+    return(atlas->pixels + (u64)page*FACE_ATLAS_PAGE_DIM*FACE_ATLAS_PAGE_DIM);
+}
+
+internal void
+face_atlas__reset_page(Face_Atlas *atlas, i32 page, i32 frame_index){
+    Face_Atlas_Page *atlas_page = &atlas->pages[page];
+    block_zero_struct(atlas_page);
+    atlas_page->last_used_frame = frame_index;
+    if (page == 0){
+        atlas_page->x = FACE_ATLAS_WHITE_DIM + 1;
+        atlas_page->line_h = FACE_ATLAS_WHITE_DIM + 1;
+    }
+}
+
+internal void
+face_atlas_init(Face *face){
+    Face_Atlas *atlas = &face->atlas;
+    block_zero_struct(atlas);
+    atlas->scratch = make_arena_system(KB(16));
+    
+    u64 page_size = FACE_ATLAS_PAGE_DIM*FACE_ATLAS_PAGE_DIM;
+    atlas->pixels = (u8*)base_allocate(get_base_allocator_system(), page_size).str;
+    block_zero(atlas->pixels, page_size);
+    atlas->page_count = 1;
+    atlas->page_max = 1;
+    face_atlas__reset_page(atlas, 0, 0);
+    
+    for (i32 y = 0; y < FACE_ATLAS_WHITE_DIM; y += 1){
+        block_fill_u8(atlas->pixels + y*FACE_ATLAS_PAGE_DIM, FACE_ATLAS_WHITE_DIM, 0xFF);
+    }
+    
+    Texture_Kind texture_kind = TextureKind_Mono;
+    Vec3_i32 dim = V3i32(FACE_ATLAS_PAGE_DIM, FACE_ATLAS_PAGE_DIM, 1);
+    face->texture_kind = texture_kind;
+    face->texture = graphics_get_texture(dim, texture_kind);
+    face->texture_dim = V3f32(dim);
+    graphics_fill_texture(texture_kind, face->texture, V3i32(0, 0, 0), dim, atlas->pixels);
+    
+    f32 white_uv = (f32)FACE_ATLAS_WHITE_DIM/(f32)FACE_ATLAS_PAGE_DIM;
+    face->white.uv = Rf32(0.f, 0.f, white_uv, white_uv);
+    face->white.w = 0.f;
+}
+
+internal void
+face_atlas_free(Face *face){
+    Face_Atlas *atlas = &face->atlas;
+    if (atlas->pixels != 0){
+        base_free(get_base_allocator_system(), atlas->pixels);
+        linalloc_clear(&atlas->scratch);
+    }
+    block_zero_struct(atlas);
+}
+
+internal void
+face_atlas__grow(Render_Target *target, Face *face){
+    Face_Atlas *atlas = &face->atlas;
+    i32 new_max = clamp_top(atlas->page_max*2, FACE_ATLAS_MAX_PAGES);
+    u64 page_size = FACE_ATLAS_PAGE_DIM*FACE_ATLAS_PAGE_DIM;
+    Base_Allocator *allocator = get_base_allocator_system();
+    u8 *new_pixels = (u8*)base_allocate(allocator, page_size*new_max).str;
+    block_copy(new_pixels, atlas->pixels, page_size*atlas->page_max);
+    block_zero(new_pixels + page_size*atlas->page_max, page_size*(new_max - atlas->page_max));
+    base_free(allocator, atlas->pixels);
+    atlas->pixels = new_pixels;
+    atlas->page_max = new_max;
+    
+    // NOTE: Vertices from earlier in this frame still point at the same pages,
+    // the old texture is only deleted once the renderer switches to the new one.
+    Render_Free_Texture *free_texture = push_array_zero(&target->arena, Render_Free_Texture, 1);
+    free_texture->tex_id = face->texture;
+    sll_queue_push(target->free_texture_first, target->free_texture_last, free_texture);
+    
+    Vec3_i32 dim = V3i32(FACE_ATLAS_PAGE_DIM, FACE_ATLAS_PAGE_DIM, new_max);
+    face->texture = graphics_get_texture(dim, face->texture_kind);
+    face->texture_dim = V3f32(dim);
+    dim.z = atlas->page_count;
+    graphics_fill_texture(face->texture_kind, face->texture, V3i32(0, 0, 0), dim, atlas->pixels);
+}
+
+internal void
+face_atlas__evict_page(Face *face, i32 page, i32 frame_index){
+    u16 index_count = face->advance_map.index_count;
+    for (u16 i = 0; i < index_count; i += 1){
+        if (face->glyph_states[i] == FaceGlyphState_Resident &&
+            (i32)face->bounds[i].w == page){
+            face->glyph_states[i] = FaceGlyphState_Unloaded;
+        }
+    }
+    face_atlas__reset_page(&face->atlas, page, frame_index);
+}
+
+internal b32
+face_atlas__page_fit(Face_Atlas_Page *page, Vec2_i32 dim, Vec2_i32 *p_out){
+    b32 result = false;
+    i32 x = page->x;
+    i32 y = page->y;
+    i32 line_h = page->line_h;
+    if (x + dim.x > FACE_ATLAS_PAGE_DIM){
+        y += line_h;
+        x = 0;
+        line_h = 0;
+    }
+    if (y + dim.y <= FACE_ATLAS_PAGE_DIM){
+        *p_out = V2i32(x, y);
+        page->x = x + dim.x;
+        page->y = y;
+        page->line_h = Max(line_h, dim.y);
+        result = true;
+    }
+    return(result);
+}
+
+internal b32
+face_atlas__alloc(Render_Target *target, Face *face, Vec2_i32 dim, Vec3_i32 *p_out){
+    Face_Atlas *atlas = &face->atlas;
+    i32 frame_index = target->frame_index;
+    b32 result = false;
+    
+    Vec2_i32 p = {};
+    if (face_atlas__page_fit(&atlas->pages[atlas->current_page], dim, &p)){
+        result = true;
+    }
+    else{
+        i32 page = -1;
+        if (atlas->page_count < FACE_ATLAS_MAX_PAGES){
+            if (atlas->page_count == atlas->page_max){
+                face_atlas__grow(target, face);
+            }
+            page = atlas->page_count;
+            atlas->page_count += 1;
+            face_atlas__reset_page(atlas, page, frame_index);
+        }
+        else{
+            i32 oldest_frame = frame_index;
+            for (i32 i = 0; i < atlas->page_count; i += 1){
+                i32 last_used_frame = atlas->pages[i].last_used_frame;
+                if (last_used_frame != frame_index &&
+                    (page == -1 || last_used_frame - oldest_frame < 0)){
+                    page = i;
+                    oldest_frame = last_used_frame;
+                }
+            }
+            if (page != -1){
+                face_atlas__evict_page(face, page, frame_index);
+            }
+        }
+        
+        if (page != -1){
+            atlas->current_page = page;
+            result = face_atlas__page_fit(&atlas->pages[page], dim, &p);
+        }
+    }
+    
+    if (result){
+        *p_out = V3i32(p.x, p.y, atlas->current_page);
+    }
+    return(result);
+}
+
+internal void
+face_atlas__load_glyph(Render_Target *target, Face *face, u16 index){
+    Face_Atlas *atlas = &face->atlas;
+    Arena *scratch = &atlas->scratch;
+    Temp_Memory temp = begin_temp(scratch);
+    
+    Glyph_Bitmap bitmap = {};
+    if (face->rasterize_glyph(face, index, scratch, &bitmap)){
+        Glyph_Bounds *bounds = &face->bounds[index];
+        bounds->xy_off = bitmap.xy_off;
+        
+        Vec2_i32 padded_dim = V2i32(bitmap.dim.x + 1, bitmap.dim.y + 1);
+        if (bitmap.dim.x <= 0 || bitmap.dim.y <= 0 ||
+            padded_dim.x > FACE_ATLAS_PAGE_DIM || padded_dim.y > FACE_ATLAS_PAGE_DIM){
+            face->glyph_states[index] = FaceGlyphState_Empty;
+        }
+        else{
+            Vec3_i32 p = {};
+            if (face_atlas__alloc(target, face, padded_dim, &p)){
+                u8 *page_pixels = face_atlas__page_pixels(atlas, p.z);
+                u8 *padded = push_array_zero(scratch, u8, padded_dim.x*padded_dim.y);
+                for (i32 y = 0; y < bitmap.dim.y; y += 1){
+                    block_copy(padded + y*padded_dim.x, bitmap.data + y*bitmap.dim.x, bitmap.dim.x);
+                }
+                for (i32 y = 0; y < padded_dim.y; y += 1){
+                    block_copy(page_pixels + (p.y + y)*FACE_ATLAS_PAGE_DIM + p.x, padded + y*padded_dim.x, padded_dim.x);
+                }
+                graphics_fill_texture(face->texture_kind, face->texture, p, V3i32(padded_dim.x, padded_dim.y, 1), padded);
+                
+                f32 inv_dim = 1.f/(f32)FACE_ATLAS_PAGE_DIM;
+                bounds->uv = Rf32((f32)p.x*inv_dim, (f32)p.y*inv_dim,
+                                  (f32)(p.x + bitmap.dim.x)*inv_dim, (f32)(p.y + bitmap.dim.y)*inv_dim);
+                bounds->w = (f32)p.z;
+                face->glyph_states[index] = FaceGlyphState_Resident;
+            }
+            else{
+                atlas->had_miss = true;
+            }
+        }
+    }
+    else{
+        face->glyph_states[index] = FaceGlyphState_Empty;
+    }
+    
+    end_temp(temp);
+}
+
+internal void
+face_atlas__begin_frame(Face *face, i32 frame_index){
+    Face_Atlas *atlas = &face->atlas;
+    if (atlas->had_miss){
+        i32 prev_frame = atlas->frame_index;
+        i32 page = 0;
+        i32 min_count = max_i32;
+        for (i32 i = 0; i < atlas->page_count; i += 1){
+            Face_Atlas_Page *atlas_page = &atlas->pages[i];
+            i32 count = 0;
+            if (atlas_page->last_used_frame == prev_frame){
+                count = atlas_page->use_count;
+            }
+            if (count < min_count){
+                page = i;
+                min_count = count;
+            }
+        }
+        face_atlas__evict_page(face, page, frame_index);
+        atlas->current_page = page;
+        atlas->had_miss = false;
+    }
+    atlas->frame_index = frame_index;
+}
+
+internal b32
+face_get_glyph_bounds(Render_Target *target, Face *face, u16 index, Glyph_Bounds *bounds_out){
+    b32 result = false;
+    if (index < face->advance_map.index_count){
+        i32 frame_index = target->frame_index;
+        if (face->atlas.frame_index != frame_index){
+            face_atlas__begin_frame(face, frame_index);
+        }
+        if (face->glyph_states[index] == FaceGlyphState_Unloaded){
+            face_atlas__load_glyph(target, face, index);
+        }
+        if (face->glyph_states[index] == FaceGlyphState_Resident){
+            Glyph_Bounds *bounds = &face->bounds[index];
+            Face_Atlas_Page *page = &face->atlas.pages[(i32)bounds->w];
+            if (page->last_used_frame != frame_index){
+                page->last_used_frame = frame_index;
+                page->use_count = 0;
+            }
+            page->use_count += 1;
+            *bounds_out = *bounds;
+            result = true;
+        }
+    }
+    return(result);
+}
+
+////////////////////////////////
+
 internal Face_ID
 font_set__alloc_face_id(Font_Set *set){
     Face_ID result = 0;
@@ -44,6 +309,15 @@ font_set__free_face_id(Font_Set *set, Face_ID id){
     }
 }
 
+internal void
+font_set__release_face_data(Face *face){
+    table_free(&face->advance_map.codepoint_to_index.table);
+    face_atlas_free(face);
+    if (face->release_face != 0){
+        face->release_face(face);
+    }
+}
+
 internal Font_Face_Slot*
 font_set__alloc_face_slot(Font_Set *set){
     Font_Face_Slot *result = 0;
@@ -60,7 +334,7 @@ font_set__alloc_face_slot(Font_Set *set){
 internal void
 font_set__free_face_slot(Font_Set *set, Font_Face_Slot *slot){
     if (slot->arena.base_allocator != 0){
-        table_free(&slot->face->advance_map.codepoint_to_index.table);
+        font_set__release_face_data(slot->face);
         linalloc_clear(&slot->arena);
     }
     block_zero_struct(slot);
@@ -81,6 +355,7 @@ font_set_new_face(Font_Set *set, Face_Description *description){
     Arena arena = make_arena_system();
     Face *face = font_make_face(&arena, description, set->scale_factor);
     if (face != 0){
+        face_atlas_init(face);
         Font_Face_Slot *slot = font_set__alloc_face_slot(set);
         slot->arena = arena;
         slot->face = face;
@@ -153,6 +428,8 @@ font_set_modify_face(Font_Set *set, Face_ID id, Face_Description *description){
         Arena arena = make_arena_system();
         Face *face = font_make_face(&arena, description, set->scale_factor);
         if (face != 0){
+            face_atlas_init(face);
+            font_set__release_face_data(slot->face);
             linalloc_clear(&slot->arena);
             slot->arena = arena;
             slot->face = face;
@@ -8,106 +8,736 @@
 
 // TOP
 
-internal Node*
-history__to_node(Node *sentinel, i32 index){
-    Node *result = 0;
-    i32 counter = 0;
-    Node *it = sentinel;
-    do{
-        if (counter == index){
-            result = it;
+internal Record*
+history__record_at(Record_Chunk_Array *array, i64 index){
+    Assert(0 <= index && index < array->count);
+    Record *chunk = array->chunks[index/HISTORY_RECORD_CHUNK_SIZE];
+    return(&chunk[index%HISTORY_RECORD_CHUNK_SIZE]);
+}
+
+// NOTE: Chunks are never moved or freed until the history is, so record pointers
+// stay good, and the chunks past count are reused after the array is cut back.
+internal Record*
+history__record_push(History *history, Record_Chunk_Array *array){
+    i64 index = array->count;
+    i64 chunk_index = index/HISTORY_RECORD_CHUNK_SIZE;
+    if (chunk_index == array->chunk_count){
+        if (array->chunk_count == array->chunk_max){
+            i64 new_max = clamp_bot(16, array->chunk_max*2);
+            String_Const_u8 new_memory = base_allocate(&history->heap_wrapper, sizeof(Record*)*new_max);
+            Record **new_chunks = (Record**)new_memory.str;
+            block_copy_dynamic_array(new_chunks, array->chunks, array->chunk_count);
+            if (array->chunks != 0){
+                base_free(&history->heap_wrapper, array->chunks);
+            }
+            array->chunks = new_chunks;
+            array->chunk_max = new_max;
+        }
+        String_Const_u8 new_memory = base_allocate(&history->heap_wrapper, sizeof(Record)*HISTORY_RECORD_CHUNK_SIZE);
+        array->chunks[array->chunk_count] = (Record*)new_memory.str;
+        array->chunk_count += 1;
+    }
+    array->count += 1;
+    Record *result = history__record_at(array, index);
+    block_zero_struct(result);
+    return(result);
+}
+
+// NOTE: Free group slots are chained through group.first_leaf.
+internal i64
+history__alloc_group(History *history){
+    i64 result = history->first_free_group;
+    if (result >= 0){
+        Record *record = history__record_at(&history->groups, result);
+        history->first_free_group = record->group.first_leaf;
+        block_zero_struct(record);
+    }
+    else{
+        result = history->groups.count;
+        history__record_push(history, &history->groups);
+    }
+    return(result);
+}
+
+internal void
+history__free_group(History *history, i64 index){
+    Record *record = history__record_at(&history->groups, index);
+    record->group.first_leaf = history->first_free_group;
+    history->first_free_group = index;
+}
+
+internal Record*
+history__record_from_handle(History *history, Record_Handle handle){
+    Record *result = 0;
+    if (handle >= 0){
+        result = history__record_at(&history->leaves, handle);
+    }
+    else{
+        result = history__record_at(&history->groups, ~handle);
+    }
+    return(result);
+}
+
+internal Range_i64
+history__leaf_range_from_handle(History *history, Record_Handle handle){
+    Range_i64 result = {};
+    if (handle >= 0){
+        result = Ii64(handle, handle + 1);
+    }
+    else{
+        Record *record = history__record_at(&history->groups, ~handle);
+        result = Ii64_size(record->group.first_leaf, record->group.count);
+    }
+    return(result);
+}
+
+internal void
+history__push_top(History *history, Record_Handle handle){
+    Record_Handle_Array *top = &history->top;
+    if (top->count == top->max){
+        i32 new_max = clamp_bot(1024, top->max*2);
+        String_Const_u8 new_memory = base_allocate(&history->heap_wrapper, sizeof(Record_Handle)*new_max);
+        Record_Handle *new_handles = (Record_Handle*)new_memory.str;
+        block_copy_dynamic_array(new_handles, top->handles, top->count);
+        if (top->handles != 0){
+            base_free(&history->heap_wrapper, top->handles);
+        }
+        top->handles = new_handles;
+        top->max = new_max;
+    }
+    top->handles[top->count] = handle;
+    top->count += 1;
+}
+
+////////////////////////////////
+
+// NOTE: A small LZ77 coder for sealed blocks.  The stream is a list of sequences,
+// each one a varint literal count, the literals, a varint match length, and then unless
+// the length is zero (the end of the stream) a varint distance back into the output.
+#define HISTORY_LZ_MIN_MATCH 4
+#define HISTORY_LZ_HASH_BITS 16
+
+internal u8*
+history__put_varint(u8 *dst, u64 x){
+    for (;x >= 0x80;){
+        *dst = (u8)(x | 0x80);
+        dst += 1;
+        x >>= 7;
+    }
+    *dst = (u8)x;
+    dst += 1;
+    return(dst);
+}
+
+internal u8*
+history__get_varint(u8 *src, u8 *end, u64 *x_out){
+    u64 x = 0;
+    u32 shift = 0;
+    for (;src < end && shift < 64;){
+        u8 b = *src;
+        src += 1;
+        x |= ((u64)(b & 0x7F)) << shift;
+        shift += 7;
+        if ((b & 0x80) == 0){
             break;
         }
-        counter += 1;
-        it = it->next;
-    } while (it != sentinel);
+    }
+    *x_out = x;
+    return(src);
+}
+
+internal u32
+history__lz_hash(u8 *ptr){
+    u32 x = 0;
+    block_copy(&x, ptr, 4);
+    return((x*2654435761u) >> (32 - HISTORY_LZ_HASH_BITS));
+}
+
+// NOTE: Returns zero when the output would not be smaller than dst_max.
+internal u64
+history__compress(Arena *scratch, u8 *src, u64 size, u8 *dst, u64 dst_max){
+    Temp_Memory temp = begin_temp(scratch);
+    u32 *table = push_array_zero(scratch, u32, 1 << HISTORY_LZ_HASH_BITS);
+    u8 *out = dst;
+    u8 *out_end = dst + dst_max;
+    b32 fits = true;
+    u64 literal_first = 0;
+    u64 i = 0;
+    for (;i + HISTORY_LZ_MIN_MATCH <= size;){
+        u32 hash = history__lz_hash(src + i);
+        u64 candidate = table[hash];
+        table[hash] = (u32)(i + 1);
+        if (candidate != 0 && block_match(src + candidate - 1, src + i, HISTORY_LZ_MIN_MATCH)){
+            u64 match_pos = candidate - 1;
+            u64 length = HISTORY_LZ_MIN_MATCH;
+            for (;i + length < size && src[match_pos + length] == src[i + length];){
+                length += 1;
+            }
+            u64 literal_count = i - literal_first;
+            if ((u64)(out_end - out) < literal_count + 30){
+                fits = false;
+                break;
+            }
+            out = history__put_varint(out, literal_count);
+            block_copy(out, src + literal_first, literal_count);
+            out += literal_count;
+            out = history__put_varint(out, length);
+            out = history__put_varint(out, i - match_pos);
+            i += length;
+            literal_first = i;
+        }
+        else{
+            i += 1;
+        }
+    }
+    u64 result = 0;
+    if (fits){
+        u64 literal_count = size - literal_first;
+        if ((u64)(out_end - out) >= literal_count + 20){
+            out = history__put_varint(out, literal_count);
+            block_copy(out, src + literal_first, literal_count);
+            out += literal_count;
+            out = history__put_varint(out, 0);
+            if (out < out_end){
+                result = (u64)(out - dst);
+            }
+        }
+    }
+    end_temp(temp);
+    return(result);
+}
+
+internal b32
+history__decompress(u8 *src, u64 src_size, u8 *dst, u64 dst_size){
+    u8 *end = src + src_size;
+    u64 pos = 0;
+    b32 result = false;
+    for (;src < end;){
+        u64 literal_count = 0;
+        src = history__get_varint(src, end, &literal_count);
+        if (literal_count > (u64)(end - src) || literal_count > dst_size - pos){
+            break;
+        }
+        block_copy(dst + pos, src, literal_count);
+        src += literal_count;
+        pos += literal_count;
+        u64 length = 0;
+        src = history__get_varint(src, end, &length);
+        if (length == 0){
+            result = (pos == dst_size);
+            break;
+        }
+        u64 distance = 0;
+        src = history__get_varint(src, end, &distance);
+        if (distance == 0 || distance > pos || length > dst_size - pos){
+            break;
+        }
+        // NOTE: byte by byte, a match can overlap the bytes it writes
+        u8 *from = dst + pos - distance;
+        u8 *to = dst + pos;
+        for (u64 j = 0; j < length; j += 1){
+            to[j] = from[j];
+        }
+        pos += length;
+    }
     return(result);
 }
 
+////////////////////////////////
+
 internal void
-history__push_back_record_ptr(Base_Allocator *allocator, Record_Ptr_Lookup_Table *lookup, Record *record){
-    if (lookup->records == 0 || lookup->count == lookup->max){
-        i32 new_max = clamp_bot(1024, lookup->max*2);
-        String_Const_u8 new_memory = base_allocate(allocator, sizeof(Record*)*new_max);
-        Record **new_records = (Record**)new_memory.str;
-        block_copy(new_records, lookup->records, sizeof(*new_records)*lookup->count);
-        if (lookup->records != 0){
-            base_free(allocator, lookup->records);
+history__adjust_resident(History *history, u64 size, b32 add){
+    if (add){
+        history->log.resident_size += size;
+        history->global_history->resident_size += size;
+    }
+    else{
+        history->log.resident_size -= size;
+        history->global_history->resident_size -= size;
+    }
+}
+
+internal u64
+history__block_stored_size(History_Block *block){
+    return(block->compressed?block->data_size:block->size);
+}
+
+internal History_Spill_Extent*
+history__spill_extent_alloc(Global_History *global_history){
+    History_Spill_Extent *result = global_history->spill_free_nodes;
+    if (result != 0){
+        sll_stack_pop(global_history->spill_free_nodes);
+    }
+    else{
+        result = (History_Spill_Extent*)base_allocate(get_base_allocator_system(), sizeof(*result)).str;
+    }
+    block_zero_struct(result);
+    return(result);
+}
+
+// NOTE: First fit from the ranges blocks left behind, otherwise the end of the file.
+internal u64
+history__spill_reserve(Global_History *global_history, u64 size){
+    u64 result = global_history->spill_file_size;
+    b32 found = false;
+    for (History_Spill_Extent **ptr = &global_history->spill_free_extents;
+         *ptr != 0;
+         ptr = &(*ptr)->next){
+        History_Spill_Extent *extent = *ptr;
+        if (extent->size >= size){
+            result = extent->pos;
+            extent->pos += size;
+            extent->size -= size;
+            if (extent->size == 0){
+                *ptr = extent->next;
+                sll_stack_push(global_history->spill_free_nodes, extent);
+            }
+            found = true;
+            break;
         }
-        lookup->records = new_records;
-        lookup->max = new_max;
     }
-    Assert(lookup->count < lookup->max);
-    lookup->records[lookup->count] = record;
-    lookup->count += 1;
+    if (!found){
+        global_history->spill_file_size += size;
+    }
+    return(result);
 }
 
 internal void
-history__shrink_array(Record_Ptr_Lookup_Table *lookup, i32 new_count){
-    Assert(0 <= new_count && new_count <= lookup->count);
-    lookup->count = new_count;
+history__spill_release(Global_History *global_history, u64 pos, u64 size){
+    global_history->spilled_block_count -= 1;
+    if (global_history->spilled_block_count == 0){
+        // NOTE: Nothing is left in the file, start over from the front.
+        for (;global_history->spill_free_extents != 0;){
+            History_Spill_Extent *extent = global_history->spill_free_extents;
+            sll_stack_pop(global_history->spill_free_extents);
+            sll_stack_push(global_history->spill_free_nodes, extent);
+        }
+        global_history->spill_file_size = 0;
+    }
+    else if (size > 0){
+        History_Spill_Extent *extent = history__spill_extent_alloc(global_history);
+        extent->pos = pos;
+        extent->size = size;
+        sll_stack_push(global_history->spill_free_extents, extent);
+    }
 }
 
 internal void
-history__merge_record_ptr_range_to_one_ptr(Record_Ptr_Lookup_Table *lookup, i32 first_one_based, i32 last_one_based, Record *record){
-    i32 first = first_one_based - 1;
-    i32 one_past_last = last_one_based;
-    Assert(0 <= first && first <= one_past_last && one_past_last <= lookup->count);
-    if (first < one_past_last){
-        i32 shift = 1 + first - one_past_last;
-        block_copy(lookup->records + one_past_last + shift, lookup->records + one_past_last, lookup->count - one_past_last);
-        lookup->count += shift;
+history__drop_spill_copy(History *history, History_Block *block){
+    if (block->spilled){
+        history__spill_release(history->global_history, block->spill_pos, history__block_stored_size(block));
+        block->spilled = false;
+        block->spill_pos = 0;
     }
-    lookup->records[first] = record;
 }
 
-internal Node*
-history__to_node(History *history, i32 index){
-    Node *result = 0;
-    if (index == 0){
-        result = &history->records;
+internal void
+history__drop_cache(History *history){
+    History_Log *log = &history->log;
+    if (log->cache_data != 0){
+        base_free(get_base_allocator_system(), log->cache_data);
+        history__adjust_resident(history, log->cache_size, false);
+        log->cache_data = 0;
+        log->cache_size = 0;
     }
-    else if (0 < index && index <= history->record_count){
-        Record_Ptr_Lookup_Table *lookup = &history->record_lookup;
-        Assert(lookup->count == history->record_count);
-        result = &lookup->records[index - 1]->node;
+    log->cache_index = -1;
+}
+
+// NOTE: The copy in the spill file stays behind after a page in, so a block that
+// is spilled again doesn't have to be written again.  Writes are not synced, the file
+// only has to last as long as the process.
+internal b32
+history__spill_block(History *history, History_Block *block){
+    Global_History *global_history = history->global_history;
+    b32 result = false;
+    if (block->sealed && block->data != 0 && !global_history->spill_failed){
+        u64 stored_size = history__block_stored_size(block);
+        if (!global_history->spill_file_open){
+            Temp_Memory temp = begin_temp(&global_history->arena);
+            global_history->spill_file_open = system_scratch_file_open(&global_history->arena, &global_history->spill_file);
+            end_temp(temp);
+            if (!global_history->spill_file_open){
+                // NOTE: Without a temp directory the budgets are only soft.
+                global_history->spill_failed = true;
+            }
+        }
+        if (!block->spilled && global_history->spill_file_open){
+            u64 pos = history__spill_reserve(global_history, stored_size);
+            global_history->spilled_block_count += 1;
+            if (system_scratch_file_write(global_history->spill_file, pos, SCu8(block->data, stored_size))){
+                block->spilled = true;
+                block->spill_pos = pos;
+            }
+            else{
+                history__spill_release(global_history, pos, stored_size);
+                global_history->spill_failed = true;
+            }
+        }
+        if (block->spilled){
+            base_free(get_base_allocator_system(), block->data);
+            history__adjust_resident(history, block->data_size, false);
+            block->data = 0;
+            block->data_size = stored_size;
+            result = true;
+        }
     }
     return(result);
 }
 
-////////////////////////////////
+internal b32
+history__page_in_block(History *history, History_Block *block){
+    Global_History *global_history = history->global_history;
+    b32 result = (block->data != 0);
+    if (!result && block->spilled){
+        u8 *data = (u8*)base_allocate(get_base_allocator_system(), block->data_size).str;
+        if (system_scratch_file_read(global_history->spill_file, block->spill_pos, data, block->data_size)){
+            block->data = data;
+            history__adjust_resident(history, block->data_size, true);
+            result = true;
+        }
+        else{
+            base_free(get_base_allocator_system(), data);
+        }
+    }
+    return(result);
+}
 
-internal Record*
-history__allocate_record(History *history){
-    Node *sentinel = &history->free_records;
-    Node *new_node = sentinel->next;
-    if (new_node == sentinel){
-        i32 new_record_count = 1024;
-        String_Const_u8 new_memory = base_allocate(&history->heap_wrapper, sizeof(Record)*new_record_count);
-        void *memory = new_memory.str;
-        
-        Record *new_record = (Record*)memory;
-        sentinel->next = &new_record->node;
-        new_record->node.prev = sentinel;
-        for (i32 i = 1; i < new_record_count; i += 1, new_record += 1){
-            new_record[0].node.next = &new_record[1].node;
-            new_record[1].node.prev = &new_record[0].node;
-        }
-        new_record[0].node.next = sentinel;
-        sentinel->prev = &new_record[0].node;
-        
-        new_node = &((Record*)memory)->node;
+// NOTE: Returns the decoded bytes of a block, or zero if it was spilled and can't
+// be read back.  The bytes of a compressed block are only good until the next call.
+internal u8*
+history__block_bytes(History *history, i64 index){
+    History_Log *log = &history->log;
+    History_Block *block = &log->blocks[index];
+    u8 *result = 0;
+    if (history__page_in_block(history, block)){
+        if (!block->compressed){
+            result = block->data;
+        }
+        else if (log->cache_index == index){
+            result = log->cache_data;
+        }
+        else{
+            history__drop_cache(history);
+            u8 *data = (u8*)base_allocate(get_base_allocator_system(), block->size).str;
+            if (history__decompress(block->data, block->data_size, data, block->size)){
+                log->cache_index = index;
+                log->cache_data = data;
+                log->cache_size = block->size;
+                history__adjust_resident(history, block->size, true);
+                result = data;
+            }
+            else{
+                base_free(get_base_allocator_system(), data);
+            }
+        }
+    }
+    return(result);
+}
+
+internal void
+history__seal_block(History *history, History_Block *block){
+    Global_History *global_history = history->global_history;
+    block->sealed = true;
+    if (global_history->compact){
+        Base_Allocator *allocator = get_base_allocator_system();
+        Temp_Memory temp = begin_temp(&global_history->arena);
+        u8 *packed = push_array(&global_history->arena, u8, block->size);
+        u64 packed_size = 0;
+        if (block->size <= max_u32){
+            packed_size = history__compress(&global_history->arena, block->data, block->size, packed, block->size);
+        }
+        u64 new_size = block->size;
+        u8 *new_data = 0;
+        if (packed_size > 0){
+            new_size = packed_size;
+            new_data = (u8*)base_allocate(allocator, new_size).str;
+            block_copy(new_data, packed, new_size);
+            block->compressed = true;
+        }
+        else if (block->size < block->data_size){
+            new_data = (u8*)base_allocate(allocator, new_size).str;
+            block_copy(new_data, block->data, new_size);
+        }
+        if (new_data != 0){
+            base_free(allocator, block->data);
+            history__adjust_resident(history, block->data_size, false);
+            history__adjust_resident(history, new_size, true);
+            block->data = new_data;
+            block->data_size = new_size;
+        }
+        end_temp(temp);
+    }
+}
+
+internal void
+history__unseal_block(History *history, i64 index){
+    History_Log *log = &history->log;
+    History_Block *block = &log->blocks[index];
+    if (block->sealed && !block->compressed && block->data != 0 && block->data_size == block->max){
+        history__drop_spill_copy(history, block);
+        block->sealed = false;
+    }
+    else if (block->sealed){
+        u8 *bytes = history__block_bytes(history, index);
+        u8 *data = (u8*)base_allocate(get_base_allocator_system(), block->max).str;
+        if (bytes != 0){
+            block_copy(data, bytes, block->size);
+        }
+        else{
+            block_zero(data, block->size);
+        }
+        if (block->data != 0){
+            base_free(get_base_allocator_system(), block->data);
+            history__adjust_resident(history, block->data_size, false);
+        }
+        history__drop_spill_copy(history, block);
+        history__drop_cache(history);
+        block->data = data;
+        block->data_size = block->max;
+        history__adjust_resident(history, block->data_size, true);
+        block->sealed = false;
+        block->compressed = false;
     }
-    dll_remove(new_node);
-    Record *record = CastFromMember(Record, node, new_node);
-    block_zero_struct(record);
-    return(record);
 }
 
+internal void
+history__free_block(History *history, History_Block *block){
+    if (block->data != 0){
+        base_free(get_base_allocator_system(), block->data);
+        history__adjust_resident(history, block->data_size, false);
+        block->data = 0;
+    }
+    history__drop_spill_copy(history, block);
+}
+
+// NOTE: Makes sure the open block has room for size more bytes and returns where
+// they go.  Blocks start small and grow up to HISTORY_BLOCK_SIZE, so a buffer that is
+// only edited a little doesn't hold on to a whole block.  A text bigger than that gets
+// a block of its own, every text is in one block.
+internal u8*
+history__log_reserve(History *history, u64 size){
+    History_Log *log = &history->log;
+    History_Block *block = 0;
+    if (log->block_count > 0){
+        block = &log->blocks[log->block_count - 1];
+        if (block->sealed){
+            block = 0;
+        }
+        else if (block->size + size > block->max){
+            if (block->size == 0){
+                history__free_block(history, block);
+                log->block_count -= 1;
+            }
+            else{
+                history__seal_block(history, block);
+            }
+            block = 0;
+        }
+    }
+    if (block == 0){
+        if (log->block_count == log->block_max){
+            i64 new_max = clamp_bot(16, log->block_max*2);
+            String_Const_u8 new_memory = base_allocate(&history->heap_wrapper, sizeof(History_Block)*new_max);
+            History_Block *new_blocks = (History_Block*)new_memory.str;
+            block_copy_dynamic_array(new_blocks, log->blocks, log->block_count);
+            if (log->blocks != 0){
+                base_free(&history->heap_wrapper, log->blocks);
+            }
+            log->blocks = new_blocks;
+            log->block_max = new_max;
+        }
+        u64 max = HISTORY_BLOCK_SIZE;
+        if (log->block_count < 6){
+            max = HISTORY_BLOCK_FIRST_SIZE << log->block_count;
+        }
+        max = Max(max, size);
+        block = &log->blocks[log->block_count];
+        log->block_count += 1;
+        block_zero_struct(block);
+        block->first = log->pos;
+        block->max = max;
+        block->data = (u8*)base_allocate(get_base_allocator_system(), max).str;
+        block->data_size = max;
+        history__adjust_resident(history, max, true);
+    }
+    return(block->data + block->size);
+}
+
+internal u64
+history__log_commit(History *history, u64 size){
+    History_Log *log = &history->log;
+    History_Block *block = &log->blocks[log->block_count - 1];
+    Assert(!block->sealed && block->size + size <= block->max);
+    u64 pos = log->pos;
+    block->size += size;
+    log->pos += size;
+    return(pos);
+}
+
+internal void
+history__log_truncate(History *history, u64 pos){
+    History_Log *log = &history->log;
+    if (pos < log->pos){
+        i64 keep_count = log->block_count;
+        for (;keep_count > 0 && log->blocks[keep_count - 1].first >= pos;){
+            keep_count -= 1;
+            history__free_block(history, &log->blocks[keep_count]);
+        }
+        log->block_count = keep_count;
+        history__drop_cache(history);
+        if (keep_count > 0){
+            History_Block *block = &log->blocks[keep_count - 1];
+            if (block->first + block->size > pos){
+                history__unseal_block(history, keep_count - 1);
+                block->size = pos - block->first;
+            }
+        }
+        log->pos = pos;
+    }
+}
+
+internal i64
+history__log_block_index(History_Log *log, u64 pos){
+    i64 first = 0;
+    i64 one_past_last = log->block_count;
+    for (;first + 1 < one_past_last;){
+        i64 mid = (first + one_past_last)/2;
+        if (log->blocks[mid].first <= pos){
+            first = mid;
+        }
+        else{
+            one_past_last = mid;
+        }
+    }
+    return(first);
+}
+
+// NOTE: Texts in raw blocks are handed out in place when compact mode is off, the
+// same way they were when records pointed into an arena.  Everything else is copied into
+// the arena.
+internal String_Const_u8
+history__log_read(Arena *arena, History *history, u64 pos, u64 size){
+    String_Const_u8 result = {};
+    if (size > 0){
+        History_Log *log = &history->log;
+        i64 index = history__log_block_index(log, pos);
+        History_Block *block = &log->blocks[index];
+        Assert(block->first <= pos && pos + size <= block->first + block->size);
+        u8 *bytes = history__block_bytes(history, index);
+        if (bytes != 0){
+            u8 *str = bytes + (pos - block->first);
+            if (!block->compressed && !history->global_history->compact){
+                result = SCu8(str, size);
+            }
+            else{
+                result = push_string_copy(arena, SCu8(str, size));
+            }
+        }
+        else{
+            // NOTE: The spill file is gone, there is nothing left to give back.
+            result = SCu8(push_array_zero(arena, u8, size), size);
+        }
+    }
+    return(result);
+}
+
+// NOTE: The backward text goes straight from the buffer's chunks into the log, and
+// the forward text right after it, so the two end up in the same block where the
+// compressor can find what they have in common.
+internal void
+history__store_texts(History *history, Record *record, List_String_Const_u8 backward, String_Const_u8 forward){
+    u64 backward_size = backward.total_size;
+    u8 *dst = history__log_reserve(history, backward_size + forward.size);
+    u8 *ptr = dst;
+    for (Node_String_Const_u8 *node = backward.first;
+         node != 0;
+         node = node->next){
+        block_copy(ptr, node->string.str, node->string.size);
+        ptr += node->string.size;
+    }
+    
+    u64 prefix = 0;
+    u64 suffix = 0;
+    if (history->global_history->compact){
+        u64 max = Min(backward_size, forward.size);
+        for (;prefix < max && dst[prefix] == forward.str[prefix];){
+            prefix += 1;
+        }
+        for (;prefix + suffix < max &&
+             dst[backward_size - 1 - suffix] == forward.str[forward.size - 1 - suffix];){
+            suffix += 1;
+        }
+    }
+    u64 middle_size = forward.size - prefix - suffix;
+    block_copy(ptr, forward.str + prefix, middle_size);
+    
+    u64 pos = history__log_commit(history, backward_size + middle_size);
+    record->single.backward_text.pos = pos;
+    record->single.backward_text.size = backward_size;
+    record->single.forward_text.pos = pos + backward_size;
+    record->single.forward_text.size = forward.size;
+    record->single.forward_text.shared_prefix = prefix;
+    record->single.forward_text.shared_suffix = suffix;
+}
+
+internal void
+history__spill_until(History *history, u64 *resident_size, u64 budget){
+    if (*resident_size > budget){
+        history__drop_cache(history);
+    }
+    History_Log *log = &history->log;
+    for (i64 i = 0; i < log->block_count && *resident_size > budget; i += 1){
+        History_Block *block = &log->blocks[i];
+        if (block->sealed && block->data != 0){
+            if (!history__spill_block(history, block)){
+                break;
+            }
+        }
+    }
+}
+
+// NOTE: Histories are kept in order of their last edit, so when everything
+// together is over budget the ones edited longest ago are spilled first.
+internal void
+history__enforce_budget(History *history){
+    Global_History *global_history = history->global_history;
+    dll_remove(&history->node);
+    dll_insert_back(&global_history->histories, &history->node);
+    if (global_history->compact){
+        if (global_history->buffer_budget > 0){
+            history__spill_until(history, &history->log.resident_size, global_history->buffer_budget);
+        }
+        if (global_history->global_budget > 0){
+            Node *sentinel = &global_history->histories;
+            for (Node *node = sentinel->next;
+                 node != sentinel && global_history->resident_size > global_history->global_budget && !global_history->spill_failed;
+                 node = node->next){
+                History *other = CastFromMember(History, node, node);
+                history__spill_until(other, &global_history->resident_size, global_history->global_budget);
+            }
+        }
+    }
+}
+
+////////////////////////////////
+
 internal void
 global_history_init(Global_History *global_history){
     global_history->edit_number_counter = 0;
     global_history->edit_grouping_counter = 0;
+    global_history->arena = make_arena_system();
+    dll_init_sentinel(&global_history->histories);
+    global_history->compact = false;
+    global_history->buffer_budget = MB(64);
+    global_history->global_budget = MB(512);
+    global_history->resident_size = 0;
+    block_zero_struct(&global_history->spill_file);
+    global_history->spill_file_open = false;
+    global_history->spill_failed = false;
+    global_history->spill_file_size = 0;
+    global_history->spilled_block_count = 0;
+    global_history->spill_free_extents = 0;
+    global_history->spill_free_nodes = 0;
 }
 
 internal i32
@@ -131,13 +761,17 @@ global_history_adjust_edit_grouping_counter(Global_History *global_history, i32
 internal void
 history_init(Thread_Context *tctx, Models *models, History *history){
     history->activated = true;
-    history->arena = make_arena_system();
+    history->global_history = &models->global_history;
+    dll_insert_back(&history->global_history->histories, &history->node);
+    block_zero_struct(&history->log);
+    history->log.cache_index = -1;
+    history->info_arena = make_arena_system();
     heap_init(&history->heap, tctx->allocator);
     history->heap_wrapper = base_allocator_on_heap(&history->heap);
-    dll_init_sentinel(&history->free_records);
-    dll_init_sentinel(&history->records);
-    history->record_count = 0;
-    block_zero_struct(&history->record_lookup);
+    block_zero_struct(&history->leaves);
+    block_zero_struct(&history->groups);
+    history->first_free_group = -1;
+    block_zero_struct(&history->top);
 }
 
 internal b32
@@ -148,7 +782,13 @@ history_is_activated(History *history){
 internal void
 history_free(Thread_Context *tctx, History *history){
     if (history->activated){
-        linalloc_clear(&history->arena);
+        History_Log *log = &history->log;
+        for (i64 i = 0; i < log->block_count; i += 1){
+            history__free_block(history, &log->blocks[i]);
+        }
+        history__drop_cache(history);
+        dll_remove(&history->node);
+        linalloc_clear(&history->info_arena);
         heap_free_all(&history->heap);
         block_zero_struct(history);
     }
@@ -158,7 +798,7 @@ internal i32
 history_get_record_count(History *history){
     i32 result = 0;
     if (history->activated){
-        result = history->record_count;
+        result = history->top.count;
     }
     return(result);
 }
@@ -167,89 +807,64 @@ internal Record*
 history_get_record(History *history, i32 index){
     Record *result = 0;
     if (history->activated){
-        Node *node = history__to_node(history, index);
-        if (node != 0){
-            result = CastFromMember(Record, node, node);
+        if (0 < index && index <= history->top.count){
+            result = history__record_from_handle(history, history->top.handles[index - 1]);
         }
     }
     return(result);
 }
 
 internal Record*
-history_get_sub_record(Record *record, i32 sub_index_one_based){
+history_get_sub_record(History *history, Record *record, i32 sub_index_one_based){
     Record *result = 0;
     if (record->kind == RecordKind_Group){
         if (0 < sub_index_one_based && sub_index_one_based <= record->group.count){
-            Node *node = history__to_node(&record->group.children, sub_index_one_based);
-            if (node != 0){
-                result = CastFromMember(Record, node, node);
-            }
+            result = history__record_at(&history->leaves, record->group.first_leaf + sub_index_one_based - 1);
         }
     }
     return(result);
 }
 
-internal Record*
-history_get_dummy_record(History *history){
-    Record *result = 0;
-    if (history->activated){
-        result = CastFromMember(Record, node, &history->records);
-    }
-    return(result);
+// NOTE: The texts of a single record.  When compact mode is off they usually point
+// right into the log and stay good until the history is cut back past the record.
+// Otherwise they are copied into the arena.
+internal String_Const_u8
+history_get_backward_text(Arena *arena, History *history, Record *record){
+    Assert(record->kind == RecordKind_Single);
+    History_Text text = record->single.backward_text;
+    return(history__log_read(arena, history, text.pos, text.size));
 }
 
-internal void
-history__stash_record(History *history, Record *new_record){
-    Assert(history->record_lookup.count == history->record_count);
-    dll_insert_back(&history->records, &new_record->node);
-    history->record_count += 1;
-    history__push_back_record_ptr(&history->heap_wrapper, &history->record_lookup, new_record);
-    Assert(history->record_lookup.count == history->record_count);
-}
-
-internal void
-history__free_single_node(History *history, Node *node){
-    dll_remove(node);
-    dll_insert(&history->free_records, node);
-}
-
-internal void
-history__free_nodes(History *history, i32 first_index, Node *first_node, Node *last_node){
-    if (first_node == last_node){
-        history__free_single_node(history, first_node);
+internal String_Const_u8
+history_get_forward_text(Arena *arena, History *history, Record *record){
+    Assert(record->kind == RecordKind_Single);
+    History_Text text = record->single.forward_text;
+    String_Const_u8 result = {};
+    if (text.shared_prefix + text.shared_suffix == 0){
+        result = history__log_read(arena, history, text.pos, text.size);
     }
     else{
-        {
-            Node *left = first_node->prev;
-            Node *right = last_node->next;
-            left->next = right;
-            right->prev = left;
-        }
-        
-        {
-            Node *left = &history->free_records;
-            Node *right = left->next;
-            left->next = first_node;
-            first_node->prev = left;
-            right->prev = last_node;
-            last_node->next = right;
-        }
+        u64 middle_size = text.size - text.shared_prefix - text.shared_suffix;
+        String_Const_u8 backward = history_get_backward_text(arena, history, record);
+        String_Const_u8 middle = history__log_read(arena, history, text.pos, middle_size);
+        u8 *str = push_array(arena, u8, text.size);
+        block_copy(str, backward.str, text.shared_prefix);
+        block_copy(str + text.shared_prefix, middle.str, middle_size);
+        block_copy(str + text.shared_prefix + middle_size,
+                   backward.str + backward.size - text.shared_suffix, text.shared_suffix);
+        result = SCu8(str, text.size);
     }
-    Assert(first_index != 0);
-    history->record_count = first_index - 1;
-    history__shrink_array(&history->record_lookup, history->record_count);
+    return(result);
 }
 
 internal void
 history_record_edit(Global_History *global_history, History *history, Gap_Buffer *buffer,
                     i64 pos_before_edit, Edit edit){
     if (history->activated){
-        Assert(history->record_lookup.count == history->record_count);
+        Record *new_record = history__record_push(history, &history->leaves);
+        history__push_top(history, history->leaves.count - 1);
         
-        Record *new_record = history__allocate_record(history);
-        history__stash_record(history, new_record);
-        
-        new_record->restore_point = begin_temp(&history->arena);
+        new_record->restore_point = history->log.pos;
         if (pos_before_edit >= 0){
             new_record->pos_before_edit = pos_before_edit;
         }
@@ -261,184 +876,194 @@ history_record_edit(Global_History *global_history, History *history, Gap_Buffer
         
         new_record->kind = RecordKind_Single;
         
-        new_record->single.forward_text = push_string_copy(&history->arena, edit.text);
-        new_record->single.backward_text = buffer_stringify(&history->arena, buffer, edit.range);
+        {
+            Temp_Memory temp = begin_temp(&global_history->arena);
+            List_String_Const_u8 chunks = buffer_get_chunks(&global_history->arena, buffer, edit.range);
+            history__store_texts(history, new_record, chunks, edit.text);
+            end_temp(temp);
+        }
         new_record->single.first = edit.range.first;
         
-        Assert(history->record_lookup.count == history->record_count);
+        history__enforce_budget(history);
     }
 }
 
+// NOTE: Called before a sorted batch lands.  The whole batch becomes one group
+// record with a leaf per edit, the same shape history_merge_records makes, but nothing
+// is stashed and merged per edit.  Each leaf's first is where its edit lands after the
+// edits before it, just like a group of single edits applied in order.
 internal void
-history_dump_records_after_index(History *history, i32 index){
+history_record_batch(Arena *scratch, Global_History *global_history, History *history, Gap_Buffer *buffer,
+                     i64 pos_before_edit, Batch_Edit *batch){
     if (history->activated){
-        Assert(history->record_lookup.count == history->record_count);
+        i64 group_index = history__alloc_group(history);
+        history__push_top(history, ~group_index);
+        Record *new_record = history__record_at(&history->groups, group_index);
         
-        Assert(0 <= index && index <= history->record_count);
-        if (index < history->record_count){
-            Node *node = history__to_node(history, index);
-            Node *first_node_to_clear = node->next;
-            
-            Node *sentinel = &history->records;
-            Assert(first_node_to_clear != sentinel);
-            
-            Record *first_record_to_clear = CastFromMember(Record, node, first_node_to_clear);
-            end_temp(first_record_to_clear->restore_point);
+        new_record->restore_point = history->log.pos;
+        if (pos_before_edit >= 0){
+            new_record->pos_before_edit = pos_before_edit;
+        }
+        else{
+            new_record->pos_before_edit = batch->edit.range.min;
+        }
+        new_record->edit_number = global_history_get_edit_number(global_history);
+        new_record->kind = RecordKind_Group;
+        new_record->group.first_leaf = history->leaves.count;
+        
+        i32 count = 0;
+        i64 shift = 0;
+        for (Batch_Edit *edit = batch;
+             edit != 0;
+             edit = edit->next){
+            Record *child = history__record_push(history, &history->leaves);
+            child->restore_point = history->log.pos;
+            child->pos_before_edit = new_record->pos_before_edit;
+            child->edit_number = new_record->edit_number;
+            child->kind = RecordKind_Single;
             
-            Node *last_node_to_clear = sentinel->prev;
+            Range_i64 range = edit->edit.range;
+            {
+                Temp_Memory temp = begin_temp(scratch);
+                List_String_Const_u8 chunks = buffer_get_chunks(scratch, buffer, range);
+                history__store_texts(history, child, chunks, edit->edit.text);
+                end_temp(temp);
+            }
+            child->single.first = range.first + shift;
             
-            history__free_nodes(history, index + 1, first_node_to_clear, last_node_to_clear);
+            count += 1;
+            shift += replace_range_shift(range, (i64)edit->edit.text.size);
         }
+        new_record->group.count = count;
         
-        Assert(history->record_lookup.count == history->record_count);
+        history__enforce_budget(history);
+    }
+}
+
+internal void
+history_dump_records_after_index(History *history, i32 index){
+    if (history->activated){
+        Record_Handle_Array *top = &history->top;
+        Assert(0 <= index && index <= top->count);
+        if (index < top->count){
+            Record_Handle first_handle = top->handles[index];
+            Record *first_record_to_clear = history__record_from_handle(history, first_handle);
+            history__log_truncate(history, first_record_to_clear->restore_point);
+            history->leaves.count = history__leaf_range_from_handle(history, first_handle).first;
+            
+            for (i32 i = index; i < top->count; i += 1){
+                if (top->handles[i] < 0){
+                    history__free_group(history, ~top->handles[i]);
+                }
+            }
+            top->count = index;
+        }
     }
 }
 
+// NOTE: Only called on the last record, so the group's leaves are the last leaves
+// and merging the last two is just popping one.
 internal void
-history__optimize_group(Arena *scratch, History *history, Record *record){
-    Assert(record->kind == RecordKind_Group);
+history__optimize_group(Arena *scratch, History *history, i32 top_index){
+    Record_Handle handle = history->top.handles[top_index];
+    Assert(handle < 0);
+    Record *record = history__record_at(&history->groups, ~handle);
     for (;;){
-        Record *right = CastFromMember(Record, node, record->group.children.prev);
         if (record->group.count == 1){
-            Record *child = right;
-            record->restore_point = child->restore_point;
-            record->pos_before_edit = child->pos_before_edit;
-            record->edit_number = child->edit_number;
-            record->kind = RecordKind_Single;
-            record->single = child->single;
-            // NOTE(allen): don't use "free" because the child node is no longer linked
-            // to a valid sentinel, and removing it first (as free does) will mess with
-            // the data in record->single
-            dll_insert(&history->free_records, &child->node);
+            history->top.handles[top_index] = record->group.first_leaf;
+            history__free_group(history, ~handle);
             break;
         }
-        Record *left  = CastFromMember(Record, node, right->node.prev);
-        if (right->kind == RecordKind_Single && left->kind == RecordKind_Single){
-            b32 do_merge = false;
-            
-            Temp_Memory temp = begin_temp(scratch);
-            i64 new_length_forward  = left->single.forward_text.size  + right->single.forward_text.size ;
-            i64 new_length_backward = left->single.backward_text.size + right->single.backward_text.size;
-            
-            String_Const_u8 merged_forward = {};
-            String_Const_u8 merged_backward = {};
-            
-            i64 merged_first = 0;
-            if (left->single.first + (i64)left->single.forward_text.size == right->single.first){
-                do_merge = true;
-                merged_forward = push_u8_stringf(scratch, "%.*s%.*s",
-                                                 string_expand(left->single.forward_text),
-                                                 string_expand(right->single.forward_text));
-                merged_backward = push_u8_stringf(scratch, "%.*s%.*s",
-                                                  string_expand(left->single.backward_text),
-                                                  string_expand(right->single.backward_text));
-                merged_first = left->single.first;
-            }
-            else if (right->single.first + (i64)right->single.backward_text.size == left->single.first){
-                do_merge = true;
-                merged_forward = push_u8_stringf(scratch, "%.*s%.*s",
-                                                 string_expand(right->single.forward_text),
-                                                 string_expand(left->single.forward_text));
-                merged_backward = push_u8_stringf(scratch, "%.*s%.*s",
-                                                  string_expand(right->single.backward_text),
-                                                  string_expand(left->single.backward_text));
-                merged_first = right->single.first;
-            }
-            else{
-                break;
-            }
-            
-            if (do_merge){
-                end_temp(left->restore_point);
-                
-                left->edit_number = right->edit_number;
-                left->single.first = merged_first;
-                left->single.forward_text  = push_string_copy(&history->arena, merged_forward);
-                left->single.backward_text = push_string_copy(&history->arena, merged_backward);
-                
-                history__free_single_node(history, &right->node);
-                record->group.count -= 1;
-            }
-            
-            end_temp(temp);
+        i64 right_index = record->group.first_leaf + record->group.count - 1;
+        Assert(right_index == history->leaves.count - 1);
+        Record *right = history__record_at(&history->leaves, right_index);
+        Record *left  = history__record_at(&history->leaves, right_index - 1);
+        
+        Temp_Memory temp = begin_temp(scratch);
+        
+        Record *first_part = 0;
+        Record *second_part = 0;
+        i64 merged_first = 0;
+        if (left->single.first + (i64)left->single.forward_text.size == right->single.first){
+            first_part = left;
+            second_part = right;
+            merged_first = left->single.first;
+        }
+        else if (right->single.first + (i64)right->single.backward_text.size == left->single.first){
+            first_part = right;
+            second_part = left;
+            merged_first = right->single.first;
         }
         else{
+            end_temp(temp);
             break;
         }
+        
+        String_Const_u8 merged_forward = push_u8_stringf(scratch, "%.*s%.*s",
+                                                         string_expand(history_get_forward_text(scratch, history, first_part)),
+                                                         string_expand(history_get_forward_text(scratch, history, second_part)));
+        String_Const_u8 merged_backward = push_u8_stringf(scratch, "%.*s%.*s",
+                                                          string_expand(history_get_backward_text(scratch, history, first_part)),
+                                                          string_expand(history_get_backward_text(scratch, history, second_part)));
+        List_String_Const_u8 backward_list = {};
+        string_list_push(scratch, &backward_list, merged_backward);
+        
+        history__log_truncate(history, left->restore_point);
+        
+        left->edit_number = right->edit_number;
+        left->single.first = merged_first;
+        history__store_texts(history, left, backward_list, merged_forward);
+        
+        history->leaves.count -= 1;
+        record->group.count -= 1;
+        
+        end_temp(temp);
     }
 }
 
+// NOTE: The records in the range cover a run of leaves, so the new group is just
+// that run.  Groups that get swallowed go back on the free list.
 internal void
 history_merge_records(Arena *scratch, History *history, i32 first_index, i32 last_index){
     if (history->activated){
-        Assert(history->record_lookup.count == history->record_count);
+        Record_Handle_Array *top = &history->top;
         Assert(first_index < last_index);
-        Node *first_node = history__to_node(history, first_index);
-        Node *last_node  = history__to_node(history, last_index );
-        Assert(first_node != &history->records && first_node != 0);
-        Assert(last_node  != &history->records && last_node  != 0);
+        Assert(0 < first_index && last_index <= top->count);
         
-        Record *new_record = history__allocate_record(history);
+        Record_Handle first_handle = top->handles[first_index - 1];
+        Record_Handle last_handle  = top->handles[last_index - 1];
+        Record *first_record = history__record_from_handle(history, first_handle);
+        Record *last_record  = history__record_from_handle(history, last_handle);
         
-        // NOTE(allen): here we remove (last_index - first_index + 1) nodes, and insert 1 node
-        // which simplifies to this:
-        history->record_count -= last_index - first_index;
+        u64 restore_point = first_record->restore_point;
+        i64 pos_before_edit = first_record->pos_before_edit;
+        i32 edit_number = last_record->edit_number;
+        i64 first_leaf = history__leaf_range_from_handle(history, first_handle).first;
+        i64 one_past_last_leaf = history__leaf_range_from_handle(history, last_handle).one_past_last;
         
-        Node *left = first_node->prev;
-        dll_remove_multiple(first_node, last_node);
-        dll_insert(left, &new_record->node);
-        
-        Record *first_record = CastFromMember(Record, node, first_node);
-        Record *last_record  = CastFromMember(Record, node, last_node);
-        
-        new_record->restore_point = first_record->restore_point;
-        new_record->pos_before_edit = first_record->pos_before_edit;
-        new_record->edit_number = last_record->edit_number;
-        new_record->kind = RecordKind_Group;
-        
-        Node *new_sentinel = &new_record->group.children;
-        dll_init_sentinel(new_sentinel);
-        
-        i32 count = 0;
-        for (Node *node = first_node, *next = 0;
-             node != 0;
-             node = next){
-            next = node->next;
-            Record *record = CastFromMember(Record, node, node);
-            switch (record->kind){
-                case RecordKind_Single:
-                {
-                    dll_insert_back(new_sentinel, &record->node);
-                    count += 1;
-                }break;
-                
-                case RecordKind_Group:
-                {
-                    Node *first = record->group.children.next;
-                    Node *last  = record->group.children.prev;
-                    Assert(first != &record->group.children);
-                    Assert(last  != &record->group.children);
-                    
-                    dll_insert_multiple_back(new_sentinel, first, last);
-                    count += record->group.count;
-                    
-                    // TODO(allen): free the record for the old group!?
-                }break;
-                
-                default:
-                {
-                    InvalidPath;
-                }break;
+        for (i32 i = first_index - 1; i < last_index; i += 1){
+            if (top->handles[i] < 0){
+                history__free_group(history, ~top->handles[i]);
             }
         }
         
-        new_record->group.count = count;
+        i64 group_index = history__alloc_group(history);
+        Record *new_record = history__record_at(&history->groups, group_index);
+        new_record->restore_point = restore_point;
+        new_record->pos_before_edit = pos_before_edit;
+        new_record->edit_number = edit_number;
+        new_record->kind = RecordKind_Group;
+        new_record->group.first_leaf = first_leaf;
+        new_record->group.count = (i32)(one_past_last_leaf - first_leaf);
         
-        history__merge_record_ptr_range_to_one_ptr(&history->record_lookup, first_index, last_index, new_record);
-        Assert(history->record_lookup.count == history->record_count);
+        // NOTE(allen): here we remove (last_index - first_index + 1) handles, and insert 1
+        // handle which simplifies to this:
+        top->handles[first_index - 1] = ~group_index;
+        block_copy_dynamic_array(top->handles + first_index, top->handles + last_index, top->count - last_index);
+        top->count -= last_index - first_index;
         
-        if (first_index == history->record_count){
-            history__optimize_group(scratch, history, new_record);
+        if (first_index == top->count){
+            history__optimize_group(scratch, history, first_index - 1);
         }
     }
 }
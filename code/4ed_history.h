@@ -18,45 +18,134 @@ struct Record_Batch_Slot{
     i32 first;
 };
 
+// NOTE: Record texts are appended to a log that is split into blocks.  The block
+// being written is open; once it fills up it is sealed.  In compact mode sealed blocks
+// are compressed, and when a history or all of them together go over budget the oldest
+// sealed blocks are written to the session's scratch file and read back when a record in
+// them is needed.
+#define HISTORY_BLOCK_FIRST_SIZE KB(4)
+#define HISTORY_BLOCK_SIZE KB(256)
+
+struct History_Block{
+    u64 first;
+    u64 size;
+    u64 max;
+    b32 sealed;
+    b32 compressed;
+    // NOTE: data is zero while the block is spilled.  data_size is the size of the
+    // bytes in data, or in the spill file.  A copy in the spill file is at spill_pos.
+    u8 *data;
+    u64 data_size;
+    b32 spilled;
+    u64 spill_pos;
+};
+
+struct History_Log{
+    History_Block *blocks;
+    i64 block_count;
+    i64 block_max;
+    u64 pos;
+    u64 resident_size;
+    
+    // NOTE: The last compressed block that was read, decoded.
+    i64 cache_index;
+    u8 *cache_data;
+    u64 cache_size;
+};
+
+// NOTE: shared_prefix and shared_suffix are only used for forward texts, they
+// count the bytes at either end that are the same as the backward text, which are not
+// stored twice.
+struct History_Text{
+    u64 pos;
+    u64 size;
+    u64 shared_prefix;
+    u64 shared_suffix;
+};
+
+// NOTE: Every single edit is a leaf, and the leaves sit in one chunked array in the
+// order they were made.  The top level records cover the leaves in order; a top level
+// single is just its leaf and a group covers a run of leaves.  So finding a record, a
+// group's child, or merging a range of records into one group never walks a list.
 struct Record{
-    Node node;
-    Temp_Memory restore_point;
+    u64 restore_point;
     i64 pos_before_edit;
     i32 edit_number;
     Record_Kind kind;
     union{
         struct{
-            String_Const_u8 forward_text;
-            String_Const_u8 backward_text;
+            History_Text forward_text;
+            History_Text backward_text;
             i64 first;
         } single;
         struct{
-            Node children;
+            i64 first_leaf;
             i32 count;
         } group;
     };
 };
 
-struct Record_Ptr_Lookup_Table{
-    Record **records;
+#define HISTORY_RECORD_CHUNK_SIZE 1024
+struct Record_Chunk_Array{
+    Record **chunks;
+    i64 chunk_count;
+    i64 chunk_max;
+    i64 count;
+};
+
+// NOTE: A top level record is a leaf index, or the bitwise not of a group index.
+typedef i64 Record_Handle;
+
+struct Record_Handle_Array{
+    Record_Handle *handles;
     i32 count;
     i32 max;
 };
 
+// NOTE: A free range of the spill file, left behind by a block that was dropped.
+struct History_Spill_Extent{
+    History_Spill_Extent *next;
+    u64 pos;
+    u64 size;
+};
+
+struct Global_History;
+
 struct History{
     b32 activated;
-    Arena arena;
+    Global_History *global_history;
+    Node node;
+    History_Log log;
+    // NOTE: Holds the strings handed out by the record info calls.
+    Arena info_arena;
     Heap heap;
     Base_Allocator heap_wrapper;
-    Node free_records;
-    Node records;
-    i32 record_count;
-    Record_Ptr_Lookup_Table record_lookup;
+    Record_Chunk_Array leaves;
+    Record_Chunk_Array groups;
+    i64 first_free_group;
+    Record_Handle_Array top;
 };
 
 struct Global_History{
     i32 edit_number_counter;
     i32 edit_grouping_counter;
+    
+    Arena arena;
+    Node histories;
+    b32 compact;
+    u64 buffer_budget;
+    u64 global_budget;
+    u64 resident_size;
+    
+    // NOTE: All spilled blocks share one scratch file that no one else can open and
+    // that the system deletes when the process exits.  It is opened on the first spill.
+    Plat_Handle spill_file;
+    b32 spill_file_open;
+    b32 spill_failed;
+    u64 spill_file_size;
+    i64 spilled_block_count;
+    History_Spill_Extent *spill_free_extents;
+    History_Spill_Extent *spill_free_nodes;
 };
 
 #endif
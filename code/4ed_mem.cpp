@@ -8,7 +8,7 @@
 
 // TOP
 
-// TODO(allen): Make these as fast as possible
+// NOTE: The live (vectorized) versions of these are in 4coder_base_types.cpp
 
 #if 0
 internal void
@@ -9,11 +9,16 @@
 
 // TOP
 
+internal b32
+draw__group_is_empty(Render_Group *group){
+    return(group->vertex_list.vertex_count == 0 && group->instance_list.count == 0);
+}
+
 internal void
 draw__begin_new_group(Render_Target *target){
     Render_Group *group = 0;
     if (target->group_last != 0){
-        if (target->group_last->vertex_list.vertex_count == 0){
+        if (draw__group_is_empty(target->group_last)){
             group = target->group_last;
         }
     }
@@ -34,14 +39,21 @@ draw__extend_group_vertex_memory(Arena *arena, Render_Vertex_List *list, i32 siz
     return(node);
 }
 
+internal Render_Group*
+draw__get_group_of_kind(Render_Target *target, Render_Group_Kind kind){
+    Render_Group *group = target->group_last;
+    if (group == 0 || (group->kind != kind && !draw__group_is_empty(group))){
+        draw__begin_new_group(target);
+        group = target->group_last;
+    }
+    group->kind = kind;
+    return(group);
+}
+
 internal void
 draw__write_vertices_in_current_group(Render_Target *target, Render_Vertex *vertices, i32 count){
     if (count > 0){
-        Render_Group *group = target->group_last;
-        if (group == 0){
-            draw__begin_new_group(target);
-            group = target->group_last;
-        }
+        Render_Group *group = draw__get_group_of_kind(target, RenderGroupKind_Vertices);
         
         Render_Vertex_List *list = &group->vertex_list;
         
@@ -77,6 +89,29 @@ draw__write_vertices_in_current_group(Render_Target *target, Render_Vertex *vert
     }
 }
 
+internal void
+draw__write_instance_in_current_group(Render_Target *target, Render_Group_Kind kind, void *instance){
+    Render_Group *group = draw__get_group_of_kind(target, kind);
+    Render_Instance_List *list = &group->instance_list;
+    i32 size = render_instance_sizes[kind];
+    
+    Render_Instance_Array_Node *last = list->last;
+    if (last == 0 || last->count == last->max){
+        i32 next_node_max = 64;
+        if (last != 0){
+            next_node_max = last->max*2;
+        }
+        last = push_array_zero(&target->arena, Render_Instance_Array_Node, 1);
+        sll_queue_push(list->first, list->last, last);
+        last->data = push_array(&target->arena, u8, next_node_max*size);
+        last->max = next_node_max;
+    }
+    
+    block_copy(last->data + last->count*size, instance, size);
+    last->count += 1;
+    list->count += 1;
+}
+
 internal void
 draw__set_face_id(Render_Target *target, Face_ID face_id){
     if (target->current_face_id != face_id){
@@ -141,22 +176,32 @@ draw_rectangle_outline(Render_Target *target, Rect_f32 rect, f32 roundness, f32
         thickness = clamp_bot(1.f, thickness);
         f32 half_thickness = thickness*0.5f;
         
-        Render_Vertex vertices[6] = {};
-        vertices[0].xy = V2f32(rect.x0, rect.y0);
-        vertices[1].xy = V2f32(rect.x1, rect.y0);
-        vertices[2].xy = V2f32(rect.x0, rect.y1);
-        vertices[3].xy = V2f32(rect.x1, rect.y0);
-        vertices[4].xy = V2f32(rect.x0, rect.y1);
-        vertices[5].xy = V2f32(rect.x1, rect.y1);
-        
-        Vec2_f32 center = rect_center(rect);
-        for (i32 i = 0; i < ArrayCount(vertices); i += 1){
-            vertices[i].uvw = V3f32(center.x, center.y, roundness);
-            vertices[i].color = color;
-            vertices[i].half_thickness = half_thickness;
+        if (target->instanced){
+            Render_Rect_Instance instance = {};
+            instance.rect = rect;
+            instance.color = color;
+            instance.roundness = roundness;
+            instance.half_thickness = half_thickness;
+            draw__write_instance_in_current_group(target, RenderGroupKind_Rects, &instance);
+        }
+        else{
+            Render_Vertex vertices[6] = {};
+            vertices[0].xy = V2f32(rect.x0, rect.y0);
+            vertices[1].xy = V2f32(rect.x1, rect.y0);
+            vertices[2].xy = V2f32(rect.x0, rect.y1);
+            vertices[3].xy = V2f32(rect.x1, rect.y0);
+            vertices[4].xy = V2f32(rect.x0, rect.y1);
+            vertices[5].xy = V2f32(rect.x1, rect.y1);
+            
+            Vec2_f32 center = rect_center(rect);
+            for (i32 i = 0; i < ArrayCount(vertices); i += 1){
+                vertices[i].uvw = V3f32(center.x, center.y, roundness);
+                vertices[i].color = color;
+                vertices[i].half_thickness = half_thickness;
+            }
+            
+            draw__write_vertices_in_current_group(target, vertices, ArrayCount(vertices));
         }
-        
-        draw__write_vertices_in_current_group(target, vertices, ArrayCount(vertices));
     }
 }
 
@@ -176,84 +221,104 @@ draw_font_glyph(Render_Target *target, Face *face, u32 codepoint, Vec2_f32 p,
                                   codepoint, &glyph_index)){
         glyph_index = 0;
     }
-    Glyph_Bounds bounds = face->bounds[glyph_index];
-    Vec3_f32 texture_dim = face->texture_dim;
-    
-    Render_Vertex vertices[6] = {};
-    
-    Rect_f32 uv = bounds.uv;
-    vertices[0].uvw = V3f32(uv.x0, uv.y0, bounds.w);
-    vertices[1].uvw = V3f32(uv.x1, uv.y0, bounds.w);
-    vertices[2].uvw = V3f32(uv.x0, uv.y1, bounds.w);
-    vertices[5].uvw = V3f32(uv.x1, uv.y1, bounds.w);
+    Glyph_Bounds bounds = {};
+    b32 has_glyph = face_get_glyph_bounds(target, face, glyph_index, &bounds);
     
-    Vec2_f32 y_axis = V2f32(-x_axis.y, x_axis.x);
-    Vec2_f32 x_min = bounds.xy_off.x0*x_axis;
-    Vec2_f32 x_max = bounds.xy_off.x1*x_axis;
-    Vec2_f32 y_min = bounds.xy_off.y0*y_axis;
-    Vec2_f32 y_max = bounds.xy_off.y1*y_axis;
-    Vec2_f32 p_x_min = p + x_min;
-    Vec2_f32 p_x_max = p + x_max;
-    vertices[0].xy = p_x_min + y_min;
-    vertices[1].xy = p_x_max + y_min;
-    vertices[2].xy = p_x_min + y_max;
-    vertices[5].xy = p_x_max + y_max;
-    
-    /* NOTE simon (26/09/24): We don't use rect_overlap here because the text rect is not guaranteed to be axis aligned. */
-    b32 draw = rect_contains_point( target->current_clip_box, vertices[ 0 ].xy );
-    draw  = draw || rect_contains_point( target->current_clip_box, vertices[ 1 ].xy );
-    draw  = draw || rect_contains_point( target->current_clip_box, vertices[ 2 ].xy );
-    draw  = draw || rect_contains_point( target->current_clip_box, vertices[ 5 ].xy );
-    
-    if ( draw ) {
-    
-#if 0    
-        Vec2_f32 xy_min = p + bounds.xy_off.x0*x_axis + bounds.xy_off.y0*y_axis;
-        Vec2_f32 xy_max = p + bounds.xy_off.x1*x_axis + bounds.xy_off.y1*y_axis;
+    // NOTE: Upright glyphs go out as a single instance, anything rotated
+    // or scaled keeps the six vertex quad.
+    if (target->instanced && x_axis.x == 1.f && x_axis.y == 0.f){
+        Rect_f32 xy = Rf32(p + bounds.xy_off.p0, p + bounds.xy_off.p1);
+        b32 draw = rect_overlap(xy, target->current_clip_box);
+        if (has_glyph && draw){
+            Vec2_f32 texel = bounds.uv.p0*(f32)FACE_ATLAS_PAGE_DIM;
+            Vec2_f32 dim = rect_dim(xy);
+            Render_Glyph_Instance instance = {};
+            instance.p = xy.p0;
+            instance.color = color;
+            instance.texel = ((u32)(texel.x + 0.5f)) | (((u32)(texel.y + 0.5f)) << 16);
+            instance.dim_page = (((u32)(dim.x + 0.5f)) |
+                                 (((u32)(dim.y + 0.5f)) << 12) |
+                                 (((u32)bounds.w) << 24));
+            draw__write_instance_in_current_group(target, RenderGroupKind_Glyphs, &instance);
+        }
+    }
+    else{
+        Render_Vertex vertices[6] = {};
         
-        vertices[0].xy = V2f32(xy_min.x, xy_min.y);
-        vertices[1].xy = V2f32(xy_max.x, xy_min.y);
-        vertices[2].xy = V2f32(xy_min.x, xy_max.y);
-        vertices[5].xy = V2f32(xy_max.x, xy_max.y);
-#endif
+        Rect_f32 uv = bounds.uv;
+        vertices[0].uvw = V3f32(uv.x0, uv.y0, bounds.w);
+        vertices[1].uvw = V3f32(uv.x1, uv.y0, bounds.w);
+        vertices[2].uvw = V3f32(uv.x0, uv.y1, bounds.w);
+        vertices[5].uvw = V3f32(uv.x1, uv.y1, bounds.w);
+        
+        Vec2_f32 y_axis = V2f32(-x_axis.y, x_axis.x);
+        Vec2_f32 x_min = bounds.xy_off.x0*x_axis;
+        Vec2_f32 x_max = bounds.xy_off.x1*x_axis;
+        Vec2_f32 y_min = bounds.xy_off.y0*y_axis;
+        Vec2_f32 y_max = bounds.xy_off.y1*y_axis;
+        Vec2_f32 p_x_min = p + x_min;
+        Vec2_f32 p_x_max = p + x_max;
+        vertices[0].xy = p_x_min + y_min;
+        vertices[1].xy = p_x_max + y_min;
+        vertices[2].xy = p_x_min + y_max;
+        vertices[5].xy = p_x_max + y_max;
+        
+        /* NOTE simon (26/09/24): We don't use rect_overlap here because the text rect is not guaranteed to be axis aligned. */
+        b32 draw = rect_contains_point( target->current_clip_box, vertices[ 0 ].xy );
+        draw  = draw || rect_contains_point( target->current_clip_box, vertices[ 1 ].xy );
+        draw  = draw || rect_contains_point( target->current_clip_box, vertices[ 2 ].xy );
+        draw  = draw || rect_contains_point( target->current_clip_box, vertices[ 5 ].xy );
+        
+        if ( has_glyph && draw ) {
         
 #if 0    
-        if (!HasFlag(flags, GlyphFlag_Rotate90)){
-            Rect_f32 xy = Rf32(p + bounds.xy_off.p0, p + bounds.xy_off.p1);
+            Vec2_f32 xy_min = p + bounds.xy_off.x0*x_axis + bounds.xy_off.y0*y_axis;
+            Vec2_f32 xy_max = p + bounds.xy_off.x1*x_axis + bounds.xy_off.y1*y_axis;
             
-            vertices[0].xy  = V2f32(xy.x0, xy.y1);
-            vertices[0].uvw = V3f32(uv.x0, uv.y1, bounds.w);
-            vertices[1].xy  = V2f32(xy.x1, xy.y1);
-            vertices[1].uvw = V3f32(uv.x1, uv.y1, bounds.w);
-            vertices[2].xy  = V2f32(xy.x0, xy.y0);
-            vertices[2].uvw = V3f32(uv.x0, uv.y0, bounds.w);
-            vertices[5].xy  = V2f32(xy.x1, xy.y0);
-            vertices[5].uvw = V3f32(uv.x1, uv.y0, bounds.w);
-        }
-        else{
-            Rect_f32 xy = Rf32(p.x - bounds.xy_off.y1, p.y + bounds.xy_off.x0,
-                               p.x - bounds.xy_off.y0, p.y + bounds.xy_off.x1);
+            vertices[0].xy = V2f32(xy_min.x, xy_min.y);
+            vertices[1].xy = V2f32(xy_max.x, xy_min.y);
+            vertices[2].xy = V2f32(xy_min.x, xy_max.y);
+            vertices[5].xy = V2f32(xy_max.x, xy_max.y);
+#endif
             
-            vertices[0].xy  = V2f32(xy.x0, xy.y1);
-            vertices[0].uvw = V3f32(uv.x1, uv.y1, bounds.w);
-            vertices[1].xy  = V2f32(xy.x1, xy.y1);
-            vertices[1].uvw = V3f32(uv.x1, uv.y0, bounds.w);
-            vertices[2].xy  = V2f32(xy.x0, xy.y0);
-            vertices[2].uvw = V3f32(uv.x0, uv.y1, bounds.w);
-            vertices[5].xy  = V2f32(xy.x1, xy.y0);
-            vertices[5].uvw = V3f32(uv.x0, uv.y0, bounds.w);
-        }
+#if 0    
+            if (!HasFlag(flags, GlyphFlag_Rotate90)){
+                Rect_f32 xy = Rf32(p + bounds.xy_off.p0, p + bounds.xy_off.p1);
+                
+                vertices[0].xy  = V2f32(xy.x0, xy.y1);
+                vertices[0].uvw = V3f32(uv.x0, uv.y1, bounds.w);
+                vertices[1].xy  = V2f32(xy.x1, xy.y1);
+                vertices[1].uvw = V3f32(uv.x1, uv.y1, bounds.w);
+                vertices[2].xy  = V2f32(xy.x0, xy.y0);
+                vertices[2].uvw = V3f32(uv.x0, uv.y0, bounds.w);
+                vertices[5].xy  = V2f32(xy.x1, xy.y0);
+                vertices[5].uvw = V3f32(uv.x1, uv.y0, bounds.w);
+            }
+            else{
+                Rect_f32 xy = Rf32(p.x - bounds.xy_off.y1, p.y + bounds.xy_off.x0,
+                                   p.x - bounds.xy_off.y0, p.y + bounds.xy_off.x1);
+                
+                vertices[0].xy  = V2f32(xy.x0, xy.y1);
+                vertices[0].uvw = V3f32(uv.x1, uv.y1, bounds.w);
+                vertices[1].xy  = V2f32(xy.x1, xy.y1);
+                vertices[1].uvw = V3f32(uv.x1, uv.y0, bounds.w);
+                vertices[2].xy  = V2f32(xy.x0, xy.y0);
+                vertices[2].uvw = V3f32(uv.x0, uv.y1, bounds.w);
+                vertices[5].xy  = V2f32(xy.x1, xy.y0);
+                vertices[5].uvw = V3f32(uv.x0, uv.y0, bounds.w);
+            }
 #endif
-        
-        vertices[3] = vertices[1];
-        vertices[4] = vertices[2];
-        
-        for (i32 i = 0; i < ArrayCount(vertices); i += 1){
-            vertices[i].color = color;
-            vertices[i].half_thickness = 0.f;
+            
+            vertices[3] = vertices[1];
+            vertices[4] = vertices[2];
+            
+            for (i32 i = 0; i < ArrayCount(vertices); i += 1){
+                vertices[i].color = color;
+                vertices[i].half_thickness = 0.f;
+            }
+            
+            draw__write_vertices_in_current_group(target, vertices, ArrayCount(vertices));
         }
-        
-        draw__write_vertices_in_current_group(target, vertices, ArrayCount(vertices));
     }
 }
 
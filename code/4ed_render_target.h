@@ -37,9 +37,57 @@ struct Render_Vertex_List{
     i32 vertex_count;
 };
 
+// NOTE: Backends that set Render_Target.instanced take glyphs and
+// rectangles as one instance each, expanded to quads in the vertex shader.
+// Each group holds one kind of primitive so draw order is kept across kinds.
+typedef i32 Render_Group_Kind;
+enum{
+    RenderGroupKind_Vertices,
+    RenderGroupKind_Glyphs,
+    RenderGroupKind_Rects,
+    RenderGroupKind_COUNT,
+};
+
+// NOTE: texel is the atlas position (x | y << 16), dim_page packs the
+// glyph size and atlas page (w | h << 12 | page << 24).
+struct Render_Glyph_Instance{
+    Vec2_f32 p;
+    u32 color;
+    u32 texel;
+    u32 dim_page;
+};
+
+struct Render_Rect_Instance{
+    Rect_f32 rect;
+    u32 color;
+    f32 roundness;
+    f32 half_thickness;
+};
+
+global_const i32 render_instance_sizes[RenderGroupKind_COUNT] = {
+    0,
+    sizeof(Render_Glyph_Instance),
+    sizeof(Render_Rect_Instance),
+};
+
+struct Render_Instance_Array_Node{
+    Render_Instance_Array_Node *next;
+    u8 *data;
+    i32 count;
+    i32 max;
+};
+
+struct Render_Instance_List{
+    Render_Instance_Array_Node *first;
+    Render_Instance_Array_Node *last;
+    i32 count;
+};
+
 struct Render_Group{
     Render_Group *next;
+    Render_Group_Kind kind;
     Render_Vertex_List vertex_list;
+    Render_Instance_List instance_list;
     // parameters
     Face_ID face_id;
     Rect_f32 clip_box;
@@ -47,6 +95,7 @@ struct Render_Group{
 
 struct Render_Target{
     b8 clip_all;
+    b8 instanced;
     i32 width;
     i32 height;
     i32 bound_texture;
@@ -68,6 +117,11 @@ struct Render_Target{
     Rect_f32 current_clip_box;
     void *font_set;
     u32 fallback_texture_id;
+    
+    // NOTE: CPU time spent submitting frames, logged by the platform layer
+    u64 submit_time;
+    u64 submit_bytes;
+    i32 submit_frame_count;
 };
 
 #endif
@@ -65,20 +65,38 @@ string_compute_needle_jump_table(Arena *arena, String_Const_u8 needle, Scan_Dire
 
 #define character_predicate_check_character(p, c) (((p).b[(c)/8] & (1 << ((c)%8))) != 0)
 
+// NOTE: The KMP scans only know that a match equals the needle up to case.
+// Bytes kept across a shift were compared against a different needle byte, so the
+// exact check has to look at the matched text again.
+internal b32
+string_match__window_is_exact(u8 *window, u64 start, String_Const_u8 needle){
+    b32 result = true;
+    for (u64 k = 0; k < needle.size; k += 1){
+        if (window[(start + k)%needle.size] != needle.str[k]){
+            result = false;
+            break;
+        }
+    }
+    return(result);
+}
+
 internal String_Match_List
-find_all_matches_forward(Arena *arena, i32 maximum_output_count,
-                         List_String_Const_u8 chunks, String_Const_u8 needle,
-                         u64_Array jump_table, Character_Predicate *predicate,
-                         u64 base_index, Buffer_ID buffer, i32 string_id){
+find_all_matches_forward__kmp(Arena *arena, i32 maximum_output_count,
+                              List_String_Const_u8 chunks, String_Const_u8 needle,
+                              u64_Array jump_table, Character_Predicate *predicate,
+                              u64 base_index, Buffer_ID buffer, i32 string_id){
     String_Match_List list = {};
     
     if (chunks.node_count > 0){
         u64 i = 0;
         u64 j = 0;
         b8 current_l = false;
-        i64 last_insensitive = -1;
         i64 last_boundary = -1;
         
+        // NOTE: The last needle.size bytes of text, indexed by position mod
+        // needle.size, so a match can be checked for case against the text itself.
+        u8 *window = push_array(arena, u8, needle.size);
+        
         Node_String_Const_u8 *node = chunks.first;
         i64 chunk_pos = 0;
         
@@ -113,22 +131,17 @@ find_all_matches_forward(Arena *arena, i32 maximum_output_count,
         
         for (;node != 0;){
             c = node->string.str[chunk_pos];
+            window[i%needle.size] = c;
             n = i - j;
             needle_c = needle.str[n];
             if (character_to_upper(c) == character_to_upper(needle_c)){
-                if (c != needle_c){
-                    last_insensitive = i;
-                }
-                
                 jump_back_code = 0;
                 goto iterate_forward;
                 jump_back_0:
                 
                 if (n + 1 == needle.size){
                     String_Match_Flag flags = 0;
-                    if (!(last_insensitive >= 0 &&
-                          j <= (u64)last_insensitive &&
-                          (u64)last_insensitive < j + needle.size)){
+                    if (string_match__window_is_exact(window, j, needle)){
                         AddFlag(flags, StringMatch_CaseSensitive);
                     }
                     if (!(last_boundary >= 0 &&
@@ -180,10 +193,10 @@ find_all_matches_forward(Arena *arena, i32 maximum_output_count,
 }
 
 internal String_Match_List
-find_all_matches_backward(Arena *arena, i32 maximum_output_count,
-                          List_String_Const_u8 chunks, String_Const_u8 needle,
-                          u64_Array jump_table, Character_Predicate *predicate,
-                          u64 base_index, Buffer_ID buffer, i32 string_id){
+find_all_matches_backward__kmp(Arena *arena, i32 maximum_output_count,
+                               List_String_Const_u8 chunks, String_Const_u8 needle,
+                               u64_Array jump_table, Character_Predicate *predicate,
+                               u64 base_index, Buffer_ID buffer, i32 string_id){
     String_Match_List list = {};
     
     string_list_reverse(&chunks);
@@ -194,9 +207,10 @@ find_all_matches_backward(Arena *arena, i32 maximum_output_count,
         i64 i = size - 1;
         i64 j = size - 1;
         b8 current_r = false;
-        i64 last_insensitive = size;
         i64 last_boundary = size;
         
+        u8 *window = push_array(arena, u8, needle.size);
+        
         Node_String_Const_u8 *node = chunks.first;
         i64 chunk_pos = node->string.size - 1;
         
@@ -233,22 +247,17 @@ find_all_matches_backward(Arena *arena, i32 maximum_output_count,
         
         for (;node != 0;){
             c = node->string.str[chunk_pos];
+            window[i%needle.size] = c;
             n = j - i;
             needle_c = needle.str[needle.size - 1 - n];
             if (character_to_upper(c) == character_to_upper(needle_c)){
-                if (c != needle_c){
-                    last_insensitive = i;
-                }
-                
                 jump_back_code = 0;
                 goto iterate_backward;
                 jump_back_0:
                 
                 if (n + 1 == needle.size){
                     String_Match_Flag flags = 0;
-                    if (!(last_insensitive < size &&
-                          j >= last_insensitive &&
-                          last_insensitive > j - (i64)needle.size)){
+                    if (string_match__window_is_exact(window, j - (needle.size - 1), needle)){
                         AddFlag(flags, StringMatch_CaseSensitive);
                     }
                     if (!(last_boundary < size &&
@@ -304,6 +313,468 @@ find_all_matches_backward(Arena *arena, i32 maximum_output_count,
     return(list);
 }
 
+////////////////////////////////
+
+// NOTE: The filtered scans compare the first and last byte of the needle against
+// 16 or 32 positions at once and only check the whole needle at the candidates that
+// pass.  They find the same matches as the KMP scans and work out the same flags from
+// the text around each match.
+
+struct String_Match_Scan{
+    Arena *arena;
+    String_Match_List list;
+    i32 maximum_output_count;
+    String_Const_u8 needle;
+    Character_Predicate *predicate;
+    u64 base_index;
+    Buffer_ID buffer;
+    i32 string_id;
+    u64 total_size;
+    Node_String_Const_u8 *node;
+    u64 chunk_start;
+    u8 neighbor;
+    b32 done;
+};
+
+// NOTE: The KMP scans check the predicate against needle bytes where the text
+// only matches up to case, so the filtered scans only stand in for them when both cases
+// of every letter agree in the predicate.
+internal b32
+string_match__can_filter(Character_Predicate *predicate){
+    b32 result = true;
+    for (u8 c = 'a'; c <= 'z'; c += 1){
+        u8 upper = character_to_upper(c);
+        if (character_predicate_check_character(*predicate, c) !=
+            character_predicate_check_character(*predicate, upper)){
+            result = false;
+            break;
+        }
+    }
+    return(result);
+}
+
+internal void
+string_match__check_forward(String_Match_Scan *scan, u64 offset){
+    String_Const_u8 needle = scan->needle;
+    Node_String_Const_u8 *node = scan->node;
+    u64 node_start = scan->chunk_start;
+    u64 pos = offset;
+    b32 is_match = true;
+    b32 is_exact = true;
+    for (u64 k = 0; k < needle.size; k += 1){
+        for (;node != 0 && pos >= node->string.size;){
+            node_start += node->string.size;
+            pos = 0;
+            node = node->next;
+        }
+        if (node == 0){
+            is_match = false;
+            break;
+        }
+        u8 c = node->string.str[pos];
+        u8 needle_c = needle.str[k];
+        if (c != needle_c){
+            is_exact = false;
+            if (character_to_upper(c) != character_to_upper(needle_c)){
+                is_match = false;
+                break;
+            }
+        }
+        pos += 1;
+    }
+    
+    if (is_match){
+        u64 start = scan->chunk_start + offset;
+        u64 end = start + needle.size;
+        u64 node_end = node_start + node->string.size;
+        String_Match_Flag flags = 0;
+        if (is_exact){
+            AddFlag(flags, StringMatch_CaseSensitive);
+        }
+        if (!(node_end != end && 0 < node_start && start <= node_start)){
+            AddFlag(flags, StringMatch_Straddled);
+        }
+        if (end < scan->total_size){
+            u8 next_c = 0;
+            if (pos < node->string.size){
+                next_c = node->string.str[pos];
+            }
+            else{
+                for (node = node->next; node != 0; node = node->next){
+                    if (node->string.size > 0){
+                        next_c = node->string.str[0];
+                        break;
+                    }
+                }
+            }
+            if (character_predicate_check_character(*scan->predicate, next_c)){
+                AddFlag(flags, StringMatch_RightSideSloppy);
+            }
+        }
+        if (start > 0){
+            u8 prev_c = scan->neighbor;
+            if (offset > 0){
+                prev_c = scan->node->string.str[offset - 1];
+            }
+            if (character_predicate_check_character(*scan->predicate, prev_c)){
+                AddFlag(flags, StringMatch_LeftSideSloppy);
+            }
+        }
+        string_match_list_push(scan->arena, &scan->list, scan->buffer, scan->string_id, flags,
+                               scan->base_index + start, needle.size);
+        if (scan->list.count >= scan->maximum_output_count){
+            scan->done = true;
+        }
+    }
+}
+
+// NOTE: The backward scan walks a reversed chunk list, so node->next is the chunk
+// before this one in the text, and offset is the position of the last byte of the match.
+internal void
+string_match__check_backward(String_Match_Scan *scan, u64 offset){
+    String_Const_u8 needle = scan->needle;
+    Node_String_Const_u8 *node = scan->node;
+    u64 node_start = scan->chunk_start;
+    u64 pos = offset;
+    b32 is_match = true;
+    b32 is_exact = true;
+    for (u64 k = needle.size; k > 0; k -= 1){
+        u8 c = node->string.str[pos];
+        u8 needle_c = needle.str[k - 1];
+        if (c != needle_c){
+            is_exact = false;
+            if (character_to_upper(c) != character_to_upper(needle_c)){
+                is_match = false;
+                break;
+            }
+        }
+        if (k > 1){
+            if (pos > 0){
+                pos -= 1;
+            }
+            else{
+                for (node = node->next; node != 0; node = node->next){
+                    if (node->string.size > 0){
+                        break;
+                    }
+                }
+                if (node == 0){
+                    is_match = false;
+                    break;
+                }
+                node_start -= node->string.size;
+                pos = node->string.size - 1;
+            }
+        }
+    }
+    
+    if (is_match){
+        u64 start = node_start + pos;
+        u64 end = scan->chunk_start + offset + 1;
+        u64 node_end = node_start + node->string.size;
+        String_Match_Flag flags = 0;
+        if (is_exact){
+            AddFlag(flags, StringMatch_CaseSensitive);
+        }
+        if (!(start != node_start && node_end < scan->total_size && node_end <= end)){
+            AddFlag(flags, StringMatch_Straddled);
+        }
+        if (start > 0){
+            u8 prev_c = 0;
+            if (pos > 0){
+                prev_c = node->string.str[pos - 1];
+            }
+            else{
+                for (node = node->next; node != 0; node = node->next){
+                    if (node->string.size > 0){
+                        prev_c = node->string.str[node->string.size - 1];
+                        break;
+                    }
+                }
+            }
+            if (character_predicate_check_character(*scan->predicate, prev_c)){
+                AddFlag(flags, StringMatch_LeftSideSloppy);
+            }
+        }
+        if (end < scan->total_size){
+            u8 next_c = scan->neighbor;
+            if (offset + 1 < scan->node->string.size){
+                next_c = scan->node->string.str[offset + 1];
+            }
+            if (character_predicate_check_character(*scan->predicate, next_c)){
+                AddFlag(flags, StringMatch_RightSideSloppy);
+            }
+        }
+        string_match_list_push(scan->arena, &scan->list, scan->buffer, scan->string_id, flags,
+                               scan->base_index + start, needle.size);
+        if (scan->list.count >= scan->maximum_output_count){
+            scan->done = true;
+        }
+    }
+}
+
+// NOTE: Letters are filtered by setting the case bit on both sides of the compare.
+// That lets a few other bytes through ('@' for '`' and such), the full check drops them.
+internal u8
+string_match__case_bit(u8 c){
+    u8 result = 0;
+    if (character_to_upper(c) != character_to_lower(c)){
+        result = 0x20;
+    }
+    return(result);
+}
+
+#if ARCH_HAS_X86_SIMD
+// NOTE: The filter kernels test the candidates whose whole match lies in str,
+// opl is the number of such candidates.  They return how far they got; the caller
+// finishes the rest one byte at a time.
+internal TARGET_SSE2 u64
+string_match__filter_forward__sse2(String_Match_Scan *scan, u8 *str, u64 opl){
+    u64 m = scan->needle.size;
+    u8 first = scan->needle.str[0];
+    u8 last = scan->needle.str[m - 1];
+    __m128i first_case = _mm_set1_epi8((char)string_match__case_bit(first));
+    __m128i last_case = _mm_set1_epi8((char)string_match__case_bit(last));
+    __m128i first_v = _mm_or_si128(_mm_set1_epi8((char)first), first_case);
+    __m128i last_v = _mm_or_si128(_mm_set1_epi8((char)last), last_case);
+    u64 i = 0;
+    for (;i + 16 <= opl && !scan->done; i += 16){
+        __m128i a = _mm_loadu_si128((__m128i*)(str + i));
+        __m128i b = _mm_loadu_si128((__m128i*)(str + i + m - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, first_case), first_v),
+                                   _mm_cmpeq_epi8(_mm_or_si128(b, last_case), last_v));
+        u32 mask = (u32)_mm_movemask_epi8(eq);
+        for (;mask != 0 && !scan->done;){
+            string_match__check_forward(scan, i + bit_scan_forward_u32(mask));
+            mask &= mask - 1;
+        }
+    }
+    return(i);
+}
+
+internal TARGET_AVX2 u64
+string_match__filter_forward__avx2(String_Match_Scan *scan, u8 *str, u64 opl){
+    u64 m = scan->needle.size;
+    u8 first = scan->needle.str[0];
+    u8 last = scan->needle.str[m - 1];
+    __m256i first_case = _mm256_set1_epi8((char)string_match__case_bit(first));
+    __m256i last_case = _mm256_set1_epi8((char)string_match__case_bit(last));
+    __m256i first_v = _mm256_or_si256(_mm256_set1_epi8((char)first), first_case);
+    __m256i last_v = _mm256_or_si256(_mm256_set1_epi8((char)last), last_case);
+    u64 i = 0;
+    for (;i + 32 <= opl && !scan->done; i += 32){
+        __m256i a = _mm256_loadu_si256((__m256i*)(str + i));
+        __m256i b = _mm256_loadu_si256((__m256i*)(str + i + m - 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(a, first_case), first_v),
+                                      _mm256_cmpeq_epi8(_mm256_or_si256(b, last_case), last_v));
+        u32 mask = (u32)_mm256_movemask_epi8(eq);
+        for (;mask != 0 && !scan->done;){
+            string_match__check_forward(scan, i + bit_scan_forward_u32(mask));
+            mask &= mask - 1;
+        }
+    }
+    return(i);
+}
+
+// NOTE: The backward kernels visit the same candidates from the top down and
+// return how many candidates are left at the bottom.
+internal TARGET_SSE2 u64
+string_match__filter_backward__sse2(String_Match_Scan *scan, u8 *str, u64 opl){
+    u64 m = scan->needle.size;
+    u8 first = scan->needle.str[0];
+    u8 last = scan->needle.str[m - 1];
+    __m128i first_case = _mm_set1_epi8((char)string_match__case_bit(first));
+    __m128i last_case = _mm_set1_epi8((char)string_match__case_bit(last));
+    __m128i first_v = _mm_or_si128(_mm_set1_epi8((char)first), first_case);
+    __m128i last_v = _mm_or_si128(_mm_set1_epi8((char)last), last_case);
+    u64 i = opl;
+    for (;i >= 16 && !scan->done; i -= 16){
+        u64 base = i - 16;
+        __m128i a = _mm_loadu_si128((__m128i*)(str + base));
+        __m128i b = _mm_loadu_si128((__m128i*)(str + base + m - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, first_case), first_v),
+                                   _mm_cmpeq_epi8(_mm_or_si128(b, last_case), last_v));
+        u32 mask = (u32)_mm_movemask_epi8(eq);
+        for (;mask != 0 && !scan->done;){
+            u32 bit = bit_scan_reverse_u32(mask);
+            string_match__check_backward(scan, base + bit + m - 1);
+            mask &= ~(1u << bit);
+        }
+    }
+    return(i);
+}
+
+internal TARGET_AVX2 u64
+string_match__filter_backward__avx2(String_Match_Scan *scan, u8 *str, u64 opl){
+    u64 m = scan->needle.size;
+    u8 first = scan->needle.str[0];
+    u8 last = scan->needle.str[m - 1];
+    __m256i first_case = _mm256_set1_epi8((char)string_match__case_bit(first));
+    __m256i last_case = _mm256_set1_epi8((char)string_match__case_bit(last));
+    __m256i first_v = _mm256_or_si256(_mm256_set1_epi8((char)first), first_case);
+    __m256i last_v = _mm256_or_si256(_mm256_set1_epi8((char)last), last_case);
+    u64 i = opl;
+    for (;i >= 32 && !scan->done; i -= 32){
+        u64 base = i - 32;
+        __m256i a = _mm256_loadu_si256((__m256i*)(str + base));
+        __m256i b = _mm256_loadu_si256((__m256i*)(str + base + m - 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(a, first_case), first_v),
+                                      _mm256_cmpeq_epi8(_mm256_or_si256(b, last_case), last_v));
+        u32 mask = (u32)_mm256_movemask_epi8(eq);
+        for (;mask != 0 && !scan->done;){
+            u32 bit = bit_scan_reverse_u32(mask);
+            string_match__check_backward(scan, base + bit + m - 1);
+            mask &= ~(1u << bit);
+        }
+    }
+    return(i);
+}
+#endif
+
+internal void
+string_match__scan_chunk_forward(String_Match_Scan *scan){
+    String_Const_u8 chunk = scan->node->string;
+    u64 m = scan->needle.size;
+    u64 offset = 0;
+#if ARCH_HAS_X86_SIMD
+    if (chunk.size >= m){
+        u64 opl = chunk.size - m + 1;
+        if (cpu_has_feature(CPUFeature_AVX2)){
+            offset = string_match__filter_forward__avx2(scan, chunk.str, opl);
+        }
+        else if (cpu_has_feature(CPUFeature_SSE2)){
+            offset = string_match__filter_forward__sse2(scan, chunk.str, opl);
+        }
+    }
+#endif
+    u8 first = character_to_upper(scan->needle.str[0]);
+    for (;offset < chunk.size && !scan->done; offset += 1){
+        if (character_to_upper(chunk.str[offset]) == first){
+            string_match__check_forward(scan, offset);
+        }
+    }
+}
+
+internal void
+string_match__scan_chunk_backward(String_Match_Scan *scan){
+    String_Const_u8 chunk = scan->node->string;
+    u64 m = scan->needle.size;
+    u64 offset_opl = chunk.size;
+#if ARCH_HAS_X86_SIMD
+    if (chunk.size >= m){
+        u64 opl = chunk.size - m + 1;
+        if (cpu_has_feature(CPUFeature_AVX2)){
+            offset_opl = string_match__filter_backward__avx2(scan, chunk.str, opl) + m - 1;
+        }
+        else if (cpu_has_feature(CPUFeature_SSE2)){
+            offset_opl = string_match__filter_backward__sse2(scan, chunk.str, opl) + m - 1;
+        }
+    }
+#endif
+    u8 last = character_to_upper(scan->needle.str[m - 1]);
+    for (u64 offset = offset_opl; offset > 0 && !scan->done;){
+        offset -= 1;
+        if (character_to_upper(chunk.str[offset]) == last){
+            string_match__check_backward(scan, offset);
+        }
+    }
+}
+
+internal String_Match_List
+find_all_matches_forward__filtered(Arena *arena, i32 maximum_output_count,
+                                   List_String_Const_u8 chunks, String_Const_u8 needle,
+                                   Character_Predicate *predicate,
+                                   u64 base_index, Buffer_ID buffer, i32 string_id){
+    String_Match_Scan scan = {};
+    scan.arena = arena;
+    scan.maximum_output_count = maximum_output_count;
+    scan.needle = needle;
+    scan.predicate = predicate;
+    scan.base_index = base_index;
+    scan.buffer = buffer;
+    scan.string_id = string_id;
+    scan.total_size = chunks.total_size;
+    for (Node_String_Const_u8 *node = chunks.first;
+         node != 0 && !scan.done;
+         node = node->next){
+        if (node->string.size > 0){
+            scan.node = node;
+            string_match__scan_chunk_forward(&scan);
+            scan.neighbor = node->string.str[node->string.size - 1];
+        }
+        scan.chunk_start += node->string.size;
+    }
+    return(scan.list);
+}
+
+internal String_Match_List
+find_all_matches_backward__filtered(Arena *arena, i32 maximum_output_count,
+                                    List_String_Const_u8 chunks, String_Const_u8 needle,
+                                    Character_Predicate *predicate,
+                                    u64 base_index, Buffer_ID buffer, i32 string_id){
+    String_Match_Scan scan = {};
+    scan.arena = arena;
+    scan.maximum_output_count = maximum_output_count;
+    scan.needle = needle;
+    scan.predicate = predicate;
+    scan.base_index = base_index;
+    scan.buffer = buffer;
+    scan.string_id = string_id;
+    scan.total_size = chunks.total_size;
+    scan.chunk_start = chunks.total_size;
+    string_list_reverse(&chunks);
+    for (Node_String_Const_u8 *node = chunks.first;
+         node != 0 && !scan.done;
+         node = node->next){
+        scan.chunk_start -= node->string.size;
+        if (node->string.size > 0){
+            scan.node = node;
+            string_match__scan_chunk_backward(&scan);
+            scan.neighbor = node->string.str[0];
+        }
+    }
+    string_list_reverse(&chunks);
+    return(scan.list);
+}
+
+internal String_Match_List
+find_all_matches_forward(Arena *arena, i32 maximum_output_count,
+                         List_String_Const_u8 chunks, String_Const_u8 needle,
+                         u64_Array jump_table, Character_Predicate *predicate,
+                         u64 base_index, Buffer_ID buffer, i32 string_id){
+    String_Match_List list = {};
+    if (string_match__can_filter(predicate)){
+        list = find_all_matches_forward__filtered(arena, maximum_output_count,
+                                                  chunks, needle, predicate,
+                                                  base_index, buffer, string_id);
+    }
+    else{
+        list = find_all_matches_forward__kmp(arena, maximum_output_count,
+                                             chunks, needle, jump_table, predicate,
+                                             base_index, buffer, string_id);
+    }
+    return(list);
+}
+
+internal String_Match_List
+find_all_matches_backward(Arena *arena, i32 maximum_output_count,
+                          List_String_Const_u8 chunks, String_Const_u8 needle,
+                          u64_Array jump_table, Character_Predicate *predicate,
+                          u64 base_index, Buffer_ID buffer, i32 string_id){
+    String_Match_List list = {};
+    if (string_match__can_filter(predicate)){
+        list = find_all_matches_backward__filtered(arena, maximum_output_count,
+                                                   chunks, needle, predicate,
+                                                   base_index, buffer, string_id);
+    }
+    else{
+        list = find_all_matches_backward__kmp(arena, maximum_output_count,
+                                              chunks, needle, jump_table, predicate,
+                                              base_index, buffer, string_id);
+    }
+    return(list);
+}
+
 internal String_Match_List
 find_all_matches(Arena *arena, i32 maximum_output_count,
                  List_String_Const_u8 chunks, String_Const_u8 needle,
@@ -329,5 +800,205 @@ find_all_matches(Arena *arena, i32 maximum_output_count,
     return(list);
 }
 
+////////////////////////////////
+
+// NOTE: Parallel search across many buffers.  The caller gathers the chunks
+// of every buffer while it holds the models, then the buffers are spread over the
+// workers one at a time.  Nothing can edit the buffers until the workers are done,
+// so the chunks are a consistent read snapshot for the whole search.
+
+struct Match_Search_Buffer{
+    Buffer_ID buffer;
+    List_String_Const_u8 chunks;
+    String_Match_List matches;
+};
+
+struct Match_Search_Job{
+    i32 next_index;
+    i32 thread_count;
+    Match_Search_Buffer *buffers;
+    i32 buffer_count;
+    String_Const_u8_Array needles;
+    u64_Array *jump_tables;
+    Character_Predicate *predicate;
+    String_Match_Flag must_have_flags;
+    String_Match_Flag must_not_have_flags;
+};
+
+#define MATCH_SEARCH_MAX_THREADS 64
+
+struct Match_Search_Pool;
+
+struct Match_Search_Worker{
+    Match_Search_Pool *pool;
+    i32 index;
+    u64 job_number;
+    Arena arena;
+    System_Thread thread;
+};
+
+// NOTE: The search workers are launched the first time a search asks for them
+// and then sleep between searches, so a search on every keystroke does not pay for
+// starting and joining threads.  The calling thread is always worker zero.
+struct Match_Search_Pool{
+    b32 initialized;
+    System_Mutex mutex;
+    System_Condition_Variable start_cv;
+    System_Condition_Variable done_cv;
+    Match_Search_Job *job;
+    u64 job_number;
+    i32 busy_count;
+    i32 thread_count;
+    Match_Search_Worker workers[MATCH_SEARCH_MAX_THREADS];
+};
+
+global Match_Search_Pool match_search_pool = {};
+
+internal void
+match_search__buffer(Arena *arena, Match_Search_Job *job, Match_Search_Buffer *buffer){
+    String_Match_List buffer_matches = {};
+    for (i32 i = 0; i < job->needles.count; i += 1){
+        String_Const_u8 needle = job->needles.vals[i];
+        if (needle.size > 0 && buffer->chunks.node_count > 0){
+            String_Match_List pattern_matches =
+                find_all_matches_forward(arena, max_i32, buffer->chunks, needle,
+                                         job->jump_tables[i], job->predicate,
+                                         0, buffer->buffer, i);
+            string_match_list_filter_flags(&pattern_matches, job->must_have_flags, job->must_not_have_flags);
+            if (pattern_matches.count > 0){
+                if (buffer_matches.count == 0){
+                    buffer_matches = pattern_matches;
+                }
+                else{
+                    buffer_matches = string_match_list_merge_front_to_back(&buffer_matches, &pattern_matches);
+                }
+            }
+        }
+    }
+    buffer->matches = buffer_matches;
+}
+
+internal void
+match_search__run(Match_Search_Pool *pool, Match_Search_Worker *worker, Match_Search_Job *job){
+    if (worker->index < job->thread_count){
+        for (;;){
+            system_mutex_acquire(pool->mutex);
+            i32 index = job->next_index;
+            job->next_index += 1;
+            system_mutex_release(pool->mutex);
+            if (index >= job->buffer_count){
+                break;
+            }
+            match_search__buffer(&worker->arena, job, &job->buffers[index]);
+        }
+    }
+}
+
+internal void
+match_search__worker_main(void *ptr){
+    Match_Search_Worker *worker = (Match_Search_Worker*)ptr;
+    Match_Search_Pool *pool = worker->pool;
+    for (;;){
+        system_mutex_acquire(pool->mutex);
+        for (;pool->job_number == worker->job_number;){
+            system_condition_variable_wait(pool->start_cv, pool->mutex);
+        }
+        worker->job_number = pool->job_number;
+        Match_Search_Job *job = pool->job;
+        system_mutex_release(pool->mutex);
+        
+        match_search__run(pool, worker, job);
+        
+        system_mutex_acquire(pool->mutex);
+        pool->busy_count -= 1;
+        if (pool->busy_count == 0){
+            system_condition_variable_signal(pool->done_cv);
+        }
+        system_mutex_release(pool->mutex);
+    }
+}
+
+internal String_Match_List
+find_all_matches_parallel(Arena *scratch, Arena *arena,
+                          Match_Search_Buffer *buffers, i32 buffer_count,
+                          String_Const_u8_Array needles, Character_Predicate *predicate,
+                          String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags,
+                          i32 thread_count){
+    Match_Search_Job job = {};
+    job.buffers = buffers;
+    job.buffer_count = buffer_count;
+    job.needles = needles;
+    job.jump_tables = push_array_zero(scratch, u64_Array, needles.count);
+    for (i32 i = 0; i < needles.count; i += 1){
+        if (needles.vals[i].size > 0){
+            job.jump_tables[i] = string_compute_needle_jump_table(scratch, needles.vals[i], Scan_Forward);
+        }
+    }
+    Character_Predicate dummy = {};
+    job.predicate = (predicate != 0)?predicate:&dummy;
+    job.must_have_flags = must_have_flags;
+    job.must_not_have_flags = must_not_have_flags;
+    thread_count = clamp(1, thread_count, MATCH_SEARCH_MAX_THREADS);
+    thread_count = clamp_top(thread_count, clamp_bot(1, buffer_count));
+    job.thread_count = thread_count;
+    
+    Match_Search_Pool *pool = &match_search_pool;
+    if (!pool->initialized){
+        pool->initialized = true;
+        pool->mutex = system_mutex_make();
+        pool->start_cv = system_condition_variable_make();
+        pool->done_cv = system_condition_variable_make();
+        pool->thread_count = 1;
+        pool->workers[0].pool = pool;
+        pool->workers[0].arena = make_arena_system(KB(64));
+    }
+    
+    // NOTE: Searches come through the custom api with the frame mutex held, so
+    // one runs at a time and the workers it asks for can be added without the lock.
+    for (;pool->thread_count < thread_count;){
+        Match_Search_Worker *worker = &pool->workers[pool->thread_count];
+        worker->pool = pool;
+        worker->index = pool->thread_count;
+        worker->job_number = pool->job_number;
+        worker->arena = make_arena_system(KB(64));
+        worker->thread = system_thread_launch(match_search__worker_main, worker);
+        pool->thread_count += 1;
+    }
+    
+    system_mutex_acquire(pool->mutex);
+    pool->job = &job;
+    pool->job_number += 1;
+    pool->busy_count = pool->thread_count - 1;
+    for (i32 i = 1; i < pool->thread_count; i += 1){
+        system_condition_variable_signal(pool->start_cv);
+    }
+    system_mutex_release(pool->mutex);
+    
+    match_search__run(pool, &pool->workers[0], &job);
+    
+    system_mutex_acquire(pool->mutex);
+    for (;pool->busy_count > 0;){
+        system_condition_variable_wait(pool->done_cv, pool->mutex);
+    }
+    pool->job = 0;
+    system_mutex_release(pool->mutex);
+    
+    // NOTE: Copy out in buffer order so the result outlives the worker arenas.
+    String_Match_List list = {};
+    for (i32 i = 0; i < buffer_count; i += 1){
+        for (String_Match *node = buffers[i].matches.first;
+             node != 0;
+             node = node->next){
+            string_match_list_push(arena, &list, node->buffer, node->string_id, node->flags, node->range);
+        }
+        block_zero_struct(&buffers[i].matches);
+    }
+    for (i32 i = 0; i < pool->thread_count; i += 1){
+        linalloc_clear(&pool->workers[i].arena);
+    }
+    
+    return(list);
+}
+
 // BOTTOM
 
@@ -44,6 +44,22 @@ define_api(Arena *arena){
         api_param(arena, call, "String_Const_u8", "file_name");
     }
     
+    {
+        API_Call *call = api_call(arena, api, "file_watch_add", "b32");
+        api_param(arena, call, "String_Const_u8", "file_name");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "file_watch_remove", "void");
+        api_param(arena, call, "String_Const_u8", "file_name");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "file_watch_wait", "File_Watch_Changes");
+        api_param(arena, call, "Arena*", "arena");
+        api_param(arena, call, "u64", "timeout_microseconds");
+    }
+    
     {
         API_Call *call = api_call(arena, api, "load_handle", "b32");
         api_param(arena, call, "Arena*", "scratch");
@@ -60,7 +76,18 @@ define_api(Arena *arena){
         API_Call *call = api_call(arena, api, "load_file", "b32");
         api_param(arena, call, "Plat_Handle", "handle");
         api_param(arena, call, "char*", "buffer");
-        api_param(arena, call, "u32", "size");
+        api_param(arena, call, "u64", "size");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "load_map", "String_Const_u8");
+        api_param(arena, call, "Plat_Handle", "handle");
+        api_param(arena, call, "u64", "size");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "load_unmap", "void");
+        api_param(arena, call, "String_Const_u8", "data");
     }
     
     {
@@ -72,9 +99,41 @@ define_api(Arena *arena){
         API_Call *call = api_call(arena, api, "save_file", "File_Attributes");
         api_param(arena, call, "Arena*", "scratch");
         api_param(arena, call, "char*", "file_name");
+        api_param(arena, call, "List_String_Const_u8", "data");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "delete_file", "b32");
+        api_param(arena, call, "Arena*", "scratch");
+        api_param(arena, call, "char*", "file_name");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "scratch_file_open", "b32");
+        api_param(arena, call, "Arena*", "scratch");
+        api_param(arena, call, "Plat_Handle*", "out");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "scratch_file_write", "b32");
+        api_param(arena, call, "Plat_Handle", "handle");
+        api_param(arena, call, "u64", "pos");
         api_param(arena, call, "String_Const_u8", "data");
     }
     
+    {
+        API_Call *call = api_call(arena, api, "scratch_file_read", "b32");
+        api_param(arena, call, "Plat_Handle", "handle");
+        api_param(arena, call, "u64", "pos");
+        api_param(arena, call, "u8*", "buffer");
+        api_param(arena, call, "u64", "size");
+    }
+    
+    {
+        API_Call *call = api_call(arena, api, "scratch_file_close", "void");
+        api_param(arena, call, "Plat_Handle", "handle");
+    }
+    
     {
         API_Call *call = api_call(arena, api, "load_library", "b32");
         api_param(arena, call, "Arena*", "scratch");
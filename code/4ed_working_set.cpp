@@ -41,24 +41,106 @@ file_change_notification_check(Arena *scratch, Working_Set *working_set, Editing
     }
 }
 
+internal void
+working_set_watch_file(Working_Set *working_set, Editing_File *file){
+    Assert(file->watch_state == FileWatchState_None);
+    file->watch_state = FileWatchState_Pending;
+    dll_insert_back(&working_set->watch_pending_sentinel, &file->watch_node);
+}
+
+internal void
+working_set_unwatch_file(Working_Set *working_set, Editing_File *file){
+    switch (file->watch_state){
+        case FileWatchState_Pending:
+        {
+            dll_remove(&file->watch_node);
+        }break;
+        
+        case FileWatchState_Watched:
+        {
+            system_file_watch_remove(SCu8(file->canon.name_space, file->canon.name_size));
+        }break;
+        
+        case FileWatchState_Polled:
+        {
+            if (working_set->sync_check_iterator == &file->watch_node){
+                working_set->sync_check_iterator = working_set->sync_check_iterator->next;
+            }
+            dll_remove(&file->watch_node);
+            working_set->poll_count -= 1;
+        }break;
+    }
+    block_zero_struct(&file->watch_node);
+    file->watch_state = FileWatchState_None;
+}
+
+internal Editing_File*
+working_set_contains_canon(Working_Set *working_set, String_Const_u8 name);
+
 internal void
 file_change_notification_thread_main(void *ptr){
     Models *models = (Models*)ptr;
     Arena arena = make_arena_system();
     Working_Set *working_set = &models->working_set;
     for (;;){
-        system_sleep(Thousand(250));
+        Temp_Memory temp = begin_temp(&arena);
+        File_Watch_Changes changes = system_file_watch_wait(&arena, Thousand(250));
         Mutex_Lock lock(working_set->mutex);
-        if (working_set->active_file_count > 0){
-            i32 check_count = working_set->active_file_count/16;
-            check_count = clamp(1, check_count, 100);
+        
+        // NOTE: the system dropped events, start every watch over
+        if (changes.lost_changes){
             Node *used = &working_set->active_file_sentinel;
+            for (Node *node = used->next;
+                 node != used;
+                 node = node->next){
+                Editing_File *file = CastFromMember(Editing_File, main_chain_node, node);
+                if (file->watch_state == FileWatchState_Watched){
+                    working_set_unwatch_file(working_set, file);
+                    working_set_watch_file(working_set, file);
+                }
+            }
+        }
+        
+        // NOTE: new watches, checked once in case they changed before the watch
+        {
+            Node *pending = &working_set->watch_pending_sentinel;
+            for (Node *node = pending->next, *next = 0;
+                 node != pending;
+                 node = next){
+                next = node->next;
+                Editing_File *file = CastFromMember(Editing_File, watch_node, node);
+                dll_remove(node);
+                String_Const_u8 name = SCu8(file->canon.name_space, file->canon.name_size);
+                if (system_file_watch_add(name)){
+                    block_zero_struct(node);
+                    file->watch_state = FileWatchState_Watched;
+                }
+                else{
+                    dll_insert_back(&working_set->poll_sentinel, node);
+                    file->watch_state = FileWatchState_Polled;
+                    working_set->poll_count += 1;
+                }
+                file_change_notification_check(&arena, working_set, file);
+            }
+        }
+        
+        for (i32 i = 0; i < changes.count; i += 1){
+            Editing_File *file = working_set_contains_canon(working_set, changes.file_names[i]);
+            if (file != 0 && file->watch_state == FileWatchState_Watched){
+                file_change_notification_check(&arena, working_set, file);
+            }
+        }
+        
+        if (working_set->poll_count > 0){
+            i32 check_count = working_set->poll_count/16;
+            check_count = clamp(1, check_count, 100);
+            Node *used = &working_set->poll_sentinel;
             Node *node = working_set->sync_check_iterator;
             if (node == 0 || node == used){
                 node = used->next;
             }
             for (i32 i = 0; i < check_count; i += 1){
-                Editing_File *file = CastFromMember(Editing_File, main_chain_node, node);
+                Editing_File *file = CastFromMember(Editing_File, watch_node, node);
                 node = node->next;
                 if (node == used){
                     node = node->next;
@@ -67,6 +149,8 @@ file_change_notification_thread_main(void *ptr){
             }
             working_set->sync_check_iterator = node;
         }
+        
+        end_temp(temp);
     }
 }
 
@@ -100,8 +184,9 @@ working_set_allocate_file(Working_Set *working_set, Lifetime_Allocator *lifetime
 
 internal void
 working_set_free_file(Heap *heap, Working_Set *working_set, Editing_File *file){
-    if (working_set->sync_check_iterator == &file->main_chain_node){
-        working_set->sync_check_iterator = working_set->sync_check_iterator->next;
+    working_set_unwatch_file(working_set, file);
+    if (file->snapshot_cache_node.next != 0){
+        dll_remove(&file->snapshot_cache_node);
     }
     dll_remove(&file->main_chain_node);
     dll_remove(&file->touch_node);
@@ -135,8 +220,12 @@ working_set_init(Models *models, Working_Set *working_set){
     working_set->id_to_ptr_table = make_table_u64_u64(allocator, slot_count);
     working_set->canon_table = make_table_Data_u64(allocator, slot_count);
     working_set->name_table = make_table_Data_u64(allocator, slot_count);
+    working_set->base_name_table = make_table_Data_u64(allocator, slot_count);
     
+    dll_init_sentinel(&working_set->watch_pending_sentinel);
+    dll_init_sentinel(&working_set->poll_sentinel);
     dll_init_sentinel(&working_set->has_external_mod_sentinel);
+    dll_init_sentinel(&working_set->snapshot_cache_sentinel);
     working_set->mutex = system_mutex_make();
     working_set->file_change_thread = system_thread_launch(file_change_notification_thread_main, models);
 }
@@ -286,30 +375,32 @@ file_bind_file_name(Working_Set *working_set, Editing_File *file, String_Const_u
     file_name_terminate(&file->canon);
     b32 result = working_set_canon_add(working_set, file, string_from_file_name(&file->canon));
     Assert(result);
+    working_set_watch_file(working_set, file);
 }
 
 internal void
 buffer_unbind_file(Working_Set *working_set, Editing_File *file){
     Assert(file->unique_name.name_size == 0);
     Assert(file->canon.name_size != 0);
+    working_set_unwatch_file(working_set, file);
     working_set_canon_remove(working_set, string_from_file_name(&file->canon));
     file->canon.name_size = 0;
 }
 
 internal b32
 buffer_name_has_conflict(Working_Set *working_set, String_Const_u8 base_name){
-    b32 hit_conflict = false;
-    Node *used_nodes = &working_set->active_file_sentinel;
-    for (Node *node = used_nodes->next;
-         node != used_nodes;
-         node = node->next){
-        Editing_File *file_ptr = CastFromMember(Editing_File, main_chain_node, node);
-        if (file_ptr && string_match(base_name, string_from_file_name(&file_ptr->unique_name))){
-            hit_conflict = true;
-            break;
-        }
+    return(working_set_contains_name(working_set, base_name) != 0);
+}
+
+internal Base_Name_Group*
+working_set_get_base_name_group(Working_Set *working_set, String_Const_u8 base_name){
+    Base_Name_Group *result = 0;
+    base_name.size = clamp_top(base_name.size, sizeof(result->name.name_space));
+    u64 val = 0;
+    if (table_read(&working_set->base_name_table, make_data(base_name.str, base_name.size), &val)){
+        result = (Base_Name_Group*)IntAsPtr(val);
     }
-    return(hit_conflict);
+    return(result);
 }
 
 internal void
@@ -351,6 +442,25 @@ buffer_bind_name_low_level(Arena *scratch, Working_Set *working_set, Editing_Fil
         file->base_name.name_size = size;
     }
     
+    {
+        String_Const_u8 key = string_from_file_name(&file->base_name);
+        Base_Name_Group *group = working_set_get_base_name_group(working_set, key);
+        if (group == 0){
+            group = working_set->free_base_name_groups;
+            if (group == 0){
+                group = push_array(&working_set->arena, Base_Name_Group, 1);
+            }
+            else{
+                sll_stack_pop(working_set->free_base_name_groups);
+            }
+            block_zero_struct(group);
+            dll_init_sentinel(&group->files);
+            group->name = file->base_name;
+            table_insert(&working_set->base_name_table, make_data(group->name.name_space, group->name.name_size), (u64)PtrAsInt(group));
+        }
+        dll_insert_back(&group->files, &file->base_name_node);
+    }
+    
     {
         u64 size = new_name.name_size;
         block_copy(file->unique_name.name_space, new_name.name_space, size);
@@ -366,6 +476,12 @@ buffer_unbind_name_low_level(Working_Set *working_set, Editing_File *file){
     Assert(file->base_name.name_size != 0);
     Assert(file->unique_name.name_size != 0);
     working_set_remove_name(working_set, string_from_file_name(&file->unique_name));
+    dll_remove(&file->base_name_node);
+    Base_Name_Group *group = working_set_get_base_name_group(working_set, string_from_file_name(&file->base_name));
+    if (group != 0 && group->files.next == &group->files){
+        table_erase(&working_set->base_name_table, make_data(group->name.name_space, group->name.name_size));
+        sll_stack_push(working_set->free_base_name_groups, group);
+    }
     file->base_name.name_size = 0;
     file->unique_name.name_size = 0;
 }
@@ -390,12 +506,13 @@ buffer_bind_name(Thread_Context *tctx, Models *models, Arena *scratch, Working_S
         conflict_count += 1;
     }
     
-    Node *used_nodes = &working_set->active_file_sentinel;
-    for (Node *node = used_nodes->next;
-         node != used_nodes;
-         node = node->next){
-        Editing_File *file_ptr = CastFromMember(Editing_File, main_chain_node, node);
-        if (file_ptr != 0 && string_match(base_name, string_from_file_name(&file_ptr->base_name))){
+    Base_Name_Group *group = working_set_get_base_name_group(working_set, base_name);
+    if (group != 0){
+        Node *used_nodes = &group->files;
+        for (Node *node = used_nodes->next;
+             node != used_nodes;
+             node = node->next){
+            Editing_File *file_ptr = CastFromMember(Editing_File, base_name_node, node);
             Node_Ptr *new_node = push_array(scratch, Node_Ptr, 1);
             sll_queue_push(conflict_first, conflict_last, new_node);
             new_node->file_ptr = file_ptr;
@@ -12,6 +12,14 @@
 #if !defined(FRED_WORKING_SET_H)
 #define FRED_WORKING_SET_H
 
+// NOTE: All files that share a base name, so binding a name only looks at the
+// files it can conflict with.
+struct Base_Name_Group{
+    Base_Name_Group *next;
+    Node files;
+    Editing_File_Name name;
+};
+
 struct Working_Set{
     // NOTE(allen): After initialization of file_change_thread
     // the members of this struct should only be accessed by a thread
@@ -29,9 +37,20 @@ struct Working_Set{
     Table_u64_u64 id_to_ptr_table;
     Table_Data_u64 canon_table;
     Table_Data_u64 name_table;
+    Table_Data_u64 base_name_table;
+    Base_Name_Group *free_base_name_groups;
     
+    // NOTE: Files with a canonical name wait in watch_pending until the file
+    // change thread asks the system to watch their directory, the ones it can't
+    // watch move to poll and are checked a few at a time.
+    Node watch_pending_sentinel;
+    Node poll_sentinel;
+    i32 poll_count;
     Node *sync_check_iterator;
     Node has_external_mod_sentinel;
+    // NOTE: Files whose buffers hold the copy of their last snapshot, only touched
+    // with the frame mutex held.
+    Node snapshot_cache_sentinel;
     System_Mutex mutex;
     System_Thread file_change_thread;
 };
@@ -0,0 +1,549 @@
+/*
+ * 4coder buffer benchmarks
+ *
+ * Times the buffer storage engines and the line index on synthetic workloads and
+ * checks their results against each other.
+ *
+ * build: custom/bin/build_one_time bench/4ed_bench_buffer.cpp ../build
+ * usage: one_time [section] [megabytes] [corpus-directory]
+ *
+ */
+
+// TOP
+
+#include "4coder_base_types.h"
+#include "4coder_table.h"
+#include "4coder_events.h"
+#include "4coder_types.h"
+
+#include "4coder_base_types.cpp"
+#include "4coder_stringf.cpp"
+#include "4coder_malloc_allocator.cpp"
+#include "4coder_file.cpp"
+
+#include <stdlib.h>
+#include <string.h>
+#if OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#include <dirent.h>
+#endif
+
+internal void*
+system_memory_allocate(u64 size, String_Const_u8 location){
+    return(malloc(size));
+}
+
+internal void
+system_memory_free(void *ptr, u64 size){
+    free(ptr);
+}
+
+#include "4coder_system_allocator.cpp"
+
+#include "../4ed_buffer.h"
+#include "../4ed_buffer.cpp"
+
+////////////////////////////////
+
+function u64
+bench_now_us(void){
+    u64 result = 0;
+#if OS_WINDOWS
+    LARGE_INTEGER counter = {};
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (u64)(counter.QuadPart*1000000/frequency.QuadPart);
+#else
+    struct timespec t = {};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (u64)t.tv_sec*1000000 + (u64)t.tv_nsec/1000;
+#endif
+    return(result);
+}
+
+global u64 bench_random_state = 0x9E3779B97F4A7C15llu;
+
+function u64
+bench_random(void){
+    u64 x = bench_random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    bench_random_state = x;
+    return(x);
+}
+
+function String_Const_u8
+bench_make_text(Arena *arena, u64 size){
+    String_Const_u8 result = {};
+    result.str = push_array(arena, u8, size);
+    result.size = size;
+    for (u64 i = 0; i < size; i += 1){
+        u64 r = bench_random()%64;
+        result.str[i] = (r == 0)?'\n':(u8)('a' + r%26);
+    }
+    return(result);
+}
+
+function b32
+bench_buffers_match(Arena *arena, Gap_Buffer *a, Gap_Buffer *b){
+    b32 result = false;
+    Temp_Memory temp = begin_temp(arena);
+    i64 size = buffer_size(a);
+    if (size == buffer_size(b)){
+        String_Const_u8 a_string = buffer_stringify(arena, a, Ii64(0, size));
+        String_Const_u8 b_string = buffer_stringify(arena, b, Ii64(0, size));
+        result = (memcmp(a_string.str, b_string.str, (size_t)size) == 0);
+    }
+    end_temp(temp);
+    return(result);
+}
+
+////////////////////////////////
+
+// NOTE: Random position edits.  The same sequence of small replaces is applied to a
+// gap buffer and a piece tree buffer; every edit lands far from the last one, which is
+// the case that makes the gap buffer move most of its text.
+function b32
+bench_storage(Arena *arena, u64 megabytes){
+    u64 size = MB(1)*megabytes;
+    String_Const_u8 text = bench_make_text(arena, size);
+    i32 edit_count = 2000;
+    
+    Gap_Buffer buffers[2] = {};
+    buffer_init(&buffers[0], text.str, text.size, get_allocator_malloc(), BufferStorage_Gap);
+    buffer_init(&buffers[1], text.str, text.size, get_allocator_malloc(), BufferStorage_PieceTree);
+    char *names[2] = {"gap buffer", "piece tree"};
+    
+    printf("storage: %d random position edits on %lluMB\n", edit_count, (unsigned long long)megabytes);
+    for (i32 kind = 0; kind < 2; kind += 1){
+        bench_random_state = 0x1234567;
+        Gap_Buffer *buffer = &buffers[kind];
+        u64 start = bench_now_us();
+        for (i32 i = 0; i < edit_count; i += 1){
+            i64 buffer_size_ = buffer_size(buffer);
+            i64 first = (i64)(bench_random()%(u64)(buffer_size_ + 1));
+            i64 one_past_last = Min(first + (i64)(bench_random()%8), buffer_size_);
+            String_Const_u8 insert = string_prefix(string_u8_litexpr("edit\nedit"), bench_random()%10);
+            i64 shift = (i64)insert.size - (one_past_last - first);
+            buffer_replace_range(buffer, Ii64(first, one_past_last), insert, shift);
+        }
+        u64 edit_time = bench_now_us() - start;
+        
+        start = bench_now_us();
+        Temp_Memory temp = begin_temp(arena);
+        List_String_Const_u8 chunks = buffer_get_chunks(arena, buffer);
+        u64 checksum = 0;
+        for (Node_String_Const_u8 *node = chunks.first; node != 0; node = node->next){
+            for (u64 i = 0; i < node->string.size; i += 1){
+                checksum += node->string.str[i];
+            }
+        }
+        end_temp(temp);
+        u64 read_time = bench_now_us() - start;
+        
+        printf("  %-12s %8.2fus/edit  full read %8.2fms  (checksum %llu, %lld pieces)\n",
+               names[kind], (f64)edit_time/edit_count, read_time/1000.0, (unsigned long long)checksum,
+               (long long)buffer->piece_tree.piece_count);
+    }
+    
+    b32 result = bench_buffers_match(arena, &buffers[0], &buffers[1]);
+    printf("  contents %s\n", result?"match":"DIFFER");
+    buffer_free(&buffers[0]);
+    buffer_free(&buffers[1]);
+    return(result);
+}
+
+////////////////////////////////
+
+// NOTE: Typing at the top of a file with two million lines.  Each keystroke goes
+// through buffer_remeasure_starts just like an edit in the editor, and every eighth
+// keystroke is a newline so the line count keeps changing.  The "flat array" row
+// times the shift of every later line start that the old line_starts array paid on
+// each of those keystrokes.
+function b32
+bench_lines(Arena *arena, Thread_Context *tctx){
+    i64 line_count = 2000000;
+    u64 size = (u64)line_count*40;
+    String_Const_u8 text = push_data(arena, size);
+    for (u64 i = 0; i < size; i += 1){
+        text.str[i] = ((i % 40) == 39)?'\n':'x';
+    }
+    
+    Gap_Buffer buffer = {};
+    buffer_init(&buffer, text.str, text.size, get_allocator_malloc(), BufferStorage_Gap);
+    u64 start = bench_now_us();
+    buffer_measure_starts(arena, &buffer);
+    u64 measure_time = bench_now_us() - start;
+    
+    i32 keystroke_count = 20000;
+    start = bench_now_us();
+    for (i32 i = 0; i < keystroke_count; i += 1){
+        String_Const_u8 key = ((i % 8) == 7)?string_u8_litexpr("\n"):string_u8_litexpr("a");
+        i64 pos = 5 + i;
+        Batch_Edit edit = {};
+        edit.edit.text = key;
+        edit.edit.range = Ii64(pos);
+        buffer_replace_range(&buffer, edit.edit.range, key, (i64)key.size);
+        buffer_remeasure_starts(tctx, &buffer, &edit);
+    }
+    u64 typing_time = bench_now_us() - start;
+    
+    i64 *flat = push_array(arena, i64, line_count);
+    for (i64 i = 0; i < line_count; i += 1){
+        flat[i] = i*40;
+    }
+    i32 flat_count = 200;
+    start = bench_now_us();
+    for (i32 i = 0; i < flat_count; i += 1){
+        for (i64 j = 1; j < line_count; j += 1){
+            flat[j] += 1;
+        }
+    }
+    u64 flat_time = bench_now_us() - start;
+    
+    Gap_Buffer check = {};
+    String_Const_u8 final_text = buffer_stringify(arena, &buffer, Ii64(0, buffer_size(&buffer)));
+    buffer_init(&check, final_text.str, final_text.size, get_allocator_malloc(), BufferStorage_Gap);
+    buffer_measure_starts(arena, &check);
+    b32 result = (buffer_line_count(&buffer) == buffer_line_count(&check));
+    for (i32 i = 0; i < 10000 && result; i += 1){
+        i64 line_number = 1 + (i64)(bench_random()%(u64)buffer_line_count(&check));
+        i64 pos = (i64)(bench_random()%(u64)(buffer_size(&check) + 1));
+        result = (buffer_get_first_pos_from_line_number(&buffer, line_number) ==
+                  buffer_get_first_pos_from_line_number(&check, line_number) &&
+                  buffer_get_line_index(&buffer, pos) == buffer_get_line_index(&check, pos));
+    }
+    
+    printf("lines: %d keystrokes at line 1 of %lld lines\n", keystroke_count, (long long)line_count);
+    printf("  initial measure %8.2fms\n", measure_time/1000.0);
+    printf("  line index      %8.2fus/keystroke\n", (f64)typing_time/keystroke_count);
+    printf("  flat array      %8.2fus/keystroke (shift only)\n", (f64)flat_time/flat_count);
+    printf("  incremental index %s a fresh measure\n", result?"matches":"DIFFERS FROM");
+    
+    buffer_free(&buffer);
+    buffer_free(&check);
+    return(result);
+}
+
+////////////////////////////////
+
+function void
+bench_push_corpus(Arena *arena, List_String_Const_u8 *list, String_Const_u8 dir){
+    List_String_Const_u8 names = {};
+    List_String_Const_u8 sub_dirs = {};
+#if OS_WINDOWS
+    WIN32_FIND_DATAA find_data = {};
+    String_Const_u8 pattern = push_u8_stringf(arena, "%.*s\\*", string_expand(dir));
+    HANDLE search = FindFirstFileA((char*)pattern.str, &find_data);
+    if (search != INVALID_HANDLE_VALUE){
+        do{
+            if (find_data.cFileName[0] != '.'){
+                String_Const_u8 name = push_u8_stringf(arena, "%.*s\\%s", string_expand(dir), find_data.cFileName);
+                string_list_push(arena, HasFlag(find_data.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY)?&sub_dirs:&names, name);
+            }
+        }while (FindNextFileA(search, &find_data));
+        FindClose(search);
+    }
+#else
+    String_Const_u8 dir_z = push_string_copy(arena, dir);
+    DIR *dir_handle = opendir((char*)dir_z.str);
+    if (dir_handle != 0){
+        for (struct dirent *entry = readdir(dir_handle);
+             entry != 0;
+             entry = readdir(dir_handle)){
+            if (entry->d_name[0] != '.'){
+                String_Const_u8 name = push_u8_stringf(arena, "%.*s/%s", string_expand(dir), entry->d_name);
+                string_list_push(arena, (entry->d_type == DT_DIR)?&sub_dirs:&names, name);
+            }
+        }
+        closedir(dir_handle);
+    }
+#endif
+    
+    for (Node_String_Const_u8 *node = names.first;
+         node != 0;
+         node = node->next){
+        FILE *file = fopen((char*)node->string.str, "rb");
+        if (file != 0){
+            string_list_push(arena, list, data_from_file(arena, file));
+            fclose(file);
+        }
+    }
+    for (Node_String_Const_u8 *node = sub_dirs.first;
+         node != 0;
+         node = node->next){
+        bench_push_corpus(arena, list, node->string);
+    }
+}
+
+// NOTE: Newline counting and line start measurement over the test data corpus, with
+// each kernel run directly so the vector paths can be compared with the scalar loop.
+function b32
+bench_newlines(Arena *arena, char *corpus_dir){
+    List_String_Const_u8 list = {};
+    bench_push_corpus(arena, &list, SCu8(corpus_dir));
+    String_Const_u8 corpus = string_list_flatten(arena, list);
+    
+    b32 result = (corpus.size > 0);
+    if (!result){
+        printf("newlines: no files under %s\n", corpus_dir);
+    }
+    else{
+        i32 pass_count = (i32)clamp_bot(1, (i64)(GB(1)/corpus.size));
+        printf("newlines: %d passes over %.2fMB from %s\n", pass_count, corpus.size/(1024.0*1024.0), corpus_dir);
+        
+        i64 expected = count_lines__scalar(corpus.str, corpus.size);
+        // NOTE: Reloaded every pass so the optimizer cannot fold the passes together.
+        u8 *volatile corpus_str = corpus.str;
+        i64 *starts = push_array(arena, i64, expected + 1);
+        
+        char *names[] = {"scalar", "sse2", "avx2"};
+        for (i32 kernel = 0; kernel < 3; kernel += 1){
+            b32 available = (kernel == 0);
+#if ARCH_HAS_X86_SIMD
+            available = (available ||
+                         (kernel == 1 && cpu_has_feature(CPUFeature_SSE2)) ||
+                         (kernel == 2 && cpu_has_feature(CPUFeature_AVX2)));
+#endif
+            if (available){
+                i64 count = 0;
+                i64 filled = 0;
+                u64 start = bench_now_us();
+                for (i32 pass = 0; pass < pass_count; pass += 1){
+                    switch (kernel){
+                        case 0: count += count_lines__scalar(corpus_str, corpus.size); break;
+#if ARCH_HAS_X86_SIMD
+                        case 1: count += count_lines__sse2(corpus_str, corpus.size); break;
+                        case 2: count += count_lines__avx2(corpus_str, corpus.size); break;
+#endif
+                    }
+                }
+                u64 count_time = clamp_bot(1, bench_now_us() - start);
+                start = bench_now_us();
+                for (i32 pass = 0; pass < pass_count; pass += 1){
+                    switch (kernel){
+                        case 0: filled += fill_line_starts__scalar(starts, corpus_str, corpus.size, 0); break;
+#if ARCH_HAS_X86_SIMD
+                        case 1: filled += fill_line_starts__sse2(starts, corpus_str, corpus.size, 0); break;
+                        case 2: filled += fill_line_starts__avx2(starts, corpus_str, corpus.size, 0); break;
+#endif
+                    }
+                }
+                u64 fill_time = clamp_bot(1, bench_now_us() - start);
+                f64 bytes = (f64)corpus.size*pass_count;
+                printf("  %-7s count %6.2fGB/s  fill starts %6.2fGB/s\n", names[kernel],
+                       bytes/(count_time*1000.0), bytes/(fill_time*1000.0));
+                if (count != expected*pass_count || filled != expected*pass_count){
+                    printf("  %s found %lld/%lld newlines, expected %lld\n", names[kernel],
+                           (long long)(count/pass_count), (long long)(filled/pass_count), (long long)expected);
+                    result = false;
+                }
+            }
+        }
+        
+        Gap_Buffer buffer = {};
+        buffer_init(&buffer, corpus.str, corpus.size, get_allocator_malloc(), BufferStorage_Gap);
+        u64 start = bench_now_us();
+        buffer_measure_starts(arena, &buffer);
+        u64 measure_time = clamp_bot(1, bench_now_us() - start);
+        printf("  buffer_measure_starts %6.2fGB/s (%lld lines)\n",
+               (f64)corpus.size/(measure_time*1000.0), (long long)buffer_line_count(&buffer));
+        if (buffer_line_count(&buffer) != expected + 1){
+            result = false;
+        }
+        buffer_free(&buffer);
+    }
+    return(result);
+}
+
+////////////////////////////////
+
+// NOTE: The byte at a time loops the block primitives used before they were vectorized,
+// kept here as the baseline.
+function void
+bench_copy_bytes(void *dst, const void *src, u64 size){
+    u8 *d = (u8*)dst;
+    u8 *s = (u8*)src;
+    if (d < s){
+        u8 *e = d + size;
+        for (; d < e; d += 1, s += 1){
+            *d = *s;
+        }
+    }
+    else if (d > s){
+        u8 *e = d;
+        d += size - 1;
+        s += size - 1;
+        for (; d >= e; d -= 1, s -= 1){
+            *d = *s;
+        }
+    }
+}
+
+function i32
+bench_compare_bytes(void *a, void *b, u64 size){
+    i32 result = 0;
+    for (u8 *pa = (u8*)a, *pb = (u8*)b, *ea = pa + size; pa < ea; pa += 1, pb += 1){
+        i32 dif = (i32)*pa - (i32)*pb;
+        if (dif != 0){
+            result = (dif > 0)?1:-1;
+            break;
+        }
+    }
+    return(result);
+}
+
+function b32
+bench_block_check(void){
+    b32 result = true;
+    u64 size = 4096;
+    u8 *a = (u8*)malloc(size);
+    u8 *b = (u8*)malloc(size);
+    u8 *r = (u8*)malloc(size);
+    for (i32 round = 0; round < 100000 && result; round += 1){
+        for (u64 i = 0; i < size; i += 1){
+            a[i] = (u8)bench_random();
+        }
+        memcpy(b, a, size);
+        memcpy(r, a, size);
+        u64 n = bench_random()%(((round % 10) == 0)?3000:200);
+        u64 src = bench_random()%(size - n);
+        u64 dst = bench_random()%(size - n);
+        if ((round % 3) == 0){
+            i64 near_src = (i64)src + (i64)(bench_random()%41) - 20;
+            dst = (u64)clamp(0, near_src, (i64)(size - n));
+        }
+        memmove(r + dst, r + src, n);
+        block_copy(b + dst, b + src, n);
+        result = (memcmp(r, b, size) == 0);
+        
+        u64 offset = bench_random()%100;
+        memcpy(b, a, size);
+        if (n > 0 && (round % 2) == 0){
+            b[offset + bench_random()%n] ^= (u8)(1 + bench_random()%255);
+        }
+        i32 expected = bench_compare_bytes(a + offset, b + offset, n);
+        result = (result &&
+                  block_compare(a + offset, b + offset, n) == expected &&
+                  block_match(a + offset, b + offset, n) == (expected == 0));
+        
+        memset(r + src, 7, n);
+        block_fill_u8(b + src, n, 7);
+        memset(r + dst, 0, n);
+        block_zero(b + dst, n);
+        memcpy(r, b, size);
+        result = (result && memcmp(r, b, size) == 0);
+    }
+    free(a);
+    free(b);
+    free(r);
+    return(result);
+}
+
+// NOTE: Gap moves alternate edits at the two ends of the buffer so every edit moves
+// the whole text across the gap; the whole buffer read is what push_whole_buffer does.
+function b32
+bench_block(Arena *arena, u64 megabytes){
+    b32 result = bench_block_check();
+    printf("block: overlap, compare, match and fill checks %s\n", result?"pass":"FAIL");
+    
+    u64 size = MB(1)*megabytes;
+    String_Const_u8 text = bench_make_text(arena, size);
+    u8 *scratch = (u8*)malloc(size*2);
+    
+    i32 move_count = 20;
+    Gap_Buffer buffer = {};
+    buffer_init(&buffer, text.str, text.size, get_allocator_malloc(), BufferStorage_Gap);
+    u64 start = bench_now_us();
+    for (i32 i = 0; i < move_count; i += 1){
+        i64 pos = ((i % 2) == 0)?0:buffer_size(&buffer);
+        buffer_replace_range(&buffer, Ii64(pos), string_u8_litexpr("x"), 1);
+    }
+    u64 move_time = clamp_bot(1, bench_now_us() - start);
+    start = bench_now_us();
+    for (i32 i = 0; i < move_count; i += 1){
+        if ((i % 2) == 0){
+            bench_copy_bytes(scratch + size, scratch, size);
+        }
+        else{
+            bench_copy_bytes(scratch, scratch + size, size);
+        }
+    }
+    u64 move_bytes_time = clamp_bot(1, bench_now_us() - start);
+    
+    i32 read_count = 20;
+    u64 checksum = 0;
+    start = bench_now_us();
+    for (i32 i = 0; i < read_count; i += 1){
+        Temp_Memory temp = begin_temp(arena);
+        String_Const_u8 whole = buffer_stringify(arena, &buffer, Ii64(0, buffer_size(&buffer)));
+        checksum += whole.str[i];
+        end_temp(temp);
+    }
+    u64 read_time = clamp_bot(1, bench_now_us() - start);
+    start = bench_now_us();
+    for (i32 i = 0; i < read_count; i += 1){
+        Temp_Memory temp = begin_temp(arena);
+        u8 *whole = push_array(arena, u8, buffer_size(&buffer));
+        bench_copy_bytes(whole, buffer.data, (u64)buffer.size1);
+        bench_copy_bytes(whole + buffer.size1, buffer.data + buffer.size1 + buffer.gap_size, (u64)buffer.size2);
+        checksum += whole[i];
+        end_temp(temp);
+    }
+    u64 read_bytes_time = clamp_bot(1, bench_now_us() - start);
+    
+    printf("block: %lluMB buffer\n", (unsigned long long)megabytes);
+    printf("  gap move           %8.2fms vectorized  %8.2fms byte loop\n",
+           move_time/(1000.0*move_count), move_bytes_time/(1000.0*move_count));
+    printf("  push_whole_buffer  %8.2fms vectorized  %8.2fms byte loop  (checksum %llu)\n",
+           read_time/(1000.0*read_count), read_bytes_time/(1000.0*read_count), (unsigned long long)checksum);
+    
+    buffer_free(&buffer);
+    free(scratch);
+    return(result);
+}
+
+////////////////////////////////
+
+int
+main(int argc, char **argv){
+    Arena arena = make_arena_malloc();
+    Thread_Context tctx = {};
+    thread_ctx_init(&tctx, ThreadKind_Main, get_allocator_malloc(), get_allocator_malloc());
+    char *section = "all";
+    u64 megabytes = 64;
+    if (argc > 1){
+        section = argv[1];
+    }
+    char *corpus_dir = "../non-source/test_data";
+    if (argc > 2){
+        megabytes = (u64)atoi(argv[2]);
+    }
+    if (argc > 3){
+        corpus_dir = argv[3];
+    }
+    String_Const_u8 section_name = SCu8(section);
+    b32 all = string_match(section_name, string_u8_litexpr("all"));
+    
+    b32 ok = true;
+    if (all || string_match(section_name, string_u8_litexpr("storage"))){
+        ok = bench_storage(&arena, megabytes) && ok;
+    }
+    if (all || string_match(section_name, string_u8_litexpr("lines"))){
+        ok = bench_lines(&arena, &tctx) && ok;
+    }
+    if (all || string_match(section_name, string_u8_litexpr("newlines"))){
+        ok = bench_newlines(&arena, corpus_dir) && ok;
+    }
+    if (all || string_match(section_name, string_u8_litexpr("block"))){
+        ok = bench_block(&arena, megabytes) && ok;
+    }
+    
+    return(ok?0:1);
+}
+
+// BOTTOM
@@ -0,0 +1,316 @@
+/*
+ * 4coder coroutine benchmarks
+ *
+ * Times a coroutine_run/coroutine_yield round trip and a create/run/finish cycle for
+ * the thread+cv backend and, where it is supported, the stack switching backend.
+ *
+ * build: custom/bin/build_one_time bench/4ed_bench_coroutine.cpp ../build
+ * usage: one_time [iterations]
+ *
+ */
+
+// TOP
+
+#include "4coder_base_types.h"
+#include "4coder_table.h"
+#include "4coder_events.h"
+#include "4coder_types.h"
+#include "4coder_system_types.h"
+
+#include "4coder_base_types.cpp"
+#include "4coder_malloc_allocator.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#if OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+
+// NOTE: The benchmark keeps the OS object's pointer in the first bytes of the handle.
+internal Plat_Handle
+bench_handle_from_ptr(void *ptr){
+    Plat_Handle result = {};
+    block_copy(&result, &ptr, sizeof(ptr));
+    return(result);
+}
+
+internal void*
+bench_ptr_from_handle(Plat_Handle handle){
+    void *result = 0;
+    block_copy(&result, &handle, sizeof(result));
+    return(result);
+}
+
+// NOTE: The coroutine stacks get a guard page, so memory comes straight from the OS
+// here instead of from malloc.
+#if OS_WINDOWS
+
+internal void*
+system_memory_allocate(u64 size, String_Const_u8 location){
+    return(VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE));
+}
+
+internal b32
+system_memory_set_protection(void *ptr, u64 size, u32 flags){
+    DWORD old_protect = 0;
+    return(VirtualProtect(ptr, size, (flags == 0)?PAGE_NOACCESS:PAGE_READWRITE, &old_protect));
+}
+
+internal void
+system_memory_free(void *ptr, u64 size){
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+struct Bench_Thread_Start{
+    Thread_Function *proc;
+    void *ptr;
+};
+
+internal DWORD WINAPI
+bench_thread_main(LPVOID ptr){
+    Bench_Thread_Start start = *(Bench_Thread_Start*)ptr;
+    free(ptr);
+    start.proc(start.ptr);
+    return(0);
+}
+
+internal System_Thread
+system_thread_launch(Thread_Function *proc, void *ptr){
+    Bench_Thread_Start *start = (Bench_Thread_Start*)malloc(sizeof(*start));
+    start->proc = proc;
+    start->ptr = ptr;
+    return(bench_handle_from_ptr(CreateThread(0, 0, bench_thread_main, start, 0, 0)));
+}
+
+internal System_Mutex
+system_mutex_make(void){
+    CRITICAL_SECTION *mutex = (CRITICAL_SECTION*)malloc(sizeof(*mutex));
+    InitializeCriticalSection(mutex);
+    return(bench_handle_from_ptr(mutex));
+}
+
+internal void
+system_mutex_acquire(System_Mutex mutex){
+    EnterCriticalSection((CRITICAL_SECTION*)bench_ptr_from_handle(mutex));
+}
+
+internal void
+system_mutex_release(System_Mutex mutex){
+    LeaveCriticalSection((CRITICAL_SECTION*)bench_ptr_from_handle(mutex));
+}
+
+internal System_Condition_Variable
+system_condition_variable_make(void){
+    CONDITION_VARIABLE *cv = (CONDITION_VARIABLE*)malloc(sizeof(*cv));
+    InitializeConditionVariable(cv);
+    return(bench_handle_from_ptr(cv));
+}
+
+internal void
+system_condition_variable_wait(System_Condition_Variable cv, System_Mutex mutex){
+    SleepConditionVariableCS((CONDITION_VARIABLE*)bench_ptr_from_handle(cv), (CRITICAL_SECTION*)bench_ptr_from_handle(mutex), INFINITE);
+}
+
+internal void
+system_condition_variable_signal(System_Condition_Variable cv){
+    WakeConditionVariable((CONDITION_VARIABLE*)bench_ptr_from_handle(cv));
+}
+
+#else
+
+internal void*
+system_memory_allocate(u64 size, String_Const_u8 location){
+    void *result = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    return((result == MAP_FAILED)?0:result);
+}
+
+internal b32
+system_memory_set_protection(void *ptr, u64 size, u32 flags){
+    int protect = 0;
+    MovFlag(flags, MemProtect_Read, protect, PROT_READ);
+    MovFlag(flags, MemProtect_Write, protect, PROT_WRITE);
+    MovFlag(flags, MemProtect_Execute, protect, PROT_EXEC);
+    return(mprotect(ptr, size, protect) == 0);
+}
+
+internal void
+system_memory_free(void *ptr, u64 size){
+    munmap(ptr, size);
+}
+
+struct Bench_Thread_Start{
+    Thread_Function *proc;
+    void *ptr;
+};
+
+internal void*
+bench_thread_main(void *ptr){
+    Bench_Thread_Start start = *(Bench_Thread_Start*)ptr;
+    free(ptr);
+    start.proc(start.ptr);
+    return(0);
+}
+
+internal System_Thread
+system_thread_launch(Thread_Function *proc, void *ptr){
+    Bench_Thread_Start *start = (Bench_Thread_Start*)malloc(sizeof(*start));
+    start->proc = proc;
+    start->ptr = ptr;
+    pthread_t thread = {};
+    pthread_create(&thread, 0, bench_thread_main, start);
+    pthread_detach(thread);
+    System_Thread result = {};
+    return(result);
+}
+
+internal System_Mutex
+system_mutex_make(void){
+    pthread_mutex_t *mutex = (pthread_mutex_t*)malloc(sizeof(*mutex));
+    pthread_mutex_init(mutex, 0);
+    return(bench_handle_from_ptr(mutex));
+}
+
+internal void
+system_mutex_acquire(System_Mutex mutex){
+    pthread_mutex_lock((pthread_mutex_t*)bench_ptr_from_handle(mutex));
+}
+
+internal void
+system_mutex_release(System_Mutex mutex){
+    pthread_mutex_unlock((pthread_mutex_t*)bench_ptr_from_handle(mutex));
+}
+
+internal System_Condition_Variable
+system_condition_variable_make(void){
+    pthread_cond_t *cv = (pthread_cond_t*)malloc(sizeof(*cv));
+    pthread_cond_init(cv, 0);
+    return(bench_handle_from_ptr(cv));
+}
+
+internal void
+system_condition_variable_wait(System_Condition_Variable cv, System_Mutex mutex){
+    pthread_cond_wait((pthread_cond_t*)bench_ptr_from_handle(cv), (pthread_mutex_t*)bench_ptr_from_handle(mutex));
+}
+
+internal void
+system_condition_variable_signal(System_Condition_Variable cv){
+    pthread_cond_signal((pthread_cond_t*)bench_ptr_from_handle(cv));
+}
+
+#endif
+
+#include "4coder_system_allocator.cpp"
+
+// NOTE: Both backends are compiled into this program, each in its own namespace, by
+// including the coroutine code once per value of FRED_COROUTINE_THREADS.
+namespace coroutine_threads{
+#define FRED_COROUTINE_THREADS 1
+#include "../4ed_coroutine.h"
+#include "../4ed_coroutine.cpp"
+}
+
+#if ARCH_X64 && (OS_LINUX || OS_MAC)
+#define BENCH_STACK_SWITCHING 1
+#undef FRED_COROUTINE_H
+#undef FRED_COROUTINE_THREADS
+namespace coroutine_stacks{
+#define FRED_COROUTINE_THREADS 0
+#include "../4ed_coroutine.h"
+#include "../4ed_coroutine.cpp"
+}
+#else
+#define BENCH_STACK_SWITCHING 0
+#endif
+
+////////////////////////////////
+
+function u64
+bench_now_us(void){
+    u64 result = 0;
+#if OS_WINDOWS
+    LARGE_INTEGER counter = {};
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (u64)(counter.QuadPart*1000000/frequency.QuadPart);
+#else
+    struct timespec t = {};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (u64)t.tv_sec*1000000 + (u64)t.tv_nsec/1000;
+#endif
+    return(result);
+}
+
+global i64 bench_iterations = 200000;
+
+// NOTE: The same benchmark in each backend's namespace, so Coroutine and
+// Coroutine_Group resolve to that backend's types.
+#define BENCH_COROUTINE_BACKEND(N)                                              \
+namespace N{                                                                    \
+    internal void                                                               \
+    bench_yield_loop(Coroutine *me){                                            \
+        for (i64 i = 0; i < bench_iterations; i += 1){                          \
+            coroutine_yield(me);                                                \
+        }                                                                       \
+    }                                                                           \
+    internal void                                                               \
+    bench_finish(Coroutine *me){                                                \
+        *(i64*)me->in += 1;                                                     \
+    }                                                                           \
+    internal void                                                               \
+    bench_run(char *name){                                                      \
+        Coroutine_Group group = {};                                             \
+        coroutine_system_init(&group);                                          \
+                                                                                \
+        Coroutine *co = coroutine_create(&group, bench_yield_loop);             \
+        i64 round_trips = 0;                                                    \
+        u64 start = bench_now_us();                                             \
+        for (;co != 0; round_trips += 1){                                       \
+            co = coroutine_run(&group, co, 0, 0);                               \
+        }                                                                       \
+        u64 round_trip_time = clamp_bot(1, bench_now_us() - start);             \
+                                                                                \
+        i64 finished = 0;                                                       \
+        start = bench_now_us();                                                 \
+        for (i64 i = 0; i < bench_iterations; i += 1){                          \
+            co = coroutine_create(&group, bench_finish);                        \
+            co = coroutine_run(&group, co, &finished, 0);                       \
+            Assert(co == 0);                                                    \
+        }                                                                       \
+        u64 finish_time = clamp_bot(1, bench_now_us() - start);                 \
+                                                                                \
+        printf("  %-16s run+yield %8.1fns   create+run+finish %8.1fns\n",      \
+               name, round_trip_time*1000.0/round_trips,                        \
+               finish_time*1000.0/finished);                                    \
+    }                                                                           \
+}
+
+BENCH_COROUTINE_BACKEND(coroutine_threads)
+#if BENCH_STACK_SWITCHING
+BENCH_COROUTINE_BACKEND(coroutine_stacks)
+#endif
+
+int
+main(int argc, char **argv){
+    if (argc > 1){
+        bench_iterations = (i64)atoi(argv[1]);
+    }
+
+    Thread_Context tctx = {};
+    thread_ctx_init(&tctx, ThreadKind_Main, get_base_allocator_system(), get_base_allocator_system());
+
+    printf("coroutines: %lld iterations per test\n", (long long)bench_iterations);
+    coroutine_threads::bench_run("thread+cv");
+#if BENCH_STACK_SWITCHING
+    coroutine_stacks::bench_run("stack switching");
+#else
+    printf("  stack switching  not supported on this target\n");
+#endif
+    return(0);
+}
+
+// BOTTOM
@@ -0,0 +1,322 @@
+/*
+ * 4coder marker index benchmark
+ *
+ * Checks the buffer marker index against buffer_update_cursors_lean_l/_r on random
+ * batches, with touching, adjacent and empty edits mixed in, then times a single edit
+ * on a large marker set through the index and through the old sort and shift path.
+ *
+ * build: custom/bin/build_one_time bench/4ed_bench_markers.cpp ../build
+ * usage: one_time [marker-count]
+ *
+ */
+
+// TOP
+
+// NOTE: The marker index lives in the core's dynamic variables, so the whole core is
+// compiled in.  Nothing here calls through the system or graphics APIs.
+#include "../4ed_app_target.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#if OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+////////////////////////////////
+
+function u64
+bench_now_us(void){
+    u64 result = 0;
+#if OS_WINDOWS
+    LARGE_INTEGER counter = {};
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (u64)(counter.QuadPart*1000000/frequency.QuadPart);
+#else
+    struct timespec t = {};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (u64)t.tv_sec*1000000 + (u64)t.tv_nsec/1000;
+#endif
+    return(result);
+}
+
+global u64 bench_random_state = 0x9E3779B97F4A7C15llu;
+
+function u64
+bench_random(void){
+    u64 x = bench_random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    bench_random_state = x;
+    return(x);
+}
+
+function i64
+bench_random_range(i64 first, i64 one_past_last){
+    return(first + (i64)(bench_random()%(u64)(one_past_last - first)));
+}
+
+////////////////////////////////
+
+struct Bench_Markers{
+    Buffer_Marker_Index index;
+    Marker_Node *nodes;
+    // NOTE: buffer_unsort_cursors needs the cursor indices to be array slots, so the
+    // node behind each slot is kept on the side.
+    Cursor_With_Index *expected[2];
+    i32 *node_index[2];
+    i32 count[2];
+};
+
+function void
+bench_markers_place(Bench_Markers *markers, i64 *positions, b32 *lean_right, i32 count){
+    block_zero_struct(&markers->index);
+    markers->nodes = (Marker_Node*)malloc(sizeof(Marker_Node)*count);
+    for (i32 side = 0; side < 2; side += 1){
+        markers->expected[side] = (Cursor_With_Index*)malloc(sizeof(Cursor_With_Index)*count);
+        markers->node_index[side] = (i32*)malloc(sizeof(i32)*count);
+        markers->count[side] = 0;
+    }
+    for (i32 i = 0; i < count; i += 1){
+        i32 side = lean_right[i]?1:0;
+        marker_index__insert(&markers->index, &markers->nodes[i], positions[i], side);
+        i32 slot = markers->count[side];
+        markers->count[side] += 1;
+        markers->expected[side][slot].pos = positions[i];
+        markers->expected[side][slot].index = slot;
+        markers->node_index[side][slot] = i;
+    }
+}
+
+function void
+bench_markers_release(Bench_Markers *markers){
+    free(markers->nodes);
+    for (i32 side = 0; side < 2; side += 1){
+        free(markers->expected[side]);
+        free(markers->node_index[side]);
+    }
+}
+
+// NOTE: The reference applies the batch the way edit_fix_markers always has: sort,
+// run the lean function over the whole batch, unsort.
+function void
+bench_markers_apply(Bench_Markers *markers, Batch_Edit *batch){
+    marker_index_apply_batch(&markers->index, batch);
+    for (i32 side = 0; side < 2; side += 1){
+        buffer_sort_cursors(markers->expected[side], markers->count[side]);
+        if (side == 0){
+            buffer_update_cursors_lean_l(markers->expected[side], markers->count[side], batch);
+        }
+        else{
+            buffer_update_cursors_lean_r(markers->expected[side], markers->count[side], batch);
+        }
+        buffer_unsort_cursors(markers->expected[side], markers->count[side]);
+    }
+}
+
+function i32
+bench_markers_mismatches(Bench_Markers *markers){
+    i32 result = 0;
+    for (i32 side = 0; side < 2; side += 1){
+        for (i32 i = 0; i < markers->count[side]; i += 1){
+            i32 node_index = markers->node_index[side][i];
+            i64 expected = markers->expected[side][i].pos;
+            i64 pos = marker_index__node_pos(&markers->nodes[node_index]);
+            if (pos != expected){
+                if (result < 4){
+                    printf("  marker %d (%s) at %lld, expected %lld\n", node_index,
+                           (side == 1)?"lean right":"lean left", (long long)pos, (long long)expected);
+                }
+                result += 1;
+            }
+        }
+    }
+    return(result);
+}
+
+////////////////////////////////
+
+// NOTE: The batch from the marker index review: a marker at 5 with [5,6)->"" and then
+// [6,8)->"XY".  Leaning right, the marker is only matched by the first edit and stays
+// at 5.
+function b32
+bench_markers_touching_case(void){
+    i64 positions[] = {5, 5, 6, 6, 8, 8};
+    b32 lean_right[] = {true, false, true, false, true, false};
+    Bench_Markers markers = {};
+    bench_markers_place(&markers, positions, lean_right, ArrayCount(positions));
+
+    Batch_Edit edits[2] = {};
+    edits[0].next = &edits[1];
+    edits[0].edit.range = Ii64(5, 6);
+    edits[1].edit.text = string_u8_litexpr("XY");
+    edits[1].edit.range = Ii64(6, 8);
+    bench_markers_apply(&markers, edits);
+
+    i32 mismatches = bench_markers_mismatches(&markers);
+    i64 pos = marker_index__node_pos(&markers.nodes[0]);
+    printf("touching: lean right marker at 5 ends at %lld (%s)\n", (long long)pos,
+           (mismatches == 0)?"matches lean_r":"MISMATCH");
+    bench_markers_release(&markers);
+    return(mismatches == 0);
+}
+
+// NOTE: Random sorted batches.  Each edit starts either right where the last one
+// ended (touching), one byte after it (adjacent) or further on, and about a third of
+// them are pure inserts or pure deletes.  Half of the markers sit on edit boundaries,
+// which is where lean left and lean right disagree.
+function b32
+bench_markers_random(i32 round_count){
+    i32 marker_count = 2000;
+    i32 max_edit_count = 64;
+    i64 buffer_size = 4000;
+
+    i64 *positions = (i64*)malloc(sizeof(i64)*marker_count);
+    b32 *lean_right = (b32*)malloc(sizeof(b32)*marker_count);
+    Batch_Edit *edits = (Batch_Edit*)malloc(sizeof(Batch_Edit)*max_edit_count);
+    String_Const_u8 insert_text = string_u8_litexpr("abcdefgh");
+
+    i32 bad_rounds = 0;
+    i64 batch_count = 0;
+    for (i32 round = 0; round < round_count; round += 1){
+        Bench_Markers markers = {};
+        for (i32 i = 0; i < marker_count; i += 1){
+            positions[i] = bench_random_range(0, buffer_size + 1);
+            lean_right[i] = (b32)(bench_random()&1);
+        }
+
+        i64 size = buffer_size;
+        for (i32 step = 0; step < 8; step += 1){
+            i32 edit_count = 0;
+            i64 pos = bench_random_range(0, 8);
+            for (;edit_count < max_edit_count && pos <= size;){
+                i64 length = 0;
+                switch (bench_random()%3){
+                    case 0: length = 0; break;
+                    case 1: length = 1; break;
+                    default: length = bench_random_range(1, 6); break;
+                }
+                i64 one_past_last = Min(pos + length, size);
+                Batch_Edit *edit = &edits[edit_count];
+                edit->next = 0;
+                edit->edit.range = Ii64(pos, one_past_last);
+                edit->edit.text = string_prefix(insert_text, bench_random()%4);
+                if (edit_count > 0){
+                    edits[edit_count - 1].next = edit;
+                }
+                edit_count += 1;
+                switch (bench_random()%4){
+                    case 0: pos = one_past_last; break;
+                    case 1: pos = one_past_last + 1; break;
+                    default: pos = one_past_last + bench_random_range(2, 200); break;
+                }
+            }
+            if (edit_count == 0){
+                continue;
+            }
+
+            if (step == 0){
+                for (i32 i = 0; i < marker_count; i += 2){
+                    Range_i64 range = edits[bench_random()%edit_count].edit.range;
+                    positions[i] = (bench_random()&1)?range.first:range.one_past_last;
+                }
+                bench_markers_place(&markers, positions, lean_right, marker_count);
+            }
+
+            bench_markers_apply(&markers, edits);
+            batch_count += 1;
+            for (i32 i = 0; i < edit_count; i += 1){
+                size += (i64)edits[i].edit.text.size - range_size(edits[i].edit.range);
+            }
+
+            if (bench_markers_mismatches(&markers) > 0){
+                printf("  round %d, batch %d of %d edits\n", round, step, edit_count);
+                bad_rounds += 1;
+                break;
+            }
+        }
+        bench_markers_release(&markers);
+    }
+
+    printf("random: %lld batches over %d rounds of %d markers, %d mismatched rounds\n",
+           (long long)batch_count, round_count, marker_count, bad_rounds);
+    free(positions);
+    free(lean_right);
+    free(edits);
+    return(bad_rounds == 0);
+}
+
+// NOTE: One character typed in the middle of a buffer with marker_count markers.  The
+// sort path copies, sorts, shifts and unsorts every marker, as edit_fix_markers did
+// before the index.
+function void
+bench_markers_time(i32 marker_count){
+    i64 buffer_size = (i64)marker_count*8;
+    i64 *positions = (i64*)malloc(sizeof(i64)*marker_count);
+    b32 *lean_right = (b32*)malloc(sizeof(b32)*marker_count);
+    for (i32 i = 0; i < marker_count; i += 1){
+        positions[i] = bench_random_range(0, buffer_size + 1);
+        lean_right[i] = (b32)(bench_random()&1);
+    }
+    Bench_Markers markers = {};
+    bench_markers_place(&markers, positions, lean_right, marker_count);
+
+    Batch_Edit edit = {};
+    edit.edit.text = string_u8_litexpr("x");
+
+    i32 rep_count = 200;
+    u64 start = bench_now_us();
+    for (i32 rep = 0; rep < rep_count; rep += 1){
+        edit.edit.range = Ii64_size(buffer_size/2 + rep, 0);
+        marker_index_apply_batch(&markers.index, &edit);
+    }
+    u64 index_time = bench_now_us() - start;
+
+    Cursor_With_Index *cursors = (Cursor_With_Index*)malloc(sizeof(Cursor_With_Index)*marker_count);
+    i32 sort_rep_count = 20;
+    start = bench_now_us();
+    for (i32 rep = 0; rep < sort_rep_count; rep += 1){
+        for (i32 i = 0; i < marker_count; i += 1){
+            cursors[i].pos = positions[i];
+            cursors[i].index = i;
+        }
+        edit.edit.range = Ii64_size(buffer_size/2 + rep, 0);
+        buffer_sort_cursors(cursors, marker_count);
+        buffer_update_cursors_lean_r(cursors, marker_count, &edit);
+        buffer_unsort_cursors(cursors, marker_count);
+        for (i32 i = 0; i < marker_count; i += 1){
+            positions[i] = cursors[i].pos;
+        }
+    }
+    u64 sort_time = bench_now_us() - start;
+
+    printf("time: one insert on %d markers, index %.2fus, sort path %.2fus\n", marker_count,
+           (f64)index_time/rep_count, (f64)sort_time/sort_rep_count);
+
+    free(cursors);
+    free(positions);
+    free(lean_right);
+    bench_markers_release(&markers);
+}
+
+int
+main(int argc, char **argv){
+    i32 marker_count = 100000;
+    if (argc > 1){
+        marker_count = atoi(argv[1]);
+    }
+
+    b32 ok = true;
+    ok = bench_markers_touching_case() && ok;
+    ok = bench_markers_random(500) && ok;
+    if (marker_count > 0){
+        bench_markers_time(marker_count);
+    }
+    return(ok?0:1);
+}
+
+// BOTTOM
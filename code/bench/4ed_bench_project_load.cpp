@@ -0,0 +1,576 @@
+/*
+ * 4coder project load benchmark
+ *
+ * Loads every file under a directory the two ways load_project can: with the walk, the
+ * reads and the buffer setup all on the calling thread, and with the walk and the reads
+ * on worker threads while the calling thread sets up buffers a batch at a time under the
+ * per tick budget.  The longest tick is the longest the frame is held by the load.
+ *
+ * build: custom/bin/build_one_time bench/4ed_bench_project_load.cpp ../build
+ * usage: one_time [directory] [worker-count] [passes]
+ *
+ */
+
+// TOP
+
+#include "4coder_base_types.h"
+#include "4coder_table.h"
+#include "4coder_events.h"
+#include "4coder_types.h"
+#include "4coder_system_types.h"
+#include "4coder_variables.h"
+#include "4coder_project_commands.h"
+
+#include "4coder_base_types.cpp"
+#include "4coder_stringf.cpp"
+#include "4coder_malloc_allocator.cpp"
+#include "4coder_file.cpp"
+
+#include <stdlib.h>
+#include <string.h>
+#if OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#endif
+
+internal void*
+system_memory_allocate(u64 size, String_Const_u8 location){
+    return(malloc(size));
+}
+
+internal void
+system_memory_free(void *ptr, u64 size){
+    free(ptr);
+}
+
+// NOTE: The benchmark keeps the OS object's pointer in the first bytes of the handle.
+internal Plat_Handle
+bench_handle_from_ptr(void *ptr){
+    Plat_Handle result = {};
+    block_copy(&result, &ptr, sizeof(ptr));
+    return(result);
+}
+
+internal void*
+bench_ptr_from_handle(Plat_Handle handle){
+    void *result = 0;
+    block_copy(&result, &handle, sizeof(result));
+    return(result);
+}
+
+struct Bench_Thread_Start{
+    Thread_Function *proc;
+    void *ptr;
+};
+
+#if OS_WINDOWS
+
+internal DWORD WINAPI
+bench_thread_main(LPVOID ptr){
+    Bench_Thread_Start start = *(Bench_Thread_Start*)ptr;
+    free(ptr);
+    start.proc(start.ptr);
+    return(0);
+}
+
+internal System_Thread
+system_thread_launch(Thread_Function *proc, void *ptr){
+    Bench_Thread_Start *start = (Bench_Thread_Start*)malloc(sizeof(*start));
+    start->proc = proc;
+    start->ptr = ptr;
+    return(bench_handle_from_ptr(CreateThread(0, 0, bench_thread_main, start, 0, 0)));
+}
+
+internal System_Mutex
+system_mutex_make(void){
+    CRITICAL_SECTION *mutex = (CRITICAL_SECTION*)malloc(sizeof(*mutex));
+    InitializeCriticalSection(mutex);
+    return(bench_handle_from_ptr(mutex));
+}
+
+internal void
+system_mutex_acquire(System_Mutex mutex){
+    EnterCriticalSection((CRITICAL_SECTION*)bench_ptr_from_handle(mutex));
+}
+
+internal void
+system_mutex_release(System_Mutex mutex){
+    LeaveCriticalSection((CRITICAL_SECTION*)bench_ptr_from_handle(mutex));
+}
+
+internal System_Condition_Variable
+system_condition_variable_make(void){
+    CONDITION_VARIABLE *cv = (CONDITION_VARIABLE*)malloc(sizeof(*cv));
+    InitializeConditionVariable(cv);
+    return(bench_handle_from_ptr(cv));
+}
+
+internal void
+system_condition_variable_wait(System_Condition_Variable cv, System_Mutex mutex){
+    SleepConditionVariableCS((CONDITION_VARIABLE*)bench_ptr_from_handle(cv), (CRITICAL_SECTION*)bench_ptr_from_handle(mutex), INFINITE);
+}
+
+internal void
+system_condition_variable_signal(System_Condition_Variable cv){
+    WakeConditionVariable((CONDITION_VARIABLE*)bench_ptr_from_handle(cv));
+}
+
+#else
+
+internal void*
+bench_thread_main(void *ptr){
+    Bench_Thread_Start start = *(Bench_Thread_Start*)ptr;
+    free(ptr);
+    start.proc(start.ptr);
+    return(0);
+}
+
+internal System_Thread
+system_thread_launch(Thread_Function *proc, void *ptr){
+    Bench_Thread_Start *start = (Bench_Thread_Start*)malloc(sizeof(*start));
+    start->proc = proc;
+    start->ptr = ptr;
+    pthread_t thread = {};
+    pthread_create(&thread, 0, bench_thread_main, start);
+    pthread_detach(thread);
+    System_Thread result = {};
+    return(result);
+}
+
+internal System_Mutex
+system_mutex_make(void){
+    pthread_mutex_t *mutex = (pthread_mutex_t*)malloc(sizeof(*mutex));
+    pthread_mutex_init(mutex, 0);
+    return(bench_handle_from_ptr(mutex));
+}
+
+internal void
+system_mutex_acquire(System_Mutex mutex){
+    pthread_mutex_lock((pthread_mutex_t*)bench_ptr_from_handle(mutex));
+}
+
+internal void
+system_mutex_release(System_Mutex mutex){
+    pthread_mutex_unlock((pthread_mutex_t*)bench_ptr_from_handle(mutex));
+}
+
+internal System_Condition_Variable
+system_condition_variable_make(void){
+    pthread_cond_t *cv = (pthread_cond_t*)malloc(sizeof(*cv));
+    pthread_cond_init(cv, 0);
+    return(bench_handle_from_ptr(cv));
+}
+
+internal void
+system_condition_variable_wait(System_Condition_Variable cv, System_Mutex mutex){
+    pthread_cond_wait((pthread_cond_t*)bench_ptr_from_handle(cv), (pthread_mutex_t*)bench_ptr_from_handle(mutex));
+}
+
+internal void
+system_condition_variable_signal(System_Condition_Variable cv){
+    pthread_cond_signal((pthread_cond_t*)bench_ptr_from_handle(cv));
+}
+
+#endif
+
+#include "4coder_system_allocator.cpp"
+
+#include "../4ed_buffer.h"
+#include "../4ed_buffer.cpp"
+
+////////////////////////////////
+
+function u64
+bench_now_us(void){
+    u64 result = 0;
+#if OS_WINDOWS
+    LARGE_INTEGER counter = {};
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (u64)(counter.QuadPart*1000000/frequency.QuadPart);
+#else
+    struct timespec t = {};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (u64)t.tv_sec*1000000 + (u64)t.tv_nsec/1000;
+#endif
+    return(result);
+}
+
+function void
+bench_list_dir(Arena *arena, String_Const_u8 dir, List_String_Const_u8 *names, List_String_Const_u8 *sub_dirs){
+#if OS_WINDOWS
+    WIN32_FIND_DATAA find_data = {};
+    String_Const_u8 pattern = push_u8_stringf(arena, "%.*s\\*", string_expand(dir));
+    HANDLE search = FindFirstFileA((char*)pattern.str, &find_data);
+    if (search != INVALID_HANDLE_VALUE){
+        do{
+            if (find_data.cFileName[0] != '.'){
+                String_Const_u8 name = push_u8_stringf(arena, "%.*s\\%s", string_expand(dir), find_data.cFileName);
+                string_list_push(arena, HasFlag(find_data.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY)?sub_dirs:names, name);
+            }
+        }while (FindNextFileA(search, &find_data));
+        FindClose(search);
+    }
+#else
+    String_Const_u8 dir_z = push_string_copy(arena, dir);
+    DIR *dir_handle = opendir((char*)dir_z.str);
+    if (dir_handle != 0){
+        for (struct dirent *entry = readdir(dir_handle);
+             entry != 0;
+             entry = readdir(dir_handle)){
+            if (entry->d_name[0] != '.'){
+                String_Const_u8 name = push_u8_stringf(arena, "%.*s/%s", string_expand(dir), entry->d_name);
+                string_list_push(arena, (entry->d_type == DT_DIR)?sub_dirs:names, name);
+            }
+        }
+        closedir(dir_handle);
+    }
+#endif
+}
+
+// NOTE: Stands in for create_buffer_from_data: the text is copied into a new buffer
+// and its line starts are measured.  The buffers stay alive until the pass is over,
+// the same as the ones the editor keeps open.
+struct Bench_Buffer_Node{
+    Bench_Buffer_Node *next;
+    Gap_Buffer buffer;
+};
+
+struct Bench_Pass{
+    Arena arena;
+    Bench_Buffer_Node *first_buffer;
+    i32 file_count;
+    u64 size;
+    i64 line_count;
+    u64 total_time;
+    u64 first_buffer_time;
+    u64 longest_tick;
+    i32 tick_count;
+};
+
+function void
+bench_create_buffer(Bench_Pass *pass, String_Const_u8 data){
+    Bench_Buffer_Node *node = push_array_zero(&pass->arena, Bench_Buffer_Node, 1);
+    sll_stack_push(pass->first_buffer, node);
+    buffer_init(&node->buffer, data.str, data.size, get_allocator_malloc(), BufferStorage_Gap);
+    Temp_Memory temp = begin_temp(&pass->arena);
+    buffer_measure_starts(&pass->arena, &node->buffer);
+    end_temp(temp);
+    pass->file_count += 1;
+    pass->size += data.size;
+    pass->line_count += buffer_line_count(&node->buffer);
+}
+
+function void
+bench_pass_free(Bench_Pass *pass){
+    for (Bench_Buffer_Node *node = pass->first_buffer;
+         node != 0;
+         node = node->next){
+        buffer_free(&node->buffer);
+    }
+    linalloc_clear(&pass->arena);
+}
+
+////////////////////////////////
+
+// NOTE: The whole load on the calling thread, the way the project loader ran before
+// the reads moved to the workers.  All of it lands in a single frame.
+function void
+bench_load_serial(Bench_Pass *pass, String_Const_u8 dir){
+    Arena arena = make_arena_malloc();
+    List_String_Const_u8 names = {};
+    List_String_Const_u8 sub_dirs = {};
+    bench_list_dir(&arena, dir, &names, &sub_dirs);
+    for (Node_String_Const_u8 *node = names.first;
+         node != 0;
+         node = node->next){
+        FILE *file = fopen((char*)node->string.str, "rb");
+        if (file != 0){
+            String_Const_u8 data = data_from_file(&arena, file);
+            fclose(file);
+            bench_create_buffer(pass, data);
+        }
+    }
+    for (Node_String_Const_u8 *node = sub_dirs.first;
+         node != 0;
+         node = node->next){
+        bench_load_serial(pass, node->string);
+    }
+    linalloc_clear(&arena);
+}
+
+////////////////////////////////
+
+// NOTE: A stand in for the async system: workers take directories off a queue, read
+// their files into Prj_Load_Batch arenas with the project loader's limits and hand
+// the batches to the calling thread.
+struct Bench_Dir_Job{
+    Bench_Dir_Job *next;
+    String_Const_u8 path;
+};
+
+struct Bench_Loader{
+    System_Mutex mutex;
+    System_Condition_Variable job_cv;
+    System_Condition_Variable batch_cv;
+    System_Condition_Variable space_cv;
+    Bench_Dir_Job *first_job;
+    Bench_Dir_Job *last_job;
+    i32 pending_dir_count;
+    u64 in_flight_size;
+    Prj_Load_Batch *first_batch;
+    Prj_Load_Batch *last_batch;
+    Prj_Load_Batch *current_batch;
+};
+
+function void
+bench_loader_push_dir(Bench_Loader *loader, String_Const_u8 path){
+    Bench_Dir_Job *job = (Bench_Dir_Job*)malloc(sizeof(Bench_Dir_Job) + path.size);
+    job->next = 0;
+    job->path = SCu8((u8*)(job + 1), path.size);
+    block_copy(job->path.str, path.str, path.size);
+    system_mutex_acquire(loader->mutex);
+    sll_queue_push(loader->first_job, loader->last_job, job);
+    loader->pending_dir_count += 1;
+    system_condition_variable_signal(loader->job_cv);
+    system_mutex_release(loader->mutex);
+}
+
+function void
+bench_loader_push_batch(Bench_Loader *loader, Prj_Load_Batch *batch){
+    system_mutex_acquire(loader->mutex);
+    sll_queue_push(loader->first_batch, loader->last_batch, batch);
+    loader->in_flight_size += batch->size;
+    system_condition_variable_signal(loader->batch_cv);
+    system_mutex_release(loader->mutex);
+}
+
+function void
+bench_load_dir(Bench_Loader *loader, String_Const_u8 path){
+    Arena arena = make_arena_malloc();
+    List_String_Const_u8 names = {};
+    List_String_Const_u8 sub_dirs = {};
+    bench_list_dir(&arena, path, &names, &sub_dirs);
+    for (Node_String_Const_u8 *node = sub_dirs.first;
+         node != 0;
+         node = node->next){
+        bench_loader_push_dir(loader, node->string);
+    }
+    
+    Prj_Load_Batch *batch = 0;
+    for (Node_String_Const_u8 *node = names.first;
+         node != 0;
+         node = node->next){
+        FILE *file = fopen((char*)node->string.str, "rb");
+        if (file != 0){
+            if (batch == 0){
+                Arena batch_arena = make_arena_system(KB(64));
+                batch = push_array_zero(&batch_arena, Prj_Load_Batch, 1);
+                batch->arena = batch_arena;
+            }
+            Prj_Load_File *load_file = push_array_zero(&batch->arena, Prj_Load_File, 1);
+            sll_queue_push(batch->first, batch->last, load_file);
+            batch->count += 1;
+            load_file->data = data_from_file(&batch->arena, file);
+            load_file->is_loaded = true;
+            batch->size += load_file->data.size;
+            fclose(file);
+    
+            if (batch->count >= PRJ_LOAD_BATCH_MAX_COUNT || batch->size >= PRJ_LOAD_BATCH_MAX_SIZE){
+                bench_loader_push_batch(loader, batch);
+                batch = 0;
+            }
+        }
+    }
+    if (batch != 0){
+        bench_loader_push_batch(loader, batch);
+    }
+    linalloc_clear(&arena);
+    
+    system_mutex_acquire(loader->mutex);
+    loader->pending_dir_count -= 1;
+    system_condition_variable_signal(loader->batch_cv);
+    system_mutex_release(loader->mutex);
+}
+
+function void
+bench_loader_worker(void *ptr){
+    Bench_Loader *loader = (Bench_Loader*)ptr;
+    for (;;){
+        system_mutex_acquire(loader->mutex);
+        for (;loader->first_job == 0;){
+            system_condition_variable_wait(loader->job_cv, loader->mutex);
+        }
+        Bench_Dir_Job *job = loader->first_job;
+        sll_queue_pop(loader->first_job, loader->last_job);
+        for (;loader->in_flight_size >= PRJ_LOAD_MAX_IN_FLIGHT;){
+            system_condition_variable_wait(loader->space_cv, loader->mutex);
+        }
+        system_condition_variable_signal(loader->space_cv);
+        system_mutex_release(loader->mutex);
+    
+        bench_load_dir(loader, job->path);
+        free(job);
+    }
+}
+
+// NOTE: The calling thread side of the loader, one loop iteration per tick.  Waiting on
+// batch_cv stands in for the frame loop sleeping until the next step; only the time
+// spent inside a tick counts against the frame.
+function void
+bench_load_threaded(Bench_Pass *pass, Bench_Loader *loader, String_Const_u8 dir, u64 start){
+    bench_loader_push_dir(loader, dir);
+    for (;;){
+        system_mutex_acquire(loader->mutex);
+        for (;loader->current_batch == 0 && loader->first_batch == 0 && loader->pending_dir_count > 0;){
+            system_condition_variable_wait(loader->batch_cv, loader->mutex);
+        }
+        b32 finished = (loader->current_batch == 0 && loader->first_batch == 0);
+        system_mutex_release(loader->mutex);
+        if (finished){
+            break;
+        }
+    
+        u64 tick_start = bench_now_us();
+        u64 end_time = tick_start + PRJ_LOAD_TICK_MAX_TIME;
+        for (;;){
+            Prj_Load_Batch *batch = loader->current_batch;
+            if (batch == 0){
+                system_mutex_acquire(loader->mutex);
+                batch = loader->first_batch;
+                if (batch != 0){
+                    sll_queue_pop(loader->first_batch, loader->last_batch);
+                }
+                system_mutex_release(loader->mutex);
+                if (batch == 0){
+                    break;
+                }
+                loader->current_batch = batch;
+            }
+            
+            b32 out_of_time = false;
+            for (;batch->first != 0 && !out_of_time;){
+                Prj_Load_File *file = batch->first;
+                batch->first = file->next;
+                bench_create_buffer(pass, file->data);
+                if (pass->first_buffer_time == 0){
+                    pass->first_buffer_time = clamp_bot(1, bench_now_us() - start);
+                }
+                out_of_time = (bench_now_us() >= end_time);
+            }
+            
+            if (batch->first == 0){
+                loader->current_batch = 0;
+                u64 size = batch->size;
+                Arena batch_arena = batch->arena;
+                linalloc_clear(&batch_arena);
+                
+                system_mutex_acquire(loader->mutex);
+                loader->in_flight_size -= size;
+                system_condition_variable_signal(loader->space_cv);
+                system_mutex_release(loader->mutex);
+            }
+            
+            if (out_of_time){
+                break;
+            }
+        }
+        u64 tick_time = bench_now_us() - tick_start;
+        pass->longest_tick = Max(pass->longest_tick, tick_time);
+        pass->tick_count += 1;
+    }
+}
+
+////////////////////////////////
+
+function void
+bench_print_pass(char *name, Bench_Pass *pass){
+    printf("  %-15s total %8.2fms  longest tick %8.2fms  ticks %4d",
+           name, pass->total_time/1000.0, pass->longest_tick/1000.0, pass->tick_count);
+    if (pass->first_buffer_time != 0){
+        printf("  first buffer %8.2fms", pass->first_buffer_time/1000.0);
+    }
+    printf("\n");
+}
+
+int
+main(int argc, char **argv){
+    Thread_Context tctx = {};
+    thread_ctx_init(&tctx, ThreadKind_Main, get_allocator_malloc(), get_allocator_malloc());
+    char *dir = "../non-source/test_data/lots_of_files";
+    i32 worker_count = 1;
+    i32 pass_count = 5;
+    if (argc > 1){
+        dir = argv[1];
+    }
+    if (argc > 2){
+        worker_count = clamp_bot(1, atoi(argv[2]));
+    }
+    if (argc > 3){
+        pass_count = clamp_bot(1, atoi(argv[3]));
+    }
+    String_Const_u8 dir_name = SCu8(dir);
+    
+    Bench_Loader loader = {};
+    loader.mutex = system_mutex_make();
+    loader.job_cv = system_condition_variable_make();
+    loader.batch_cv = system_condition_variable_make();
+    loader.space_cv = system_condition_variable_make();
+    for (i32 i = 0; i < worker_count; i += 1){
+        system_thread_launch(bench_loader_worker, &loader);
+    }
+    
+    // NOTE: The best pass of each kind is kept, the first pass also warms the file cache.
+    Bench_Pass best_serial = {};
+    Bench_Pass best_threaded = {};
+    b32 result = true;
+    for (i32 i = 0; i < pass_count; i += 1){
+        Bench_Pass serial = {};
+        serial.arena = make_arena_malloc();
+        u64 start = bench_now_us();
+        bench_load_serial(&serial, dir_name);
+        serial.total_time = clamp_bot(1, bench_now_us() - start);
+        serial.longest_tick = serial.total_time;
+        serial.tick_count = 1;
+        bench_pass_free(&serial);
+    
+        Bench_Pass threaded = {};
+        threaded.arena = make_arena_malloc();
+        start = bench_now_us();
+        bench_load_threaded(&threaded, &loader, dir_name, start);
+        threaded.total_time = clamp_bot(1, bench_now_us() - start);
+        bench_pass_free(&threaded);
+    
+        result = (result &&
+                  serial.file_count == threaded.file_count &&
+                  serial.size == threaded.size &&
+                  serial.line_count == threaded.line_count);
+        if (i == 0 || serial.total_time < best_serial.total_time){
+            best_serial = serial;
+        }
+        if (i == 0 || threaded.longest_tick < best_threaded.longest_tick){
+            best_threaded = threaded;
+        }
+    }
+    
+    if (best_serial.file_count == 0){
+        printf("project load: no files under %s\n", dir);
+        result = false;
+    }
+    else{
+        printf("project load: %d files, %.2fMB from %s, %d worker%s, best of %d passes\n",
+               best_serial.file_count, best_serial.size/(1024.0*1024.0), dir,
+               worker_count, (worker_count == 1)?"":"s", pass_count);
+        bench_print_pass("calling thread", &best_serial);
+        bench_print_pass("workers+ticks", &best_threaded);
+        printf("  files, sizes and line counts %s\n", result?"match":"DIFFER");
+    }
+    
+    return(result?0:1);
+}
+
+// BOTTOM
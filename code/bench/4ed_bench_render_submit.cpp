@@ -0,0 +1,359 @@
+/*
+ * 4coder render submit benchmark
+ *
+ * Emits a synthetic editor frame through the render target, once as six vertex quads
+ * and once as instances, and copies each frame into a stream buffer the way gl_render
+ * fills its mapped range.  Reports the time per frame for both steps and the bytes
+ * each frame uploads.
+ *
+ * build: custom/bin/build_one_time bench/4ed_bench_render_submit.cpp ../build
+ * usage: one_time [frame-count]
+ *
+ */
+
+// TOP
+
+// NOTE: The render target lives in the core, so the whole core is compiled in.  The
+// face below has every glyph it draws resident in the atlas already, so nothing here
+// calls through the system, graphics or font APIs.  Only CPU time is measured, the
+// driver's side of the upload and the draw calls are not part of it.
+#include "../4ed_app_target.cpp"
+#include "4coder_malloc_allocator.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#if OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+////////////////////////////////
+
+function u64
+bench_now_us(void){
+    u64 result = 0;
+#if OS_WINDOWS
+    LARGE_INTEGER counter = {};
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (u64)(counter.QuadPart*1000000/frequency.QuadPart);
+#else
+    struct timespec t = {};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (u64)t.tv_sec*1000000 + (u64)t.tv_nsec/1000;
+#endif
+    return(result);
+}
+
+////////////////////////////////
+
+// NOTE: A monospaced ASCII face.  Space is empty like it is in a real font, everything
+// else is resident on the first atlas page.
+function void
+bench_face_init(Face *face, Render_Target *target){
+    block_zero_struct(face);
+    face->id = 1;
+
+    u16 glyph_count = 128;
+    f32 advance = 9.f;
+    face->metrics.line_height = 18.f;
+    face->metrics.space_advance = advance;
+    face->metrics.byte_advance = advance*3.f;
+    for (i32 i = 0; i < 3; i += 1){
+        face->metrics.byte_sub_advances[i] = advance;
+    }
+
+    Face_Advance_Map *map = &face->advance_map;
+    map->index_count = glyph_count;
+    map->advance = (f32*)malloc(sizeof(f32)*glyph_count);
+    map->codepoint_to_index.has_zero_index = true;
+    map->codepoint_to_index.zero_index = 0;
+    map->codepoint_to_index.max_index = glyph_count - 1;
+    map->codepoint_to_index.table = make_table_u32_u16(get_allocator_malloc(), glyph_count*2);
+
+    face->bounds = (Glyph_Bounds*)malloc(sizeof(Glyph_Bounds)*glyph_count);
+    face->glyph_states = (Face_Glyph_State*)malloc(sizeof(Face_Glyph_State)*glyph_count);
+    f32 texel = 1.f/(f32)FACE_ATLAS_PAGE_DIM;
+    for (u16 i = 0; i < glyph_count; i += 1){
+        if (i > 0){
+            table_insert(&map->codepoint_to_index.table, (u32)i, i);
+        }
+        map->advance[i] = advance;
+        Glyph_Bounds *bounds = &face->bounds[i];
+        f32 x = (f32)((i%64)*12);
+        f32 y = (f32)((i/64)*20);
+        bounds->uv = Rf32(x*texel, y*texel, (x + 8.f)*texel, (y + 17.f)*texel);
+        bounds->w = 0.f;
+        bounds->xy_off = Rf32(0.f, -13.f, 8.f, 4.f);
+        face->glyph_states[i] = (i == ' ')?FaceGlyphState_Empty:FaceGlyphState_Resident;
+    }
+
+    face->atlas.page_count = 1;
+    face->atlas.page_max = 1;
+    face->atlas.frame_index = target->frame_index;
+}
+
+////////////////////////////////
+
+global char *bench_code_lines[] = {
+    "internal void",
+    "draw__write_instance_in_current_group(Render_Target *target, Render_Group_Kind kind){",
+    "    Render_Group *group = draw__get_group_of_kind(target, kind);",
+    "    Render_Instance_List *list = &group->instance_list;",
+    "    i32 size = render_instance_sizes[kind];",
+    "    ",
+    "    Render_Instance_Array_Node *last = list->last;",
+    "    if (last == 0 || last->count == last->max){",
+    "        i32 next_node_max = 64;",
+    "        // NOTE: double the node each time the list runs out of room",
+    "        last = push_array_zero(&target->arena, Render_Instance_Array_Node, 1);",
+    "        sll_queue_push(list->first, list->last, last);",
+    "    }",
+    "    block_copy(last->data + last->count*size, instance, size);",
+    "}",
+    "",
+};
+
+global u32 bench_token_colors[] = {
+    0xFF90B080, 0xFFD08F20, 0xFFA08563, 0xFF6B8E23, 0xFFCDAA7D, 0xFF2E8B57,
+};
+
+// NOTE: Two code panels with a file bar each and a footer.  Every line is drawn as a
+// run of token sized strings, the way the default render hook colors tokens, with a
+// line highlight, a cursor, a mark outline and a scope highlight on top.
+function void
+bench_emit_frame(Render_Target *target, Face *face){
+    begin_frame(target, 0);
+
+    f32 line_height = face->metrics.line_height;
+    f32 panel_w = (f32)(target->width/2);
+    i32 line_count = (i32)(((f32)target->height - line_height*2.f)/line_height);
+
+    for (i32 panel = 0; panel < 2; panel += 1){
+        f32 x0 = panel_w*(f32)panel;
+        Rect_f32 panel_rect = Rf32(x0, 0.f, x0 + panel_w, (f32)target->height - line_height);
+        Rect_f32 prev_clip = draw_set_clip(target, panel_rect);
+
+        draw_rectangle(target, panel_rect, 0.f, 0xFF0C0C0C);
+        Rect_f32 bar = Rf32(x0, 0.f, x0 + panel_w, line_height);
+        draw_rectangle(target, bar, 0.f, 0xFF888888);
+        draw_string(target, face, string_u8_litexpr("4ed_render_target.cpp - 3120"),
+                    V2f32(x0 + 4.f, line_height - 4.f), 0xFF000000);
+
+        Rect_f32 text_rect = Rf32(x0, line_height, x0 + panel_w, panel_rect.y1);
+        draw_set_clip(target, text_rect);
+
+        i32 cursor_line = 7 + panel*11;
+        for (i32 line = 0; line < line_count; line += 1){
+            f32 y = line_height*(f32)(line + 1);
+            if (line == cursor_line){
+                draw_rectangle(target, Rf32(x0, y, x0 + panel_w, y + line_height), 0.f, 0xFF1E1E1E);
+            }
+            if (line >= 9 && line <= 13){
+                draw_rectangle(target, Rf32(x0 + 4.f, y, x0 + 40.f, y + line_height), 0.f, 0x20FFFFFF);
+            }
+
+            char *text = bench_code_lines[line%ArrayCount(bench_code_lines)];
+            String_Const_u8 string = SCu8(text);
+            Vec2_f32 p = V2f32(x0 + 4.f, y + line_height - 4.f);
+            u64 start = 0;
+            for (i32 token = 0; start < string.size; token += 1){
+                u64 size = 1 + (start*7 + (u64)token*3)%9;
+                String_Const_u8 piece = string_substring(string, Ii64(start, Min(start + size, string.size)));
+                u32 color = bench_token_colors[token%ArrayCount(bench_token_colors)];
+                p.x += draw_string(target, face, piece, p, color);
+                start += piece.size;
+            }
+
+            if (line == cursor_line){
+                f32 cursor_x = x0 + 4.f + 9.f*12.f;
+                draw_rectangle(target, Rf32(cursor_x, y, cursor_x + 9.f, y + line_height), 1.f, 0xFF00EE00);
+                draw_rectangle_outline(target, Rf32(cursor_x + 9.f*8.f, y, cursor_x + 9.f*9.f, y + line_height),
+                                       1.f, 2.f, 0xFF1E90FF);
+            }
+        }
+
+        draw_set_clip(target, prev_clip);
+    }
+
+    Rect_f32 footer = Rf32(0.f, (f32)target->height - line_height, (f32)target->width, (f32)target->height);
+    draw_rectangle(target, footer, 0.f, 0xFF404040);
+    draw_string(target, face, string_u8_litexpr("build complete, 0 errors"),
+                V2f32(4.f, (f32)target->height - 4.f), 0xFFFFFFFF);
+}
+
+////////////////////////////////
+
+// NOTE: gl__group_data_size and gl__write_group_data from opengl/4ed_opengl_render.cpp.
+// They can't be shared with a program that has no GL context, so the sizes and the
+// copy are repeated here.
+function u64
+bench_group_data_size(Render_Group *group){
+    u64 result = 0;
+    if (group->kind == RenderGroupKind_Vertices){
+        result = group->vertex_list.vertex_count*sizeof(Render_Vertex);
+    }
+    else{
+        result = group->instance_list.count*render_instance_sizes[group->kind];
+    }
+    return(round_up_u64(result, 16));
+}
+
+function void
+bench_write_group_data(u8 *dst, Render_Group *group){
+    if (group->kind == RenderGroupKind_Vertices){
+        for (Render_Vertex_Array_Node *node = group->vertex_list.first;
+             node != 0;
+             node = node->next){
+            u64 size = node->vertex_count*sizeof(*node->vertices);
+            block_copy(dst, node->vertices, size);
+            dst += size;
+        }
+    }
+    else{
+        u64 instance_size = render_instance_sizes[group->kind];
+        for (Render_Instance_Array_Node *node = group->instance_list.first;
+             node != 0;
+             node = node->next){
+            u64 size = node->count*instance_size;
+            block_copy(dst, node->data, size);
+            dst += size;
+        }
+    }
+}
+
+struct Bench_Stream{
+    u8 *memory;
+    u64 size;
+    u64 cursor;
+};
+
+// NOTE: The stream advances through one allocation and starts over at the front when a
+// frame doesn't fit, like gl__stream_map orphaning the buffer.
+function u64
+bench_upload_frame(Bench_Stream *stream, Render_Target *target){
+    u64 frame_size = 0;
+    for (Render_Group *group = target->group_first;
+         group != 0;
+         group = group->next){
+        frame_size += bench_group_data_size(group);
+    }
+    if (frame_size > 0){
+        if (stream->cursor + frame_size > stream->size){
+            if (frame_size > stream->size){
+                free(stream->memory);
+                stream->size = round_up_u64(frame_size*2, MB(1));
+                stream->memory = (u8*)malloc(stream->size);
+            }
+            stream->cursor = 0;
+        }
+        u8 *frame_data = stream->memory + stream->cursor;
+        u64 offset = 0;
+        for (Render_Group *group = target->group_first;
+             group != 0;
+             group = group->next){
+            if (!draw__group_is_empty(group)){
+                bench_write_group_data(frame_data + offset, group);
+                offset += bench_group_data_size(group);
+            }
+        }
+        stream->cursor += frame_size;
+    }
+    return(frame_size);
+}
+
+////////////////////////////////
+
+struct Bench_Submit_Result{
+    f64 emit_us;
+    f64 upload_us;
+    u64 bytes;
+    i32 group_count;
+    i32 primitive_count;
+};
+
+function Bench_Submit_Result
+bench_submit(b32 instanced, i32 frame_count){
+    Render_Target target = {};
+    target.width = 1920;
+    target.height = 1080;
+    target.instanced = (b8)instanced;
+    target.frame_index = 1;
+    target.arena = make_arena_malloc();
+
+    Face face = {};
+    bench_face_init(&face, &target);
+
+    Bench_Stream stream = {};
+
+    // NOTE: One frame first so the arena and the stream are already at full size.
+    bench_emit_frame(&target, &face);
+    bench_upload_frame(&stream, &target);
+
+    u64 emit_time = 0;
+    u64 upload_time = 0;
+    u64 bytes = 0;
+    for (i32 frame = 0; frame < frame_count; frame += 1){
+        u64 start = bench_now_us();
+        bench_emit_frame(&target, &face);
+        u64 mid = bench_now_us();
+        bytes = bench_upload_frame(&stream, &target);
+        u64 end = bench_now_us();
+        emit_time += mid - start;
+        upload_time += end - mid;
+    }
+
+    Bench_Submit_Result result = {};
+    result.emit_us = (f64)emit_time/frame_count;
+    result.upload_us = (f64)upload_time/frame_count;
+    result.bytes = bytes;
+    for (Render_Group *group = target.group_first;
+         group != 0;
+         group = group->next){
+        if (!draw__group_is_empty(group)){
+            result.group_count += 1;
+            if (group->kind == RenderGroupKind_Vertices){
+                result.primitive_count += group->vertex_list.vertex_count/6;
+            }
+            else{
+                result.primitive_count += group->instance_list.count;
+            }
+        }
+    }
+
+    linalloc_clear(&target.arena);
+    free(stream.memory);
+    return(result);
+}
+
+int
+main(int argc, char **argv){
+    i32 frame_count = 2000;
+    if (argc > 1){
+        frame_count = atoi(argv[1]);
+    }
+    if (frame_count <= 0){
+        frame_count = 1;
+    }
+
+    Bench_Submit_Result vertices = bench_submit(false, frame_count);
+    Bench_Submit_Result instances = bench_submit(true, frame_count);
+
+    printf("%d frames of 1920x1080, two code panels\n", frame_count);
+    printf("vertices:  %5d quads in %3d groups, emit %7.2fus, upload %6.2fus, %8llu bytes\n",
+           vertices.primitive_count, vertices.group_count,
+           vertices.emit_us, vertices.upload_us, (unsigned long long)vertices.bytes);
+    printf("instances: %5d quads in %3d groups, emit %7.2fus, upload %6.2fus, %8llu bytes\n",
+           instances.primitive_count, instances.group_count,
+           instances.emit_us, instances.upload_us, (unsigned long long)instances.bytes);
+
+    b32 ok = (vertices.primitive_count == instances.primitive_count);
+    if (!ok){
+        printf("quad counts differ\n");
+    }
+    return(ok?0:1);
+}
+
+// BOTTOM
@@ -0,0 +1,187 @@
+/*
+ * 4coder string matching benchmarks
+ *
+ * Times the KMP scans against the filtered scans of find_all_matches on a large
+ * chunked buffer and checks that both return the same matches and flags.
+ *
+ * build: custom/bin/build_one_time bench/4ed_bench_string_matching.cpp ../build
+ * usage: one_time [megabytes]
+ *
+ */
+
+// TOP
+
+#include "4coder_base_types.h"
+#include "4coder_table.h"
+#include "4coder_events.h"
+#include "4coder_types.h"
+#include "4coder_system_types.h"
+#include "4coder_string_match.h"
+
+#include "4coder_base_types.cpp"
+#include "4coder_malloc_allocator.cpp"
+#include "4coder_string_match.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+internal void*
+system_memory_allocate(u64 size, String_Const_u8 location){
+    return(malloc(size));
+}
+
+internal void
+system_memory_free(void *ptr, u64 size){
+    free(ptr);
+}
+
+#include "4coder_system_allocator.cpp"
+
+// NOTE: Only the single buffer scans run here; the parallel search pool is never
+// started, so its system calls can be empty.
+internal System_Thread system_thread_launch(Thread_Function *proc, void *ptr){ System_Thread result = {}; return(result); }
+internal System_Mutex system_mutex_make(void){ System_Mutex result = {}; return(result); }
+internal void system_mutex_acquire(System_Mutex mutex){}
+internal void system_mutex_release(System_Mutex mutex){}
+internal System_Condition_Variable system_condition_variable_make(void){ System_Condition_Variable result = {}; return(result); }
+internal void system_condition_variable_wait(System_Condition_Variable cv, System_Mutex mutex){}
+internal void system_condition_variable_signal(System_Condition_Variable cv){}
+
+#include "../4ed_string_matching.cpp"
+
+////////////////////////////////
+
+function u64
+bench_now_us(void){
+    u64 result = 0;
+#if OS_WINDOWS
+    LARGE_INTEGER counter = {};
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    result = (u64)(counter.QuadPart*1000000/frequency.QuadPart);
+#else
+    struct timespec t = {};
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    result = (u64)t.tv_sec*1000000 + (u64)t.tv_nsec/1000;
+#endif
+    return(result);
+}
+
+global u64 bench_random_state = 0x9E3779B97F4A7C15llu;
+
+function u64
+bench_random(void){
+    u64 x = bench_random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    bench_random_state = x;
+    return(x);
+}
+
+// NOTE: Code-like text: identifiers from a small vocabulary in mixed case, separated
+// by punctuation and newlines, cut into 64KB chunks like a buffer's.
+function List_String_Const_u8
+bench_make_chunks(Arena *arena, u64 size){
+    char *words[] = {
+        "buffer", "Buffer", "render_target", "Render_Target", "layout", "i64", "count",
+        "string", "String_Const_u8", "arena", "Arena", "result", "node", "next", "face",
+    };
+    char *separators[] = {" ", "(", ");\n", ", ", "->", " = ", "\n    ", "_",};
+    u8 *text = push_array(arena, u8, size);
+    u64 pos = 0;
+    for (;pos < size;){
+        String_Const_u8 word = SCu8(words[bench_random()%ArrayCount(words)]);
+        String_Const_u8 separator = SCu8(separators[bench_random()%ArrayCount(separators)]);
+        for (u64 i = 0; i < word.size && pos < size; i += 1, pos += 1){
+            text[pos] = word.str[i];
+        }
+        for (u64 i = 0; i < separator.size && pos < size; i += 1, pos += 1){
+            text[pos] = separator.str[i];
+        }
+    }
+    List_String_Const_u8 chunks = {};
+    for (u64 first = 0; first < size; first += KB(64)){
+        string_list_push(arena, &chunks, SCu8(text + first, Min(KB(64), size - first)));
+    }
+    return(chunks);
+}
+
+function b32
+bench_lists_match(String_Match_List a, String_Match_List b){
+    b32 result = (a.count == b.count);
+    for (String_Match *x = a.first, *y = b.first;
+         result && x != 0 && y != 0;
+         x = x->next, y = y->next){
+        result = (x->range.min == y->range.min &&
+                  x->range.max == y->range.max &&
+                  x->flags == y->flags);
+    }
+    return(result);
+}
+
+int
+main(int argc, char **argv){
+    Arena arena = make_arena_malloc();
+    u64 megabytes = 64;
+    if (argc > 1){
+        megabytes = (u64)atoi(argv[1]);
+    }
+    
+    // NOTE: The predicate the search commands use.
+    Character_Predicate predicate = {};
+    for (u32 c = 0; c < 256; c += 1){
+        if (character_is_alpha_numeric((u8)c) || c == '_' || c >= 128){
+            predicate.b[c/8] |= (u8)(1 << (c%8));
+        }
+    }
+    
+    List_String_Const_u8 chunks = bench_make_chunks(&arena, MB(1)*megabytes);
+    char *needles[] = {"x", "buffer", "Render_Target", "render_targeT", "qz", "layout_count"};
+    char *directions[] = {"forward", "backward"};
+    
+    printf("string matching: %lluMB in %d chunks, %s\n", (unsigned long long)megabytes,
+           (i32)chunks.node_count, string_match__can_filter(&predicate)?"filtered scans enabled":"no filter");
+    b32 ok = true;
+    for (i32 i = 0; i < ArrayCount(needles); i += 1){
+        String_Const_u8 needle = SCu8(needles[i]);
+        for (i32 d = 0; d < 2; d += 1){
+            Scan_Direction direction = (d == 0)?Scan_Forward:Scan_Backward;
+            Temp_Memory temp = begin_temp(&arena);
+            u64_Array jump_table = string_compute_needle_jump_table(&arena, needle, direction);
+            
+            u64 start = bench_now_us();
+            String_Match_List kmp = {};
+            if (direction == Scan_Forward){
+                kmp = find_all_matches_forward__kmp(&arena, max_i32, chunks, needle, jump_table, &predicate, 0, 1, 0);
+            }
+            else{
+                kmp = find_all_matches_backward__kmp(&arena, max_i32, chunks, needle, jump_table, &predicate, 0, 1, 0);
+            }
+            u64 kmp_time = clamp_bot(1, bench_now_us() - start);
+            
+            start = bench_now_us();
+            String_Match_List filtered = find_all_matches(&arena, max_i32, chunks, needle, jump_table,
+                                                          &predicate, direction, 0, 1, 0);
+            u64 filtered_time = clamp_bot(1, bench_now_us() - start);
+            
+            b32 same = bench_lists_match(kmp, filtered);
+            ok = ok && same;
+            f64 bytes = (f64)chunks.total_size;
+            printf("  %-14s %-8s %8d matches  kmp %6.2fGB/s  filtered %6.2fGB/s  %s\n",
+                   needles[i], directions[d], kmp.count,
+                   bytes/(kmp_time*1000.0), bytes/(filtered_time*1000.0), same?"same":"DIFFERENT");
+            end_temp(temp);
+        }
+    }
+    return(ok?0:1);
+}
+
+// BOTTOM
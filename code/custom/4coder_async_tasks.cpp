@@ -10,22 +10,88 @@
 
 global Async_System global_async_system = {};
 
+function Async_Node*
+async_get_node(Async_System *async_system, Async_Task task){
+    Async_Node *result = 0;
+    u64 val = 0;
+    if (task != 0 && table_read(&async_system->task_table, task, &val)){
+        result = (Async_Node*)IntAsPtr(val);
+    }
+    return(result);
+}
+
 function Async_Node*
 async_pop_node(Async_System *async_system){
     for (;async_system->task_count == 0;){
         system_condition_variable_wait(async_system->cv, async_system->mutex);
     }
-    Node *node = async_system->task_sent.next;
-    Assert(node != &async_system->task_sent);
+    // NOTE: Highest priority first, oldest first within a priority.  Every worker
+    // takes from the same queues under the system mutex; a task is a whole buffer lex
+    // or parse, so one lock per pop costs nothing next to the work.
+    Node *node = 0;
+    for (i32 priority = AsyncPriority_COUNT - 1; priority >= 0 && node == 0; priority -= 1){
+        Node *sentinel = &async_system->queues[priority];
+        if (sentinel->next != sentinel){
+            node = sentinel->next;
+        }
+    }
+    Assert(node != 0);
     dll_remove(node);
     async_system->task_count -= 1;
     Async_Node *a_node = CastFromMember(Async_Node, node, node);
+    a_node->queued = false;
     a_node->next = 0;
     return(a_node);
 }
 
-function Async_Node*
-async_push_node__inner(Async_System *async_system, Async_Task_Function_Type *func, String_Const_u8 data){
+function void
+async_free_node(Async_System *async_system, Async_Node *node){
+    table_erase(&async_system->task_table, node->task);
+    heap_free(&async_system->node_heap, node->data.str);
+    sll_stack_push(async_system->free_nodes, node);
+}
+
+function void async_finish_node(Async_System *async_system, Async_Node *node);
+
+function void
+async_queue_node(Async_System *async_system, Async_Node *node){
+    if (node->func == 0){
+        // NOTE: Join handles have nothing to run, they are done as soon as the
+        // tasks they wait on are.
+        async_finish_node(async_system, node);
+    }
+    else{
+        node->queued = true;
+        dll_insert_back(&async_system->queues[node->priority], &node->node);
+        async_system->task_count += 1;
+        system_condition_variable_signal(async_system->cv);
+    }
+}
+
+function void
+async_finish_node(Async_System *async_system, Async_Node *node){
+    Async_Dependent *dependent = node->first_dependent;
+    node->first_dependent = 0;
+    async_free_node(async_system, node);
+    for (;dependent != 0;){
+        Async_Dependent *next = dependent->next;
+        Async_Node *waiting_node = async_get_node(async_system, dependent->task);
+        if (waiting_node != 0){
+            Assert(waiting_node->wait_count > 0);
+            waiting_node->wait_count -= 1;
+            if (waiting_node->wait_count == 0){
+                async_queue_node(async_system, waiting_node);
+            }
+        }
+        sll_stack_push(async_system->free_dependents, dependent);
+        dependent = next;
+    }
+    system_condition_variable_signal(async_system->join_cv);
+}
+
+function Async_Task
+async_push_node(Async_System *async_system, Async_Priority priority, Async_Task *deps, i32 dep_count,
+                Async_Task_Function_Type *func, String_Const_u8 data){
     Async_Task result = async_system->task_id_counter;
     async_system->task_id_counter += 1;
     
@@ -38,27 +104,38 @@ async_push_node__inner(Async_System *async_system, Async_Task_Function_Type *fun
     }
     node->task = result;
     node->thread = 0;
+    node->queued = false;
+    node->priority = clamp(AsyncPriority_Low, priority, AsyncPriority_High);
+    node->wait_count = 0;
+    node->first_dependent = 0;
     node->func = func;
     node->data.str = (u8*)heap_allocate(&async_system->node_heap, data.size);
     block_copy(node->data.str, data.str, data.size);
     node->data.size = data.size;
-    dll_insert_back(&async_system->task_sent, &node->node);
-    async_system->task_count += 1;
-    system_condition_variable_signal(async_system->cv);
+    table_insert(&async_system->task_table, result, PtrAsInt(node));
     
-    return(node);
-}
-
-function Async_Task
-async_push_node(Async_System *async_system, Async_Task_Function_Type *func, String_Const_u8 data){
-    Async_Node *node = async_push_node__inner(async_system, func, data);
-    return(node->task);
-}
-
-function void
-async_free_node(Async_System *async_system, Async_Node *node){
-    heap_free(&async_system->node_heap, node->data.str);
-    sll_stack_push(async_system->free_nodes, node);
+    // NOTE: Dependencies that are already finished or canceled are not waited on.
+    for (i32 i = 0; i < dep_count; i += 1){
+        Async_Node *dep_node = async_get_node(async_system, deps[i]);
+        if (dep_node != 0){
+            Async_Dependent *dependent = async_system->free_dependents;
+            if (dependent == 0){
+                dependent = push_array(&async_system->node_arena, Async_Dependent, 1);
+            }
+            else{
+                sll_stack_pop(async_system->free_dependents);
+            }
+            dependent->task = result;
+            sll_stack_push(dep_node->first_dependent, dependent);
+            node->wait_count += 1;
+        }
+    }
+    
+    if (node->wait_count == 0){
+        async_queue_node(async_system, node);
+    }
+    
+    return(result);
 }
 
 function void
@@ -100,40 +177,44 @@ async_task_thread(void *thread_ptr){
         thread->node = 0;
         thread->task = 0;
         thread->cancel_signal = false;
-        async_free_node(async_system, node);
-        system_condition_variable_signal(async_system->join_cv);
+        async_finish_node(async_system, node);
         system_mutex_release(async_system->mutex);
     }
 }
 
 function Async_Node*
 async_get_pending_node(Async_System *async_system, Async_Task task){
-    Async_Node *result = 0;
-    if (task != 0){
-        for (Node *node = async_system->task_sent.next;
-             node != &async_system->task_sent;
-             node = node->next){
-            Async_Node *a_node = CastFromMember(Async_Node, node, node);
-            if (a_node->task == task){
-                result = a_node;
-                break;
-            }
-        }
+    Async_Node *result = async_get_node(async_system, task);
+    if (result != 0 && result->thread != 0){
+        result = 0;
     }
     return(result);
 }
 
 function Async_Node*
 async_get_running_node(Async_System *async_system, Async_Task task){
-    Async_Node *result = 0;
-    if (task != 0 && async_system->thread.task == task){
-        result = async_system->thread.node;
+    Async_Node *result = async_get_node(async_system, task);
+    if (result != 0 && result->thread == 0){
+        result = 0;
     }
     return(result);
 }
 
 ////////////////////////////////
 
+function void
+async_task_set_thread_count(Async_System *async_system, i32 thread_count){
+    thread_count = clamp(1, thread_count, ASYNC_THREAD_MAX);
+    system_mutex_acquire(async_system->mutex);
+    for (;async_system->thread_count < thread_count;){
+        Async_Thread *thread = &async_system->threads[async_system->thread_count];
+        thread->async_system = async_system;
+        async_system->thread_count += 1;
+        thread->thread = system_thread_launch(async_task_thread, thread);
+    }
+    system_mutex_release(async_system->mutex);
+}
+
 function void
 async_task_handler_init(Application_Links *app, Async_System *async_system){
     block_zero_struct(async_system);
@@ -143,19 +224,53 @@ async_task_handler_init(Application_Links *app, Async_System *async_system){
     async_system->mutex = system_mutex_make();
     async_system->cv = system_condition_variable_make();
     async_system->join_cv = system_condition_variable_make();
-    dll_init_sentinel(&async_system->task_sent);
-    async_system->thread.async_system = async_system;
-    async_system->thread.thread = system_thread_launch(async_task_thread, &async_system->thread);
+    async_system->task_id_counter = 1;
+    async_system->task_table = make_table_u64_u64(get_base_allocator_system(), 128);
+    for (i32 i = 0; i < AsyncPriority_COUNT; i += 1){
+        dll_init_sentinel(&async_system->queues[i]);
+    }
+    async_task_set_thread_count(async_system, 1);
 }
 
 function Async_Task
-async_task_no_dep(Async_System *async_system, Async_Task_Function_Type *func, String_Const_u8 data){
+async_task_with_deps(Async_System *async_system, Async_Priority priority, Async_Task *deps, i32 dep_count,
+                     Async_Task_Function_Type *func, String_Const_u8 data){
     system_mutex_acquire(async_system->mutex);
-    Async_Task result = async_push_node(async_system, func, data);
+    Async_Task result = async_push_node(async_system, priority, deps, dep_count, func, data);
     system_mutex_release(async_system->mutex);
     return(result);
 }
 
+function Async_Task
+async_task_no_dep(Async_System *async_system, Async_Task_Function_Type *func, String_Const_u8 data, Async_Priority priority){
+    return(async_task_with_deps(async_system, priority, 0, 0, func, data));
+}
+
+function Async_Task
+async_task_no_dep(Async_System *async_system, Async_Task_Function_Type *func, String_Const_u8 data){
+    return(async_task_with_deps(async_system, AsyncPriority_Normal, 0, 0, func, data));
+}
+
+function Async_Task
+async_task_join(Async_System *async_system, Async_Task *tasks, i32 count){
+    return(async_task_with_deps(async_system, AsyncPriority_Normal, tasks, count, 0, SCu8()));
+}
+
+function void
+async_task_set_priority(Async_System *async_system, Async_Task task, Async_Priority priority){
+    priority = clamp(AsyncPriority_Low, priority, AsyncPriority_High);
+    system_mutex_acquire(async_system->mutex);
+    Async_Node *node = async_get_pending_node(async_system, task);
+    if (node != 0 && node->priority != priority){
+        node->priority = priority;
+        if (node->queued){
+            dll_remove(&node->node);
+            dll_insert_back(&async_system->queues[priority], &node->node);
+        }
+    }
+    system_mutex_release(async_system->mutex);
+}
+
 function b32
 async_task_is_pending(Async_System *async_system, Async_Task task){
     system_mutex_acquire(async_system->mutex);
@@ -174,10 +289,7 @@ async_task_is_running(Async_System *async_system, Async_Task task){
 
 function b32
 async_task_is_running_or_pending__inner(Async_System *async_system, Async_Task task){
-    Async_Node *node = async_get_pending_node(async_system, task);
-    if (node == 0){
-        node = async_get_running_node(async_system, task);
-    }
+    Async_Node *node = async_get_node(async_system, task);
     return(node != 0);
 }
 
@@ -212,9 +324,12 @@ async_task_cancel(Application_Links *app, Async_System *async_system, Async_Task
     system_mutex_acquire(async_system->mutex);
     Async_Node *node = async_get_pending_node(async_system, task);
     if (node != 0){
-        dll_remove(&node->node);
-        async_system->task_count -= 1;
-        async_free_node(async_system, node);
+        // NOTE: Tasks waiting on a canceled task are released as if it had finished.
+        if (node->queued){
+            dll_remove(&node->node);
+            async_system->task_count -= 1;
+        }
+        async_finish_node(async_system, node);
     }
     else{
         node = async_get_running_node(async_system, task);
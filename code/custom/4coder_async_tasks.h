@@ -10,6 +10,16 @@
 typedef void Async_Task_Function_Type(struct Async_Context *actx, String_Const_u8 data);
 typedef u64 Async_Task;
 
+typedef i32 Async_Priority;
+enum{
+    AsyncPriority_Low,
+    AsyncPriority_Normal,
+    AsyncPriority_High,
+    AsyncPriority_COUNT,
+};
+
+#define ASYNC_THREAD_MAX 32
+
 struct Async_Thread{
     struct Async_System *async_system;
     System_Thread thread;
@@ -18,6 +28,11 @@ struct Async_Thread{
     b32 cancel_signal;
 };
 
+struct Async_Dependent{
+    Async_Dependent *next;
+    Async_Task task;
+};
+
 struct Async_Node{
     union{
         Async_Node *next;
@@ -25,6 +40,10 @@ struct Async_Node{
     };
     Async_Task task;
     Async_Thread *thread;
+    b32 queued;
+    Async_Priority priority;
+    i32 wait_count;
+    Async_Dependent *first_dependent;
     Async_Task_Function_Type *func;
     String_Const_u8 data;
 };
@@ -39,10 +58,13 @@ struct Async_System{
     System_Condition_Variable join_cv;
     Async_Task task_id_counter;
     Async_Node *free_nodes;
-    Node task_sent;
+    Async_Dependent *free_dependents;
+    Table_u64_u64 task_table;
+    Node queues[AsyncPriority_COUNT];
     i32 task_count;
     
-    Async_Thread thread;
+    Async_Thread threads[ASYNC_THREAD_MAX];
+    i32 thread_count;
 };
 
 struct Async_Context{
@@ -61,24 +61,25 @@ set_line_indents(Application_Links *app, Arena *arena, Buffer_ID buffer, Range_i
     }
 }
 
-internal Token*
-find_anchor_token(Application_Links *app, Buffer_ID buffer, Token_Array *tokens, i64 invalid_line){
+internal i64
+find_anchor_token_index(Application_Links *app, Buffer_ID buffer, Token_Array *tokens, i64 invalid_line){
     ProfileScope(app, "find anchor token");
-    Token *result = 0;
+    i64 result = -1;
     
-    if (tokens != 0 && tokens->tokens != 0){
-        result = tokens->tokens;
+    if (tokens != 0 && tokens->count > 0){
+        result = 0;
         i64 invalid_pos = get_line_start_pos(app, buffer, invalid_line);
         i32 scope_counter = 0;
         i32 paren_counter = 0;
-        Token *token = tokens->tokens;
-        for (;;token += 1){
+        Token_Iterator_Array it = token_iterator(0, tokens);
+        for (;;){
+            Token *token = token_it_current(&it);
             if (token->pos + token->size > invalid_pos){
                 break;
             }
             if (!HasFlag(token->flags,  TokenBaseFlag_PreprocessorBody)){
                 if (scope_counter == 0 && paren_counter == 0){
-                    result = token;
+                    result = token_it_index(&it);
                 }
                 switch (token->kind){
                     case TokenBaseKind_ScopeOpen:
@@ -104,12 +105,25 @@ find_anchor_token(Application_Links *app, Buffer_ID buffer, Token_Array *tokens,
                     }break;
                 }
             }
+            if (!token_it_inc_all(&it)){
+                break;
+            }
         }
     }
     
     return(result);
 }
 
+internal Token*
+find_anchor_token(Application_Links *app, Buffer_ID buffer, Token_Array *tokens, i64 invalid_line){
+    Token *result = 0;
+    i64 index = find_anchor_token_index(app, buffer, tokens, invalid_line);
+    if (index >= 0){
+        result = token_array_at(tokens, index);
+    }
+    return(result);
+}
+
 internal Nest*
 indent__new_nest(Arena *arena, Nest_Alloc *alloc){
     Nest *new_nest = alloc->free_nest;
@@ -168,21 +182,20 @@ get_indentation_array(Application_Links *app, Arena *arena, Buffer_ID buffer, Ra
     
 #if 0
     Managed_Scope scope = buffer_get_managed_scope(app, buffer);
-    Token_Array *tokens = scope_attachment(app, scope, attachment_tokens, Token_Array);
+    Token_Store *tokens = scope_attachment(app, scope, attachment_tokens, Token_Store);
 #endif
     
     Token_Array token_array = get_token_array_from_buffer(app, buffer);
     Token_Array *tokens = &token_array;
     
     i64 anchor_line = clamp_bot(1, lines.first - 1);
-    Token *anchor_token = find_anchor_token(app, buffer, tokens, anchor_line);
-    if (anchor_token != 0 &&
-        anchor_token >= tokens->tokens &&
-        anchor_token < tokens->tokens + tokens->count){
-        i64 line = get_line_number_from_pos(app, buffer, anchor_token->pos);
+    i64 anchor_index = find_anchor_token_index(app, buffer, tokens, anchor_line);
+    if (0 <= anchor_index && anchor_index < tokens->count){
+        Token anchor_token = token_array_read(tokens, anchor_index);
+        i64 line = get_line_number_from_pos(app, buffer, anchor_token.pos);
         line = clamp_top(line, lines.first);
         
-        Token_Iterator_Array token_it = token_iterator(0, tokens, anchor_token);
+        Token_Iterator_Array token_it = token_iterator_index(0, tokens, anchor_index);
         
         Scratch_Block scratch(app, arena);
         Nest *nest = 0;
@@ -196,7 +209,7 @@ get_indentation_array(Application_Links *app, Arena *arena, Buffer_ID buffer, Ra
         Indent_Line_Cache line_cache = {};
         
         for (;;){
-            Token *token = token_it_read(&token_it);
+            Token *token = token_it_current(&token_it);
             
             if (line_cache.where_token_starts == 0 ||
                 token->pos >= line_cache.one_past_last_pos){
@@ -358,7 +371,7 @@ auto_indent_buffer(Application_Links *app, Buffer_ID buffer, Range_i64 pos, Inde
     Token_Array *tokens = &token_array;
     
     b32 result = false;
-    if (tokens->tokens != 0){
+    if (tokens->count > 0){
         result = true;
         
         Scratch_Block scratch(app);
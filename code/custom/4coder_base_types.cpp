@@ -165,11 +165,118 @@ global_const String_Const_u8 zero_data = {};
 
 ////////////////////////////////
 
+global CPU_Feature_Flags global_cpu_features = 0;
+
+function CPU_Feature_Flags
+cpu_features(void){
+    CPU_Feature_Flags result = global_cpu_features;
+    if (result == 0){
+        result = CPUFeature_Queried;
+#if ARCH_HAS_X86_SIMD
+# if COMPILER_CL
+        int info[4] = {};
+        __cpuid(info, 1);
+        b32 os_saves_ymm = false;
+        if ((info[3] & (1 << 26)) != 0){
+            result |= CPUFeature_SSE2;
+        }
+        if ((info[2] & (1 << 27)) != 0){
+            os_saves_ymm = ((_xgetbv(0) & 6) == 6);
+        }
+        __cpuidex(info, 7, 0);
+        if (os_saves_ymm && (info[1] & (1 << 5)) != 0){
+            result |= CPUFeature_AVX2;
+        }
+# else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")){
+            result |= CPUFeature_SSE2;
+        }
+        if (__builtin_cpu_supports("avx2")){
+            result |= CPUFeature_AVX2;
+        }
+# endif
+#endif
+        global_cpu_features = result;
+    }
+    return(result);
+}
+
+function b32
+cpu_has_feature(CPU_Feature_Flags feature){
+    return((cpu_features() & feature) != 0);
+}
+
+// NOTE: x must not be zero
+function u32
+bit_scan_forward_u32(u32 x){
+    u32 result = 0;
+#if COMPILER_CL
+    unsigned long index = 0;
+    _BitScanForward(&index, x);
+    result = (u32)index;
+#else
+    result = (u32)__builtin_ctz(x);
+#endif
+    return(result);
+}
+
+// NOTE: x must not be zero
+function u32
+bit_scan_reverse_u32(u32 x){
+    u32 result = 0;
+#if COMPILER_CL
+    unsigned long index = 0;
+    _BitScanReverse(&index, x);
+    result = (u32)index;
+#else
+    result = 31 - (u32)__builtin_clz(x);
+#endif
+    return(result);
+}
+
+////////////////////////////////
+
+// NOTE: On x64 SSE2 is always present, so the block primitives work 64 bytes per
+// round with unaligned loads and stores, then 16, then finish with bytes.  Within a round
+// every load happens before any store, which keeps block_copy safe for overlapping ranges
+// as long as it walks away from the side the destination is on.
+#if ARCH_X64
+# define BLOCK_SIMD 1
+#else
+# define BLOCK_SIMD 0
+#endif
+
+#if BLOCK_SIMD
+function void
+block__fill_m128(u8 *p, u64 size, __m128i v){
+    u8 *e = p + size;
+    for (;e - p >= 64; p += 64){
+        _mm_storeu_si128((__m128i*)(p +  0), v);
+        _mm_storeu_si128((__m128i*)(p + 16), v);
+        _mm_storeu_si128((__m128i*)(p + 32), v);
+        _mm_storeu_si128((__m128i*)(p + 48), v);
+    }
+    for (;e - p >= 16; p += 16){
+        _mm_storeu_si128((__m128i*)p, v);
+    }
+    u8 bytes[16];
+    _mm_storeu_si128((__m128i*)bytes, v);
+    for (u8 *b = bytes; p < e; p += 1, b += 1){
+        *p = *b;
+    }
+}
+#endif
+
 function void
 block_zero(void *mem, u64 size){
+#if BLOCK_SIMD
+    block__fill_m128((u8*)mem, size, _mm_setzero_si128());
+#else
     for (u8 *p = (u8*)mem, *e = p + size; p < e; p += 1){
         *p = 0;
     }
+#endif
 }
 function void
 block_zero(String_Const_u8 data){
@@ -177,9 +284,13 @@ block_zero(String_Const_u8 data){
 }
 function void
 block_fill_ones(void *mem, u64 size){
+#if BLOCK_SIMD
+    block__fill_m128((u8*)mem, size, _mm_set1_epi8((char)0xFF));
+#else
     for (u8 *p = (u8*)mem, *e = p + size; p < e; p += 1){
         *p = 0xFF;
     }
+#endif
 }
 function void
 block_fill_ones(String_Const_u8 data){
@@ -191,15 +302,47 @@ block_copy(void *dst, const void *src, u64 size){
     u8 *s = (u8*)src;
     if (d < s){
         u8 *e = d + size;
+#if BLOCK_SIMD
+        for (;e - d >= 64; d += 64, s += 64){
+            __m128i v0 = _mm_loadu_si128((__m128i*)(s +  0));
+            __m128i v1 = _mm_loadu_si128((__m128i*)(s + 16));
+            __m128i v2 = _mm_loadu_si128((__m128i*)(s + 32));
+            __m128i v3 = _mm_loadu_si128((__m128i*)(s + 48));
+            _mm_storeu_si128((__m128i*)(d +  0), v0);
+            _mm_storeu_si128((__m128i*)(d + 16), v1);
+            _mm_storeu_si128((__m128i*)(d + 32), v2);
+            _mm_storeu_si128((__m128i*)(d + 48), v3);
+        }
+        for (;e - d >= 16; d += 16, s += 16){
+            _mm_storeu_si128((__m128i*)d, _mm_loadu_si128((__m128i*)s));
+        }
+#endif
         for (; d < e; d += 1, s += 1){
             *d = *s;
         }
     }
     else if (d > s){
-        u8 *e = d;
-        d += size - 1;
-        s += size - 1;
-        for (; d >= e; d -= 1, s -= 1){
+        u8 *b = d;
+        d += size;
+        s += size;
+#if BLOCK_SIMD
+        for (;d - b >= 64; d -= 64, s -= 64){
+            __m128i v0 = _mm_loadu_si128((__m128i*)(s - 16));
+            __m128i v1 = _mm_loadu_si128((__m128i*)(s - 32));
+            __m128i v2 = _mm_loadu_si128((__m128i*)(s - 48));
+            __m128i v3 = _mm_loadu_si128((__m128i*)(s - 64));
+            _mm_storeu_si128((__m128i*)(d - 16), v0);
+            _mm_storeu_si128((__m128i*)(d - 32), v1);
+            _mm_storeu_si128((__m128i*)(d - 48), v2);
+            _mm_storeu_si128((__m128i*)(d - 64), v3);
+        }
+        for (;d - b >= 16; d -= 16, s -= 16){
+            _mm_storeu_si128((__m128i*)(d - 16), _mm_loadu_si128((__m128i*)(s - 16)));
+        }
+#endif
+        for (; d > b;){
+            d -= 1;
+            s -= 1;
             *d = *s;
         }
     }
@@ -207,55 +350,104 @@ block_copy(void *dst, const void *src, u64 size){
 function b32
 block_match(void *a, void *b, u64 size){
     b32 result = true;
-    for (u8 *pa = (u8*)a, *pb = (u8*)b, *ea = pa + size; pa < ea; pa += 1, pb += 1){
-        if (*pa != *pb){
+    u8 *pa = (u8*)a;
+    u8 *pb = (u8*)b;
+    u8 *ea = pa + size;
+#if BLOCK_SIMD
+    for (;ea - pa >= 16; pa += 16, pb += 16){
+        __m128i va = _mm_loadu_si128((__m128i*)pa);
+        __m128i vb = _mm_loadu_si128((__m128i*)pb);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF){
             result = false;
             break;
         }
     }
+#endif
+    if (result){
+        for (;pa < ea; pa += 1, pb += 1){
+            if (*pa != *pb){
+                result = false;
+                break;
+            }
+        }
+    }
     return(result);
 }
 function i32
 block_compare(void *a, void *b, u64 size){
     i32 result = 0;
-    for (u8 *pa = (u8*)a, *pb = (u8*)b, *ea = pa + size; pa < ea; pa += 1, pb += 1){
-        i32 dif = (i32)*pa - (i32)*pb;
-        if (dif != 0){
-            result = (dif > 0)?1:-1;
+    u8 *pa = (u8*)a;
+    u8 *pb = (u8*)b;
+    u8 *ea = pa + size;
+#if BLOCK_SIMD
+    for (;ea - pa >= 16; pa += 16, pb += 16){
+        __m128i va = _mm_loadu_si128((__m128i*)pa);
+        __m128i vb = _mm_loadu_si128((__m128i*)pb);
+        u32 equal_mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if (equal_mask != 0xFFFF){
+            u32 i = bit_scan_forward_u32(~equal_mask);
+            result = (pa[i] > pb[i])?1:-1;
             break;
         }
     }
+    if (result == 0)
+#endif
+    {
+        for (;pa < ea; pa += 1, pb += 1){
+            i32 dif = (i32)*pa - (i32)*pb;
+            if (dif != 0){
+                result = (dif > 0)?1:-1;
+                break;
+            }
+        }
+    }
     return(result);
 }
 function void
 block_fill_u8(void *a, u64 size, u8 val){
+#if BLOCK_SIMD
+    block__fill_m128((u8*)a, size, _mm_set1_epi8((char)val));
+#else
     for (u8 *ptr = (u8*)a, *e = ptr + size; ptr < e; ptr += 1){
         *ptr = val;
     }
+#endif
 }
 function void
 block_fill_u16(void *a, u64 size, u16 val){
     Assert(size%sizeof(u16) == 0);
+#if BLOCK_SIMD
+    block__fill_m128((u8*)a, size, _mm_set1_epi16((short)val));
+#else
     u64 count = size/sizeof(u16);
     for (u16 *ptr = (u16*)a, *e = ptr + count; ptr < e; ptr += 1){
         *ptr = val;
     }
+#endif
 }
 function void
 block_fill_u32(void *a, u64 size, u32 val){
     Assert(size%sizeof(u32) == 0);
+#if BLOCK_SIMD
+    block__fill_m128((u8*)a, size, _mm_set1_epi32((int)val));
+#else
     u64 count = size/sizeof(u32);
     for (u32 *ptr = (u32*)a, *e = ptr + count; ptr < e; ptr += 1){
         *ptr = val;
     }
+#endif
 }
 function void
 block_fill_u64(void *a, u64 size, u64 val){
     Assert(size%sizeof(u64) == 0);
+#if BLOCK_SIMD
+    block__fill_m128((u8*)a, size, _mm_set1_epi64x((long long)val));
+#else
     u64 count = size/sizeof(u64);
     for (u64 *ptr = (u64*)a, *e = ptr + count; ptr < e; ptr += 1){
         *ptr = val;
     }
+#endif
 }
 
 #define block_zero_struct(p) block_zero((p), sizeof(*(p)))
@@ -218,6 +218,44 @@ typedef double f64;
 
 typedef void Void_Func(void);
 
+////////////////////////////////
+
+// NOTE: SIMD kernels are compiled per function with TARGET_* so the rest of the
+// build keeps its baseline flags; callers pick a kernel at run time with cpu_features.
+#if ARCH_X64 || ARCH_X86
+# define ARCH_HAS_X86_SIMD 1
+# if COMPILER_CL
+#  include <intrin.h>
+# else
+#  include <immintrin.h>
+# endif
+#else
+# define ARCH_HAS_X86_SIMD 0
+#endif
+
+#if COMPILER_CL
+# define TARGET_SSE2
+# define TARGET_AVX2
+#else
+# define TARGET_SSE2 __attribute__((target("sse2")))
+# define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+typedef u32 CPU_Feature_Flags;
+enum{
+    CPUFeature_Queried = (1 << 0),
+    CPUFeature_SSE2    = (1 << 1),
+    CPUFeature_AVX2    = (1 << 2),
+};
+
+// NOTE: Returns the value from before the add.
+#if COMPILER_CL
+# include <intrin.h>
+# define atomic_add_i32(p,v) _InterlockedExchangeAdd((long volatile*)(p), (long)(v))
+#else
+# define atomic_add_i32(p,v) __sync_fetch_and_add((i32 volatile*)(p), (i32)(v))
+#endif
+
 typedef i32 Generated_Group;
 enum{
   GeneratedGroup_Core,
@@ -1398,6 +1436,8 @@ struct Thread_Context{
   Profile_Record *prof_first;
   Profile_Record *prof_last;
   i32 prof_record_count;
+  // NOTE: When non-zero, used in place of the system thread id for profiles.
+  i32 prof_thread_id;
   
   void *user_data;
 };
@@ -159,6 +159,20 @@ list->count -= 1;
 }
 }
 
+function void
+code_index__clear_patches(Code_Index_File_Storage *storage){
+for (Arena_Node *node = storage->first_patch, *next = 0;
+     node != 0;
+     node = next){
+next = node->next;
+// NOTE: the node lives inside its own arena
+Arena arena = node->arena;
+linalloc_clear(&arena);
+}
+storage->first_patch = 0;
+storage->patch_count = 0;
+}
+
 function void
 code_index_set_file(Buffer_ID buffer, Arena arena, Code_Index_File *index){
 Code_Index_File_Storage *storage = 0;
@@ -169,6 +183,7 @@ table_read(&global_code_index.buffer_to_index_file, lookup, &val);
 storage = (Code_Index_File_Storage*)IntAsPtr(val);
 code_index__clear_file(storage->file);
 linalloc_clear(&storage->arena);
+code_index__clear_patches(storage);
 }
 else{
 storage = code_index__alloc_storage();
@@ -191,6 +206,7 @@ Code_Index_File_Storage *storage = (Code_Index_File_Storage*)IntAsPtr(val);
 code_index__clear_file(storage->file);
 
 linalloc_clear(&storage->arena);
+code_index__clear_patches(storage);
 table_erase(&global_code_index.buffer_to_index_file, lookup);
 code_index__free_storage(storage);
 }
@@ -240,6 +256,25 @@ code_index_shift(&nest->nest_array, old_range, new_size);
 function void
 code_index_shift(Code_Index_File *file, Range_i64 old_range, u64 new_size){
 code_index_shift(&file->nest_array, old_range, new_size);
+i32 count = file->note_array.count;
+Code_Index_Note **note_ptr = file->note_array.ptrs;
+for (i32 i = 0; i < count; i += 1, note_ptr += 1){
+Code_Index_Note *note = *note_ptr;
+index_shift(&note->pos.min, old_range, new_size);
+index_shift(&note->pos.max, old_range, new_size);
+}
+
+Range_i64 new_text = Ii64_size(old_range.min, new_size);
+if (file->has_dirty_range){
+index_shift(&file->dirty_range.min, old_range, new_size);
+index_shift(&file->dirty_range.max, old_range, new_size);
+file->dirty_range = range_union(file->dirty_range, new_text);
+}
+else{
+file->has_dirty_range = true;
+file->dirty_range = new_text;
+}
+file->edit_count += 1;
 }
 
 
@@ -251,6 +286,10 @@ generic_parse_inc(Generic_Parse_State *state){
 if (!token_it_inc_all(&state->it)){
 state->finished = true;
 }
+else{
+Token *token = token_it_read(&state->it);
+state->scan_reach = Max(state->scan_reach, token->pos + token->size);
+}
 }
 
 function void
@@ -746,32 +785,18 @@ state->paren_counter -= 1;
 return(result);
 }
 
-function b32
-generic_parse_full_input_breaks(Code_Index_File *index, Generic_Parse_State *state, i32 limit){
-b32 result = false;
-
-i64 first_index = token_it_index(&state->it);
-i64 one_past_last_index = first_index + limit;
-for (;;){
-generic_parse_skip_soft_tokens(index, state);
-Token *token = token_it_read(&state->it);
-
-if (token == 0 || state->finished){
-result = true;
-break;
-}
-
+function void
+generic_parse_top_level(Code_Index_File *index, Generic_Parse_State *state, Token *token){
+b32 is_restart_point = (state->scan_reach <= token->pos + token->size);
+Code_Index_Nest *nest = 0;
 if (token->kind == TokenBaseKind_Preprocessor){
-Code_Index_Nest *nest = generic_parse_preprocessor(index, state);
-code_index_push_nest(&index->nest_list, nest);
+nest = generic_parse_preprocessor(index, state);
 }
 else if (token->kind == TokenBaseKind_ScopeOpen){
-Code_Index_Nest *nest = generic_parse_scope(index, state);
-code_index_push_nest(&index->nest_list, nest);
+nest = generic_parse_scope(index, state);
 }
 else if (token->kind == TokenBaseKind_ParentheticalOpen){
-Code_Index_Nest *nest = generic_parse_paren(index, state);
-code_index_push_nest(&index->nest_list, nest);
+nest = generic_parse_paren(index, state);
 }
 else if (state->do_cpp_parse){
 if (token->sub_kind == TokenCppKind_Struct ||
@@ -792,6 +817,30 @@ generic_parse_inc(state);
 else{
 generic_parse_inc(state);
 }
+if (nest != 0){
+// NOTE: a paren is never a restart point, the function scan before it
+// depends on what is inside it.
+nest->is_restart_point = (is_restart_point && nest->kind != CodeIndexNest_Paren);
+code_index_push_nest(&index->nest_list, nest);
+}
+}
+
+function b32
+generic_parse_full_input_breaks(Code_Index_File *index, Generic_Parse_State *state, i32 limit){
+b32 result = false;
+
+i64 first_index = token_it_index(&state->it);
+i64 one_past_last_index = first_index + limit;
+for (;;){
+generic_parse_skip_soft_tokens(index, state);
+Token *token = token_it_read(&state->it);
+
+if (token == 0 || state->finished){
+result = true;
+break;
+}
+
+generic_parse_top_level(index, state, token);
 
 i64 index = token_it_index(&state->it);
 if (index >= one_past_last_index){
@@ -811,6 +860,241 @@ index->note_array = code_index_note_ptr_array_from_list(state->arena, &index->no
 return(result);
 }
 
+////////////////////////////////
+// NOTE: Incremental Reparse
+
+// NOTE: The parser state at the top level is the same at every restart point, so
+// the text from the last restart point before the dirty range is parsed again, up to the
+// first old restart scope after it that the new parse also reaches as a restart point.
+// From there on the new parse would repeat the old one node for node.
+function b32
+code_index_plan_reparse(Arena *arena, Buffer_ID buffer, Token_Array *tokens, Code_Index_Reparse *reparse){
+block_zero_struct(reparse);
+reparse->end_pos = max_i64;
+Code_Index_File_Storage *storage = 0;
+Table_Lookup lookup = table_lookup(&global_code_index.buffer_to_index_file, buffer);
+if (lookup.found_match){
+u64 val = 0;
+table_read(&global_code_index.buffer_to_index_file, lookup, &val);
+storage = (Code_Index_File_Storage*)IntAsPtr(val);
+reparse->edit_count = storage->file->edit_count;
+}
+if (storage != 0 && storage->file->has_dirty_range &&
+    storage->patch_count < CODE_INDEX_MAX_PATCH_COUNT){
+Code_Index_File *file = storage->file;
+Range_i64 dirty = file->dirty_range;
+reparse->dirty_range = dirty;
+
+i32 count = file->nest_array.count;
+Code_Index_Nest **nest_ptrs = file->nest_array.ptrs;
+i32 sync_count = 0;
+for (i32 i = 0; i < count; i += 1){
+Code_Index_Nest *nest = nest_ptrs[i];
+if (!nest->is_restart_point){
+continue;
+}
+if (nest->open.min < dirty.min && nest->open.min > reparse->restart_pos){
+// NOTE: the opening token has to end before the dirty range too, the
+// scans before it looked at all of it.
+i64 token_index = token_index_from_pos(tokens, nest->open.min);
+Token *token = tokens->tokens + token_index;
+if (token->pos == nest->open.min && token->pos + token->size <= dirty.min){
+reparse->restart_pos = nest->open.min;
+}
+}
+else if (nest->kind == CodeIndexNest_Scope && nest->open.min >= dirty.max){
+sync_count += 1;
+}
+}
+
+if (reparse->restart_pos > 0 || sync_count > 0){
+reparse->is_incremental = true;
+reparse->sync_positions = push_array(arena, i64, sync_count);
+for (i32 i = 0; i < count; i += 1){
+Code_Index_Nest *nest = nest_ptrs[i];
+if (nest->is_restart_point && nest->kind == CodeIndexNest_Scope &&
+    nest->open.min >= dirty.max){
+reparse->sync_positions[reparse->sync_count] = nest->open.min;
+reparse->sync_count += 1;
+}
+}
+}
+}
+return(reparse->is_incremental);
+}
+
+function void
+generic_parse_reparse_init(Generic_Parse_State *state, Code_Index_Reparse *reparse){
+state->it = token_iterator_pos(state->it.user_id, state->it.tokens, state->it.count, reparse->restart_pos);
+}
+
+function b32
+generic_parse_reparse_breaks(Code_Index_File *index, Generic_Parse_State *state, i32 limit, Code_Index_Reparse *reparse){
+b32 result = false;
+
+i64 first_index = token_it_index(&state->it);
+i64 one_past_last_index = first_index + limit;
+for (;;){
+generic_parse_skip_soft_tokens(index, state);
+Token *token = token_it_read(&state->it);
+
+if (token == 0 || state->finished){
+result = true;
+break;
+}
+
+if (token->kind == TokenBaseKind_ScopeOpen &&
+    token->pos >= reparse->dirty_range.max &&
+    state->scan_reach <= token->pos + token->size){
+for (;reparse->sync_count > 0 && reparse->sync_positions[0] < token->pos;){
+reparse->sync_positions += 1;
+reparse->sync_count -= 1;
+}
+if (reparse->sync_count > 0 && reparse->sync_positions[0] == token->pos){
+reparse->end_pos = token->pos;
+result = true;
+break;
+}
+}
+
+generic_parse_top_level(index, state, token);
+
+i64 index = token_it_index(&state->it);
+if (index >= one_past_last_index){
+token = token_it_read(&state->it);
+if (token == 0){
+result = true;
+}
+break;
+}
+}
+
+return(result);
+}
+
+function void
+code_index__set_nest_file(Code_Index_Nest_Ptr_Array *array, Code_Index_File *file){
+for (i32 i = 0; i < array->count; i += 1){
+Code_Index_Nest *nest = array->ptrs[i];
+nest->file = file;
+code_index__set_nest_file(&nest->nest_array, file);
+}
+}
+
+function b32
+code_index_splice_file(Buffer_ID buffer, Arena arena, Code_Index_File *region, Code_Index_Reparse *reparse){
+b32 result = false;
+Table_Lookup lookup = table_lookup(&global_code_index.buffer_to_index_file, buffer);
+if (lookup.found_match){
+u64 val = 0;
+table_read(&global_code_index.buffer_to_index_file, lookup, &val);
+Code_Index_File_Storage *storage = (Code_Index_File_Storage*)IntAsPtr(val);
+Code_Index_File *file = storage->file;
+if (file->edit_count == reparse->edit_count){
+Range_i64 replaced = Ii64(reparse->restart_pos, reparse->end_pos);
+
+// NOTE: notes, only the replaced and new ones touch the name hash
+Code_Index_Note_List prefix_notes = {};
+Code_Index_Note_List tail_notes = {};
+for (Code_Index_Note *node = file->note_list.first, *next = 0;
+     node != 0;
+     node = next){
+next = node->next;
+Code_Index_Note_List *dst = 0;
+if (node->pos.min < replaced.min){
+dst = &prefix_notes;
+}
+else if (node->pos.min >= replaced.max){
+dst = &tail_notes;
+}
+else{
+Code_Index_Note_List *list = code_index__list_from_string(node->text);
+zdll_remove_NP_(list->first, list->last, node, next_in_hash, prev_in_hash);
+list->count -= 1;
+}
+if (dst != 0){
+node->next = 0;
+sll_queue_push(dst->first, dst->last, node);
+dst->count += 1;
+}
+}
+for (Code_Index_Note *node = region->note_list.first;
+     node != 0;
+     node = node->next){
+node->file = file;
+Code_Index_Note_List *list = code_index__list_from_string(node->text);
+zdll_push_back_NP_(list->first, list->last, node, next_in_hash, prev_in_hash);
+list->count += 1;
+}
+
+// NOTE: top level nests, the nests under a kept nest are never in the
+// replaced range, the ones in the region are all new.
+Code_Index_Nest_List prefix_nests = {};
+Code_Index_Nest_List tail_nests = {};
+for (Code_Index_Nest *node = file->nest_list.first, *next = 0;
+     node != 0;
+     node = next){
+next = node->next;
+node->next = 0;
+if (node->open.min < replaced.min){
+code_index_push_nest(&prefix_nests, node);
+}
+else if (node->open.min >= replaced.max){
+code_index_push_nest(&tail_nests, node);
+}
+}
+region->nest_array = code_index_nest_ptr_array_from_list(&arena, &region->nest_list);
+code_index__set_nest_file(&region->nest_array, file);
+
+Code_Index_Note_List note_list = {};
+Code_Index_Note_List *note_parts[] = {&prefix_notes, &region->note_list, &tail_notes};
+for (i32 i = 0; i < ArrayCount(note_parts); i += 1){
+Code_Index_Note_List *part = note_parts[i];
+if (part->first != 0){
+if (note_list.last != 0){
+note_list.last->next = part->first;
+}
+else{
+note_list.first = part->first;
+}
+note_list.last = part->last;
+note_list.count += part->count;
+}
+}
+Code_Index_Nest_List nest_list = {};
+Code_Index_Nest_List *nest_parts[] = {&prefix_nests, &region->nest_list, &tail_nests};
+for (i32 i = 0; i < ArrayCount(nest_parts); i += 1){
+Code_Index_Nest_List *part = nest_parts[i];
+if (part->first != 0){
+if (nest_list.last != 0){
+nest_list.last->next = part->first;
+}
+else{
+nest_list.first = part->first;
+}
+nest_list.last = part->last;
+nest_list.count += part->count;
+}
+}
+
+file->note_list = note_list;
+file->nest_list = nest_list;
+file->note_array = code_index_note_ptr_array_from_list(&arena, &file->note_list);
+file->nest_array = code_index_nest_ptr_array_from_list(&arena, &file->nest_list);
+file->has_dirty_range = false;
+file->dirty_range = Ii64();
+
+Arena_Node *node = push_array_zero(&arena, Arena_Node, 1);
+node->arena = arena;
+sll_stack_push(storage->first_patch, node);
+storage->patch_count += 1;
+
+result = true;
+}
+}
+return(result);
+}
+
 
 ////////////////////////////////
 // NOTE(allen): Not sure
@@ -833,21 +1117,23 @@ function Token_Pair
 layout_token_pair(Token_Array *tokens, i64 pos){
 Token_Pair result = {};
 Token_Iterator_Array it = token_iterator_pos(0, tokens, pos);
-Token *b = token_it_read(&it);
+Token *b = token_it_current(&it);
 if (b != 0){
 if (b->kind == TokenBaseKind_Whitespace){
 token_it_inc_non_whitespace(&it);
-b = token_it_read(&it);
+b = token_it_current(&it);
 }
 }
+// NOTE: b has to be copied out before the iterator moves, token_it_current reuses
+// the same token.
+if (b != 0){
+result.b = *b;
+}
 token_it_dec_non_whitespace(&it);
-Token *a = token_it_read(&it);
+Token *a = token_it_current(&it);
 if (a != 0){
 result.a = *a;
 }
-if (b != 0){
-result.b = *b;
-}
 return(result);
 }
 
@@ -31,6 +31,9 @@ struct Code_Index_Nest{
     
     Code_Index_Nest_Kind kind;
     b32 is_closed;
+    // NOTE: Set on top level nests the parser reached without having looked
+    // at any token past their opening token, a reparse can start over from these.
+    b32 is_restart_point;
     Range_i64 open;
     Range_i64 close;
     
@@ -78,13 +81,39 @@ struct Code_Index_File{
     Code_Index_Note_List note_list;
     Code_Index_Note_Ptr_Array note_array;
     Buffer_ID buffer;
+    
+    // NOTE: Every edit bumps edit_count and grows dirty_range to cover the new
+    // text, both in the buffer's current coordinates.
+    i64 edit_count;
+    b32 has_dirty_range;
+    Range_i64 dirty_range;
 };
 
+// NOTE: A reparse spliced into a file keeps its nodes in a patch arena owned by
+// the storage, a full parse clears them all.  Past CODE_INDEX_MAX_PATCH_COUNT patches
+// the next parse is a full one so replaced nodes can't pile up.
+#define CODE_INDEX_MAX_PATCH_COUNT 64
+
 struct Code_Index_File_Storage{
     Code_Index_File_Storage *next;
     Code_Index_File_Storage *prev;
     Arena arena;
     Code_Index_File *file;
+    Arena_Node *first_patch;
+    i32 patch_count;
+};
+
+// NOTE: A reparse covers [restart_pos, end_pos), everything outside that range
+// keeps the nodes of the previous parse.  end_pos is found by the parse, it stops at the
+// first old restart scope in sync_positions it lands on past the dirty range.
+struct Code_Index_Reparse{
+    i64 edit_count;
+    b32 is_incremental;
+    Range_i64 dirty_range;
+    i64 restart_pos;
+    i64 end_pos;
+    i64 *sync_positions;
+    i32 sync_count;
 };
 
 struct Code_Index{
@@ -112,6 +141,7 @@ struct Generic_Parse_State{
     Generic_Parse_Comment_Function *handle_comment;
     u8 *prev_line_start;
     b32 finished;
+    i64 scan_reach;
     
     i32 scope_counter;
     i32 paren_counter;
@@ -1522,6 +1522,13 @@ load_config_and_apply(Application_Links *app, Arena *out_arena, i32 override_fon
     b32 lalt_lctrl_is_altgr = def_get_config_b32(vars_save_string_lit("lalt_lctrl_is_altgr"));
     global_set_setting(app, GlobalSetting_LAltLCtrlIsAltGr, lalt_lctrl_is_altgr);
     
+    b32 compact_history = def_get_config_b32(vars_save_string_lit("compact_history"));
+    global_set_setting(app, GlobalSetting_CompactHistory, compact_history);
+    u64 history_buffer_budget_mb = def_get_config_u64(app, vars_save_string_lit("history_buffer_budget_mb"));
+    global_set_setting(app, GlobalSetting_HistoryBufferBudget, (i64)MB(history_buffer_budget_mb));
+    u64 history_global_budget_mb = def_get_config_u64(app, vars_save_string_lit("history_global_budget_mb"));
+    global_set_setting(app, GlobalSetting_HistoryGlobalBudget, (i64)MB(history_global_budget_mb));
+    
     String_Const_u8 default_theme_name = def_get_config_string(scratch, vars_save_string_lit("default_theme_name"));
     Color_Table *colors = get_color_table_by_name(default_theme_name);
     set_active_color(colors);
@@ -624,6 +624,9 @@ default_4coder_initialize(Application_Links *app, String_Const_u8_Array file_nam
     
     load_config_and_apply(app, &global_config_arena, override_font_size, override_hinting);
     
+    i32 async_thread_count = (i32)def_get_config_u64(app, vars_save_string_lit("async_thread_count"));
+    async_task_set_thread_count(&global_async_system, async_thread_count);
+    
     String_Const_u8 bindings_file_name = string_u8_litexpr("bindings.4coder");
     String_Const_u8 mapping = def_get_config_string(scratch, vars_save_string_lit("mapping"));
     
@@ -117,37 +117,31 @@ CUSTOM_DOC("Input consumption loop for default view behavior")
     }
 }
 
+function void do_full_parse_async(Async_Context *actx, String_Const_u8 data);
+function Async_Priority buffer_async_priority(Application_Links *app, Buffer_ID buffer_id);
+
 function void
 code_index_update_tick(Application_Links *app){
-    Scratch_Block scratch(app);
+    // NOTE: Parsing happens on the async workers.  A buffer that is modified again
+    // while its parse is still queued shares that parse, it reads the buffer once it
+    // starts.  A parse that is already running is canceled and queued again.
     for (Buffer_Modified_Node *node = global_buffer_modified_set.first;
          node != 0;
          node = node->next){
-        Temp_Memory_Block temp(scratch);
         Buffer_ID buffer_id = node->buffer;
-        
-        String_Const_u8 contents = push_whole_buffer(app, scratch, buffer_id);
-        Token_Array tokens = get_token_array_from_buffer(app, buffer_id);
-        if (tokens.count == 0){
+        Managed_Scope scope = buffer_get_managed_scope(app, buffer_id);
+        Async_Task *parse_task_ptr = scope_attachment(app, scope, buffer_parse_task, Async_Task);
+        if (parse_task_ptr == 0){
             continue;
         }
-        
-        Arena arena = make_arena_system(KB(16));
-        Code_Index_File *index = push_array_zero(&arena, Code_Index_File, 1);
-        index->buffer = buffer_id;
-        
-        Generic_Parse_State state = {};
-        generic_parse_init(app, &arena, contents, &tokens, &state);
-        // TODO(allen): Actually determine this in a fair way.
-        // Maybe switch to an enum?
-        // Actually probably a pointer to a struct that defines the language.
-        state.do_cpp_parse = true;
-        generic_parse_full_input_breaks(index, &state, max_i32);
-        
-        code_index_lock();
-        code_index_set_file(buffer_id, arena, index);
-        code_index_unlock();
-        buffer_clear_layout_cache(app, buffer_id);
+        if (async_task_is_pending(&global_async_system, *parse_task_ptr)){
+            continue;
+        }
+        if (async_task_is_running(&global_async_system, *parse_task_ptr)){
+            async_task_cancel(app, &global_async_system, *parse_task_ptr);
+        }
+        *parse_task_ptr = async_task_no_dep(&global_async_system, do_full_parse_async, make_data_struct(&buffer_id),
+                                            buffer_async_priority(app, buffer_id));
     }
     
     buffer_modified_set_clear();
@@ -283,7 +277,7 @@ default_render_buffer(Application_Links *app, View_ID view_id, Face_ID face_id,
     
     // NOTE(allen): Token colorizing
     Token_Array token_array = get_token_array_from_buffer(app, buffer);
-    if (token_array.tokens != 0){
+    if (token_array.count > 0){
         draw_cpp_token_colors(app, text_layout_id, &token_array);
         
         // NOTE(allen): Scan for TODOs and NOTEs
@@ -308,7 +302,7 @@ default_render_buffer(Application_Links *app, View_ID view_id, Face_ID face_id,
             if (!token_it_inc_non_whitespace(&it)){
                 break;
             }
-            Token *token = token_it_read(&it);
+            Token *token = token_it_current(&it);
             String_Const_u8 lexeme = push_token_lexeme(app, scratch, buffer, token);
             Code_Index_Note *note = code_index_note_from_string(lexeme);
             if (note != 0 && note->note_kind == CodeIndexNote_Function){
@@ -370,7 +364,7 @@ default_render_buffer(Application_Links *app, View_ID view_id, Face_ID face_id,
     b64 show_whitespace = false;
     view_get_setting(app, view_id, ViewSetting_ShowWhitespace, &show_whitespace);
     if (show_whitespace){
-        if (token_array.tokens == 0){
+        if (token_array.count == 0){
             draw_whitespace_highlight(app, buffer, text_layout_id, cursor_roundness);
         }
         else{
@@ -631,22 +625,37 @@ BUFFER_NAME_RESOLVER_SIG(default_buffer_name_resolution){
 
 function void
 parse_async__inner(Async_Context *actx, Buffer_ID buffer_id,
-                   String_Const_u8 contents, Token_Array *tokens, i32 limit_factor){
+                   String_Const_u8 contents, Token_Array *tokens, i32 limit_factor,
+                   Code_Index_Reparse *reparse){
     Application_Links *app = actx->app;
     ProfileBlock(app, "async parse");
     
-    Arena arena = make_arena_system(KB(16));
+    Arena arena = make_arena_system(reparse->is_incremental?KB(4):KB(16));
     Code_Index_File *index = push_array_zero(&arena, Code_Index_File, 1);
     index->buffer = buffer_id;
     
     Generic_Parse_State state = {};
     generic_parse_init(app, &arena, contents, tokens, &state);
+    // TODO(allen): Actually determine this in a fair way.
+    // Maybe switch to an enum?
+    // Actually probably a pointer to a struct that defines the language.
+    state.do_cpp_parse = true;
+    if (reparse->is_incremental){
+        generic_parse_reparse_init(&state, reparse);
+    }
     
     b32 canceled = false;
     
     for (;;){
-        if (generic_parse_full_input_breaks(index, &state, limit_factor)){
-            break;
+        if (reparse->is_incremental){
+            if (generic_parse_reparse_breaks(index, &state, limit_factor, reparse)){
+                break;
+            }
+        }
+        else{
+            if (generic_parse_full_input_breaks(index, &state, limit_factor)){
+                break;
+            }
         }
         if (async_check_canceled(actx)){
             canceled = true;
@@ -654,33 +663,115 @@ parse_async__inner(Async_Context *actx, Buffer_ID buffer_id,
         }
     }
     
+    b32 published = false;
     if (!canceled){
         acquire_global_frame_mutex(app);
         code_index_lock();
-        code_index_set_file(buffer_id, arena, index);
+        // NOTE: If the buffer was edited after the snapshot this parse is stale,
+        // the edit marked the buffer modified so another parse is on the way.
+        Code_Index_File *file = code_index_get_file(buffer_id);
+        if (reparse->is_incremental){
+            published = code_index_splice_file(buffer_id, arena, index, reparse);
+        }
+        else if (file == 0 || file->edit_count == reparse->edit_count){
+            code_index_set_file(buffer_id, arena, index);
+            published = true;
+        }
         code_index_unlock();
-        buffer_clear_layout_cache(app, buffer_id);
+        if (published && def_enable_virtual_whitespace){
+            buffer_clear_layout_cache(app, buffer_id);
+        }
         release_global_frame_mutex(app);
     }
-    else{
+    if (!published){
         linalloc_clear(&arena);
     }
 }
 
+function void
+do_full_parse_async__inner(Async_Context *actx, Buffer_ID buffer_id){
+    Application_Links *app = actx->app;
+    Scratch_Block scratch(app);
+    
+    // NOTE: The snapshot, the tokens and the reparse plan all come from one hold of
+    // the frame mutex, so they describe the same text.  Nothing in here may wait on
+    // the lex task, waiting drops the mutex.  While a lex of the buffer is queued or
+    // running its tokens are stale, so the parse is queued again behind it.
+    Buffer_Snapshot *snapshot = 0;
+    Token_Array tokens = {};
+    Code_Index_Reparse reparse = {};
+    {
+        ProfileBlock(app, "async parse contents (before mutex)");
+        acquire_global_frame_mutex(app);
+        ProfileBlock(app, "async parse contents (after mutex)");
+        Managed_Scope scope = buffer_get_managed_scope(app, buffer_id);
+        Async_Task *lex_task_ptr = scope_attachment(app, scope, buffer_lex_task, Async_Task);
+        Async_Task *parse_task_ptr = scope_attachment(app, scope, buffer_parse_task, Async_Task);
+        Token_Store *store = scope_attachment(app, scope, attachment_tokens, Token_Store);
+        if (lex_task_ptr != 0 && parse_task_ptr != 0 &&
+            async_task_is_running_or_pending(&global_async_system, *lex_task_ptr)){
+            *parse_task_ptr = async_task_with_deps(&global_async_system,
+                                                   buffer_async_priority(app, buffer_id),
+                                                   lex_task_ptr, 1,
+                                                   do_full_parse_async, make_data_struct(&buffer_id));
+        }
+        else if (store != 0 && store->count > 0){
+            snapshot = buffer_snapshot_acquire(app, buffer_id);
+            Token_Array buffer_tokens = token_array_from_store(store);
+            tokens = token_array_copy(scratch, &buffer_tokens);
+            code_index_lock();
+            code_index_plan_reparse(scratch, buffer_id, &tokens, &reparse);
+            code_index_unlock();
+        }
+        release_global_frame_mutex(app);
+    }
+    
+    if (tokens.count > 0){
+        String_Const_u8 contents = {};
+        {
+            ProfileBlock(app, "async parse contents (copy snapshot)");
+            contents = push_whole_snapshot(app, scratch, snapshot);
+        }
+        // NOTE: The parser slices token ranges out of the contents without clamping,
+        // so tokens that do not end exactly at the end of the snapshot are never parsed.
+        Token *last = tokens.tokens + tokens.count - 1;
+        if (last->pos + last->size == (i64)contents.size){
+            parse_async__inner(actx, buffer_id, contents, &tokens, 10000, &reparse);
+        }
+    }
+    buffer_snapshot_release(app, snapshot);
+}
+
+function void
+do_full_parse_async(Async_Context *actx, String_Const_u8 data){
+    if (data.size == sizeof(Buffer_ID)){
+        Buffer_ID buffer = *(Buffer_ID*)data.str;
+        do_full_parse_async__inner(actx, buffer);
+    }
+}
+
 function void
 do_full_lex_async__inner(Async_Context *actx, Buffer_ID buffer_id){
     Application_Links *app = actx->app;
     ProfileScope(app, "async lex");
     Scratch_Block scratch(app);
     
-    String_Const_u8 contents = {};
+    // NOTE: Only taking the snapshot needs the mutex, the copy the lexer reads
+    // from is made after it is released.
+    Buffer_Snapshot *snapshot = 0;
     {
         ProfileBlock(app, "async lex contents (before mutex)");
         acquire_global_frame_mutex(app);
         ProfileBlock(app, "async lex contents (after mutex)");
-        contents = push_whole_buffer(app, scratch, buffer_id);
+        snapshot = buffer_snapshot_acquire(app, buffer_id);
         release_global_frame_mutex(app);
     }
+    String_Const_u8 contents = {};
+    {
+        ProfileBlock(app, "async lex contents (copy snapshot)");
+        contents = push_whole_snapshot(app, scratch, snapshot);
+        buffer_snapshot_release(app, snapshot);
+    }
     
     i32 limit_factor = 10000;
     
@@ -707,14 +798,9 @@ do_full_lex_async__inner(Async_Context *actx, Buffer_ID buffer_id){
         Managed_Scope scope = buffer_get_managed_scope(app, buffer_id);
         if (scope != 0){
             Base_Allocator *allocator = managed_scope_allocator(app, scope);
-            Token_Array *tokens_ptr = scope_attachment(app, scope, attachment_tokens, Token_Array);
-            base_free(allocator, tokens_ptr->tokens);
-            Token_Array tokens = {};
-            tokens.tokens = base_array(allocator, Token, list.total_count);
-            tokens.count = list.total_count;
-            tokens.max = list.total_count;
-            token_fill_memory_from_list(tokens.tokens, &list);
-            block_copy_struct(tokens_ptr, &tokens);
+            Token_Store *tokens_ptr = scope_attachment(app, scope, attachment_tokens, Token_Store);
+            token_store_free(allocator, tokens_ptr);
+            *tokens_ptr = token_store_from_list(allocator, &list);
         }
         buffer_mark_as_modified(buffer_id);
         release_global_frame_mutex(app);
@@ -729,6 +815,21 @@ do_full_lex_async(Async_Context *actx, String_Const_u8 data){
     }
 }
 
+// NOTE: Lexing buffers that are on screen comes before lexing everything else.
+function Async_Priority
+buffer_async_priority(Application_Links *app, Buffer_ID buffer_id){
+    Async_Priority result = AsyncPriority_Normal;
+    for (View_ID view = get_view_next(app, 0, Access_Always);
+         view != 0;
+         view = get_view_next(app, view, Access_Always)){
+        if (view_get_buffer(app, view, Access_Always) == buffer_id){
+            result = AsyncPriority_High;
+            break;
+        }
+    }
+    return(result);
+}
+
 BUFFER_HOOK_SIG(default_begin_buffer){
     ProfileScope(app, "begin buffer");
     
@@ -833,12 +934,21 @@ BUFFER_HOOK_SIG(default_begin_buffer){
         wrap_lines = def_get_config_b32(vars_save_string_lit("enable_output_wrapping"));
     }
     
+    u64 piece_tree_threshold_mb = def_get_config_u64(app, vars_save_string_lit("piece_tree_threshold_mb"));
+    if (piece_tree_threshold_mb > 0 &&
+        (u64)buffer_get_size(app, buffer_id) >= MB(piece_tree_threshold_mb)){
+        buffer_set_setting(app, buffer_id, BufferSetting_PieceTreeStorage, true);
+    }
+    
     if (use_lexer){
         ProfileBlock(app, "begin buffer kick off lexer");
         Async_Task *lex_task_ptr = scope_attachment(app, scope, buffer_lex_task, Async_Task);
-        *lex_task_ptr = async_task_no_dep(&global_async_system, do_full_lex_async, make_data_struct(&buffer_id));
+        *lex_task_ptr = async_task_no_dep(&global_async_system, do_full_lex_async, make_data_struct(&buffer_id),
+                                          buffer_async_priority(app, buffer_id));
     }
     
+    trigram_index_begin_buffer(app, buffer_id);
+    
     {
         b32 *wrap_lines_ptr = scope_attachment(app, scope, buffer_wrap_lines, b32);
         *wrap_lines_ptr = wrap_lines;
@@ -958,6 +1068,8 @@ BUFFER_EDIT_RANGE_SIG(default_buffer_edit_range){
         code_index_unlock();
     }
     
+    trigram_index_buffer_edit(app, buffer_id, old_range, range_size(new_range));
+    
     i64 insert_size = range_size(new_range);
     i64 text_shift = replace_range_shift(old_range, insert_size);
     
@@ -976,22 +1088,23 @@ BUFFER_EDIT_RANGE_SIG(default_buffer_edit_range){
         *lex_task_ptr = 0;
     }
     
-    Token_Array *ptr = scope_attachment(app, scope, attachment_tokens, Token_Array);
-    if (ptr != 0 && ptr->tokens != 0){
+    Token_Store *ptr = scope_attachment(app, scope, attachment_tokens, Token_Store);
+    if (ptr != 0 && ptr->count > 0){
         ProfileBlockNamed(app, "attempt resync", profile_attempt_resync);
         
-        i64 token_index_first = token_relex_first(ptr, old_range.first, 1);
+        Token_Array tokens = token_array_from_store(ptr);
+        i64 token_index_first = token_relex_first(&tokens, old_range.first, 1);
         i64 token_index_resync_guess =
-            token_relex_resync(ptr, old_range.one_past_last, 16);
+            token_relex_resync(&tokens, old_range.one_past_last, 16);
         
         if (token_index_resync_guess - token_index_first >= 4000){
             do_full_relex = true;
         }
         else{
-            Token *token_first = ptr->tokens + token_index_first;
-            Token *token_resync = ptr->tokens + token_index_resync_guess;
+            Token token_first = token_store_read(ptr, token_index_first);
+            Token token_resync = token_store_read(ptr, token_index_resync_guess);
             
-            Range_i64 relex_range = Ii64(token_first->pos, token_resync->pos + token_resync->size + text_shift);
+            Range_i64 relex_range = Ii64(token_first.pos, token_resync.pos + token_resync.size + text_shift);
             String_Const_u8 partial_text = push_buffer_range(app, scratch, buffer_id, relex_range);
             
             Token_List relex_list = lex_full_input_cpp(scratch, partial_text);
@@ -999,7 +1112,7 @@ BUFFER_EDIT_RANGE_SIG(default_buffer_edit_range){
                 token_drop_eof(&relex_list);
             }
             
-            Token_Relex relex = token_relex(relex_list, relex_range.first - text_shift, ptr->tokens, token_index_first, token_index_resync_guess);
+            Token_Relex relex = token_relex(relex_list, relex_range.first - text_shift, &tokens, token_index_first, token_index_resync_guess);
             
             ProfileCloseNow(profile_attempt_resync);
             
@@ -1011,32 +1124,14 @@ BUFFER_EDIT_RANGE_SIG(default_buffer_edit_range){
                 
                 i64 token_index_resync = relex.first_resync_index;
                 
-                Range_i64 head = Ii64(0, token_index_first);
                 Range_i64 replaced = Ii64(token_index_first, token_index_resync);
-                Range_i64 tail = Ii64(token_index_resync, ptr->count);
                 i64 resynced_count = (token_index_resync_guess + 1) - token_index_resync;
                 i64 relexed_count = relex_list.total_count - resynced_count;
-                i64 tail_shift = relexed_count - (token_index_resync - token_index_first);
                 
-                i64 new_tokens_count = ptr->count + tail_shift;
-                Token *new_tokens = base_array(allocator, Token, new_tokens_count);
-                
-                Token *old_tokens = ptr->tokens;
-                block_copy_array_shift(new_tokens, old_tokens, head, 0);
-                token_fill_memory_from_list(new_tokens + replaced.first, &relex_list, relexed_count);
-                for (i64 i = 0, index = replaced.first; i < relexed_count; i += 1, index += 1){
-                    new_tokens[index].pos += relex_range.first;
-                }
-                for (i64 i = tail.first; i < tail.one_past_last; i += 1){
-                    old_tokens[i].pos += text_shift;
-                }
-                block_copy_array_shift(new_tokens, ptr->tokens, tail, tail_shift);
-                
-                base_free(allocator, ptr->tokens);
-                
-                ptr->tokens = new_tokens;
-                ptr->count = new_tokens_count;
-                ptr->max = new_tokens_count;
+                Token_Store new_tokens = token_store_splice(allocator, ptr, replaced, &relex_list, relexed_count,
+                                                            relex_range.first, text_shift);
+                token_store_free(allocator, ptr);
+                *ptr = new_tokens;
                 
                 buffer_mark_as_modified(buffer_id);
             }
@@ -1045,7 +1140,7 @@ BUFFER_EDIT_RANGE_SIG(default_buffer_edit_range){
     
     if (do_full_relex){
         *lex_task_ptr = async_task_no_dep(&global_async_system, do_full_lex_async,
-                                          make_data_struct(&buffer_id));
+                                          make_data_struct(&buffer_id), buffer_async_priority(app, buffer_id));
     }
     
     // no meaning for return
@@ -1058,6 +1153,11 @@ BUFFER_HOOK_SIG(default_end_buffer){
     if (lex_task_ptr != 0){
         async_task_cancel(app, &global_async_system, *lex_task_ptr);
     }
+    Async_Task *parse_task_ptr = scope_attachment(app, scope, buffer_parse_task, Async_Task);
+    if (parse_task_ptr != 0){
+        async_task_cancel(app, &global_async_system, *parse_task_ptr);
+    }
+    trigram_index_end_buffer(app, buffer_id);
     buffer_unmark_as_modified(buffer_id);
     code_index_lock();
     code_index_erase_file(buffer_id);
@@ -1074,6 +1174,15 @@ default_view_change_buffer(Application_Links *app, View_ID view_id,
 	if (prev_buffer_id != 0){
 		*prev_buffer_id = old_buffer_id;
 	}
+    
+    Buffer_ID buffers[2] = {old_buffer_id, new_buffer_id};
+    for (i32 i = 0; i < ArrayCount(buffers); i += 1){
+        Managed_Scope buffer_scope = buffer_get_managed_scope(app, buffers[i]);
+        Async_Task *lex_task_ptr = scope_attachment(app, buffer_scope, buffer_lex_task, Async_Task);
+        if (lex_task_ptr != 0 && *lex_task_ptr != 0){
+            async_task_set_priority(&global_async_system, *lex_task_ptr, buffer_async_priority(app, buffers[i]));
+        }
+    }
 }
 
 internal void
@@ -42,6 +42,7 @@
 #include "4coder_delta_rule.h"
 #include "4coder_layout_rule.h"
 #include "4coder_code_index.h"
+#include "4coder_trigram_index.h"
 #include "4coder_draw.h"
 #include "4coder_insertion.h"
 #include "4coder_command_map.h"
@@ -105,6 +106,7 @@
 #include "4coder_delta_rule.cpp"
 #include "4coder_layout_rule.cpp"
 #include "4coder_code_index.cpp"
+#include "4coder_trigram_index.cpp"
 #include "4coder_fancy.cpp"
 #include "4coder_draw.cpp"
 #include "4coder_font_helper.cpp"
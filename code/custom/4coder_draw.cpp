@@ -565,7 +565,7 @@ draw_cpp_token_colors(Application_Links *app, Text_Layout_ID text_layout_id, Tok
     i64 first_index = token_index_from_pos(array, visible_range.first);
     Token_Iterator_Array it = token_iterator_index(0, array, first_index);
     for (;;){
-        Token *token = token_it_read(&it);
+        Token *token = token_it_current(&it);
         if (token->pos >= visible_range.one_past_last){
             break;
         }
@@ -584,7 +584,7 @@ draw_whitespace_highlight(Application_Links *app, Text_Layout_ID text_layout_id,
     i64 first_index = token_index_from_pos(array, visible_range.first);
     Token_Iterator_Array it = token_iterator_index(0, array, first_index);
     for (;;){
-        Token *token = token_it_read(&it);
+        Token *token = token_it_current(&it);
         if (token->pos >= visible_range.one_past_last){
             break;
         }
@@ -632,7 +632,7 @@ draw_comment_highlights(Application_Links *app, Buffer_ID buffer, Text_Layout_ID
     Token_Iterator_Array it = token_iterator_index(buffer, array, first_index);
     for (;;){
         Temp_Memory_Block temp(scratch);
-        Token *token = token_it_read(&it);
+        Token *token = token_it_current(&it);
         if (token->pos >= visible_range.one_past_last){
             break;
         }
@@ -761,15 +761,15 @@ function void
 draw_paren_highlight(Application_Links *app, Buffer_ID buffer, Text_Layout_ID text_layout_id,
                      i64 pos, ARGB_Color *colors, i32 color_count){
     Token_Array token_array = get_token_array_from_buffer(app, buffer);
-    if (token_array.tokens != 0){
+    if (token_array.count > 0){
         Token_Iterator_Array it = token_iterator_pos(0, &token_array, pos);
-        Token *token = token_it_read(&it);
+        Token *token = token_it_current(&it);
         if (token != 0 && token->kind == TokenBaseKind_ParentheticalOpen){
             pos = token->pos + token->size;
         }
         else{
             if (token_it_dec_all(&it)){
-                token = token_it_read(&it);
+                token = token_it_current(&it);
                 if (token->kind == TokenBaseKind_ParentheticalClose &&
                     pos == token->pos + token->size){
                     pos = token->pos;
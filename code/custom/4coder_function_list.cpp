@@ -16,7 +16,7 @@ get_function_positions(Application_Links *app, Buffer_ID buffer, i64 first_token
     Get_Positions_Results result = {};
     
     Token_Array array = get_token_array_from_buffer(app, buffer);
-    if (array.tokens != 0){
+    if (array.count > 0){
         Token_Iterator_Array it = token_iterator_index(buffer, &array, first_token_index);
         
         i32 nest_level = 0;
@@ -35,7 +35,7 @@ get_function_positions(Application_Links *app, Buffer_ID buffer, i64 first_token
         first_paren_position = 0;
         last_paren_index = 0;
         for (;;){
-            Token *token = token_it_read(&it);
+            Token *token = token_it_current(&it);
             if (!HasFlag(token->flags, TokenBaseFlag_PreprocessorBody)){
                 switch (token->sub_kind){
                     case TokenCppKind_BraceOp:
@@ -70,7 +70,7 @@ get_function_positions(Application_Links *app, Buffer_ID buffer, i64 first_token
         paren_mode1:
         paren_nest_level = 0;
         for (;;){
-            Token *token = token_it_read(&it);
+            Token *token = token_it_current(&it);
             if (!HasFlag(token->flags, TokenBaseFlag_PreprocessorBody)){
                 switch (token->sub_kind){
                     case TokenCppKind_ParenOp:
@@ -100,7 +100,7 @@ get_function_positions(Application_Links *app, Buffer_ID buffer, i64 first_token
             it = first_paren_it;
             i64 signature_start_index = 0;
             for (;;){
-                Token *token = token_it_read(&it);
+                Token *token = token_it_current(&it);
                 if (HasFlag(token->flags, TokenBaseFlag_PreprocessorBody) ||
                     token->sub_kind == TokenCppKind_BraceCl ||
                     token->sub_kind == TokenCppKind_Semicolon ||
@@ -163,13 +163,13 @@ print_positions_buffered(Application_Links *app, Buffer_Insertion *out, Buffer_I
         Assert(end_index > start_index);
         
         Token_Array array = get_token_array_from_buffer(app, buffer);
-        if (array.tokens != 0){
+        if (array.count > 0){
             insertf(out, "%.*s:%lld: ", string_expand(buffer_name), line_number);
             
             Token prev_token = {};
             Token_Iterator_Array it = token_iterator_index(buffer, &array, start_index);
             for (;;){
-                Token *token = token_it_read(&it);
+                Token *token = token_it_current(&it);
                 if (!HasFlag(token->flags, TokenBaseFlag_PreprocessorBody) &&
                     token->kind != TokenBaseKind_Comment &&
                     token->kind != TokenBaseKind_Whitespace){
@@ -238,7 +238,7 @@ list_all_functions(Application_Links *app, Buffer_ID optional_target_buffer){
         }
         
         Token_Array array = get_token_array_from_buffer(app, buffer);
-        if (array.tokens != 0){
+        if (array.count > 0){
             i64 token_index = 0;
             b32 still_looping = false;
             do{
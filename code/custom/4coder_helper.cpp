@@ -54,9 +54,9 @@ get_token_array_from_buffer(Application_Links *app, Buffer_ID buffer){
     if (lex_task_ptr != 0){
         async_task_wait(app, &global_async_system, *lex_task_ptr);
     }
-    Token_Array *ptr = scope_attachment(app, scope, attachment_tokens, Token_Array);
+    Token_Store *ptr = scope_attachment(app, scope, attachment_tokens, Token_Store);
     if (ptr != 0){
-        result = *ptr;
+        result = token_array_from_store(ptr);
     }
     return(result);
 }
@@ -432,10 +432,10 @@ get_line_end_pos_from_pos(Application_Links *app, Buffer_ID buffer, i64 pos){
     return(get_line_side_pos_from_pos(app, buffer, pos, Side_Max));
 }
 
-function Token*
+function Token
 get_first_token_from_line(Application_Links *app, Buffer_ID buffer, Token_Array tokens, i64 line){
     i64 line_start = get_line_start_pos(app, buffer, line);
-    return(token_from_pos(&tokens, line_start));
+    return(token_array_read(&tokens, token_index_from_pos(&tokens, line_start)));
 }
 
 ////////////////////////////////
@@ -616,7 +616,7 @@ function i64
 boundary_token(Application_Links *app, Buffer_ID buffer, Side side, Scan_Direction direction, i64 pos){
     i64 result = boundary_non_whitespace(app, buffer, side, direction, pos);
     Token_Array tokens = get_token_array_from_buffer(app, buffer);
-    if (tokens.tokens != 0){
+    if (tokens.count > 0){
         switch (direction){
             case Scan_Forward:
             {
@@ -624,10 +624,10 @@ boundary_token(Application_Links *app, Buffer_ID buffer, Side side, Scan_Directi
                 result = buffer_size;
                 if (tokens.count > 0){
                     Token_Iterator_Array it = token_iterator_pos(0, &tokens, pos);
-                    Token *token = token_it_read(&it);
+                    Token *token = token_it_current(&it);
                     if (token->kind == TokenBaseKind_Whitespace){
                         token_it_inc_non_whitespace(&it);
-                        token = token_it_read(&it);
+                        token = token_it_current(&it);
                     }
                     if (token != 0){
                         if (side == Side_Max){
@@ -636,7 +636,7 @@ boundary_token(Application_Links *app, Buffer_ID buffer, Side side, Scan_Directi
                         else{
                             if (token->pos <= pos){
                                 token_it_inc_non_whitespace(&it);
-                                token = token_it_read(&it);
+                                token = token_it_current(&it);
                             }
                             if (token != 0){
                                 result = token->pos;
@@ -651,23 +651,23 @@ boundary_token(Application_Links *app, Buffer_ID buffer, Side side, Scan_Directi
                 result = 0;
                 if (tokens.count > 0){
                     Token_Iterator_Array it = token_iterator_pos(0, &tokens, pos);
-                    Token *token = token_it_read(&it);
+                    Token *token = token_it_current(&it);
                     if (token->kind == TokenBaseKind_Whitespace){
                         token_it_dec_non_whitespace(&it);
-                        token = token_it_read(&it);
+                        token = token_it_current(&it);
                     }
                     if (token != 0){
                         if (side == Side_Min){
                             if (token->pos >= pos){
                                 token_it_dec_non_whitespace(&it);
-                                token = token_it_read(&it);
+                                token = token_it_current(&it);
                             }
                             result = token->pos;
                         }
                         else{
                             if (token->pos + token->size >= pos){
                                 token_it_dec_non_whitespace(&it);
-                                token = token_it_read(&it);
+                                token = token_it_current(&it);
                             }
                             result = token->pos + token->size;
                         }
@@ -1044,6 +1044,28 @@ push_whole_buffer(Application_Links *app, Arena *arena, Buffer_ID buffer){
     return(push_buffer_range(app, arena, buffer, buffer_range(app, buffer)));
 }
 
+function String_Const_u8
+push_snapshot_range(Application_Links *app, Arena *arena, Buffer_Snapshot *snapshot, Range_i64 range){
+    String_Const_u8 result = {};
+    i64 length = range_size(range);
+    if (length > 0){
+        Temp_Memory restore_point = begin_temp(arena);
+        u8 *memory = push_array(arena, u8, length);
+        if (buffer_snapshot_read_range(app, snapshot, range, memory)){
+            result = SCu8(memory, length);
+        }
+        else{
+            end_temp(restore_point);
+        }
+    }
+    return(result);
+}
+
+function String_Const_u8
+push_whole_snapshot(Application_Links *app, Arena *arena, Buffer_Snapshot *snapshot){
+    return(push_snapshot_range(app, arena, snapshot, Ii64(0, buffer_snapshot_size(app, snapshot))));
+}
+
 function String_Const_u8
 push_view_range_string(Application_Links *app, Arena *arena, View_ID view){
     Buffer_ID buffer = view_get_buffer(app, view, Access_ReadVisible);
@@ -1067,7 +1089,7 @@ push_enclose_range_at_pos(Application_Links *app, Arena *arena, Buffer_ID buffer
 function String_Const_u8
 token_it_lexeme(Application_Links *app, Arena *arena, Token_Iterator_Array *it){
     String_Const_u8 result = {};
-    Token *token = token_it_read(it);
+    Token *token = token_it_current(it);
     if (token != 0){
         result = push_token_lexeme(app, arena, (Buffer_ID)it->user_id, token);
     }
@@ -1076,7 +1098,7 @@ token_it_lexeme(Application_Links *app, Arena *arena, Token_Iterator_Array *it){
 
 function b32
 token_it_check_and_get_lexeme(Application_Links *app, Arena *arena, Token_Iterator_Array *it, Token_Base_Kind kind, String_Const_u8 *lexeme_out){
-    Token *token = token_it_read(it);
+    Token *token = token_it_current(it);
     b32 result = {};
     if (token != 0 && token->kind == kind){
         result = true;
@@ -1384,27 +1406,109 @@ clear_buffer(Application_Links *app, Buffer_ID buffer){
 
 function String_Match_List
 find_all_matches_all_buffers(Application_Links *app, Arena *arena, String_Const_u8_Array match_patterns, String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags){
-    String_Match_List all_matches = {};
+    Scratch_Block scratch(app, arena);
+    i32 buffer_count = 0;
+    for (Buffer_ID buffer = get_buffer_next(app, 0, Access_Always);
+         buffer != 0;
+         buffer = get_buffer_next(app, buffer, Access_Always)){
+        buffer_count += 1;
+    }
+    Buffer_ID *buffers = push_array(scratch, Buffer_ID, buffer_count);
+    i32 counter = 0;
     for (Buffer_ID buffer = get_buffer_next(app, 0, Access_Always);
          buffer != 0;
          buffer = get_buffer_next(app, buffer, Access_Always)){
+        buffers[counter] = buffer;
+        counter += 1;
+    }
+    
+    // NOTE: With the trigram index on, buffers it rules out for every pattern are
+    // skipped, large buffers are searched only in their candidate ranges, and the rest
+    // are searched whole on the worker threads.  A buffer whose index is still being
+    // built on the async workers is searched whole.
+    b32 use_index = def_get_config_b32(vars_save_string_lit("search_trigram_index"));
+    Range_i64_Array **candidate_ranges = push_array_zero(scratch, Range_i64_Array*, buffer_count);
+    b8 *skip_buffer = push_array_zero(scratch, b8, buffer_count);
+    Buffer_ID *whole_buffers = push_array(scratch, Buffer_ID, buffer_count);
+    i32 whole_count = 0;
+    for (i32 i = 0; i < buffer_count; i += 1){
+        Trigram_Index *index = 0;
+        if (use_index){
+            index = trigram_index_get(app, buffers[i]);
+        }
+        if (index == 0){
+            whole_buffers[whole_count] = buffers[i];
+            whole_count += 1;
+        }
+        else{
+            Range_i64_Array *ranges = push_array(scratch, Range_i64_Array, match_patterns.count);
+            b32 has_candidates = false;
+            for (i32 j = 0; j < match_patterns.count; j += 1){
+                ranges[j] = trigram_index_candidate_ranges(scratch, index, match_patterns.vals[j]);
+                has_candidates = (has_candidates || ranges[j].count > 0);
+            }
+            if (!has_candidates){
+                skip_buffer[i] = true;
+            }
+            else if (buffer_get_size(app, buffers[i]) >= TRIGRAM_REGION_SEARCH_MIN_SIZE){
+                candidate_ranges[i] = ranges;
+            }
+            else{
+                whole_buffers[whole_count] = buffers[i];
+                whole_count += 1;
+            }
+        }
+    }
+    
+    i32 thread_count = (i32)def_get_config_u64(app, vars_save_string_lit("search_thread_count"));
+    String_Match_List whole_matches = buffer_find_all_matches_parallel(app, arena, whole_buffers, whole_count, match_patterns,
+                                                                       &character_predicate_alpha_numeric_underscore_utf8,
+                                                                       must_have_flags, must_not_have_flags, thread_count);
+    
+    String_Match_List all_matches = {};
+    String_Match *whole_node = whole_matches.first;
+    for (i32 i = 0; i < buffer_count; i += 1){
+        if (skip_buffer[i]){
+            continue;
+        }
+        Buffer_ID buffer = buffers[i];
         String_Match_List buffer_matches = {};
-        for (i32 i = 0; i < match_patterns.count; i += 1){
-            Range_i64 range = buffer_range(app, buffer);
-            String_Match_List pattern_matches = buffer_find_all_matches(app, arena, buffer, i, range, match_patterns.vals[i],
-                                                                        &character_predicate_alpha_numeric_underscore_utf8, Scan_Forward);
-            string_match_list_filter_flags(&pattern_matches, must_have_flags, must_not_have_flags);
-            if (pattern_matches.count > 0){
-                if (buffer_matches.count == 0){
-                    buffer_matches = pattern_matches;
+        if (candidate_ranges[i] == 0){
+            for (;whole_node != 0 && whole_node->buffer == buffer;){
+                String_Match *next = whole_node->next;
+                whole_node->next = 0;
+                sll_queue_push(buffer_matches.first, buffer_matches.last, whole_node);
+                buffer_matches.count += 1;
+                whole_node = next;
+            }
+        }
+        else{
+            for (i32 j = 0; j < match_patterns.count; j += 1){
+                Range_i64_Array ranges = candidate_ranges[i][j];
+                String_Match_List pattern_matches = {};
+                for (i32 k = 0; k < ranges.count; k += 1){
+                    String_Match_List range_matches = buffer_find_all_matches(app, arena, buffer, j, ranges.ranges[k], match_patterns.vals[j],
+                                                                              &character_predicate_alpha_numeric_underscore_utf8, Scan_Forward);
+                    pattern_matches = string_match_list_join(&pattern_matches, &range_matches);
                 }
-                else{
-                    buffer_matches = string_match_list_merge_front_to_back(&buffer_matches, &pattern_matches);
+                string_match_list_filter_flags(&pattern_matches, must_have_flags, must_not_have_flags);
+                if (pattern_matches.count > 0){
+                    if (buffer_matches.count == 0){
+                        buffer_matches = pattern_matches;
+                    }
+                    else{
+                        buffer_matches = string_match_list_merge_front_to_back(&buffer_matches, &pattern_matches);
+                    }
                 }
             }
         }
         all_matches = string_match_list_join(&all_matches, &buffer_matches);
     }
+    
+    if (use_index){
+        trigram_index_save(app);
+    }
+    
     return(all_matches);
 }
 
@@ -1964,17 +2068,12 @@ get_query_string(Application_Links *app, char *query_str, u8 *string_space, i32
     return(bar.string);
 }
 
-function Token*
+function Token
 get_token_from_pos(Application_Links *app, Token_Array *array, u64 pos){
-    Token *result = 0;
-    if (array->count > 0){
-        i64 index = token_index_from_pos(array, pos);
-        result = array->tokens + index;
-    }
-    return(result);
+    return(token_array_read(array, token_index_from_pos(array, pos)));
 }
 
-function Token*
+function Token
 get_token_from_pos(Application_Links *app, Buffer_ID buffer, u64 pos){
     Token_Array array = get_token_array_from_buffer(app, buffer);
     return(get_token_from_pos(app, &array, pos));
@@ -1983,9 +2082,10 @@ get_token_from_pos(Application_Links *app, Buffer_ID buffer, u64 pos){
 function String_Const_u8
 push_token_or_word_under_pos(Application_Links *app, Arena *arena, Buffer_ID buffer, u64 pos){
     String_Const_u8 result = {};
-    Token *token = get_token_from_pos(app, buffer, pos);
-    if (token != 0 && token->size > 0 && token->kind != TokenBaseKind_Whitespace){
-        Range_i64 range = Ii64(token);
+    Token_Array array = get_token_array_from_buffer(app, buffer);
+    Token token = token_array_read(&array, token_index_from_pos(&array, pos));
+    if (token.size > 0 && token.kind != TokenBaseKind_Whitespace){
+        Range_i64 range = Ii64(&token);
         result = push_buffer_range(app, arena, buffer, range);
     }
     return(result);
@@ -2367,12 +2467,13 @@ find_nest_side(Application_Links *app, Buffer_ID buffer, i64 pos,
     }
     
     Managed_Scope scope = buffer_get_managed_scope(app, buffer);
-    Token_Array *tokens = scope_attachment(app, scope, attachment_tokens, Token_Array);
-    if (tokens != 0 && tokens->count > 0){
-        Token_Iterator_Array it = token_iterator_pos(0, tokens, pos);
+    Token_Store *store = scope_attachment(app, scope, attachment_tokens, Token_Store);
+    if (store != 0 && store->count > 0){
+        Token_Array tokens = token_array_from_store(store);
+        Token_Iterator_Array it = token_iterator_pos(0, &tokens, pos);
         i32 level = 0;
         for (;;){
-            Token *token = token_it_read(&it);
+            Token *token = token_it_current(&it);
             Nest_Delimiter_Kind token_delim = get_nest_delimiter_kind(token->kind, flags);
             
             if (level == 0 && token_delim == delim){
@@ -46,6 +46,25 @@ prj_get_standard_blacklist(Arena *arena){
     return(prj_pattern_list_from_extension_array(arena, black_array));
 }
 
+function Prj_Pattern_List
+prj_pattern_list_copy(Arena *arena, Prj_Pattern_List list){
+    Prj_Pattern_List result = {};
+    for (Prj_Pattern_Node *src = list.first;
+         src != 0;
+         src = src->next){
+        Prj_Pattern_Node *node = push_array_zero(arena, Prj_Pattern_Node, 1);
+        sll_queue_push(result.first, result.last, node);
+        result.count += 1;
+        
+        for (String8Node *str = src->pattern.absolutes.first;
+             str != 0;
+             str = str->next){
+            string_list_push(arena, &node->pattern.absolutes, push_string_copy(arena, str->string));
+        }
+    }
+    return(result);
+}
+
 function b32
 prj_match_in_pattern_list(String8 string, Prj_Pattern_List list){
     b32 found_match = false;
@@ -108,40 +127,121 @@ prj_close_files_with_ext(Application_Links *app, String8Array extension_array){
     }while(do_repeat);
 }
 
+function void prj_load_dir_async(Async_Context *actx, String_Const_u8 data);
+
 function void
-prj_open_files_pattern_filter__rec(Application_Links *app, String8 path, Prj_Pattern_List whitelist, Prj_Pattern_List blacklist, Prj_Open_File_Flags flags){
-    Scratch_Block scratch(app);
+prj_loader_push_dir(Prj_Loader *loader, String8 path){
+    u8 data[KB(4)];
+    u64 size = sizeof(loader) + path.size;
+    if (size <= sizeof(data)){
+        block_copy(data, &loader, sizeof(loader));
+        block_copy(data + sizeof(loader), path.str, path.size);
+        system_mutex_acquire(loader->mutex);
+        loader->pending_dir_count += 1;
+        system_mutex_release(loader->mutex);
+        async_task_no_dep(&global_async_system, prj_load_dir_async, SCu8(data, size), AsyncPriority_High);
+    }
+}
+
+function Prj_Load_Batch*
+prj_loader_new_batch(void){
+    Arena arena = make_arena_system(KB(64));
+    Prj_Load_Batch *batch = push_array_zero(&arena, Prj_Load_Batch, 1);
+    batch->arena = arena;
+    return(batch);
+}
+
+function void
+prj_loader_push_batch(Prj_Loader *loader, Prj_Load_Batch *batch){
+    system_mutex_acquire(loader->mutex);
+    sll_queue_push(loader->first_batch, loader->last_batch, batch);
+    loader->in_flight_size += batch->size;
+    system_mutex_release(loader->mutex);
+}
+
+function void
+prj_load_dir_async(Async_Context *actx, String_Const_u8 data){
+    Prj_Loader *loader = 0;
+    block_copy(&loader, data.str, sizeof(loader));
+    String8 path = SCu8(data.str + sizeof(loader), data.size - sizeof(loader));
+    Scratch_Block scratch(actx->app);
+    
+    // NOTE: Hold off reading more until the caller catches up, then pass the
+    // wake up along in case there is room for other waiting directories too.
+    system_mutex_acquire(loader->mutex);
+    for (;loader->in_flight_size >= PRJ_LOAD_MAX_IN_FLIGHT;){
+        system_condition_variable_wait(loader->space_cv, loader->mutex);
+    }
+    system_condition_variable_signal(loader->space_cv);
+    system_mutex_release(loader->mutex);
     
-    ProfileScopeNamed(app, "get file list", profile_get_file_list);
     File_List list = system_get_file_list(scratch, path);
-    ProfileCloseNow(profile_get_file_list);
+    Prj_Load_Batch *batch = 0;
     
     File_Info **info = list.infos;
     for (u32 i = 0; i < list.count; ++i, ++info){
         String8 file_name = (**info).file_name;
         if (HasFlag((**info).attributes.flags, FileAttribute_IsDirectory)){
-            if ((flags & PrjOpenFileFlag_Recursive) == 0){
+            if ((loader->flags & PrjOpenFileFlag_Recursive) == 0){
                 continue;
             }
-            if (prj_match_in_pattern_list(file_name, blacklist)){
+            if (prj_match_in_pattern_list(file_name, loader->blacklist)){
                 continue;
             }
             String8 new_path = push_u8_stringf(scratch, "%.*s%.*s/", string_expand(path), string_expand(file_name));
-            prj_open_files_pattern_filter__rec(app, new_path, whitelist, blacklist, flags);
+            prj_loader_push_dir(loader, new_path);
         }
         else{
-            if (!prj_match_in_pattern_list(file_name, whitelist)){
+            if (!prj_match_in_pattern_list(file_name, loader->whitelist)){
                 continue;
             }
-            if (prj_match_in_pattern_list(file_name, blacklist)){
+            if (prj_match_in_pattern_list(file_name, loader->blacklist)){
                 continue;
             }
-            String8 full_path = push_u8_stringf(scratch, "%.*s%.*s", string_expand(path), string_expand(file_name));
-            create_buffer(app, full_path, 0);
+            
+            if (batch == 0){
+                batch = prj_loader_new_batch();
+            }
+            Prj_Load_File *file = push_array_zero(&batch->arena, Prj_Load_File, 1);
+            sll_queue_push(batch->first, batch->last, file);
+            batch->count += 1;
+            file->file_name = push_u8_stringf(&batch->arena, "%.*s%.*s", string_expand(path), string_expand(file_name));
+            
+            // NOTE: A file that can't be read here is still handed to create_buffer
+            // so it fails or succeeds the same way it would without the loader.
+            Plat_Handle handle = {};
+            if (system_load_handle(scratch, (char*)file->file_name.str, &handle)){
+                File_Attributes attributes = system_load_attributes(handle);
+                u8 *memory = push_array(&batch->arena, u8, attributes.size);
+                if (system_load_file(handle, (char*)memory, attributes.size)){
+                    file->data = SCu8(memory, attributes.size);
+                    file->attributes = attributes;
+                    file->is_loaded = true;
+                    batch->size += attributes.size;
+                }
+                system_load_close(handle);
+            }
+            
+            if (batch->count >= PRJ_LOAD_BATCH_MAX_COUNT || batch->size >= PRJ_LOAD_BATCH_MAX_SIZE){
+                prj_loader_push_batch(loader, batch);
+                batch = 0;
+            }
         }
     }
+    
+    if (batch != 0){
+        prj_loader_push_batch(loader, batch);
+    }
+    
+    system_mutex_acquire(loader->mutex);
+    loader->pending_dir_count -= 1;
+    system_mutex_release(loader->mutex);
 }
 
+global Prj_Loader *prj_first_loader = 0;
+global Prj_Loader *prj_last_loader = 0;
+global Tick_Function *prj_load_next_tick = 0;
+
 function void
 prj_open_files_pattern_filter(Application_Links *app, String8 dir, Prj_Pattern_List whitelist, Prj_Pattern_List blacklist, Prj_Open_File_Flags flags){
     ProfileScope(app, "open all files in directory pattern");
@@ -150,7 +250,128 @@ prj_open_files_pattern_filter(Application_Links *app, String8 dir, Prj_Pattern_L
     if (!character_is_slash(string_get_character(directory, directory.size - 1))){
         directory = push_u8_stringf(scratch, "%.*s/", string_expand(dir));
     }
-    prj_open_files_pattern_filter__rec(app, directory, whitelist, blacklist, flags);
+    
+    // NOTE: The loader outlives this call, the buffers are created from
+    // prj_load_tick so the frame never waits on the workers.
+    Arena arena = make_arena_system(KB(4));
+    Prj_Loader *loader = push_array_zero(&arena, Prj_Loader, 1);
+    loader->arena = arena;
+    loader->mutex = system_mutex_make();
+    loader->space_cv = system_condition_variable_make();
+    loader->whitelist = prj_pattern_list_copy(&loader->arena, whitelist);
+    loader->blacklist = prj_pattern_list_copy(&loader->arena, blacklist);
+    loader->flags = flags;
+    sll_queue_push(prj_first_loader, prj_last_loader, loader);
+    prj_loader_push_dir(loader, directory);
+    
+    // NOTE: Until the batches are drained the workers wait on space_cv, so the
+    // drain can't depend on the tick hook remembering to call it.
+    Tick_Function *tick = (Tick_Function*)get_custom_hook(app, HookID_Tick);
+    if (tick != prj_load_tick){
+        prj_load_next_tick = tick;
+        set_custom_hook(app, HookID_Tick, prj_load_tick);
+    }
+    
+    animate_in_n_milliseconds(app, 0);
+}
+
+function b32
+prj_loader_update(Application_Links *app, Prj_Loader *loader, u64 end_time){
+    b32 finished = false;
+    for (;;){
+        Prj_Load_Batch *batch = loader->current_batch;
+        if (batch == 0){
+            system_mutex_acquire(loader->mutex);
+            batch = loader->first_batch;
+            if (batch != 0){
+                sll_queue_pop(loader->first_batch, loader->last_batch);
+            }
+            else if (loader->pending_dir_count == 0){
+                finished = true;
+            }
+            system_mutex_release(loader->mutex);
+            if (batch == 0){
+                break;
+            }
+            loader->current_batch = batch;
+        }
+        
+        ProfileScope(app, "create loaded buffers");
+        b32 out_of_time = false;
+        for (;batch->first != 0 && !out_of_time;){
+            Prj_Load_File *file = batch->first;
+            batch->first = file->next;
+            if (file->is_loaded){
+                create_buffer_from_data(app, file->file_name, file->data, file->attributes, 0);
+            }
+            else{
+                create_buffer(app, file->file_name, 0);
+            }
+            out_of_time = (system_now_time() >= end_time);
+        }
+        
+        if (batch->first == 0){
+            loader->current_batch = 0;
+            u64 size = batch->size;
+            Arena batch_arena = batch->arena;
+            linalloc_clear(&batch_arena);
+            
+            system_mutex_acquire(loader->mutex);
+            loader->in_flight_size -= size;
+            system_condition_variable_signal(loader->space_cv);
+            system_mutex_release(loader->mutex);
+        }
+        
+        if (out_of_time){
+            break;
+        }
+    }
+    return(finished);
+}
+
+function b32
+prj_load_update_tick(Application_Links *app){
+    if (prj_first_loader == 0){
+        return(false);
+    }
+    ProfileScope(app, "project load tick");
+    u64 end_time = system_now_time() + PRJ_LOAD_TICK_MAX_TIME;
+    Prj_Loader *first = 0;
+    Prj_Loader *last = 0;
+    for (Prj_Loader *loader = prj_first_loader, *next = 0;
+         loader != 0;
+         loader = next){
+        next = loader->next;
+        if (prj_loader_update(app, loader, end_time)){
+            // NOTE: No directories are pending and every batch is taken, so
+            // no worker can touch the loader anymore.
+            system_condition_variable_free(loader->space_cv);
+            system_mutex_free(loader->mutex);
+            Arena arena = loader->arena;
+            linalloc_clear(&arena);
+        }
+        else{
+            sll_queue_push(first, last, loader);
+        }
+    }
+    prj_first_loader = first;
+    prj_last_loader = last;
+    return(first != 0);
+}
+
+function void
+prj_load_tick(Application_Links *app, Frame_Info frame_info){
+    Tick_Function *next_tick = prj_load_next_tick;
+    if (prj_load_update_tick(app)){
+        animate_in_n_milliseconds(app, 0);
+    }
+    else{
+        set_custom_hook(app, HookID_Tick, next_tick);
+        prj_load_next_tick = 0;
+    }
+    if (next_tick != 0){
+        next_tick(app, frame_info);
+    }
 }
 
 function void
@@ -969,6 +1190,11 @@ CUSTOM_DOC("Looks for a project.4coder file in the current directory and tries t
         String8 title = push_u8_stringf(scratch, "4coder project: %.*s", string_expand(proj_name));
         set_window_title(app, title);
     }
+    
+    // NOTE: Pick up the search index saved for this project
+    if (dump.data.str != 0){
+        trigram_index_set_project(app, project_root);
+    }
 }
 
 CUSTOM_COMMAND_SIG(project_fkey_command)
@@ -30,6 +30,55 @@ enum{
     PrjOpenFileFlag_Recursive = 1,
 };
 
+////////////////////////////////
+// NOTE: Directory Loading Types
+
+// NOTE: Opening a directory tree walks directories and reads files on the async
+// workers, prj_load_tick creates the buffers as the batches come in and stops for the
+// frame once PRJ_LOAD_TICK_MAX_TIME microseconds are used up.  prj_load_tick puts
+// itself in front of the tick hook while anything is loading, calls the hook it
+// replaced every frame, and puts that hook back when the last directory is done.  A
+// tick hook set in the middle of a load replaces prj_load_tick, so it has to call
+// prj_load_update_tick itself until the load is done.
+// Batches that are read but not created yet are capped at PRJ_LOAD_MAX_IN_FLIGHT bytes.
+#define PRJ_LOAD_BATCH_MAX_COUNT 64
+#define PRJ_LOAD_BATCH_MAX_SIZE MB(4)
+#define PRJ_LOAD_MAX_IN_FLIGHT MB(64)
+#define PRJ_LOAD_TICK_MAX_TIME 8000
+
+struct Prj_Load_File{
+    Prj_Load_File *next;
+    String8 file_name;
+    String8 data;
+    File_Attributes attributes;
+    b32 is_loaded;
+};
+
+struct Prj_Load_Batch{
+    Prj_Load_Batch *next;
+    Arena arena;
+    Prj_Load_File *first;
+    Prj_Load_File *last;
+    i32 count;
+    u64 size;
+};
+
+struct Prj_Loader{
+    Prj_Loader *next;
+    Arena arena;
+    System_Mutex mutex;
+    System_Condition_Variable space_cv;
+    Prj_Pattern_List whitelist;
+    Prj_Pattern_List blacklist;
+    Prj_Open_File_Flags flags;
+    i32 pending_dir_count;
+    u64 in_flight_size;
+    Prj_Load_Batch *first_batch;
+    Prj_Load_Batch *last_batch;
+    // NOTE: The batch the tick is part way through, it is not shared with the workers.
+    Prj_Load_Batch *current_batch;
+};
+
 ///////////////////////////////
 // NOTE(allen): Project Files
 
@@ -61,12 +110,15 @@ enum{
 function Prj_Pattern_List prj_pattern_list_from_extension_array(Arena *arena, String8Array list);
 function Prj_Pattern_List prj_pattern_list_from_var(Arena *arena, Variable_Handle var);
 function Prj_Pattern_List prj_get_standard_blacklist(Arena *arena);
+function Prj_Pattern_List prj_pattern_list_copy(Arena *arena, Prj_Pattern_List list);
 
 function b32  prj_match_in_pattern_list(String8 string, Prj_Pattern_List list);
 
 function void prj_close_files_with_ext(Application_Links *app, String8Array extension_array);
 function void prj_open_files_pattern_filter(Application_Links *app, String8 dir, Prj_Pattern_List whitelist, Prj_Pattern_List blacklist, Prj_Open_File_Flags flags);
 function void prj_open_all_files_with_ext_in_hot(Application_Links *app, String8Array array, Prj_Open_File_Flags flags);
+function b32  prj_load_update_tick(Application_Links *app);
+function void prj_load_tick(Application_Links *app, Frame_Info frame_info);
 
 ////////////////////////////////
 // NOTE(allen): Project Files
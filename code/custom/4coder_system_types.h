@@ -36,6 +36,18 @@ enum{
     SystemPath_CurrentDirectory,
     SystemPath_Binary,
     SystemPath_UserDirectory,
+    SystemPath_TempDirectory,
+};
+
+// NOTE: The full names of files that may have changed inside watched directories.
+// When lost_changes is set the system dropped events and every watched file has to be
+// checked again.  Only the Linux layer watches directories (with inotify); on Windows
+// and Mac file_watch_add always fails, file_watch_wait only sleeps, and every open
+// file is polled for changes.
+struct File_Watch_Changes{
+    String_Const_u8 *file_names;
+    i32 count;
+    b32 lost_changes;
 };
 
 struct Memory_Annotation_Node{
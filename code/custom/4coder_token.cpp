@@ -75,6 +75,236 @@ token_array_from_list(Arena *arena, Token_List *list){
     return(array);
 }
 
+////////////////////////////////
+
+internal Token_Store
+token_store_make(Base_Allocator *allocator, i64 count){
+    Token_Store store = {};
+    if (count > 0){
+        i64 block_count = (count + TOKEN_STORE_BLOCK_COUNT - 1) >> TOKEN_STORE_BLOCK_COUNT_LOG2;
+        u64 size = (block_count*sizeof(*store.block_pos) +
+                    count*(sizeof(*store.pos) + sizeof(*store.size) +
+                           sizeof(*store.sub_kind) + sizeof(*store.sub_flags) +
+                           sizeof(*store.kind) + sizeof(*store.flags)));
+        String_Const_u8 memory = base_allocate(allocator, size);
+        store.count = count;
+        store.block_count = block_count;
+        store.block_pos = (i64*)memory.str;
+        store.pos = (u32*)(store.block_pos + block_count);
+        store.size = store.pos + count;
+        store.sub_kind = (i16*)(store.size + count);
+        store.sub_flags = (u16*)(store.sub_kind + count);
+        store.kind = (u8*)(store.sub_flags + count);
+        store.flags = store.kind + count;
+    }
+    return(store);
+}
+
+internal void
+token_store_free(Base_Allocator *allocator, Token_Store *store){
+    if (store->block_pos != 0){
+        base_free(allocator, store->block_pos);
+    }
+    block_zero_struct(store);
+}
+
+// NOTE: Tokens have to be written in order, the first token of a block sets the
+// position the rest of the block is relative to.
+internal void
+token_store_write(Token_Store *store, i64 index, Token *token){
+    i64 block_index = (index >> TOKEN_STORE_BLOCK_COUNT_LOG2);
+    if ((index & (TOKEN_STORE_BLOCK_COUNT - 1)) == 0){
+        store->block_pos[block_index] = token->pos;
+    }
+    i64 relative_pos = token->pos - store->block_pos[block_index];
+    Assert(0 <= relative_pos && relative_pos <= (i64)max_u32);
+    Assert(0 <= token->size && token->size <= (i64)max_u32);
+    Assert(token->flags <= max_u8);
+    store->pos[index] = (u32)relative_pos;
+    store->size[index] = (u32)token->size;
+    store->sub_kind[index] = token->sub_kind;
+    store->sub_flags[index] = token->sub_flags;
+    store->kind[index] = (u8)token->kind;
+    store->flags[index] = (u8)token->flags;
+}
+
+internal Token
+token_store_read(Token_Store *store, i64 index){
+    Token token = {};
+    i64 block_index = (index >> TOKEN_STORE_BLOCK_COUNT_LOG2);
+    token.pos = store->block_pos[block_index] + store->pos[index];
+    token.size = store->size[index];
+    token.kind = store->kind[index];
+    token.flags = store->flags[index];
+    token.sub_kind = store->sub_kind[index];
+    token.sub_flags = store->sub_flags[index];
+    return(token);
+}
+
+internal void
+token_store_fill_from_list(Token_Store *store, i64 first_index, Token_List *list, i64 count, i64 pos_shift){
+    i64 index = first_index;
+    for (Token_Block *node = list->first;
+         node != 0 && count > 0;
+         node = node->next){
+        i64 write_count = clamp_top(node->count, count);
+        for (i64 i = 0; i < write_count; i += 1, index += 1){
+            Token token = node->tokens[i];
+            token.pos += pos_shift;
+            token_store_write(store, index, &token);
+        }
+        count -= write_count;
+    }
+}
+
+internal Token_Store
+token_store_from_list(Base_Allocator *allocator, Token_List *list){
+    Token_Store store = token_store_make(allocator, list->total_count);
+    token_store_fill_from_list(&store, 0, list, list->total_count, 0);
+    return(store);
+}
+
+internal void
+token_store__copy_fields(Token_Store *dst, i64 dst_index, Token_Store *src, i64 src_index, i64 count){
+    block_copy_dynamic_array(dst->size + dst_index, src->size + src_index, count);
+    block_copy_dynamic_array(dst->sub_kind + dst_index, src->sub_kind + src_index, count);
+    block_copy_dynamic_array(dst->sub_flags + dst_index, src->sub_flags + src_index, count);
+    block_copy_dynamic_array(dst->kind + dst_index, src->kind + src_index, count);
+    block_copy_dynamic_array(dst->flags + dst_index, src->flags + src_index, count);
+}
+
+// NOTE: Builds a new store out of the tokens of src outside of replaced, the first
+// insert_count tokens of list shifted by insert_shift in place of replaced, and every
+// token after replaced shifted by tail_shift.  The head keeps its blocks so it is copied
+// as it is, only the positions of the tail have to be rebased onto their new blocks.
+internal Token_Store
+token_store_splice(Base_Allocator *allocator, Token_Store *src, Range_i64 replaced,
+                   Token_List *list, i64 insert_count, i64 insert_shift, i64 tail_shift){
+    i64 count = src->count - range_size(replaced) + insert_count;
+    Token_Store store = token_store_make(allocator, count);
+    
+    i64 head_count = replaced.first;
+    i64 head_block_count = (head_count + TOKEN_STORE_BLOCK_COUNT - 1) >> TOKEN_STORE_BLOCK_COUNT_LOG2;
+    block_copy_dynamic_array(store.block_pos, src->block_pos, head_block_count);
+    block_copy_dynamic_array(store.pos, src->pos, head_count);
+    token_store__copy_fields(&store, 0, src, 0, head_count);
+    
+    token_store_fill_from_list(&store, head_count, list, insert_count, insert_shift);
+    
+    i64 tail_first = head_count + insert_count;
+    i64 tail_count = src->count - replaced.one_past_last;
+    token_store__copy_fields(&store, tail_first, src, replaced.one_past_last, tail_count);
+    for (i64 i = 0; i < tail_count; i += 1){
+        i64 src_index = replaced.one_past_last + i;
+        i64 dst_index = tail_first + i;
+        i64 pos = src->block_pos[src_index >> TOKEN_STORE_BLOCK_COUNT_LOG2] + src->pos[src_index] + tail_shift;
+        i64 block_index = (dst_index >> TOKEN_STORE_BLOCK_COUNT_LOG2);
+        if ((dst_index & (TOKEN_STORE_BLOCK_COUNT - 1)) == 0){
+            store.block_pos[block_index] = pos;
+        }
+        store.pos[dst_index] = (u32)(pos - store.block_pos[block_index]);
+    }
+    
+    return(store);
+}
+
+// NOTE: Finds the last token that starts at or before pos.
+internal i64
+token_store_index_from_pos(Token_Store *store, i64 pos){
+    i64 result = 0;
+    if (store->count > 0){
+        i64 *block_pos = store->block_pos;
+        i64 first_block = 0;
+        i64 one_past_last_block = store->block_count;
+        for (;first_block + 1 < one_past_last_block;){
+            i64 mid = (first_block + one_past_last_block) >> 1;
+            if (block_pos[mid] <= pos){
+                first_block = mid;
+            }
+            else{
+                one_past_last_block = mid;
+            }
+        }
+        
+        i64 base_index = (first_block << TOKEN_STORE_BLOCK_COUNT_LOG2);
+        i64 block_count = clamp_top(store->count - base_index, TOKEN_STORE_BLOCK_COUNT);
+        u32 *block = store->pos + base_index;
+        i64 relative_pos = pos - block_pos[first_block];
+        i64 first = 0;
+        if (relative_pos >= 0){
+            u32 relative_pos_u32 = (u32)clamp_top(relative_pos, (i64)max_u32);
+            i64 one_past_last = block_count;
+            for (;first + 1 < one_past_last;){
+                i64 mid = (first + one_past_last) >> 1;
+                if (block[mid] <= relative_pos_u32){
+                    first = mid;
+                }
+                else{
+                    one_past_last = mid;
+                }
+            }
+        }
+        result = base_index + first;
+    }
+    return(result);
+}
+
+internal Token_Array
+token_array_from_store(Token_Store *store){
+    Token_Array array = {};
+    array.count = store->count;
+    array.store = store;
+    return(array);
+}
+
+internal Token
+token_array_read(Token_Array *array, i64 index){
+    Token result = {};
+    if (0 <= index && index < array->count){
+        if (array->store != 0){
+            result = token_store_read(array->store, index);
+        }
+        else{
+            result = array->tokens[index];
+        }
+    }
+    return(result);
+}
+
+internal Token*
+token_array_at(Token_Array *array, i64 index){
+    Token *result = 0;
+    if (0 <= index && index < array->count){
+        if (array->store != 0){
+            array->token = token_store_read(array->store, index);
+            result = &array->token;
+        }
+        else{
+            result = array->tokens + index;
+        }
+    }
+    return(result);
+}
+
+internal Token_Array
+token_array_copy(Arena *arena, Token_Array *array){
+    Token_Array result = {};
+    result.tokens = push_array(arena, Token, array->count);
+    result.count = array->count;
+    result.max = array->count;
+    if (array->store != 0){
+        for (i64 i = 0; i < array->count; i += 1){
+            result.tokens[i] = token_store_read(array->store, i);
+        }
+    }
+    else{
+        block_copy_dynamic_array(result.tokens, array->tokens, array->count);
+    }
+    return(result);
+}
+
+////////////////////////////////
+
 internal i64
 token_index_from_pos(Token *tokens, i64 count, i64 pos){
     i64 result = 0;
@@ -109,7 +339,14 @@ token_index_from_pos(Token *tokens, i64 count, i64 pos){
 
 internal i64
 token_index_from_pos(Token_Array *tokens, u64 pos){
-    return(token_index_from_pos(tokens->tokens, tokens->count, pos));
+    i64 result = 0;
+    if (tokens->store != 0){
+        result = token_store_index_from_pos(tokens->store, (i64)pos);
+    }
+    else{
+        result = token_index_from_pos(tokens->tokens, tokens->count, pos);
+    }
+    return(result);
 }
 
 internal Token*
@@ -120,8 +357,12 @@ token_from_pos(Token *tokens, i64 count, i64 pos){
 
 internal Token*
 token_from_pos(Token_Array *tokens, u64 pos){
-    i64 index = token_index_from_pos(tokens, pos);
-    return(tokens->tokens + index);
+    Token *result = 0;
+    if (tokens->count > 0){
+        i64 index = token_index_from_pos(tokens, pos);
+        result = token_array_at(tokens, index);
+    }
+    return(result);
 }
 
 ////////////////////////////////
@@ -138,9 +379,28 @@ token_iterator_index(u64 user_id, Token *tokens, i64 count, i64 token_index){
     return(it);
 }
 
+internal Token_Iterator_Array
+token_iterator_index(u64 user_id, Token_Store *store, i64 token_index){
+    Token_Iterator_Array it = {};
+    if (store->count > 0){
+        it.user_id = user_id;
+        it.count = store->count;
+        it.store = store;
+        it.index = token_index;
+    }
+    return(it);
+}
+
 internal Token_Iterator_Array
 token_iterator_index(u64 user_id, Token_Array *tokens, i64 token_index){
-    return(token_iterator_index(user_id, tokens->tokens, tokens->count, token_index));
+    Token_Iterator_Array it = {};
+    if (tokens->store != 0){
+        it = token_iterator_index(user_id, tokens->store, token_index);
+    }
+    else{
+        it = token_iterator_index(user_id, tokens->tokens, tokens->count, token_index);
+    }
+    return(it);
 }
 
 internal Token_Iterator_Array
@@ -150,7 +410,14 @@ token_iterator(u64 user_id, Token *tokens, i64 count, Token *token){
 
 internal Token_Iterator_Array
 token_iterator(u64 user_id, Token_Array *tokens, Token *token){
-    return(token_iterator_index(user_id, tokens->tokens, tokens->count, (i64)(token - tokens->tokens)));
+    Token_Iterator_Array it = {};
+    if (tokens->store != 0){
+        it = token_iterator_index(user_id, tokens->store, token_index_from_pos(tokens, token->pos));
+    }
+    else{
+        it = token_iterator_index(user_id, tokens->tokens, tokens->count, (i64)(token - tokens->tokens));
+    }
+    return(it);
 }
 
 internal Token_Iterator_Array
@@ -160,7 +427,7 @@ token_iterator(u64 user_id, Token *tokens, i64 count){
 
 internal Token_Iterator_Array
 token_iterator(u64 user_id, Token_Array *tokens){
-    return(token_iterator_index(user_id, tokens->tokens, tokens->count, 0));
+    return(token_iterator_index(user_id, tokens, 0));
 }
 
 internal Token_Iterator_Array
@@ -171,28 +438,47 @@ token_iterator_pos(u64 user_id, Token *tokens, i64 count, i64 pos){
 
 internal Token_Iterator_Array
 token_iterator_pos(u64 user_id, Token_Array *tokens, i64 pos){
-    i64 index = token_index_from_pos(tokens->tokens, tokens->count, pos);
-    return(token_iterator_index(user_id, tokens->tokens, tokens->count, index));
+    i64 index = token_index_from_pos(tokens, pos);
+    return(token_iterator_index(user_id, tokens, index));
 }
 
 internal Token*
-token_it_read(Token_Iterator_Array *it){
+token_it_current(Token_Iterator_Array *it){
     Token *result = 0;
-    if (it->tokens != 0){
+    if (it->store != 0){
+        it->token = token_store_read(it->store, it->index);
+        result = &it->token;
+    }
+    else if (it->tokens != 0){
         result = it->ptr;
     }
     return(result);
 }
 
+internal Token*
+token_it_read(Token_Iterator_Array *it){
+    return(token_it_current(it));
+}
+
 internal i64
 token_it_index(Token_Iterator_Array *it){
-    return((i64)(it->ptr - it->tokens));
+    i64 result = it->index;
+    if (it->store == 0){
+        result = (i64)(it->ptr - it->tokens);
+    }
+    return(result);
 }
 
 internal b32
 token_it_inc_all(Token_Iterator_Array *it){
     b32 result = false;
-    if (it->tokens != 0){
+    if (it->store != 0){
+        if (it->index < it->count - 1){
+            it->index += 1;
+            result = true;
+        }
+    }
+    else if (it->tokens != 0){
         if (it->ptr < it->tokens + it->count - 1){
             it->ptr += 1;
             result = true;
@@ -204,7 +490,13 @@ token_it_inc_all(Token_Iterator_Array *it){
 internal b32
 token_it_dec_all(Token_Iterator_Array *it){
     b32 result = false;
-    if (it->tokens != 0){
+    if (it->store != 0){
+        if (it->index > 0){
+            it->index -= 1;
+            result = true;
+        }
+    }
+    else if (it->tokens != 0){
         if (it->ptr > it->tokens){
             it->ptr -= 1;
             result = true;
@@ -218,7 +510,7 @@ token_it_inc_non_whitespace(Token_Iterator_Array *it){
     b32 result = false;
     repeat:
     if (token_it_inc_all(it)){
-        Token *token = token_it_read(it);
+        Token *token = token_it_current(it);
         if (token != 0 && token->kind == TokenBaseKind_Whitespace){
             goto repeat;
         }
@@ -232,7 +524,7 @@ token_it_dec_non_whitespace(Token_Iterator_Array *it){
     b32 result = false;
     repeat:
     if (token_it_dec_all(it)){
-        Token *token = token_it_read(it);
+        Token *token = token_it_current(it);
         if (token != 0 && token->kind == TokenBaseKind_Whitespace){
             goto repeat;
         }
@@ -246,7 +538,7 @@ token_it_inc(Token_Iterator_Array *it){
     b32 result = false;
     repeat:
     if (token_it_inc_all(it)){
-        Token *token = token_it_read(it);
+        Token *token = token_it_current(it);
         if (token != 0 && (token->kind == TokenBaseKind_Whitespace ||
                            token->kind == TokenBaseKind_Comment)){
             goto repeat;
@@ -261,7 +553,7 @@ token_it_dec(Token_Iterator_Array *it){
     b32 result = false;
     repeat:
     if (token_it_dec_all(it)){
-        Token *token = token_it_read(it);
+        Token *token = token_it_current(it);
         if (token != 0 && (token->kind == TokenBaseKind_Whitespace ||
                            token->kind == TokenBaseKind_Comment)){
             goto repeat;
@@ -621,7 +913,7 @@ token_relex_first(Token_Array *tokens, i64 edit_range_first, i64 backup_repeats)
     }
     if (good_status){
         for (;;){
-            Token *token = token_it_read(&it);
+            Token *token = token_it_current(&it);
             if (!HasFlag(token->flags, TokenBaseFlag_PreprocessorBody)){
                 break;
             }
@@ -642,7 +934,7 @@ token_relex_resync(Token_Array *tokens, i64 edit_range_first, i64 look_ahead_rep
     }
     if (good_status){
         for (;;){
-            Token *token = token_it_read(&it);
+            Token *token = token_it_current(&it);
             if (!HasFlag(token->flags, TokenBaseFlag_PreprocessorBody)){
                 break;
             }
@@ -655,24 +947,24 @@ token_relex_resync(Token_Array *tokens, i64 edit_range_first, i64 look_ahead_rep
 }
 
 internal Token_Relex
-token_relex(Token_List relex_list, i64 new_pos_to_old_pos_shift, Token *tokens, i64 relex_first, i64 relex_last){
+token_relex(Token_List relex_list, i64 new_pos_to_old_pos_shift, Token_Array *tokens, i64 relex_first, i64 relex_last){
     Token_Relex relex = {};
     if (relex_list.total_count > 0){
-        Token_Array relexed_tokens = {tokens + relex_first, relex_last - relex_first + 1};
         Token_Iterator_List it = token_iterator_index(0, &relex_list, relex_list.total_count - 1);
         for (;;){
             Token *token = token_it_read(&it);
             i64 new_pos_rebased = token->pos + new_pos_to_old_pos_shift;
-            i64 old_token_index = token_index_from_pos(&relexed_tokens, new_pos_rebased);
-            Token *old_token = relexed_tokens.tokens + old_token_index;
-            if (new_pos_rebased == old_token->pos &&
-                token->size == old_token->size &&
-                token->kind == old_token->kind &&
-                token->sub_kind == old_token->sub_kind &&
-                token->flags == old_token->flags &&
-                token->sub_flags == old_token->sub_flags){
+            i64 old_token_index = token_index_from_pos(tokens, new_pos_rebased);
+            old_token_index = clamp(relex_first, old_token_index, relex_last);
+            Token old_token = token_array_read(tokens, old_token_index);
+            if (new_pos_rebased == old_token.pos &&
+                token->size == old_token.size &&
+                token->kind == old_token.kind &&
+                token->sub_kind == old_token.sub_kind &&
+                token->flags == old_token.flags &&
+                token->sub_flags == old_token.sub_flags){
                 relex.successful_resync = true;
-                relex.first_resync_index = relex_first + old_token_index;
+                relex.first_resync_index = old_token_index;
             }
             else{
                 break;
@@ -685,5 +977,11 @@ token_relex(Token_List relex_list, i64 new_pos_to_old_pos_shift, Token *tokens,
     return(relex);
 }
 
+internal Token_Relex
+token_relex(Token_List relex_list, i64 new_pos_to_old_pos_shift, Token *tokens, i64 relex_first, i64 relex_last){
+    Token_Array array = {tokens, relex_last + 1, relex_last + 1};
+    return(token_relex(relex_list, new_pos_to_old_pos_shift, &array, relex_first, relex_last));
+}
+
 // BOTTOM
 
@@ -66,10 +66,39 @@ struct Token_Pair{
     Token b;
 };
 
+// NOTE: A Token_Store holds the same tokens as a Token_Array in 14 bytes a token
+// instead of 24, buffers keep their tokens in one.  Each field is its own array, and the
+// tokens are grouped in blocks of TOKEN_STORE_BLOCK_COUNT that keep the position of
+// their first token, so a token only keeps its position relative to its block.  Finding
+// a position searches the small array of block positions first and then one block.
+// NOTE: There is never a plain copy of a store.  The APIs that hand out Token pointers
+// into a store array (token_from_pos, token_it_read) decode the one token they point at
+// into the array or the iterator, see below.
+#define TOKEN_STORE_BLOCK_COUNT_LOG2 8
+#define TOKEN_STORE_BLOCK_COUNT (1 << TOKEN_STORE_BLOCK_COUNT_LOG2)
+
+struct Token_Store{
+    i64 count;
+    i64 block_count;
+    i64 *block_pos;
+    u32 *pos;
+    u32 *size;
+    i16 *sub_kind;
+    u16 *sub_flags;
+    u8 *kind;
+    u8 *flags;
+};
+
+// NOTE: An array either owns its tokens or reads them out of a store, in which case
+// tokens is null and the helpers read through the store.  token_from_pos on a store
+// array decodes into token, that pointer is only good until the array hands out
+// another one.
 struct Token_Array{
     Token *tokens;
     i64 count;
     i64 max;
+    Token_Store *store;
+    Token token;
 };
 
 struct Token_Block{
@@ -92,11 +121,16 @@ struct Token_Relex{
     i64 first_resync_index;
 };
 
+// NOTE: token_it_current and token_it_read read a store token into the iterator itself,
+// that pointer is only good until the iterator is read again.
 struct Token_Iterator_Array{
     u64 user_id;
     Token *ptr;
     Token *tokens;
     i64 count;
+    Token_Store *store;
+    i64 index;
+    Token token;
 };
 
 struct Token_Iterator_List{
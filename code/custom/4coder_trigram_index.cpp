@@ -0,0 +1,535 @@
+/*
+4coder_trigram_index.cpp - Per buffer trigram filters that narrow searches across buffers.
+*/
+
+// TOP
+
+#define TRIGRAM_INDEX_FILE_MAGIC 0x58444954u
+#define TRIGRAM_INDEX_FILE_VERSION 2
+
+// NOTE: How many blocks the async build fills between checks for cancellation.
+#define TRIGRAM_BUILD_BLOCKS_PER_STEP 64
+
+global Trigram_Index_Cache trigram_index_cache = {};
+
+function u32
+trigram_hash(u8 a, u8 b, u8 c){
+    u32 x = ((u32)character_to_upper(a) |
+             ((u32)character_to_upper(b) << 8) |
+             ((u32)character_to_upper(c) << 16));
+    return((x*2654435761u) >> (32 - TRIGRAM_BLOOM_BITS_LOG2));
+}
+
+function b32
+trigram_bloom_check(Trigram_Block *block, u32 hash){
+    return((block->bloom[hash/64] & (1ull << (hash%64))) != 0);
+}
+
+////////////////////////////////
+
+function i64
+trigram_index__block_count(i64 size){
+    return((size + TRIGRAM_BLOCK_TARGET_SIZE - 1)/TRIGRAM_BLOCK_TARGET_SIZE);
+}
+
+// NOTE: Splits region_size bytes evenly over block_count blocks, the first blocks take
+// the remainder.  text starts at region_start and holds up to two bytes past the region,
+// so the trigrams that start on the last two bytes of a block are counted too.  Filling a
+// run of blocks with the part of the region they cover gives the same blocks as filling
+// the whole region at once.
+function void
+trigram_index__fill_blocks(Trigram_Block *blocks, i64 *starts, i64 block_count, String_Const_u8 text, i64 region_start, i64 region_size){
+    i64 text_size = (i64)text.size;
+    i64 pos = 0;
+    for (i64 i = 0; i < block_count; i += 1){
+        Trigram_Block *block = blocks + i;
+        block_zero_struct(block);
+        starts[i] = region_start + pos;
+        i64 size = region_size/block_count + ((i < region_size%block_count)?1:0);
+        i64 trigram_end = Min(pos + size, text_size - 2);
+        for (i64 j = pos; j < trigram_end; j += 1){
+            u32 hash = trigram_hash(text.str[j], text.str[j + 1], text.str[j + 2]);
+            block->bloom[hash/64] |= (1ull << (hash%64));
+        }
+        pos += size;
+    }
+    starts[block_count] = region_start + region_size;
+}
+
+// NOTE: Makes room for new_count blocks in place of the remove_count blocks at first.
+// The blocks after them are kept and their starts move by shift, the new blocks are
+// left for the caller to fill.
+function void
+trigram_index__replace_blocks(Base_Allocator *allocator, Trigram_Index *index, i64 first, i64 remove_count, i64 new_count, i64 shift){
+    i64 tail_first = first + remove_count;
+    i64 tail_count = index->count - tail_first;
+    i64 new_total = index->count - remove_count + new_count;
+    Trigram_Block *blocks = index->blocks;
+    i64 *starts = index->starts;
+    if (starts == 0 || new_total > index->max){
+        i64 new_max = Max(new_total, index->max*2);
+        new_max = Max(new_max, 16);
+        blocks = base_array(allocator, Trigram_Block, new_max);
+        starts = base_array(allocator, i64, new_max + 1);
+        block_copy_dynamic_array(blocks, index->blocks, first);
+        block_copy_dynamic_array(starts, index->starts, first);
+        index->max = new_max;
+    }
+    block_copy_dynamic_array(blocks + first + new_count, index->blocks + tail_first, tail_count);
+    if (index->starts != 0){
+        i64 *tail_starts = starts + first + new_count;
+        block_copy_dynamic_array(tail_starts, index->starts + tail_first, tail_count + 1);
+        for (i64 i = 0; i <= tail_count; i += 1){
+            tail_starts[i] += shift;
+        }
+    }
+    if (blocks != index->blocks){
+        if (index->blocks != 0){
+            base_free(allocator, index->blocks);
+            base_free(allocator, index->starts);
+        }
+        index->blocks = blocks;
+        index->starts = starts;
+    }
+    index->count = new_total;
+}
+
+// NOTE: The last block that starts at or before pos.
+function i64
+trigram_index__block_from_pos(Trigram_Index *index, i64 pos){
+    i64 first = 0;
+    i64 one_past_last = index->count;
+    for (;first + 1 < one_past_last;){
+        i64 mid = (first + one_past_last) >> 1;
+        if (index->starts[mid] <= pos){
+            first = mid;
+        }
+        else{
+            one_past_last = mid;
+        }
+    }
+    return(first);
+}
+
+////////////////////////////////
+
+// NOTE: The index file holds, per clean file backed buffer:
+//  name size (u64), name, last write time (u64), buffer size (i64), block count (i64),
+//  block starts (block count + 1 i64s), blocks
+
+struct Trigram_Index_Entry{
+    String_Const_u8 name;
+    u64 last_write_time;
+    i64 size;
+    i64 count;
+    u8 *starts;
+    u8 *blocks;
+    Range_u64 bytes;
+};
+
+function b32
+trigram_index__read(String_Const_u8 data, u64 *pos, void *dst, u64 size){
+    b32 result = false;
+    if (*pos + size <= data.size){
+        block_copy(dst, data.str + *pos, size);
+        *pos += size;
+        result = true;
+    }
+    return(result);
+}
+
+function b32
+trigram_index__read_entry(String_Const_u8 data, u64 *pos, Trigram_Index_Entry *entry){
+    b32 result = false;
+    block_zero_struct(entry);
+    entry->bytes.min = *pos;
+    u64 name_size = 0;
+    if (trigram_index__read(data, pos, &name_size, sizeof(name_size)) &&
+        name_size <= data.size - *pos){
+        entry->name = SCu8(data.str + *pos, name_size);
+        *pos += name_size;
+        if (trigram_index__read(data, pos, &entry->last_write_time, sizeof(entry->last_write_time)) &&
+            trigram_index__read(data, pos, &entry->size, sizeof(entry->size)) &&
+            trigram_index__read(data, pos, &entry->count, sizeof(entry->count)) &&
+            entry->count >= 0 && data.size - *pos >= sizeof(i64) &&
+            (u64)entry->count <= (data.size - *pos - sizeof(i64))/(sizeof(Trigram_Block) + sizeof(i64))){
+            entry->starts = data.str + *pos;
+            *pos += (entry->count + 1)*sizeof(i64);
+            entry->blocks = data.str + *pos;
+            *pos += entry->count*sizeof(Trigram_Block);
+            entry->bytes.max = *pos;
+            result = true;
+        }
+    }
+    return(result);
+}
+
+function void
+trigram_index__adopt(Application_Links *app, Buffer_ID buffer, Trigram_Index *index){
+    Trigram_Index_Cache *cache = &trigram_index_cache;
+    if (cache->entries.allocator != 0){
+        Scratch_Block scratch(app);
+        String_Const_u8 name = push_buffer_file_name(app, scratch, buffer);
+        u64 pos = 0;
+        Trigram_Index_Entry entry = {};
+        if (name.size > 0 && table_read(&cache->entries, name, &pos) &&
+            trigram_index__read_entry(cache->data, &pos, &entry) &&
+            buffer_get_dirty_state(app, buffer) == DirtyState_UpToDate &&
+            buffer_get_file_attributes(app, buffer).last_write_time == entry.last_write_time &&
+            buffer_get_size(app, buffer) == entry.size){
+            ProfileScope(app, "trigram index adopt");
+            Managed_Scope scope = buffer_get_managed_scope(app, buffer);
+            Base_Allocator *allocator = managed_scope_allocator(app, scope);
+            trigram_index__replace_blocks(allocator, index, 0, index->count, entry.count, 0);
+            block_copy(index->blocks, entry.blocks, entry.count*sizeof(Trigram_Block));
+            block_copy(index->starts, entry.starts, (entry.count + 1)*sizeof(i64));
+            b32 good = (index->starts[0] == 0 && index->starts[entry.count] == entry.size);
+            for (i64 i = 0; i < entry.count && good; i += 1){
+                good = (index->starts[i] <= index->starts[i + 1]);
+            }
+            index->built = good;
+        }
+    }
+}
+
+////////////////////////////////
+
+function void
+trigram_index__build_async__inner(Async_Context *actx, Buffer_ID buffer_id){
+    Application_Links *app = actx->app;
+    ProfileScope(app, "async trigram index build");
+    Scratch_Block scratch(app);
+
+    Buffer_Snapshot *snapshot = 0;
+    {
+        acquire_global_frame_mutex(app);
+        snapshot = buffer_snapshot_acquire(app, buffer_id);
+        release_global_frame_mutex(app);
+    }
+    String_Const_u8 contents = push_whole_snapshot(app, scratch, snapshot);
+    buffer_snapshot_release(app, snapshot);
+
+    i64 size = (i64)contents.size;
+    i64 count = trigram_index__block_count(size);
+    Trigram_Block *blocks = push_array(scratch, Trigram_Block, count);
+    i64 *starts = push_array(scratch, i64, count + 1);
+    starts[0] = 0;
+
+    b32 canceled = false;
+    i64 base_size = (count > 0)?(size/count):0;
+    i64 extra = (count > 0)?(size%count):0;
+    for (i64 first = 0; first < count; first += TRIGRAM_BUILD_BLOCKS_PER_STEP){
+        i64 one_past_last = Min(first + TRIGRAM_BUILD_BLOCKS_PER_STEP, count);
+        i64 region_start = first*base_size + Min(first, extra);
+        i64 region_end = one_past_last*base_size + Min(one_past_last, extra);
+        String_Const_u8 text = string_substring(contents, Ii64(region_start, Min(region_end + 2, size)));
+        trigram_index__fill_blocks(blocks + first, starts + first, one_past_last - first,
+                                   text, region_start, region_end - region_start);
+        if (async_check_canceled(actx)){
+            canceled = true;
+            break;
+        }
+    }
+
+    if (!canceled){
+        acquire_global_frame_mutex(app);
+        // NOTE: An edit cancels the build before it lets go of the mutex, so a build that
+        // is still not canceled once it holds the mutex was read from the current text.
+        if (!async_check_canceled(actx)){
+            Managed_Scope scope = buffer_get_managed_scope(app, buffer_id);
+            Trigram_Index *index = 0;
+            if (scope != 0){
+                index = scope_attachment(app, scope, buffer_trigram_index, Trigram_Index);
+            }
+            if (index != 0){
+                Base_Allocator *allocator = managed_scope_allocator(app, scope);
+                trigram_index__replace_blocks(allocator, index, 0, index->count, count, 0);
+                block_copy_dynamic_array(index->blocks, blocks, count);
+                block_copy_dynamic_array(index->starts, starts, count + 1);
+                index->built = true;
+                trigram_index_cache.dirty = true;
+            }
+        }
+        release_global_frame_mutex(app);
+    }
+}
+
+function void
+trigram_index__build_async(Async_Context *actx, String_Const_u8 data){
+    if (data.size == sizeof(Buffer_ID)){
+        Buffer_ID buffer = *(Buffer_ID*)data.str;
+        trigram_index__build_async__inner(actx, buffer);
+    }
+}
+
+function void
+trigram_index__start_build(Application_Links *app, Buffer_ID buffer, Trigram_Index *index){
+    index->built = false;
+    index->build_task = async_task_no_dep(&global_async_system, trigram_index__build_async,
+                                          make_data_struct(&buffer), AsyncPriority_Low);
+}
+
+function Trigram_Index*
+trigram_index_get(Application_Links *app, Buffer_ID buffer){
+    Trigram_Index *result = 0;
+    Managed_Scope scope = buffer_get_managed_scope(app, buffer);
+    Trigram_Index *index = scope_attachment(app, scope, buffer_trigram_index, Trigram_Index);
+    if (index != 0){
+        if (!index->built &&
+            !async_task_is_running_or_pending(&global_async_system, index->build_task)){
+            trigram_index__adopt(app, buffer, index);
+            if (!index->built){
+                trigram_index__start_build(app, buffer, index);
+            }
+        }
+        if (index->built){
+            result = index;
+        }
+    }
+    return(result);
+}
+
+function void
+trigram_index_begin_buffer(Application_Links *app, Buffer_ID buffer){
+    if (def_get_config_b32(vars_save_string_lit("search_trigram_index"))){
+        trigram_index_get(app, buffer);
+    }
+}
+
+function void
+trigram_index_end_buffer(Application_Links *app, Buffer_ID buffer){
+    Managed_Scope scope = buffer_get_managed_scope(app, buffer);
+    Trigram_Index *index = scope_attachment(app, scope, buffer_trigram_index, Trigram_Index);
+    if (index != 0){
+        async_task_cancel(app, &global_async_system, index->build_task);
+    }
+}
+
+function void
+trigram_index_buffer_edit(Application_Links *app, Buffer_ID buffer, Range_i64 old_range, i64 insert_size){
+    Managed_Scope scope = buffer_get_managed_scope(app, buffer);
+    Trigram_Index *index = scope_attachment(app, scope, buffer_trigram_index, Trigram_Index);
+    if (index != 0){
+        if (async_task_is_running_or_pending(&global_async_system, index->build_task)){
+            async_task_cancel(app, &global_async_system, index->build_task);
+            trigram_index__start_build(app, buffer, index);
+        }
+        else if (index->built){
+            ProfileScope(app, "trigram index edit");
+
+            // NOTE: The blocks from the one holding old_range.min - 2 (its trigrams read
+            // into the edit) through the one holding old_range.max are rebuilt from the new
+            // text, everything after them only shifts.
+            i64 first = 0;
+            i64 last = -1;
+            if (index->count > 0){
+                first = trigram_index__block_from_pos(index, clamp_bot(0, old_range.min - 2));
+                last = trigram_index__block_from_pos(index, old_range.max);
+            }
+
+            i64 shift = insert_size - range_size(old_range);
+            Range_i64 new_region = Ii64(index->starts[first], index->starts[last + 1] + shift);
+            i64 new_count = trigram_index__block_count(range_size(new_region));
+            Base_Allocator *allocator = managed_scope_allocator(app, scope);
+            trigram_index__replace_blocks(allocator, index, first, last - first + 1, new_count, shift);
+
+            Scratch_Block scratch(app);
+            i64 buffer_size = buffer_get_size(app, buffer);
+            Range_i64 read_range = Ii64(new_region.min, Min(new_region.max + 2, buffer_size));
+            String_Const_u8 text = push_buffer_range(app, scratch, buffer, read_range);
+            trigram_index__fill_blocks(index->blocks + first, index->starts + first, new_count,
+                                       text, new_region.min, range_size(new_region));
+        }
+    }
+}
+
+function Range_i64_Array
+trigram_index_candidate_ranges(Arena *arena, Trigram_Index *index, String_Const_u8 needle){
+    Range_i64_Array result = {};
+
+    i64 *starts = index->starts;
+    i64 buffer_size = starts[index->count];
+
+    if (needle.size < 3){
+        result.ranges = push_array(arena, Range_i64, 1);
+        result.ranges[0] = Ii64(0, buffer_size);
+        result.count = 1;
+    }
+    else{
+        i64 needle_size = (i64)needle.size;
+        i64 trigram_count = needle_size - 2;
+        u32 *hashes = push_array(arena, u32, trigram_count);
+        for (i64 i = 0; i < trigram_count; i += 1){
+            hashes[i] = trigram_hash(needle.str[i], needle.str[i + 1], needle.str[i + 2]);
+        }
+
+        result.ranges = push_array(arena, Range_i64, index->count);
+        i64 reach_last = 0;
+        for (i64 b = 0; b < index->count; b += 1){
+            // NOTE: A match starting in block b has its trigrams starting before
+            // starts[b + 1] + needle_size - 3, so they land in blocks b through reach_last.
+            i64 reach = starts[b + 1] + needle_size - 3;
+            reach_last = Max(reach_last, b);
+            for (;reach_last + 1 < index->count && starts[reach_last + 1] < reach;){
+                reach_last += 1;
+            }
+
+            b32 is_candidate = true;
+            for (i64 i = 0; i < trigram_count && is_candidate; i += 1){
+                b32 found = false;
+                for (i64 c = b; c <= reach_last; c += 1){
+                    if (trigram_bloom_check(&index->blocks[c], hashes[i])){
+                        found = true;
+                        break;
+                    }
+                }
+                is_candidate = found;
+            }
+
+            if (is_candidate){
+                // NOTE: One extra byte on each side keeps the flags that look at the
+                // neighbouring characters the same as in a whole buffer search.
+                Range_i64 range = Ii64(clamp_bot(0, starts[b] - 1),
+                                       clamp_top(starts[b + 1] + needle_size, buffer_size));
+                if (result.count > 0 && result.ranges[result.count - 1].max >= range.min){
+                    result.ranges[result.count - 1].max = range.max;
+                }
+                else{
+                    result.ranges[result.count] = range;
+                    result.count += 1;
+                }
+            }
+        }
+    }
+
+    return(result);
+}
+
+////////////////////////////////
+
+function void
+trigram_index_set_project(Application_Links *app, String_Const_u8 project_root){
+    ProfileScope(app, "trigram index load");
+    Trigram_Index_Cache *cache = &trigram_index_cache;
+    Base_Allocator *allocator = get_base_allocator_system();
+    if (cache->entries.allocator != 0){
+        table_free(&cache->entries);
+    }
+    if (cache->memory.str != 0){
+        base_free(allocator, cache->memory.str);
+    }
+    block_zero_struct(cache);
+
+    Scratch_Block scratch(app);
+    String_Const_u8 user_dir = system_get_path(scratch, SystemPath_UserDirectory);
+    if (user_dir.size > 0 && project_root.size > 0){
+        if (!character_is_slash(string_get_character(user_dir, user_dir.size - 1))){
+            user_dir = push_u8_stringf(scratch, "%.*s/", string_expand(user_dir));
+        }
+        u64 hash = table_hash_u8(project_root.str, project_root.size);
+        String_Const_u8 file_name = push_u8_stringf(scratch, "%.*strigram_index_%016llx",
+                                                    string_expand(user_dir), hash);
+        File_Name_Data file = dump_file(scratch, file_name);
+
+        cache->memory = base_allocate(allocator, file_name.size + 1 + file.data.size);
+        cache->file_name = SCu8(cache->memory.str, file_name.size);
+        block_copy(cache->file_name.str, file_name.str, file_name.size);
+        cache->file_name.str[file_name.size] = 0;
+        cache->data = SCu8(cache->memory.str + file_name.size + 1, file.data.size);
+        block_copy(cache->data.str, file.data.str, file.data.size);
+        cache->entries = make_table_Data_u64(allocator, 64);
+
+        u64 pos = 0;
+        u32 magic = 0;
+        u32 version = 0;
+        if (trigram_index__read(cache->data, &pos, &magic, sizeof(magic)) &&
+            trigram_index__read(cache->data, &pos, &version, sizeof(version)) &&
+            magic == TRIGRAM_INDEX_FILE_MAGIC && version == TRIGRAM_INDEX_FILE_VERSION){
+            for (;;){
+                u64 entry_pos = pos;
+                Trigram_Index_Entry entry = {};
+                if (!trigram_index__read_entry(cache->data, &pos, &entry)){
+                    break;
+                }
+                table_insert(&cache->entries, entry.name, entry_pos);
+            }
+        }
+    }
+
+    // NOTE: The buffers that are already open take up their entries now, the rest do
+    // when they are opened.
+    if (def_get_config_b32(vars_save_string_lit("search_trigram_index"))){
+        for (Buffer_ID buffer = get_buffer_next(app, 0, Access_Always);
+             buffer != 0;
+             buffer = get_buffer_next(app, buffer, Access_Always)){
+            trigram_index_get(app, buffer);
+        }
+    }
+}
+
+function void
+trigram_index_save(Application_Links *app){
+    Trigram_Index_Cache *cache = &trigram_index_cache;
+    if (cache->file_name.size > 0 && cache->dirty){
+        ProfileScope(app, "trigram index save");
+        cache->dirty = false;
+        FILE *file = fopen((char*)cache->file_name.str, "wb");
+        if (file != 0){
+            u32 magic = TRIGRAM_INDEX_FILE_MAGIC;
+            u32 version = TRIGRAM_INDEX_FILE_VERSION;
+            fwrite(&magic, sizeof(magic), 1, file);
+            fwrite(&version, sizeof(version), 1, file);
+            Scratch_Block scratch(app);
+            for (Buffer_ID buffer = get_buffer_next(app, 0, Access_Always);
+                 buffer != 0;
+                 buffer = get_buffer_next(app, buffer, Access_Always)){
+                Managed_Scope scope = buffer_get_managed_scope(app, buffer);
+                Trigram_Index *index = scope_attachment(app, scope, buffer_trigram_index, Trigram_Index);
+                if (index == 0 || !index->built ||
+                    buffer_get_dirty_state(app, buffer) != DirtyState_UpToDate){
+                    continue;
+                }
+                Temp_Memory_Block temp(scratch);
+                String_Const_u8 name = push_buffer_file_name(app, scratch, buffer);
+                if (name.size == 0){
+                    continue;
+                }
+                u64 name_size = name.size;
+                u64 last_write_time = buffer_get_file_attributes(app, buffer).last_write_time;
+                i64 size = buffer_get_size(app, buffer);
+                fwrite(&name_size, sizeof(name_size), 1, file);
+                fwrite(name.str, name.size, 1, file);
+                fwrite(&last_write_time, sizeof(last_write_time), 1, file);
+                fwrite(&size, sizeof(size), 1, file);
+                fwrite(&index->count, sizeof(index->count), 1, file);
+                fwrite(index->starts, sizeof(i64), index->count + 1, file);
+                fwrite(index->blocks, sizeof(Trigram_Block), index->count, file);
+            }
+
+            // NOTE: Entries of files that are not open with a clean index are carried over
+            // as they were, they still hold for the file on disk.
+            u64 pos = sizeof(magic) + sizeof(version);
+            if (cache->entries.used_count > 0){
+                for (;;){
+                    Trigram_Index_Entry entry = {};
+                    if (!trigram_index__read_entry(cache->data, &pos, &entry)){
+                        break;
+                    }
+                    Buffer_ID buffer = get_buffer_by_file_name(app, entry.name, Access_Always);
+                    if (buffer != 0 && buffer_get_dirty_state(app, buffer) == DirtyState_UpToDate){
+                        Managed_Scope scope = buffer_get_managed_scope(app, buffer);
+                        Trigram_Index *index = scope_attachment(app, scope, buffer_trigram_index, Trigram_Index);
+                        if (index != 0 && index->built){
+                            continue;
+                        }
+                    }
+                    fwrite(cache->data.str + entry.bytes.min, range_size(entry.bytes), 1, file);
+                }
+            }
+            fclose(file);
+        }
+    }
+}
+
+// BOTTOM
+
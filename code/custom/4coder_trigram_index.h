@@ -0,0 +1,63 @@
+/*
+4coder_trigram_index.h - Per buffer trigram filters that narrow searches across buffers.
+*/
+
+// TOP
+
+#if !defined(FCODER_TRIGRAM_INDEX_H)
+#define FCODER_TRIGRAM_INDEX_H
+
+// NOTE: A buffer's index splits the text into blocks of at most
+// TRIGRAM_BLOCK_TARGET_SIZE bytes.  Each block keeps a one-hash bloom filter of the
+// case folded trigrams that start inside it, so a block only has to be searched when
+// every trigram of the needle might be in it or the blocks just after it.
+
+#define TRIGRAM_BLOCK_TARGET_SIZE KB(8)
+#define TRIGRAM_BLOOM_BITS_LOG2 13
+#define TRIGRAM_BLOOM_BITS (1 << TRIGRAM_BLOOM_BITS_LOG2)
+#define TRIGRAM_BLOOM_U64_COUNT (TRIGRAM_BLOOM_BITS/64)
+
+// NOTE: Buffers smaller than this are searched whole even when their index has
+// candidates, splitting them into ranges costs more than it saves.
+#define TRIGRAM_REGION_SEARCH_MIN_SIZE MB(1)
+
+struct Trigram_Block{
+    u64 bloom[TRIGRAM_BLOOM_U64_COUNT];
+};
+
+// NOTE: starts has count + 1 entries, block i covers starts[i] up to starts[i + 1] and
+// the last entry is the size of the buffer.  Until built is set the index is either
+// waiting on build_task or was never asked for, searches treat the buffer as unindexed.
+struct Trigram_Index{
+    Trigram_Block *blocks;
+    i64 *starts;
+    i64 count;
+    i64 max;
+    b32 built;
+    Async_Task build_task;
+};
+
+// NOTE: The saved indices of the current project.  The file lives in the user directory,
+// named by a hash of the project root.  entries maps each file name in data to the
+// offset of its entry, a buffer takes up its entry the first time it asks for an index
+// while it is still in the state the entry was saved from.
+struct Trigram_Index_Cache{
+    String_Const_u8 memory;
+    String_Const_u8 file_name;
+    String_Const_u8 data;
+    Table_Data_u64 entries;
+    b32 dirty;
+};
+
+function Trigram_Index* trigram_index_get(Application_Links *app, Buffer_ID buffer);
+function void trigram_index_begin_buffer(Application_Links *app, Buffer_ID buffer);
+function void trigram_index_end_buffer(Application_Links *app, Buffer_ID buffer);
+function void trigram_index_buffer_edit(Application_Links *app, Buffer_ID buffer, Range_i64 old_range, i64 insert_size);
+function Range_i64_Array trigram_index_candidate_ranges(Arena *arena, Trigram_Index *index, String_Const_u8 needle);
+function void trigram_index_set_project(Application_Links *app, String_Const_u8 project_root);
+function void trigram_index_save(Application_Links *app);
+
+#endif
+
+// BOTTOM
+
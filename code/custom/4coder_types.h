@@ -113,6 +113,10 @@ typedef u32 Text_Layout_ID;
 api(custom)
 typedef u32 Child_Process_ID;
 
+// NOTE: An immutable copy of a buffer's text, owned by the core.  Taking one needs
+// the frame mutex, reading and releasing it does not.
+struct Buffer_Snapshot;
+
 api(custom)
 typedef i32 UI_Highlight_Level;
 enum{
@@ -169,6 +173,9 @@ typedef i32 Global_Setting_ID;
 enum{
     GlobalSetting_Null,
     GlobalSetting_LAltLCtrlIsAltGr,
+    GlobalSetting_CompactHistory,
+    GlobalSetting_HistoryBufferBudget,
+    GlobalSetting_HistoryGlobalBudget,
 };
 
 api(custom)
@@ -179,6 +186,7 @@ enum{
     BufferSetting_ReadOnly,
     BufferSetting_RecordsHistory,
     BufferSetting_Unkillable,
+    BufferSetting_PieceTreeStorage,
 };
 
 api(custom)
@@ -14,6 +14,10 @@ vtable->get_buffer_next = get_buffer_next;
 vtable->get_buffer_by_name = get_buffer_by_name;
 vtable->get_buffer_by_file_name = get_buffer_by_file_name;
 vtable->buffer_read_range = buffer_read_range;
+vtable->buffer_snapshot_acquire = buffer_snapshot_acquire;
+vtable->buffer_snapshot_release = buffer_snapshot_release;
+vtable->buffer_snapshot_size = buffer_snapshot_size;
+vtable->buffer_snapshot_read_range = buffer_snapshot_read_range;
 vtable->buffer_replace_range = buffer_replace_range;
 vtable->buffer_batch_edit = buffer_batch_edit;
 vtable->buffer_seek_string = buffer_seek_string;
@@ -49,6 +53,7 @@ vtable->buffer_set_setting = buffer_set_setting;
 vtable->buffer_get_managed_scope = buffer_get_managed_scope;
 vtable->buffer_send_end_signal = buffer_send_end_signal;
 vtable->create_buffer = create_buffer;
+vtable->create_buffer_from_data = create_buffer_from_data;
 vtable->buffer_save = buffer_save;
 vtable->buffer_kill = buffer_kill;
 vtable->buffer_reopen = buffer_reopen;
@@ -177,6 +182,7 @@ vtable->draw_text_layout = draw_text_layout;
 vtable->open_color_picker = open_color_picker;
 vtable->animate_in_n_milliseconds = animate_in_n_milliseconds;
 vtable->buffer_find_all_matches = buffer_find_all_matches;
+vtable->buffer_find_all_matches_parallel = buffer_find_all_matches_parallel;
 vtable->get_core_profile_list = get_core_profile_list;
 vtable->get_custom_layer_boundary_docs = get_custom_layer_boundary_docs;
 }
@@ -197,6 +203,10 @@ get_buffer_next = vtable->get_buffer_next;
 get_buffer_by_name = vtable->get_buffer_by_name;
 get_buffer_by_file_name = vtable->get_buffer_by_file_name;
 buffer_read_range = vtable->buffer_read_range;
+buffer_snapshot_acquire = vtable->buffer_snapshot_acquire;
+buffer_snapshot_release = vtable->buffer_snapshot_release;
+buffer_snapshot_size = vtable->buffer_snapshot_size;
+buffer_snapshot_read_range = vtable->buffer_snapshot_read_range;
 buffer_replace_range = vtable->buffer_replace_range;
 buffer_batch_edit = vtable->buffer_batch_edit;
 buffer_seek_string = vtable->buffer_seek_string;
@@ -232,6 +242,7 @@ buffer_set_setting = vtable->buffer_set_setting;
 buffer_get_managed_scope = vtable->buffer_get_managed_scope;
 buffer_send_end_signal = vtable->buffer_send_end_signal;
 create_buffer = vtable->create_buffer;
+create_buffer_from_data = vtable->create_buffer_from_data;
 buffer_save = vtable->buffer_save;
 buffer_kill = vtable->buffer_kill;
 buffer_reopen = vtable->buffer_reopen;
@@ -360,6 +371,7 @@ draw_text_layout = vtable->draw_text_layout;
 open_color_picker = vtable->open_color_picker;
 animate_in_n_milliseconds = vtable->animate_in_n_milliseconds;
 buffer_find_all_matches = vtable->buffer_find_all_matches;
+buffer_find_all_matches_parallel = vtable->buffer_find_all_matches_parallel;
 get_core_profile_list = vtable->get_core_profile_list;
 get_custom_layer_boundary_docs = vtable->get_custom_layer_boundary_docs;
 }
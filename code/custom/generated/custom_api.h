@@ -12,6 +12,10 @@
 #define custom_get_buffer_by_name_sig() Buffer_ID custom_get_buffer_by_name(Application_Links* app, String_Const_u8 name, Access_Flag access)
 #define custom_get_buffer_by_file_name_sig() Buffer_ID custom_get_buffer_by_file_name(Application_Links* app, String_Const_u8 file_name, Access_Flag access)
 #define custom_buffer_read_range_sig() b32 custom_buffer_read_range(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, u8* out)
+#define custom_buffer_snapshot_acquire_sig() Buffer_Snapshot* custom_buffer_snapshot_acquire(Application_Links* app, Buffer_ID buffer_id)
+#define custom_buffer_snapshot_release_sig() void custom_buffer_snapshot_release(Application_Links* app, Buffer_Snapshot* snapshot)
+#define custom_buffer_snapshot_size_sig() i64 custom_buffer_snapshot_size(Application_Links* app, Buffer_Snapshot* snapshot)
+#define custom_buffer_snapshot_read_range_sig() b32 custom_buffer_snapshot_read_range(Application_Links* app, Buffer_Snapshot* snapshot, Range_i64 range, u8* out)
 #define custom_buffer_replace_range_sig() b32 custom_buffer_replace_range(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, String_Const_u8 string)
 #define custom_buffer_batch_edit_sig() b32 custom_buffer_batch_edit(Application_Links* app, Buffer_ID buffer_id, Batch_Edit* batch)
 #define custom_buffer_seek_string_sig() String_Match custom_buffer_seek_string(Application_Links* app, Buffer_ID buffer, String_Const_u8 needle, Scan_Direction direction, i64 start_pos)
@@ -47,6 +51,7 @@
 #define custom_buffer_get_managed_scope_sig() Managed_Scope custom_buffer_get_managed_scope(Application_Links* app, Buffer_ID buffer_id)
 #define custom_buffer_send_end_signal_sig() b32 custom_buffer_send_end_signal(Application_Links* app, Buffer_ID buffer_id)
 #define custom_create_buffer_sig() Buffer_ID custom_create_buffer(Application_Links* app, String_Const_u8 file_name, Buffer_Create_Flag flags)
+#define custom_create_buffer_from_data_sig() Buffer_ID custom_create_buffer_from_data(Application_Links* app, String_Const_u8 file_name, String_Const_u8 data, File_Attributes attributes, Buffer_Create_Flag flags)
 #define custom_buffer_save_sig() b32 custom_buffer_save(Application_Links* app, Buffer_ID buffer_id, String_Const_u8 file_name, Buffer_Save_Flag flags)
 #define custom_buffer_kill_sig() Buffer_Kill_Result custom_buffer_kill(Application_Links* app, Buffer_ID buffer_id, Buffer_Kill_Flag flags)
 #define custom_buffer_reopen_sig() Buffer_Reopen_Result custom_buffer_reopen(Application_Links* app, Buffer_ID buffer_id, Buffer_Reopen_Flag flags)
@@ -175,6 +180,7 @@
 #define custom_open_color_picker_sig() void custom_open_color_picker(Application_Links* app, Color_Picker* picker)
 #define custom_animate_in_n_milliseconds_sig() void custom_animate_in_n_milliseconds(Application_Links* app, u32 n)
 #define custom_buffer_find_all_matches_sig() String_Match_List custom_buffer_find_all_matches(Application_Links* app, Arena* arena, Buffer_ID buffer, i32 string_id, Range_i64 range, String_Const_u8 needle, Character_Predicate* predicate, Scan_Direction direction)
+#define custom_buffer_find_all_matches_parallel_sig() String_Match_List custom_buffer_find_all_matches_parallel(Application_Links* app, Arena* arena, Buffer_ID* buffers, i32 buffer_count, String_Const_u8_Array needles, Character_Predicate* predicate, String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags, i32 thread_count)
 #define custom_get_core_profile_list_sig() Profile_Global_List* custom_get_core_profile_list(Application_Links* app)
 #define custom_get_custom_layer_boundary_docs_sig() Doc_Cluster* custom_get_custom_layer_boundary_docs(Application_Links* app, Arena* arena)
 typedef b32 custom_global_set_setting_type(Application_Links* app, Global_Setting_ID setting, i64 value);
@@ -191,6 +197,10 @@ typedef Buffer_ID custom_get_buffer_next_type(Application_Links* app, Buffer_ID
 typedef Buffer_ID custom_get_buffer_by_name_type(Application_Links* app, String_Const_u8 name, Access_Flag access);
 typedef Buffer_ID custom_get_buffer_by_file_name_type(Application_Links* app, String_Const_u8 file_name, Access_Flag access);
 typedef b32 custom_buffer_read_range_type(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, u8* out);
+typedef Buffer_Snapshot* custom_buffer_snapshot_acquire_type(Application_Links* app, Buffer_ID buffer_id);
+typedef void custom_buffer_snapshot_release_type(Application_Links* app, Buffer_Snapshot* snapshot);
+typedef i64 custom_buffer_snapshot_size_type(Application_Links* app, Buffer_Snapshot* snapshot);
+typedef b32 custom_buffer_snapshot_read_range_type(Application_Links* app, Buffer_Snapshot* snapshot, Range_i64 range, u8* out);
 typedef b32 custom_buffer_replace_range_type(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, String_Const_u8 string);
 typedef b32 custom_buffer_batch_edit_type(Application_Links* app, Buffer_ID buffer_id, Batch_Edit* batch);
 typedef String_Match custom_buffer_seek_string_type(Application_Links* app, Buffer_ID buffer, String_Const_u8 needle, Scan_Direction direction, i64 start_pos);
@@ -226,6 +236,7 @@ typedef b32 custom_buffer_set_setting_type(Application_Links* app, Buffer_ID buf
 typedef Managed_Scope custom_buffer_get_managed_scope_type(Application_Links* app, Buffer_ID buffer_id);
 typedef b32 custom_buffer_send_end_signal_type(Application_Links* app, Buffer_ID buffer_id);
 typedef Buffer_ID custom_create_buffer_type(Application_Links* app, String_Const_u8 file_name, Buffer_Create_Flag flags);
+typedef Buffer_ID custom_create_buffer_from_data_type(Application_Links* app, String_Const_u8 file_name, String_Const_u8 data, File_Attributes attributes, Buffer_Create_Flag flags);
 typedef b32 custom_buffer_save_type(Application_Links* app, Buffer_ID buffer_id, String_Const_u8 file_name, Buffer_Save_Flag flags);
 typedef Buffer_Kill_Result custom_buffer_kill_type(Application_Links* app, Buffer_ID buffer_id, Buffer_Kill_Flag flags);
 typedef Buffer_Reopen_Result custom_buffer_reopen_type(Application_Links* app, Buffer_ID buffer_id, Buffer_Reopen_Flag flags);
@@ -354,6 +365,7 @@ typedef void custom_draw_text_layout_type(Application_Links* app, Text_Layout_ID
 typedef void custom_open_color_picker_type(Application_Links* app, Color_Picker* picker);
 typedef void custom_animate_in_n_milliseconds_type(Application_Links* app, u32 n);
 typedef String_Match_List custom_buffer_find_all_matches_type(Application_Links* app, Arena* arena, Buffer_ID buffer, i32 string_id, Range_i64 range, String_Const_u8 needle, Character_Predicate* predicate, Scan_Direction direction);
+typedef String_Match_List custom_buffer_find_all_matches_parallel_type(Application_Links* app, Arena* arena, Buffer_ID* buffers, i32 buffer_count, String_Const_u8_Array needles, Character_Predicate* predicate, String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags, i32 thread_count);
 typedef Profile_Global_List* custom_get_core_profile_list_type(Application_Links* app);
 typedef Doc_Cluster* custom_get_custom_layer_boundary_docs_type(Application_Links* app, Arena* arena);
 struct API_VTable_custom{
@@ -371,6 +383,10 @@ custom_get_buffer_next_type *get_buffer_next;
 custom_get_buffer_by_name_type *get_buffer_by_name;
 custom_get_buffer_by_file_name_type *get_buffer_by_file_name;
 custom_buffer_read_range_type *buffer_read_range;
+custom_buffer_snapshot_acquire_type *buffer_snapshot_acquire;
+custom_buffer_snapshot_release_type *buffer_snapshot_release;
+custom_buffer_snapshot_size_type *buffer_snapshot_size;
+custom_buffer_snapshot_read_range_type *buffer_snapshot_read_range;
 custom_buffer_replace_range_type *buffer_replace_range;
 custom_buffer_batch_edit_type *buffer_batch_edit;
 custom_buffer_seek_string_type *buffer_seek_string;
@@ -406,6 +422,7 @@ custom_buffer_set_setting_type *buffer_set_setting;
 custom_buffer_get_managed_scope_type *buffer_get_managed_scope;
 custom_buffer_send_end_signal_type *buffer_send_end_signal;
 custom_create_buffer_type *create_buffer;
+custom_create_buffer_from_data_type *create_buffer_from_data;
 custom_buffer_save_type *buffer_save;
 custom_buffer_kill_type *buffer_kill;
 custom_buffer_reopen_type *buffer_reopen;
@@ -534,6 +551,7 @@ custom_draw_text_layout_type *draw_text_layout;
 custom_open_color_picker_type *open_color_picker;
 custom_animate_in_n_milliseconds_type *animate_in_n_milliseconds;
 custom_buffer_find_all_matches_type *buffer_find_all_matches;
+custom_buffer_find_all_matches_parallel_type *buffer_find_all_matches_parallel;
 custom_get_core_profile_list_type *get_core_profile_list;
 custom_get_custom_layer_boundary_docs_type *get_custom_layer_boundary_docs;
 };
@@ -552,6 +570,10 @@ internal Buffer_ID get_buffer_next(Application_Links* app, Buffer_ID buffer_id,
 internal Buffer_ID get_buffer_by_name(Application_Links* app, String_Const_u8 name, Access_Flag access);
 internal Buffer_ID get_buffer_by_file_name(Application_Links* app, String_Const_u8 file_name, Access_Flag access);
 internal b32 buffer_read_range(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, u8* out);
+internal Buffer_Snapshot* buffer_snapshot_acquire(Application_Links* app, Buffer_ID buffer_id);
+internal void buffer_snapshot_release(Application_Links* app, Buffer_Snapshot* snapshot);
+internal i64 buffer_snapshot_size(Application_Links* app, Buffer_Snapshot* snapshot);
+internal b32 buffer_snapshot_read_range(Application_Links* app, Buffer_Snapshot* snapshot, Range_i64 range, u8* out);
 internal b32 buffer_replace_range(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, String_Const_u8 string);
 internal b32 buffer_batch_edit(Application_Links* app, Buffer_ID buffer_id, Batch_Edit* batch);
 internal String_Match buffer_seek_string(Application_Links* app, Buffer_ID buffer, String_Const_u8 needle, Scan_Direction direction, i64 start_pos);
@@ -587,6 +609,7 @@ internal b32 buffer_set_setting(Application_Links* app, Buffer_ID buffer_id, Buf
 internal Managed_Scope buffer_get_managed_scope(Application_Links* app, Buffer_ID buffer_id);
 internal b32 buffer_send_end_signal(Application_Links* app, Buffer_ID buffer_id);
 internal Buffer_ID create_buffer(Application_Links* app, String_Const_u8 file_name, Buffer_Create_Flag flags);
+internal Buffer_ID create_buffer_from_data(Application_Links* app, String_Const_u8 file_name, String_Const_u8 data, File_Attributes attributes, Buffer_Create_Flag flags);
 internal b32 buffer_save(Application_Links* app, Buffer_ID buffer_id, String_Const_u8 file_name, Buffer_Save_Flag flags);
 internal Buffer_Kill_Result buffer_kill(Application_Links* app, Buffer_ID buffer_id, Buffer_Kill_Flag flags);
 internal Buffer_Reopen_Result buffer_reopen(Application_Links* app, Buffer_ID buffer_id, Buffer_Reopen_Flag flags);
@@ -715,6 +738,7 @@ internal void draw_text_layout(Application_Links* app, Text_Layout_ID layout_id,
 internal void open_color_picker(Application_Links* app, Color_Picker* picker);
 internal void animate_in_n_milliseconds(Application_Links* app, u32 n);
 internal String_Match_List buffer_find_all_matches(Application_Links* app, Arena* arena, Buffer_ID buffer, i32 string_id, Range_i64 range, String_Const_u8 needle, Character_Predicate* predicate, Scan_Direction direction);
+internal String_Match_List buffer_find_all_matches_parallel(Application_Links* app, Arena* arena, Buffer_ID* buffers, i32 buffer_count, String_Const_u8_Array needles, Character_Predicate* predicate, String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags, i32 thread_count);
 internal Profile_Global_List* get_core_profile_list(Application_Links* app);
 internal Doc_Cluster* get_custom_layer_boundary_docs(Application_Links* app, Arena* arena);
 #undef STATIC_LINK_API
@@ -733,6 +757,10 @@ global custom_get_buffer_next_type *get_buffer_next = 0;
 global custom_get_buffer_by_name_type *get_buffer_by_name = 0;
 global custom_get_buffer_by_file_name_type *get_buffer_by_file_name = 0;
 global custom_buffer_read_range_type *buffer_read_range = 0;
+global custom_buffer_snapshot_acquire_type *buffer_snapshot_acquire = 0;
+global custom_buffer_snapshot_release_type *buffer_snapshot_release = 0;
+global custom_buffer_snapshot_size_type *buffer_snapshot_size = 0;
+global custom_buffer_snapshot_read_range_type *buffer_snapshot_read_range = 0;
 global custom_buffer_replace_range_type *buffer_replace_range = 0;
 global custom_buffer_batch_edit_type *buffer_batch_edit = 0;
 global custom_buffer_seek_string_type *buffer_seek_string = 0;
@@ -768,6 +796,7 @@ global custom_buffer_set_setting_type *buffer_set_setting = 0;
 global custom_buffer_get_managed_scope_type *buffer_get_managed_scope = 0;
 global custom_buffer_send_end_signal_type *buffer_send_end_signal = 0;
 global custom_create_buffer_type *create_buffer = 0;
+global custom_create_buffer_from_data_type *create_buffer_from_data = 0;
 global custom_buffer_save_type *buffer_save = 0;
 global custom_buffer_kill_type *buffer_kill = 0;
 global custom_buffer_reopen_type *buffer_reopen = 0;
@@ -896,6 +925,7 @@ global custom_draw_text_layout_type *draw_text_layout = 0;
 global custom_open_color_picker_type *open_color_picker = 0;
 global custom_animate_in_n_milliseconds_type *animate_in_n_milliseconds = 0;
 global custom_buffer_find_all_matches_type *buffer_find_all_matches = 0;
+global custom_buffer_find_all_matches_parallel_type *buffer_find_all_matches_parallel = 0;
 global custom_get_core_profile_list_type *get_core_profile_list = 0;
 global custom_get_custom_layer_boundary_docs_type *get_custom_layer_boundary_docs = 0;
 #undef DYNAMIC_LINK_API
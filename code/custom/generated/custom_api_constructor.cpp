@@ -78,6 +78,28 @@ api_param(arena, call, "Range_i64", "range");
 api_param(arena, call, "u8*", "out");
 }
 {
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_snapshot_acquire"), string_u8_litexpr("Buffer_Snapshot*"), string_u8_litexpr(""));
+api_param(arena, call, "Application_Links*", "app");
+api_param(arena, call, "Buffer_ID", "buffer_id");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_snapshot_release"), string_u8_litexpr("void"), string_u8_litexpr(""));
+api_param(arena, call, "Application_Links*", "app");
+api_param(arena, call, "Buffer_Snapshot*", "snapshot");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_snapshot_size"), string_u8_litexpr("i64"), string_u8_litexpr(""));
+api_param(arena, call, "Application_Links*", "app");
+api_param(arena, call, "Buffer_Snapshot*", "snapshot");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_snapshot_read_range"), string_u8_litexpr("b32"), string_u8_litexpr(""));
+api_param(arena, call, "Application_Links*", "app");
+api_param(arena, call, "Buffer_Snapshot*", "snapshot");
+api_param(arena, call, "Range_i64", "range");
+api_param(arena, call, "u8*", "out");
+}
+{
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_replace_range"), string_u8_litexpr("b32"), string_u8_litexpr(""));
 api_param(arena, call, "Application_Links*", "app");
 api_param(arena, call, "Buffer_ID", "buffer_id");
@@ -314,6 +336,14 @@ api_param(arena, call, "String_Const_u8", "file_name");
 api_param(arena, call, "Buffer_Create_Flag", "flags");
 }
 {
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("create_buffer_from_data"), string_u8_litexpr("Buffer_ID"), string_u8_litexpr(""));
+api_param(arena, call, "Application_Links*", "app");
+api_param(arena, call, "String_Const_u8", "file_name");
+api_param(arena, call, "String_Const_u8", "data");
+api_param(arena, call, "File_Attributes", "attributes");
+api_param(arena, call, "Buffer_Create_Flag", "flags");
+}
+{
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_save"), string_u8_litexpr("b32"), string_u8_litexpr(""));
 api_param(arena, call, "Application_Links*", "app");
 api_param(arena, call, "Buffer_ID", "buffer_id");
@@ -1032,6 +1062,18 @@ api_param(arena, call, "Character_Predicate*", "predicate");
 api_param(arena, call, "Scan_Direction", "direction");
 }
 {
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("buffer_find_all_matches_parallel"), string_u8_litexpr("String_Match_List"), string_u8_litexpr(""));
+api_param(arena, call, "Application_Links*", "app");
+api_param(arena, call, "Arena*", "arena");
+api_param(arena, call, "Buffer_ID*", "buffers");
+api_param(arena, call, "i32", "buffer_count");
+api_param(arena, call, "String_Const_u8_Array", "needles");
+api_param(arena, call, "Character_Predicate*", "predicate");
+api_param(arena, call, "String_Match_Flag", "must_have_flags");
+api_param(arena, call, "String_Match_Flag", "must_not_have_flags");
+api_param(arena, call, "i32", "thread_count");
+}
+{
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("get_core_profile_list"), string_u8_litexpr("Profile_Global_List*"), string_u8_litexpr(""));
 api_param(arena, call, "Application_Links*", "app");
 }
@@ -12,6 +12,10 @@ api(custom) function Buffer_ID get_buffer_next(Application_Links* app, Buffer_ID
 api(custom) function Buffer_ID get_buffer_by_name(Application_Links* app, String_Const_u8 name, Access_Flag access);
 api(custom) function Buffer_ID get_buffer_by_file_name(Application_Links* app, String_Const_u8 file_name, Access_Flag access);
 api(custom) function b32 buffer_read_range(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, u8* out);
+api(custom) function Buffer_Snapshot* buffer_snapshot_acquire(Application_Links* app, Buffer_ID buffer_id);
+api(custom) function void buffer_snapshot_release(Application_Links* app, Buffer_Snapshot* snapshot);
+api(custom) function i64 buffer_snapshot_size(Application_Links* app, Buffer_Snapshot* snapshot);
+api(custom) function b32 buffer_snapshot_read_range(Application_Links* app, Buffer_Snapshot* snapshot, Range_i64 range, u8* out);
 api(custom) function b32 buffer_replace_range(Application_Links* app, Buffer_ID buffer_id, Range_i64 range, String_Const_u8 string);
 api(custom) function b32 buffer_batch_edit(Application_Links* app, Buffer_ID buffer_id, Batch_Edit* batch);
 api(custom) function String_Match buffer_seek_string(Application_Links* app, Buffer_ID buffer, String_Const_u8 needle, Scan_Direction direction, i64 start_pos);
@@ -47,6 +51,7 @@ api(custom) function b32 buffer_set_setting(Application_Links* app, Buffer_ID bu
 api(custom) function Managed_Scope buffer_get_managed_scope(Application_Links* app, Buffer_ID buffer_id);
 api(custom) function b32 buffer_send_end_signal(Application_Links* app, Buffer_ID buffer_id);
 api(custom) function Buffer_ID create_buffer(Application_Links* app, String_Const_u8 file_name, Buffer_Create_Flag flags);
+api(custom) function Buffer_ID create_buffer_from_data(Application_Links* app, String_Const_u8 file_name, String_Const_u8 data, File_Attributes attributes, Buffer_Create_Flag flags);
 api(custom) function b32 buffer_save(Application_Links* app, Buffer_ID buffer_id, String_Const_u8 file_name, Buffer_Save_Flag flags);
 api(custom) function Buffer_Kill_Result buffer_kill(Application_Links* app, Buffer_ID buffer_id, Buffer_Kill_Flag flags);
 api(custom) function Buffer_Reopen_Result buffer_reopen(Application_Links* app, Buffer_ID buffer_id, Buffer_Reopen_Flag flags);
@@ -175,5 +180,6 @@ api(custom) function void draw_text_layout(Application_Links* app, Text_Layout_I
 api(custom) function void open_color_picker(Application_Links* app, Color_Picker* picker);
 api(custom) function void animate_in_n_milliseconds(Application_Links* app, u32 n);
 api(custom) function String_Match_List buffer_find_all_matches(Application_Links* app, Arena* arena, Buffer_ID buffer, i32 string_id, Range_i64 range, String_Const_u8 needle, Character_Predicate* predicate, Scan_Direction direction);
+api(custom) function String_Match_List buffer_find_all_matches_parallel(Application_Links* app, Arena* arena, Buffer_ID* buffers, i32 buffer_count, String_Const_u8_Array needles, Character_Predicate* predicate, String_Match_Flag must_have_flags, String_Match_Flag must_not_have_flags, i32 thread_count);
 api(custom) function Profile_Global_List* get_core_profile_list(Application_Links* app);
 api(custom) function Doc_Cluster* get_custom_layer_boundary_docs(Application_Links* app, Arena* arena);
@@ -5,11 +5,21 @@ vtable->get_path = system_get_path;
 vtable->get_canonical = system_get_canonical;
 vtable->get_file_list = system_get_file_list;
 vtable->quick_file_attributes = system_quick_file_attributes;
+vtable->file_watch_add = system_file_watch_add;
+vtable->file_watch_remove = system_file_watch_remove;
+vtable->file_watch_wait = system_file_watch_wait;
 vtable->load_handle = system_load_handle;
 vtable->load_attributes = system_load_attributes;
 vtable->load_file = system_load_file;
+vtable->load_map = system_load_map;
+vtable->load_unmap = system_load_unmap;
 vtable->load_close = system_load_close;
 vtable->save_file = system_save_file;
+vtable->delete_file = system_delete_file;
+vtable->scratch_file_open = system_scratch_file_open;
+vtable->scratch_file_write = system_scratch_file_write;
+vtable->scratch_file_read = system_scratch_file_read;
+vtable->scratch_file_close = system_scratch_file_close;
 vtable->load_library = system_load_library;
 vtable->release_library = system_release_library;
 vtable->get_proc = system_get_proc;
@@ -66,11 +76,21 @@ system_get_path = vtable->get_path;
 system_get_canonical = vtable->get_canonical;
 system_get_file_list = vtable->get_file_list;
 system_quick_file_attributes = vtable->quick_file_attributes;
+system_file_watch_add = vtable->file_watch_add;
+system_file_watch_remove = vtable->file_watch_remove;
+system_file_watch_wait = vtable->file_watch_wait;
 system_load_handle = vtable->load_handle;
 system_load_attributes = vtable->load_attributes;
 system_load_file = vtable->load_file;
+system_load_map = vtable->load_map;
+system_load_unmap = vtable->load_unmap;
 system_load_close = vtable->load_close;
 system_save_file = vtable->save_file;
+system_delete_file = vtable->delete_file;
+system_scratch_file_open = vtable->scratch_file_open;
+system_scratch_file_write = vtable->scratch_file_write;
+system_scratch_file_read = vtable->scratch_file_read;
+system_scratch_file_close = vtable->scratch_file_close;
 system_load_library = vtable->load_library;
 system_release_library = vtable->release_library;
 system_get_proc = vtable->get_proc;
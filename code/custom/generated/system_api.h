@@ -3,11 +3,21 @@
 #define system_get_canonical_sig() String_Const_u8 system_get_canonical(Arena* arena, String_Const_u8 name)
 #define system_get_file_list_sig() File_List system_get_file_list(Arena* arena, String_Const_u8 directory)
 #define system_quick_file_attributes_sig() File_Attributes system_quick_file_attributes(Arena* scratch, String_Const_u8 file_name)
+#define system_file_watch_add_sig() b32 system_file_watch_add(String_Const_u8 file_name)
+#define system_file_watch_remove_sig() void system_file_watch_remove(String_Const_u8 file_name)
+#define system_file_watch_wait_sig() File_Watch_Changes system_file_watch_wait(Arena* arena, u64 timeout_microseconds)
 #define system_load_handle_sig() b32 system_load_handle(Arena* scratch, char* file_name, Plat_Handle* out)
 #define system_load_attributes_sig() File_Attributes system_load_attributes(Plat_Handle handle)
-#define system_load_file_sig() b32 system_load_file(Plat_Handle handle, char* buffer, u32 size)
+#define system_load_file_sig() b32 system_load_file(Plat_Handle handle, char* buffer, u64 size)
+#define system_load_map_sig() String_Const_u8 system_load_map(Plat_Handle handle, u64 size)
+#define system_load_unmap_sig() void system_load_unmap(String_Const_u8 data)
 #define system_load_close_sig() b32 system_load_close(Plat_Handle handle)
-#define system_save_file_sig() File_Attributes system_save_file(Arena* scratch, char* file_name, String_Const_u8 data)
+#define system_save_file_sig() File_Attributes system_save_file(Arena* scratch, char* file_name, List_String_Const_u8 data)
+#define system_delete_file_sig() b32 system_delete_file(Arena* scratch, char* file_name)
+#define system_scratch_file_open_sig() b32 system_scratch_file_open(Arena* scratch, Plat_Handle* out)
+#define system_scratch_file_write_sig() b32 system_scratch_file_write(Plat_Handle handle, u64 pos, String_Const_u8 data)
+#define system_scratch_file_read_sig() b32 system_scratch_file_read(Plat_Handle handle, u64 pos, u8* buffer, u64 size)
+#define system_scratch_file_close_sig() void system_scratch_file_close(Plat_Handle handle)
 #define system_load_library_sig() b32 system_load_library(Arena* scratch, String_Const_u8 file_name, System_Library* out)
 #define system_release_library_sig() b32 system_release_library(System_Library handle)
 #define system_get_proc_sig() Void_Func* system_get_proc(System_Library handle, char* proc_name)
@@ -60,11 +70,21 @@ typedef String_Const_u8 system_get_path_type(Arena* arena, System_Path_Code path
 typedef String_Const_u8 system_get_canonical_type(Arena* arena, String_Const_u8 name);
 typedef File_List system_get_file_list_type(Arena* arena, String_Const_u8 directory);
 typedef File_Attributes system_quick_file_attributes_type(Arena* scratch, String_Const_u8 file_name);
+typedef b32 system_file_watch_add_type(String_Const_u8 file_name);
+typedef void system_file_watch_remove_type(String_Const_u8 file_name);
+typedef File_Watch_Changes system_file_watch_wait_type(Arena* arena, u64 timeout_microseconds);
 typedef b32 system_load_handle_type(Arena* scratch, char* file_name, Plat_Handle* out);
 typedef File_Attributes system_load_attributes_type(Plat_Handle handle);
-typedef b32 system_load_file_type(Plat_Handle handle, char* buffer, u32 size);
+typedef b32 system_load_file_type(Plat_Handle handle, char* buffer, u64 size);
+typedef String_Const_u8 system_load_map_type(Plat_Handle handle, u64 size);
+typedef void system_load_unmap_type(String_Const_u8 data);
 typedef b32 system_load_close_type(Plat_Handle handle);
-typedef File_Attributes system_save_file_type(Arena* scratch, char* file_name, String_Const_u8 data);
+typedef File_Attributes system_save_file_type(Arena* scratch, char* file_name, List_String_Const_u8 data);
+typedef b32 system_delete_file_type(Arena* scratch, char* file_name);
+typedef b32 system_scratch_file_open_type(Arena* scratch, Plat_Handle* out);
+typedef b32 system_scratch_file_write_type(Plat_Handle handle, u64 pos, String_Const_u8 data);
+typedef b32 system_scratch_file_read_type(Plat_Handle handle, u64 pos, u8* buffer, u64 size);
+typedef void system_scratch_file_close_type(Plat_Handle handle);
 typedef b32 system_load_library_type(Arena* scratch, String_Const_u8 file_name, System_Library* out);
 typedef b32 system_release_library_type(System_Library handle);
 typedef Void_Func* system_get_proc_type(System_Library handle, char* proc_name);
@@ -118,11 +138,21 @@ system_get_path_type *get_path;
 system_get_canonical_type *get_canonical;
 system_get_file_list_type *get_file_list;
 system_quick_file_attributes_type *quick_file_attributes;
+system_file_watch_add_type *file_watch_add;
+system_file_watch_remove_type *file_watch_remove;
+system_file_watch_wait_type *file_watch_wait;
 system_load_handle_type *load_handle;
 system_load_attributes_type *load_attributes;
 system_load_file_type *load_file;
+system_load_map_type *load_map;
+system_load_unmap_type *load_unmap;
 system_load_close_type *load_close;
 system_save_file_type *save_file;
+system_delete_file_type *delete_file;
+system_scratch_file_open_type *scratch_file_open;
+system_scratch_file_write_type *scratch_file_write;
+system_scratch_file_read_type *scratch_file_read;
+system_scratch_file_close_type *scratch_file_close;
 system_load_library_type *load_library;
 system_release_library_type *release_library;
 system_get_proc_type *get_proc;
@@ -177,11 +207,21 @@ internal String_Const_u8 system_get_path(Arena* arena, System_Path_Code path_cod
 internal String_Const_u8 system_get_canonical(Arena* arena, String_Const_u8 name);
 internal File_List system_get_file_list(Arena* arena, String_Const_u8 directory);
 internal File_Attributes system_quick_file_attributes(Arena* scratch, String_Const_u8 file_name);
+internal b32 system_file_watch_add(String_Const_u8 file_name);
+internal void system_file_watch_remove(String_Const_u8 file_name);
+internal File_Watch_Changes system_file_watch_wait(Arena* arena, u64 timeout_microseconds);
 internal b32 system_load_handle(Arena* scratch, char* file_name, Plat_Handle* out);
 internal File_Attributes system_load_attributes(Plat_Handle handle);
-internal b32 system_load_file(Plat_Handle handle, char* buffer, u32 size);
+internal b32 system_load_file(Plat_Handle handle, char* buffer, u64 size);
+internal String_Const_u8 system_load_map(Plat_Handle handle, u64 size);
+internal void system_load_unmap(String_Const_u8 data);
 internal b32 system_load_close(Plat_Handle handle);
-internal File_Attributes system_save_file(Arena* scratch, char* file_name, String_Const_u8 data);
+internal File_Attributes system_save_file(Arena* scratch, char* file_name, List_String_Const_u8 data);
+internal b32 system_delete_file(Arena* scratch, char* file_name);
+internal b32 system_scratch_file_open(Arena* scratch, Plat_Handle* out);
+internal b32 system_scratch_file_write(Plat_Handle handle, u64 pos, String_Const_u8 data);
+internal b32 system_scratch_file_read(Plat_Handle handle, u64 pos, u8* buffer, u64 size);
+internal void system_scratch_file_close(Plat_Handle handle);
 internal b32 system_load_library(Arena* scratch, String_Const_u8 file_name, System_Library* out);
 internal b32 system_release_library(System_Library handle);
 internal Void_Func* system_get_proc(System_Library handle, char* proc_name);
@@ -236,11 +276,21 @@ global system_get_path_type *system_get_path = 0;
 global system_get_canonical_type *system_get_canonical = 0;
 global system_get_file_list_type *system_get_file_list = 0;
 global system_quick_file_attributes_type *system_quick_file_attributes = 0;
+global system_file_watch_add_type *system_file_watch_add = 0;
+global system_file_watch_remove_type *system_file_watch_remove = 0;
+global system_file_watch_wait_type *system_file_watch_wait = 0;
 global system_load_handle_type *system_load_handle = 0;
 global system_load_attributes_type *system_load_attributes = 0;
 global system_load_file_type *system_load_file = 0;
+global system_load_map_type *system_load_map = 0;
+global system_load_unmap_type *system_load_unmap = 0;
 global system_load_close_type *system_load_close = 0;
 global system_save_file_type *system_save_file = 0;
+global system_delete_file_type *system_delete_file = 0;
+global system_scratch_file_open_type *system_scratch_file_open = 0;
+global system_scratch_file_write_type *system_scratch_file_write = 0;
+global system_scratch_file_read_type *system_scratch_file_read = 0;
+global system_scratch_file_close_type *system_scratch_file_close = 0;
 global system_load_library_type *system_load_library = 0;
 global system_release_library_type *system_release_library = 0;
 global system_get_proc_type *system_get_proc = 0;
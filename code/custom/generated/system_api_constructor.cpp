@@ -26,6 +26,19 @@ api_param(arena, call, "Arena*", "scratch");
 api_param(arena, call, "String_Const_u8", "file_name");
 }
 {
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("file_watch_add"), string_u8_litexpr("b32"), string_u8_litexpr(""));
+api_param(arena, call, "String_Const_u8", "file_name");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("file_watch_remove"), string_u8_litexpr("void"), string_u8_litexpr(""));
+api_param(arena, call, "String_Const_u8", "file_name");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("file_watch_wait"), string_u8_litexpr("File_Watch_Changes"), string_u8_litexpr(""));
+api_param(arena, call, "Arena*", "arena");
+api_param(arena, call, "u64", "timeout_microseconds");
+}
+{
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("load_handle"), string_u8_litexpr("b32"), string_u8_litexpr(""));
 api_param(arena, call, "Arena*", "scratch");
 api_param(arena, call, "char*", "file_name");
@@ -39,7 +52,16 @@ api_param(arena, call, "Plat_Handle", "handle");
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("load_file"), string_u8_litexpr("b32"), string_u8_litexpr(""));
 api_param(arena, call, "Plat_Handle", "handle");
 api_param(arena, call, "char*", "buffer");
-api_param(arena, call, "u32", "size");
+api_param(arena, call, "u64", "size");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("load_map"), string_u8_litexpr("String_Const_u8"), string_u8_litexpr(""));
+api_param(arena, call, "Plat_Handle", "handle");
+api_param(arena, call, "u64", "size");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("load_unmap"), string_u8_litexpr("void"), string_u8_litexpr(""));
+api_param(arena, call, "String_Const_u8", "data");
 }
 {
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("load_close"), string_u8_litexpr("b32"), string_u8_litexpr(""));
@@ -49,9 +71,36 @@ api_param(arena, call, "Plat_Handle", "handle");
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("save_file"), string_u8_litexpr("File_Attributes"), string_u8_litexpr(""));
 api_param(arena, call, "Arena*", "scratch");
 api_param(arena, call, "char*", "file_name");
+api_param(arena, call, "List_String_Const_u8", "data");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("delete_file"), string_u8_litexpr("b32"), string_u8_litexpr(""));
+api_param(arena, call, "Arena*", "scratch");
+api_param(arena, call, "char*", "file_name");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("scratch_file_open"), string_u8_litexpr("b32"), string_u8_litexpr(""));
+api_param(arena, call, "Arena*", "scratch");
+api_param(arena, call, "Plat_Handle*", "out");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("scratch_file_write"), string_u8_litexpr("b32"), string_u8_litexpr(""));
+api_param(arena, call, "Plat_Handle", "handle");
+api_param(arena, call, "u64", "pos");
 api_param(arena, call, "String_Const_u8", "data");
 }
 {
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("scratch_file_read"), string_u8_litexpr("b32"), string_u8_litexpr(""));
+api_param(arena, call, "Plat_Handle", "handle");
+api_param(arena, call, "u64", "pos");
+api_param(arena, call, "u8*", "buffer");
+api_param(arena, call, "u64", "size");
+}
+{
+API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("scratch_file_close"), string_u8_litexpr("void"), string_u8_litexpr(""));
+api_param(arena, call, "Plat_Handle", "handle");
+}
+{
 API_Call *call = api_call_with_location(arena, result, string_u8_litexpr("load_library"), string_u8_litexpr("b32"), string_u8_litexpr(""));
 api_param(arena, call, "Arena*", "scratch");
 api_param(arena, call, "String_Const_u8", "file_name");
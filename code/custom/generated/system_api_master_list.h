@@ -3,11 +3,21 @@ api(system) function String_Const_u8 get_path(Arena* arena, System_Path_Code pat
 api(system) function String_Const_u8 get_canonical(Arena* arena, String_Const_u8 name);
 api(system) function File_List get_file_list(Arena* arena, String_Const_u8 directory);
 api(system) function File_Attributes quick_file_attributes(Arena* scratch, String_Const_u8 file_name);
+api(system) function b32 file_watch_add(String_Const_u8 file_name);
+api(system) function void file_watch_remove(String_Const_u8 file_name);
+api(system) function File_Watch_Changes file_watch_wait(Arena* arena, u64 timeout_microseconds);
 api(system) function b32 load_handle(Arena* scratch, char* file_name, Plat_Handle* out);
 api(system) function File_Attributes load_attributes(Plat_Handle handle);
-api(system) function b32 load_file(Plat_Handle handle, char* buffer, u32 size);
+api(system) function b32 load_file(Plat_Handle handle, char* buffer, u64 size);
+api(system) function String_Const_u8 load_map(Plat_Handle handle, u64 size);
+api(system) function void load_unmap(String_Const_u8 data);
 api(system) function b32 load_close(Plat_Handle handle);
-api(system) function File_Attributes save_file(Arena* scratch, char* file_name, String_Const_u8 data);
+api(system) function File_Attributes save_file(Arena* scratch, char* file_name, List_String_Const_u8 data);
+api(system) function b32 delete_file(Arena* scratch, char* file_name);
+api(system) function b32 scratch_file_open(Arena* scratch, Plat_Handle* out);
+api(system) function b32 scratch_file_write(Plat_Handle handle, u64 pos, String_Const_u8 data);
+api(system) function b32 scratch_file_read(Plat_Handle handle, u64 pos, u8* buffer, u64 size);
+api(system) function void scratch_file_close(Plat_Handle handle);
 api(system) function b32 load_library(Arena* scratch, String_Const_u8 file_name, System_Library* out);
 api(system) function b32 release_library(System_Library handle);
 api(system) function Void_Func* get_proc(System_Library handle, char* proc_name);
@@ -1170,6 +1170,44 @@ doc_custom_api__buffer(Arena *arena, API_Definition *api_def, Doc_Cluster *clust
         Doc_Block *ret = doc_function_return(arena, &func);
         doc_text(arena, ret, "a linked list of matches to the search pattern");
     }
+    
+    ////////////////////////////////
+    
+    if (begin_doc_call(arena, cluster, api_def, "buffer_find_all_matches_parallel", &func)){
+        doc_function_brief(arena, &func, "Find all matches for a set of search patterns in many buffers, spreading the buffers over several threads");
+        
+        // params
+        Doc_Block *params = doc_function_begin_params(arena, &func);
+        doc_custom_app_ptr(arena, &func);
+        
+        doc_function_param(arena, &func, "arena");
+        doc_text(arena, params, "the arena on which the returned matches will be allocated");
+        
+        doc_function_param(arena, &func, "buffers");
+        doc_text(arena, params, "an array of the ids of the buffers to search");
+        
+        doc_function_param(arena, &func, "buffer_count");
+        doc_text(arena, params, "the number of buffer ids in buffers");
+        
+        doc_function_param(arena, &func, "needles");
+        doc_text(arena, params, "the strings to search for, the index of each string is stored as the string id of its matches");
+        
+        doc_function_param(arena, &func, "predicate");
+        doc_text(arena, params, "a character predicate used to check the left and right side of the match to add left sloppy and right sloppy match flags.");
+        
+        doc_function_param(arena, &func, "must_have_flags");
+        doc_text(arena, params, "matches that do not have all of these flags are dropped");
+        
+        doc_function_param(arena, &func, "must_not_have_flags");
+        doc_text(arena, params, "matches that have any of these flags are dropped");
+        
+        doc_function_param(arena, &func, "thread_count");
+        doc_text(arena, params, "the number of threads to search on, including the calling thread");
+        
+        // return
+        Doc_Block *ret = doc_function_return(arena, &func);
+        doc_text(arena, ret, "a linked list of matches ordered by buffer in the order of the buffers array, and by position within each buffer");
+    }
 }
 
 // BOTTOM
@@ -819,6 +819,10 @@ doc_custom_api__global(Arena *arena, API_Definition *api_def, Doc_Cluster *clust
         doc_function_param(arena, &func, "func_ptr");
         doc_text(arena, params, "a pointer to the hook function, the function pointer must have a specific signature to match the hook_id's expected signature, but this call does not do the type checking for this, so watch out for that");
         
+        // details
+        Doc_Block *det = doc_function_details(arena, &func);
+        doc_text(arena, det, "Setting a hook replaces whatever is set for it, including a hook that a helper chained in front of the previous one. In the default custom layer prj_open_files_pattern_filter puts prj_load_tick in front of HookID_Tick until the files it opens have buffers. A tick hook set before that finishes has to call prj_load_update_tick every frame, or the project files stop opening.");
+        
         // related
         Doc_Block *rel = doc_function_begin_related(arena, &func);
         doc_function_add_related(arena, rel, "Hook_ID");
@@ -32,6 +32,8 @@ GL_FUNC(glGenBuffers, void, (GLsizei n, GLuint *buffers))
 GL_FUNC(glBindBuffer, void, (GLenum target, GLuint buffer))
 GL_FUNC(glBufferData, void, (GLenum target, GLsizeiptr size, const void *data, GLenum usage))
 GL_FUNC(glBufferSubData, void, (GLenum target, GLsizeiptr offset, GLsizeiptr size, const void *data))
+GL_FUNC(glMapBufferRange, void*, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))
+GL_FUNC(glUnmapBuffer, GLboolean, (GLenum target))
 
 GL_FUNC(glCreateShader, GLuint, (GLenum type))
 GL_FUNC(glShaderSource, void, (GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length))
@@ -58,6 +60,9 @@ GL_FUNC(glEnableVertexAttribArray, void, (GLuint index))
 GL_FUNC(glVertexAttribPointer, void, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer))
 
 GL_FUNC(glVertexAttribIPointer, void, (GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer))
+GL_FUNC(glVertexAttribDivisor, void, (GLuint index, GLuint divisor))
+
+GL_FUNC(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount))
 
 GL_FUNC(glUniform1f, void, (GLint location, GLfloat v0))
 GL_FUNC(glUniform2f, void, (GLint location, GLfloat v0, GLfloat v1))
@@ -99,6 +104,12 @@ GL_FUNC(glGenVertexArrays,    void, (GLsizei n, GLuint *arrays))
 GL_FUNC(glBindVertexArray,    void, (GLuint array))
 
 GL_FUNC(glVertexAttribIPointer, void, (GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer))
+GL_FUNC(glVertexAttribDivisor, void, (GLuint index, GLuint divisor))
+
+GL_FUNC(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount))
+
+GL_FUNC(glMapBufferRange, void*, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))
+GL_FUNC(glUnmapBuffer, GLboolean, (GLenum target))
 
 #endif
 
@@ -99,6 +99,68 @@ char *gl__vertex = R"foo(
         }
         )foo";
 
+// NOTE: Instances are expanded into a four vertex triangle strip,
+// gl_VertexID picks the corner.
+char *gl__glyph_vertex = R"foo(
+        uniform vec2 view_t;
+        uniform mat2x2 view_m;
+        uniform float atlas_inv_dim;
+        in vec2 glyph_p;
+        in uint glyph_c;
+        in uint glyph_texel;
+        in uint glyph_dim_page;
+        smooth out vec4 fragment_color;
+        smooth out vec3 uvw;
+        smooth out vec2 xy;
+        smooth out vec2 adjusted_half_dim;
+        smooth out float half_thickness;
+        void main(void)
+        {
+        vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+        vec2 dim = vec2(float(glyph_dim_page & 0xFFFu), float((glyph_dim_page >> 12u) & 0xFFFu));
+        vec2 texel = vec2(float(glyph_texel & 0xFFFFu), float(glyph_texel >> 16u));
+        vec2 p = glyph_p + corner*dim;
+        gl_Position = vec4(view_m*(p - view_t), 0.0, 1.0);
+        fragment_color.b = (float((glyph_c     )&0xFFu))/255.0;
+        fragment_color.g = (float((glyph_c>> 8u)&0xFFu))/255.0;
+        fragment_color.r = (float((glyph_c>>16u)&0xFFu))/255.0;
+        fragment_color.a = (float((glyph_c>>24u)&0xFFu))/255.0;
+        uvw = vec3((texel + corner*dim)*atlas_inv_dim, float(glyph_dim_page >> 24u));
+        adjusted_half_dim = vec2(0.0, 0.0);
+        half_thickness = 0.0;
+        xy = p;
+        }
+        )foo";
+
+char *gl__rect_vertex = R"foo(
+        uniform vec2 view_t;
+        uniform mat2x2 view_m;
+        in vec4 rect_r;
+        in uint rect_c;
+        in vec2 rect_s;
+        smooth out vec4 fragment_color;
+        smooth out vec3 uvw;
+        smooth out vec2 xy;
+        smooth out vec2 adjusted_half_dim;
+        smooth out float half_thickness;
+        void main(void)
+        {
+        vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+        vec2 p = mix(rect_r.xy, rect_r.zw, corner);
+        gl_Position = vec4(view_m*(p - view_t), 0.0, 1.0);
+        fragment_color.b = (float((rect_c     )&0xFFu))/255.0;
+        fragment_color.g = (float((rect_c>> 8u)&0xFFu))/255.0;
+        fragment_color.r = (float((rect_c>>16u)&0xFFu))/255.0;
+        fragment_color.a = (float((rect_c>>24u)&0xFFu))/255.0;
+        vec2 center = (rect_r.xy + rect_r.zw)*0.5;
+        vec2 half_dim = abs(p - center);
+        uvw = vec3(center, rect_s.x);
+        adjusted_half_dim = half_dim - rect_s.xx + vec2(0.5, 0.5);
+        half_thickness = rect_s.y;
+        xy = p;
+        }
+        )foo";
+
 char *gl__fragment = R"foo(
         smooth in vec4 fragment_color;
         smooth in vec3 uvw;
@@ -137,12 +199,20 @@ char *gl__fragment = R"foo(
 X(vertex_p) \
 X(vertex_t) \
 X(vertex_c) \
-X(vertex_ht)
+X(vertex_ht) \
+X(glyph_p) \
+X(glyph_c) \
+X(glyph_texel) \
+X(glyph_dim_page) \
+X(rect_r) \
+X(rect_c) \
+X(rect_s)
 
 #define UniformList(X) \
 X(view_t) \
 X(view_m) \
-X(sampler)
+X(sampler) \
+X(atlas_inv_dim)
 
 struct GL_Program{
     u32 program;
@@ -208,14 +278,97 @@ gl__make_program(char *header, char *vertex, char *fragment){
 
 #define GLOffsetStruct(p,m) ((void*)(OffsetOfMemberStruct(p,m)))
 #define GLOffset(S,m) ((void*)(OffsetOfMember(S,m)))
+#define GLOffsetAt(b,S,m) ((void*)((b) + OffsetOfMember(S,m)))
+
+// NOTE: All of a frame's vertices and instances are written into one
+// stream buffer through a single unsynchronized map.  The write cursor only
+// moves forward, when a frame doesn't fit in the rest of the buffer the storage
+// is orphaned and writing starts over at zero, so the driver never has to wait
+// on draws still reading from earlier frames.
+struct GL_Stream_Buffer{
+    u32 buffer;
+    u64 size;
+    u64 cursor;
+};
+
+internal u64
+gl__group_data_size(Render_Group *group){
+    u64 result = 0;
+    if (group->kind == RenderGroupKind_Vertices){
+        result = group->vertex_list.vertex_count*sizeof(Render_Vertex);
+    }
+    else{
+        result = group->instance_list.count*render_instance_sizes[group->kind];
+    }
+    return(round_up_u64(result, 16));
+}
+
+internal u8*
+gl__stream_map(GL_Stream_Buffer *stream, u64 size){
+    u8 *result = 0;
+    if (size > 0){
+        if (stream->cursor + size > stream->size){
+            if (size > stream->size){
+                stream->size = round_up_u64(size*2, MB(1));
+            }
+            glBufferData(GL_ARRAY_BUFFER, stream->size, 0, GL_STREAM_DRAW);
+            stream->cursor = 0;
+        }
+        result = (u8*)glMapBufferRange(GL_ARRAY_BUFFER, stream->cursor, size,
+                                       GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_RANGE_BIT|GL_MAP_UNSYNCHRONIZED_BIT);
+    }
+    return(result);
+}
+
+internal void
+gl__write_group_data(u8 *dst, Render_Group *group){
+    if (group->kind == RenderGroupKind_Vertices){
+        for (Render_Vertex_Array_Node *node = group->vertex_list.first;
+             node != 0;
+             node = node->next){
+            u64 size = node->vertex_count*sizeof(*node->vertices);
+            block_copy(dst, node->vertices, size);
+            dst += size;
+        }
+    }
+    else{
+        u64 instance_size = render_instance_sizes[group->kind];
+        for (Render_Instance_Array_Node *node = group->instance_list.first;
+             node != 0;
+             node = node->next){
+            u64 size = node->count*instance_size;
+            block_copy(dst, node->data, size);
+            dst += size;
+        }
+    }
+}
+
+internal void
+gl__attribute(i32 location, i32 divisor){
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, divisor);
+}
+
+internal void
+gl__set_view(GL_Program *program, i32 width, i32 height){
+    glUniform2f(program->view_t, width/2.f, height/2.f);
+    f32 m[4] = {
+        2.f/width, 0.f,
+        0.f, -2.f/height,
+    };
+    glUniformMatrix2fv(program->view_m, 1, GL_FALSE, m);
+    glUniform1i(program->sampler, 0);
+}
 
 internal void
 gl_render(Render_Target *t){
+    u64 submit_begin = system_now_time();
+    
     Font_Set *font_set = (Font_Set*)t->font_set;
     
     local_persist b32 first_opengl_call = true;
-    local_persist u32 attribute_buffer = 0;
-    local_persist GL_Program gpu_program = {};
+    local_persist GL_Stream_Buffer stream = {};
+    local_persist GL_Program programs[RenderGroupKind_COUNT] = {};
     
     if (first_opengl_call){
         first_opengl_call = false;
@@ -243,8 +396,10 @@ gl_render(Render_Target *t){
         
         ////////////////////////////////
         
-        glGenBuffers(1, &attribute_buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, attribute_buffer);
+        glGenBuffers(1, &stream.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+        stream.size = MB(4);
+        glBufferData(GL_ARRAY_BUFFER, stream.size, 0, GL_STREAM_DRAW);
         
         ////////////////////////////////
         
@@ -254,8 +409,11 @@ gl_render(Render_Target *t){
         
         ////////////////////////////////
         
-        gpu_program = gl__make_program(gl__header, gl__vertex, gl__fragment);
-        glUseProgram(gpu_program.program);
+        programs[RenderGroupKind_Vertices] = gl__make_program(gl__header, gl__vertex, gl__fragment);
+        programs[RenderGroupKind_Glyphs] = gl__make_program(gl__header, gl__glyph_vertex, gl__fragment);
+        programs[RenderGroupKind_Rects] = gl__make_program(gl__header, gl__rect_vertex, gl__fragment);
+        glUseProgram(programs[RenderGroupKind_Glyphs].program);
+        glUniform1f(programs[RenderGroupKind_Glyphs].atlas_inv_dim, 1.f/(f32)FACE_ATLAS_PAGE_DIM);
         
         ////////////////////////////////
         
@@ -264,6 +422,9 @@ gl_render(Render_Target *t){
             u8 white_block[] = { 0xFF, 0xFF, 0xFF, 0xFF, };
             gl__fill_texture(TextureKind_Mono, 0, V3i32(0, 0, 0), V3i32(2, 2, 1), white_block);
         }
+        
+        // NOTE: Frames from here on emit glyphs and rectangles as instances.
+        t->instanced = true;
     }
     
     i32 width = t->width;
@@ -285,22 +446,50 @@ gl_render(Render_Target *t){
     t->free_texture_first = 0;
     t->free_texture_last = 0;
     
+    // NOTE: Upload the whole frame
+    u64 frame_size = 0;
     for (Render_Group *group = t->group_first;
          group != 0;
          group = group->next){
-        Rect_i32 box = Ri32(group->clip_box);
-        
-        Rect_i32 scissor_box = {
-            box.x0, height - box.y1, box.x1 - box.x0, box.y1 - box.y0,
-        };
-        scissor_box.x0 = clamp_bot(0, scissor_box.x0);
-        scissor_box.y0 = clamp_bot(0, scissor_box.y0);
-        scissor_box.x1 = clamp_bot(0, scissor_box.x1);
-        scissor_box.y1 = clamp_bot(0, scissor_box.y1);
-        glScissor(scissor_box.x0, scissor_box.y0, scissor_box.x1, scissor_box.y1);
-        
-        i32 vertex_count = group->vertex_list.vertex_count;
-        if (vertex_count > 0){
+        frame_size += gl__group_data_size(group);
+    }
+    u8 *frame_data = gl__stream_map(&stream, frame_size);
+    u64 frame_base = stream.cursor;
+    if (frame_data != 0){
+        u64 offset = 0;
+        for (Render_Group *group = t->group_first;
+             group != 0;
+             group = group->next){
+            gl__write_group_data(frame_data + offset, group);
+            offset += gl__group_data_size(group);
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        stream.cursor += frame_size;
+    }
+    
+    for (i32 i = 0; i < RenderGroupKind_COUNT; i += 1){
+        glUseProgram(programs[i].program);
+        gl__set_view(&programs[i], width, height);
+    }
+    Render_Group_Kind current_kind = RenderGroupKind_COUNT - 1;
+    
+    u64 group_offset = frame_base;
+    for (Render_Group *group = t->group_first;
+         group != 0;
+         group = group->next){
+        u64 group_size = gl__group_data_size(group);
+        if (group_size > 0 && frame_data != 0){
+            Rect_i32 box = Ri32(group->clip_box);
+            
+            Rect_i32 scissor_box = {
+                box.x0, height - box.y1, box.x1 - box.x0, box.y1 - box.y0,
+            };
+            scissor_box.x0 = clamp_bot(0, scissor_box.x0);
+            scissor_box.y0 = clamp_bot(0, scissor_box.y0);
+            scissor_box.x1 = clamp_bot(0, scissor_box.x1);
+            scissor_box.y1 = clamp_bot(0, scissor_box.y1);
+            glScissor(scissor_box.x0, scissor_box.y0, scissor_box.x1, scissor_box.y1);
+            
             Face *face = font_set_face_from_id(font_set, group->face_id);
             if (face != 0){
                 gl__bind_texture(t, face->texture);
@@ -309,47 +498,84 @@ gl_render(Render_Target *t){
                 gl__bind_any_texture(t);
             }
             
-            glBufferData(GL_ARRAY_BUFFER, vertex_count*sizeof(Render_Vertex), 0, GL_STREAM_DRAW);
-            i32 cursor = 0;
-            for (Render_Vertex_Array_Node *node = group->vertex_list.first;
-                 node != 0;
-                 node = node->next){
-                i32 size = node->vertex_count*sizeof(*node->vertices);
-                glBufferSubData(GL_ARRAY_BUFFER, cursor, size, node->vertices);
-                cursor += size;
+            if (current_kind != group->kind){
+                current_kind = group->kind;
+                glUseProgram(programs[current_kind].program);
+            }
+            GL_Program *program = &programs[current_kind];
+            u8 *base = (u8*)IntAsPtr(group_offset);
+            switch (group->kind){
+                case RenderGroupKind_Vertices:
+                {
+                    gl__attribute(program->vertex_p, 0);
+                    gl__attribute(program->vertex_t, 0);
+                    gl__attribute(program->vertex_c, 0);
+                    gl__attribute(program->vertex_ht, 0);
+                    glVertexAttribPointer(program->vertex_p, 2, GL_FLOAT, true, sizeof(Render_Vertex),
+                                          GLOffsetAt(base, Render_Vertex, xy));
+                    glVertexAttribPointer(program->vertex_t, 3, GL_FLOAT, true, sizeof(Render_Vertex),
+                                          GLOffsetAt(base, Render_Vertex, uvw));
+                    glVertexAttribIPointer(program->vertex_c, 1, GL_UNSIGNED_INT, sizeof(Render_Vertex),
+                                           GLOffsetAt(base, Render_Vertex, color));
+                    glVertexAttribPointer(program->vertex_ht, 1, GL_FLOAT, true, sizeof(Render_Vertex),
+                                          GLOffsetAt(base, Render_Vertex, half_thickness));
+                    
+                    glDrawArrays(GL_TRIANGLES, 0, group->vertex_list.vertex_count);
+                    glDisableVertexAttribArray(program->vertex_p);
+                    glDisableVertexAttribArray(program->vertex_t);
+                    glDisableVertexAttribArray(program->vertex_c);
+                    glDisableVertexAttribArray(program->vertex_ht);
+                }break;
+                
+                case RenderGroupKind_Glyphs:
+                {
+                    gl__attribute(program->glyph_p, 1);
+                    gl__attribute(program->glyph_c, 1);
+                    gl__attribute(program->glyph_texel, 1);
+                    gl__attribute(program->glyph_dim_page, 1);
+                    glVertexAttribPointer(program->glyph_p, 2, GL_FLOAT, false, sizeof(Render_Glyph_Instance),
+                                          GLOffsetAt(base, Render_Glyph_Instance, p));
+                    glVertexAttribIPointer(program->glyph_c, 1, GL_UNSIGNED_INT, sizeof(Render_Glyph_Instance),
+                                           GLOffsetAt(base, Render_Glyph_Instance, color));
+                    glVertexAttribIPointer(program->glyph_texel, 1, GL_UNSIGNED_INT, sizeof(Render_Glyph_Instance),
+                                           GLOffsetAt(base, Render_Glyph_Instance, texel));
+                    glVertexAttribIPointer(program->glyph_dim_page, 1, GL_UNSIGNED_INT, sizeof(Render_Glyph_Instance),
+                                           GLOffsetAt(base, Render_Glyph_Instance, dim_page));
+                    
+                    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, group->instance_list.count);
+                    glDisableVertexAttribArray(program->glyph_p);
+                    glDisableVertexAttribArray(program->glyph_c);
+                    glDisableVertexAttribArray(program->glyph_texel);
+                    glDisableVertexAttribArray(program->glyph_dim_page);
+                }break;
+                
+                case RenderGroupKind_Rects:
+                {
+                    gl__attribute(program->rect_r, 1);
+                    gl__attribute(program->rect_c, 1);
+                    gl__attribute(program->rect_s, 1);
+                    glVertexAttribPointer(program->rect_r, 4, GL_FLOAT, false, sizeof(Render_Rect_Instance),
+                                          GLOffsetAt(base, Render_Rect_Instance, rect));
+                    glVertexAttribIPointer(program->rect_c, 1, GL_UNSIGNED_INT, sizeof(Render_Rect_Instance),
+                                           GLOffsetAt(base, Render_Rect_Instance, color));
+                    glVertexAttribPointer(program->rect_s, 2, GL_FLOAT, false, sizeof(Render_Rect_Instance),
+                                          GLOffsetAt(base, Render_Rect_Instance, roundness));
+                    
+                    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, group->instance_list.count);
+                    glDisableVertexAttribArray(program->rect_r);
+                    glDisableVertexAttribArray(program->rect_c);
+                    glDisableVertexAttribArray(program->rect_s);
+                }break;
             }
-            
-            glEnableVertexAttribArray(gpu_program.vertex_p);
-            glEnableVertexAttribArray(gpu_program.vertex_t);
-            glEnableVertexAttribArray(gpu_program.vertex_c);
-            glEnableVertexAttribArray(gpu_program.vertex_ht);
-            
-            glVertexAttribPointer(gpu_program.vertex_p, 2, GL_FLOAT, true, sizeof(Render_Vertex),
-                                  GLOffset(Render_Vertex, xy));
-            glVertexAttribPointer(gpu_program.vertex_t, 3, GL_FLOAT, true, sizeof(Render_Vertex),
-                                  GLOffset(Render_Vertex, uvw));
-            glVertexAttribIPointer(gpu_program.vertex_c, 1, GL_UNSIGNED_INT, sizeof(Render_Vertex),
-                                   GLOffset(Render_Vertex, color));
-            glVertexAttribPointer(gpu_program.vertex_ht, 1, GL_FLOAT, true, sizeof(Render_Vertex),
-                                  GLOffset(Render_Vertex, half_thickness));
-            
-            glUniform2f(gpu_program.view_t, width/2.f, height/2.f);
-            f32 m[4] = {
-                2.f/width, 0.f,
-                0.f, -2.f/height,
-            };
-            glUniformMatrix2fv(gpu_program.view_m, 1, GL_FALSE, m);
-            glUniform1i(gpu_program.sampler, 0);
-            
-            glDrawArrays(GL_TRIANGLES, 0, vertex_count);
-            glDisableVertexAttribArray(gpu_program.vertex_p);
-            glDisableVertexAttribArray(gpu_program.vertex_t);
-            glDisableVertexAttribArray(gpu_program.vertex_c);
-            glDisableVertexAttribArray(gpu_program.vertex_ht);
         }
+        group_offset += group_size;
     }
     
     glFlush();
+    
+    t->submit_time += system_now_time() - submit_begin;
+    t->submit_bytes += frame_size;
+    t->submit_frame_count += 1;
 }
 
 // BOTTOM
@@ -61,6 +61,8 @@
 #include "4ed_mem.cpp"
 #include "4ed_font_set.cpp"
 #include "4coder_search_list.cpp"
+#include "4ed_font_cache.h"
+#include "4ed_font_cache.cpp"
 #include "4ed_font_provider_freetype.h"
 #include "4ed_font_provider_freetype.cpp"
 
@@ -75,9 +77,11 @@
 #include <pthread.h>
 
 #include <sys/epoll.h>
+#include <sys/inotify.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <sys/timerfd.h>
 #include <sys/eventfd.h>
@@ -148,6 +152,15 @@ struct Linux_Input_Chunk {
     Linux_Input_Chunk_Persistent pers;
 };
 
+// NOTE: One inotify watch per directory, shared by every watched file inside it.
+// A wd of -1 means the kernel dropped the watch (directory deleted or moved).
+struct Linux_File_Watch_Dir {
+    Linux_File_Watch_Dir* next;
+    String_Const_u8 name;
+    int wd;
+    i32 ref_count;
+};
+
 struct Linux_Memory_Tracker_Node {
     Linux_Memory_Tracker_Node* prev;
     Linux_Memory_Tracker_Node* next;
@@ -200,6 +213,13 @@ struct Linux_Vars {
     b32 received_new_clipboard;
     b32 clipboard_catch_all;
     
+    pthread_mutex_t file_watch_mutex;
+    int file_watch_fd;
+    int file_watch_epoll;
+    Table_Data_u64 file_watch_dir_table;
+    Table_u64_u64 file_watch_wd_table;
+    Linux_File_Watch_Dir* free_file_watch_dirs;
+    
     pthread_mutex_t audio_mutex;
     pthread_cond_t audio_cond;
     void* audio_ctx;
@@ -590,6 +610,23 @@ graphics_fill_texture_sig(){
 
 ////////////////////////////
 
+internal String_Const_u8
+linux_font_cache_directory(Arena* arena) {
+    String_Const_u8 result = {};
+    String_Const_u8 user_dir = system_get_path(arena, SystemPath_UserDirectory);
+    if(user_dir.size > 0) {
+        if(!character_is_slash(string_get_character(user_dir, user_dir.size - 1))) {
+            user_dir = push_u8_stringf(arena, "%.*s/", string_expand(user_dir));
+        }
+        String_Const_u8 cache_dir = push_u8_stringf(arena, "%.*sfont_cache/", string_expand(user_dir));
+        b32 has_user_dir = (mkdir((char*)user_dir.str, 0755) == 0 || errno == EEXIST);
+        if(has_user_dir && (mkdir((char*)cache_dir.str, 0755) == 0 || errno == EEXIST)) {
+            result = cache_dir;
+        }
+    }
+    return(result);
+}
+
 internal Face*
 font_make_face(Arena* arena, Face_Description* description, f32 scale_factor) {
     
@@ -602,7 +639,8 @@ font_make_face(Arena* arena, Face_Description* description, f32 scale_factor) {
         *name = push_u8_stringf(arena, "%.*sfonts/%.*s", string_expand(binary), string_expand(*name));
     }
     
-    Face* result = ft__font_make_face(arena, &local_description, scale_factor);
+    String_Const_u8 cache_dir = linux_font_cache_directory(arena);
+    Face* result = ft__font_make_face(arena, &local_description, scale_factor, cache_dir);
     
     if(!result) {
         // is this fatal? 4ed.cpp:277 (caller) does not check for null.
@@ -1762,6 +1800,8 @@ main(int argc, char **argv){
     pthread_mutex_init(&linuxvars.audio_mutex, &attr);
     pthread_cond_init(&linuxvars.audio_cond, NULL);
     
+    linux_file_watch_init();
+    
     // NOTE(allen): context setup
     {
         Base_Allocator* alloc = get_base_allocator_system();
@@ -2016,6 +2056,17 @@ main(int argc, char **argv){
         gl_render(&render_target);
         glXSwapBuffers(linuxvars.dpy, linuxvars.win);
         
+        // NOTE: Report the cost of frame submission
+        if (render_target.submit_frame_count >= 120){
+            i32 frame_count = render_target.submit_frame_count;
+            log_os("render submit: %.3fms cpu/frame, %lluKB/frame over %d frames\n",
+                   (f64)render_target.submit_time/(1000.0*frame_count),
+                   (unsigned long long)(render_target.submit_bytes/(KB(1)*frame_count)), frame_count);
+            render_target.submit_time = 0;
+            render_target.submit_bytes = 0;
+            render_target.submit_frame_count = 0;
+        }
+        
         // TODO(allen): don't let the screen size change until HERE after the render
         
         // NOTE(allen): Schedule a step if necessary
@@ -57,6 +57,23 @@ system_get_path(Arena* arena, System_Path_Code path_code){
                 result = SCu8((u8*)lnx_override_user_directory);
             }
         }break;
+        
+        case SystemPath_TempDirectory:
+        {
+            char *temp_cstr = getenv("TMPDIR");
+            if (temp_cstr != 0 && temp_cstr[0] != 0){
+                String_Const_u8 temp_dir = SCu8(temp_cstr);
+                if (string_get_character(temp_dir, temp_dir.size - 1) == '/'){
+                    result = push_string_copy(arena, temp_dir);
+                }
+                else{
+                    result = push_u8_stringf(arena, "%s/", temp_cstr);
+                }
+            }
+            else{
+                result = push_string_copy(arena, string_u8_litexpr("/tmp/"));
+            }
+        }break;
     }
     
     return(result);
@@ -192,6 +209,198 @@ system_quick_file_attributes(Arena* scratch, String_Const_u8 file_name){
     return(result);
 }
 
+////////////////////////////////
+
+#define LINUX_FILE_WATCH_MASK (IN_MODIFY|IN_ATTRIB|IN_CLOSE_WRITE|IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_MOVE_SELF|IN_ONLYDIR|IN_EXCL_UNLINK)
+
+internal void
+linux_file_watch_init(void){
+    pthread_mutex_init(&linuxvars.file_watch_mutex, NULL);
+    linuxvars.file_watch_epoll = -1;
+    linuxvars.file_watch_fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if (linuxvars.file_watch_fd != -1){
+        linuxvars.file_watch_epoll = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event e = {};
+        e.events = EPOLLIN;
+        if (linuxvars.file_watch_epoll == -1 ||
+            epoll_ctl(linuxvars.file_watch_epoll, EPOLL_CTL_ADD, linuxvars.file_watch_fd, &e) != 0){
+            log_os("inotify unavailable, polling files for external changes\n");
+            close(linuxvars.file_watch_fd);
+            linuxvars.file_watch_fd = -1;
+        }
+    }
+    Base_Allocator* allocator = get_base_allocator_system();
+    linuxvars.file_watch_dir_table = make_table_Data_u64(allocator, 64);
+    linuxvars.file_watch_wd_table = make_table_u64_u64(allocator, 64);
+}
+
+internal String_Const_u8
+linux_file_watch_dir_name(String_Const_u8 file_name){
+    String_Const_u8 result = string_remove_front_of_path(file_name);
+    if (result.size > 1 && result.str[result.size - 1] == '/'){
+        result.size -= 1;
+    }
+    return(result);
+}
+
+internal void
+linux_file_watch_free_dir(Linux_File_Watch_Dir* dir){
+    table_erase(&linuxvars.file_watch_dir_table, make_data(dir->name.str, dir->name.size));
+    base_free(get_base_allocator_system(), dir->name.str);
+    block_zero_struct(&dir->name);
+    sll_stack_push(linuxvars.free_file_watch_dirs, dir);
+}
+
+internal b32
+system_file_watch_add(String_Const_u8 file_name){
+    b32 result = false;
+    String_Const_u8 dir_name = linux_file_watch_dir_name(file_name);
+    if (linuxvars.file_watch_fd != -1 && dir_name.size > 0){
+        pthread_mutex_lock(&linuxvars.file_watch_mutex);
+        
+        Linux_File_Watch_Dir* dir = 0;
+        u64 val = 0;
+        if (table_read(&linuxvars.file_watch_dir_table, make_data(dir_name.str, dir_name.size), &val)){
+            dir = (Linux_File_Watch_Dir*)IntAsPtr(val);
+        }
+        else{
+            dir = linuxvars.free_file_watch_dirs;
+            if (dir != 0){
+                sll_stack_pop(linuxvars.free_file_watch_dirs);
+            }
+            else{
+                dir = base_array(get_base_allocator_system(), Linux_File_Watch_Dir, 1);
+            }
+            block_zero_struct(dir);
+            u8* name = base_array(get_base_allocator_system(), u8, dir_name.size + 1);
+            block_copy(name, dir_name.str, dir_name.size);
+            name[dir_name.size] = 0;
+            dir->name = SCu8(name, dir_name.size);
+            dir->wd = -1;
+            table_insert(&linuxvars.file_watch_dir_table, make_data(dir->name.str, dir->name.size), (u64)PtrAsInt(dir));
+        }
+        
+        if (dir->wd == -1){
+            // NOTE: ENOSPC here means max_user_watches is used up, the caller
+            // falls back to polling this file.
+            int wd = inotify_add_watch(linuxvars.file_watch_fd, (char*)dir->name.str, LINUX_FILE_WATCH_MASK);
+            if (wd != -1){
+                // NOTE: another name for a directory we already watch shares its
+                // wd, events would come back under the other name so poll this one.
+                if (table_read(&linuxvars.file_watch_wd_table, (u64)wd, &val)){
+                    log_os("inotify: %s aliases a watched directory\n", (char*)dir->name.str);
+                }
+                else{
+                    dir->wd = wd;
+                    table_insert(&linuxvars.file_watch_wd_table, (u64)wd, (u64)PtrAsInt(dir));
+                }
+            }
+            else{
+                log_os("inotify_add_watch(%s) failed: %s\n", (char*)dir->name.str, strerror(errno));
+            }
+        }
+        
+        if (dir->wd != -1){
+            dir->ref_count += 1;
+            result = true;
+        }
+        else if (dir->ref_count == 0){
+            linux_file_watch_free_dir(dir);
+        }
+        
+        pthread_mutex_unlock(&linuxvars.file_watch_mutex);
+    }
+    return(result);
+}
+
+internal void
+system_file_watch_remove(String_Const_u8 file_name){
+    String_Const_u8 dir_name = linux_file_watch_dir_name(file_name);
+    if (linuxvars.file_watch_fd != -1 && dir_name.size > 0){
+        pthread_mutex_lock(&linuxvars.file_watch_mutex);
+        u64 val = 0;
+        if (table_read(&linuxvars.file_watch_dir_table, make_data(dir_name.str, dir_name.size), &val)){
+            Linux_File_Watch_Dir* dir = (Linux_File_Watch_Dir*)IntAsPtr(val);
+            dir->ref_count -= 1;
+            if (dir->ref_count <= 0){
+                if (dir->wd != -1){
+                    table_erase(&linuxvars.file_watch_wd_table, (u64)dir->wd);
+                    inotify_rm_watch(linuxvars.file_watch_fd, dir->wd);
+                }
+                linux_file_watch_free_dir(dir);
+            }
+        }
+        pthread_mutex_unlock(&linuxvars.file_watch_mutex);
+    }
+}
+
+internal File_Watch_Changes
+system_file_watch_wait(Arena* arena, u64 timeout_microseconds){
+    File_Watch_Changes result = {};
+    if (linuxvars.file_watch_fd == -1){
+        system_sleep(timeout_microseconds);
+    }
+    else{
+        struct epoll_event e = {};
+        int timeout = (int)(timeout_microseconds/Thousand(1));
+        if (epoll_wait(linuxvars.file_watch_epoll, &e, 1, timeout) > 0){
+            List_String_Const_u8 list = {};
+            pthread_mutex_lock(&linuxvars.file_watch_mutex);
+            for (;;){
+                u8 buffer[KB(4)] __attribute__((aligned(__alignof__(struct inotify_event))));
+                ssize_t size = read(linuxvars.file_watch_fd, buffer, sizeof(buffer));
+                if (size <= 0){
+                    break;
+                }
+                for (u8* ptr = buffer; ptr < buffer + size;){
+                    struct inotify_event* event = (struct inotify_event*)ptr;
+                    ptr += sizeof(struct inotify_event) + event->len;
+                    
+                    if (HasFlag(event->mask, IN_Q_OVERFLOW)){
+                        result.lost_changes = true;
+                        continue;
+                    }
+                    
+                    u64 val = 0;
+                    if (!table_read(&linuxvars.file_watch_wd_table, (u64)event->wd, &val)){
+                        continue;
+                    }
+                    Linux_File_Watch_Dir* dir = (Linux_File_Watch_Dir*)IntAsPtr(val);
+                    
+                    if (HasFlag(event->mask, IN_IGNORED) || HasFlag(event->mask, IN_MOVE_SELF)){
+                        // NOTE: the directory is gone or renamed, the watch no
+                        // longer says anything about the files under this name.
+                        table_erase(&linuxvars.file_watch_wd_table, (u64)dir->wd);
+                        if (HasFlag(event->mask, IN_MOVE_SELF)){
+                            inotify_rm_watch(linuxvars.file_watch_fd, dir->wd);
+                        }
+                        dir->wd = -1;
+                        result.lost_changes = true;
+                    }
+                    else if (event->len > 0){
+                        String_Const_u8 name = SCu8(event->name);
+                        String_Const_u8 full_name = push_u8_stringf(arena, "%.*s%s%.*s",
+                                                                    string_expand(dir->name),
+                                                                    (dir->name.size == 1)?"":"/",
+                                                                    string_expand(name));
+                        string_list_push(arena, &list, full_name);
+                    }
+                }
+            }
+            pthread_mutex_unlock(&linuxvars.file_watch_mutex);
+            
+            result.file_names = push_array(arena, String_Const_u8, list.node_count);
+            for (Node_String_Const_u8* node = list.first;
+                 node != 0;
+                 node = node->next){
+                result.file_names[result.count] = node->string;
+                result.count += 1;
+            }
+        }
+    }
+    return(result);
+}
+
 internal b32
 system_load_handle(Arena* scratch, char* file_name, Plat_Handle* out){
     LINUX_FN_DEBUG("%s", file_name);
@@ -215,14 +424,49 @@ system_load_attributes(Plat_Handle handle){
 }
 
 internal b32
-system_load_file(Plat_Handle handle, char* buffer, u32 size){
-    LINUX_FN_DEBUG("%.*s", size, buffer);
+system_load_file(Plat_Handle handle, char* buffer, u64 size){
+    LINUX_FN_DEBUG("%llu", size);
     int fd = *(int*)&handle;
-    int bytes_read = read(fd, buffer, size);
-    if (bytes_read == size) {
-        return true;
+    // NOTE: read stops at 2GB on Linux and can come back short.
+    for (;size > 0;){
+        ssize_t bytes_read = read(fd, buffer, size);
+        if (bytes_read == -1){
+            if (errno != EINTR){
+                break;
+            }
+        }
+        else if (bytes_read == 0){
+            break;
+        }
+        else{
+            buffer += bytes_read;
+            size -= bytes_read;
+        }
+    }
+    return(size == 0);
+}
+
+internal String_Const_u8
+system_load_map(Plat_Handle handle, u64 size){
+    LINUX_FN_DEBUG("%llu", size);
+    String_Const_u8 result = {};
+    if (size > 0){
+        int fd = *(int*)&handle;
+        void *memory = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED){
+            madvise(memory, size, MADV_SEQUENTIAL);
+            result = SCu8((u8*)memory, size);
+        }
+    }
+    return(result);
+}
+
+internal void
+system_load_unmap(String_Const_u8 data){
+    LINUX_FN_DEBUG("%llu", data.size);
+    if (data.str != 0){
+        munmap(data.str, data.size);
     }
-    return false;
 }
 
 internal b32
@@ -232,30 +476,284 @@ system_load_close(Plat_Handle handle){
     return close(fd) == 0;
 }
 
+internal b32
+linux_write_chunks(int fd, List_String_Const_u8 data){
+    // NOTE: writev takes a bounded number of pieces per call and can write less
+    // than it was given, so this walks the list from wherever the last call stopped.
+    b32 result = true;
+    Node_String_Const_u8 *node = data.first;
+    u64 node_pos = 0;
+    for (;node != 0;){
+        struct iovec vecs[64];
+        i32 count = 0;
+        u64 pos = node_pos;
+        for (Node_String_Const_u8 *it = node;
+             it != 0 && count < ArrayCount(vecs);
+             it = it->next, pos = 0){
+            if (pos < it->string.size){
+                vecs[count].iov_base = it->string.str + pos;
+                vecs[count].iov_len = it->string.size - pos;
+                count += 1;
+            }
+        }
+        if (count == 0){
+            break;
+        }
+        
+        ssize_t written = writev(fd, vecs, count);
+        if (written == -1 && errno == EINTR){
+            continue;
+        }
+        if (written <= 0){
+            result = false;
+            break;
+        }
+        
+        u64 advance = (u64)written;
+        for (;node != 0;){
+            u64 left = node->string.size - node_pos;
+            if (advance < left){
+                node_pos += advance;
+                break;
+            }
+            advance -= left;
+            node = node->next;
+            node_pos = 0;
+        }
+    }
+    return(result);
+}
+
 internal File_Attributes
-system_save_file(Arena* scratch, char* file_name, String_Const_u8 data){
-    LINUX_FN_DEBUG("%s", file_name);
+linux_save_file_in_place(char* file_name, List_String_Const_u8 data){
     File_Attributes result = {};
-    
-    // TODO(inso): should probably put a \n on the end if it's a text file.
-    
     int fd = open(file_name, O_TRUNC|O_WRONLY|O_CREAT, 0666);
-    if (fd != -1) {
-        int bytes_written = write(fd, data.str, data.size);
-        if (bytes_written == -1) {
-            perror("write");
-        } else if (bytes_written == data.size) {
+    if (fd != -1){
+        if (linux_write_chunks(fd, data)){
             struct stat file_stat;
             if (fstat(fd, &file_stat) == 0){
                 result = linux_file_attributes_from_struct_stat(&file_stat);
             }
         }
+        else{
+            perror("write");
+        }
         close(fd);
-    } else {
+    }
+    else{
         perror("open");
     }
+    return(result);
+}
+
+// NOTE: The temporary file is only ever created, never opened if it exists or
+// through a symlink, so nothing already sitting at its name gets written or moved into
+// place.  A taken name moves on to the next one.
+#define LINUX_SAVE_TEMP_ATTEMPTS 16
+
+internal int
+linux_save_open_temp(Arena* scratch, char* target, mode_t mode, char** temp_name_out){
+    int result = -1;
+    for (i32 attempt = 0; attempt < LINUX_SAVE_TEMP_ATTEMPTS; attempt += 1){
+        char* temp_name = (char*)push_u8_stringf(scratch, "%s.4ed_save_%d_%d", target, (int)getpid(), attempt).str;
+        result = open(temp_name, O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW, mode);
+        if (result != -1){
+            *temp_name_out = temp_name;
+            break;
+        }
+        if (errno != EEXIST){
+            break;
+        }
+    }
+    return(result);
+}
+
+internal void
+linux_sync_parent_directory(Arena* scratch, char* target){
+    String_Const_u8 directory = string_remove_last_folder(SCu8(target));
+    char* directory_name = ".";
+    if (directory.size > 0){
+        directory_name = (char*)push_string_copy(scratch, directory).str;
+    }
+    int fd = open(directory_name, O_RDONLY|O_DIRECTORY);
+    if (fd != -1){
+        fsync(fd);
+        close(fd);
+    }
+}
+
+internal File_Attributes
+system_save_file(Arena* scratch, char* file_name, List_String_Const_u8 data){
+    LINUX_FN_DEBUG("%s", file_name);
+    File_Attributes result = {};
+    Temp_Memory temp = begin_temp(scratch);
     
-    return result;
+    // TODO(inso): should probably put a \n on the end if it's a text file.
+    
+    // NOTE: The new contents go to a temporary file next to the target that is
+    // renamed over it, so a crash in the middle of a save leaves the old file alone.
+    // Symlinks are followed so the link survives.  Files that a rename would change in
+    // other ways (hard links, other owners, a group we can't give the new file) and
+    // directories we can't create in are written in place.
+    char* target = file_name;
+    char* real_name = realpath(file_name, 0);
+    if (real_name != 0){
+        target = (char*)push_string_copy(scratch, SCu8(real_name)).str;
+        free(real_name);
+    }
+    
+    b32 in_place = false;
+    b32 keep_mode = false;
+    mode_t mode = 0666;
+    struct stat old_stat;
+    if (stat(target, &old_stat) == 0){
+        mode = (old_stat.st_mode & 07777);
+        keep_mode = true;
+        if (old_stat.st_nlink > 1 || old_stat.st_uid != geteuid()){
+            in_place = true;
+        }
+    }
+    
+    int fd = -1;
+    char* temp_name = 0;
+    if (!in_place){
+        // NOTE: Until it has the old file's group and mode only we can read it.
+        fd = linux_save_open_temp(scratch, target, keep_mode?0600:mode, &temp_name);
+        if (fd == -1){
+            in_place = true;
+        }
+        else if (keep_mode){
+            struct stat temp_stat;
+            if (fstat(fd, &temp_stat) != 0 ||
+                (temp_stat.st_gid != old_stat.st_gid && fchown(fd, (uid_t)-1, old_stat.st_gid) != 0) ||
+                fchmod(fd, mode) != 0){
+                close(fd);
+                unlink(temp_name);
+                in_place = true;
+            }
+        }
+    }
+    
+    if (in_place){
+        result = linux_save_file_in_place(target, data);
+    }
+    else{
+        b32 success = linux_write_chunks(fd, data);
+        if (success){
+            if (fsync(fd) != 0){
+                success = false;
+            }
+        }
+        struct stat file_stat;
+        if (success && fstat(fd, &file_stat) != 0){
+            success = false;
+        }
+        close(fd);
+        
+        if (success && rename(temp_name, target) == 0){
+            // NOTE: The rename itself only lasts once the directory is on disk.
+            linux_sync_parent_directory(scratch, target);
+            result = linux_file_attributes_from_struct_stat(&file_stat);
+        }
+        else{
+            perror("save");
+            unlink(temp_name);
+        }
+    }
+    
+    end_temp(temp);
+    return(result);
+}
+
+internal b32
+system_delete_file(Arena* scratch, char* file_name){
+    LINUX_FN_DEBUG("%s", file_name);
+    return(unlink(file_name) == 0);
+}
+
+// NOTE: A scratch file has no name anyone else can open.  It is made with
+// O_TMPFILE where the file system supports it, otherwise it is created 0600 with
+// O_EXCL|O_NOFOLLOW under a fresh name and unlinked right away.  Either way it goes
+// away when it is closed or the process exits, however that happens.
+#define LINUX_SCRATCH_FILE_ATTEMPTS 16
+
+internal b32
+system_scratch_file_open(Arena* scratch, Plat_Handle* out){
+    LINUX_FN_DEBUG();
+    Temp_Memory temp = begin_temp(scratch);
+    String_Const_u8 temp_dir = system_get_path(scratch, SystemPath_TempDirectory);
+    int fd = -1;
+#if defined(O_TMPFILE)
+    fd = open((char*)temp_dir.str, O_TMPFILE|O_RDWR|O_EXCL, 0600);
+#endif
+    for (i32 attempt = 0; fd == -1 && attempt < LINUX_SCRATCH_FILE_ATTEMPTS; attempt += 1){
+        local_persist i32 scratch_file_counter = 0;
+        scratch_file_counter += 1;
+        char* file_name = (char*)push_u8_stringf(scratch, "%.*s4coder_scratch_%d_%d",
+                                                 string_expand(temp_dir), (int)getpid(),
+                                                 scratch_file_counter).str;
+        fd = open(file_name, O_RDWR|O_CREAT|O_EXCL|O_NOFOLLOW, 0600);
+        if (fd != -1){
+            unlink(file_name);
+        }
+        else if (errno != EEXIST){
+            break;
+        }
+    }
+    end_temp(temp);
+    if (fd != -1){
+        *(int*)out = fd;
+    }
+    return(fd != -1);
+}
+
+internal b32
+system_scratch_file_write(Plat_Handle handle, u64 pos, String_Const_u8 data){
+    LINUX_FN_DEBUG("%llu / %llu", (unsigned long long)pos, (unsigned long long)data.size);
+    int fd = *(int*)&handle;
+    b32 result = true;
+    for (u64 written = 0; written < data.size;){
+        ssize_t n = pwrite(fd, data.str + written, data.size - written, (off_t)(pos + written));
+        if (n > 0){
+            written += (u64)n;
+        }
+        else if (n == -1 && errno == EINTR){
+            continue;
+        }
+        else{
+            result = false;
+            break;
+        }
+    }
+    return(result);
+}
+
+internal b32
+system_scratch_file_read(Plat_Handle handle, u64 pos, u8* buffer, u64 size){
+    LINUX_FN_DEBUG("%llu / %llu", (unsigned long long)pos, (unsigned long long)size);
+    int fd = *(int*)&handle;
+    b32 result = true;
+    for (u64 read_size = 0; read_size < size;){
+        ssize_t n = pread(fd, buffer + read_size, size - read_size, (off_t)(pos + read_size));
+        if (n > 0){
+            read_size += (u64)n;
+        }
+        else if (n == -1 && errno == EINTR){
+            continue;
+        }
+        else{
+            result = false;
+            break;
+        }
+    }
+    return(result);
+}
+
+internal void
+system_scratch_file_close(Plat_Handle handle){
+    LINUX_FN_DEBUG();
+    int fd = *(int*)&handle;
+    close(fd);
 }
 
 internal b32
@@ -69,6 +69,7 @@
 #include <sys/mman.h> // NOTE(yuval): Used for mmap, munmap, mprotect
 #include <sys/stat.h> // NOTE(yuval): Used for stat
 #include <sys/types.h> // NOTE(yuval): Used for struct stat, pid_t
+#include <sys/uio.h> // NOTE: Used for writev
 #include <sys/syslimits.h> // NOTE(yuval): Used for PATH_MAX
 
 #include <stdlib.h> // NOTE(yuval): Used for free
@@ -363,6 +364,8 @@ glue(_i_, __LINE__) = 1, mac_profile(name, glue(_begin_, __LINE__), system_now_t
 
 #import "mac_4ed_renderer.mm"
 
+#include "4ed_font_cache.h"
+#include "4ed_font_cache.cpp"
 #include "4ed_font_provider_freetype.h"
 #include "4ed_font_provider_freetype.cpp"
 
@@ -53,6 +53,15 @@ system_get_path_sig(){
                 result = push_u8_stringf(arena, "%s/.4coder/", home_cstr);
             }
         }break;
+
+        case SystemPath_TempDirectory:
+        {
+            NSString *temp_dir = NSTemporaryDirectory();
+            result = push_u8_stringf(arena, "%s", [temp_dir UTF8String]);
+            if (string_get_character(result, result.size - 1) != '/'){
+                result = push_u8_stringf(arena, "%.*s/", string_expand(result));
+            }
+        }break;
     }
 
     return(result);
@@ -208,6 +217,23 @@ system_quick_file_attributes_sig(){
     return(result);
 }
 
+function
+system_file_watch_add_sig(){
+    // NOTE: No directory watches on this platform, the working set polls every file.
+    return(false);
+}
+
+function
+system_file_watch_remove_sig(){
+}
+
+function
+system_file_watch_wait_sig(){
+    File_Watch_Changes result = {};
+    system_sleep(timeout_microseconds);
+    return(result);
+}
+
 function inline Plat_Handle
 mac_to_plat_handle(i32 fd){
     Plat_Handle result = *(Plat_Handle*)(&fd);
@@ -252,6 +278,8 @@ system_load_file_sig(){
                 // NOTE(yuval): An error occured while reading from the file descriptor
                 break;
             }
+        } else if (bytes_read == 0){
+            break;
         } else{
             size -= bytes_read;
             buffer += bytes_read;
@@ -262,6 +290,28 @@ system_load_file_sig(){
     return(result);
 }
 
+function
+system_load_map_sig(){
+    String_Const_u8 result = {};
+    if (size > 0){
+        i32 fd = mac_to_fd(handle);
+        void *memory = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED){
+            madvise(memory, size, MADV_SEQUENTIAL);
+            result = SCu8((u8*)memory, size);
+        }
+    }
+
+    return(result);
+}
+
+function
+system_load_unmap_sig(){
+    if (data.str != 0){
+        munmap(data.str, data.size);
+    }
+}
+
 function
 system_load_close_sig(){
     b32 result = true;
@@ -275,35 +325,249 @@ system_load_close_sig(){
     return(result);
 }
 
+function b32
+mac_write_chunks(i32 fd, List_String_Const_u8 data){
+    b32 result = true;
+    Node_String_Const_u8 *node = data.first;
+    u64 node_pos = 0;
+    while (node != 0){
+        struct iovec vecs[64];
+        i32 count = 0;
+        u64 pos = node_pos;
+        for (Node_String_Const_u8 *it = node;
+             it != 0 && count < ArrayCount(vecs);
+             it = it->next, pos = 0){
+            if (pos < it->string.size){
+                vecs[count].iov_base = it->string.str + pos;
+                vecs[count].iov_len = it->string.size - pos;
+                count += 1;
+            }
+        }
+        if (count == 0){
+            break;
+        }
+
+        ssize_t bytes_written = writev(fd, vecs, count);
+        if (bytes_written == -1 && errno == EINTR){
+            continue;
+        }
+        if (bytes_written <= 0){
+            result = false;
+            break;
+        }
+
+        u64 advance = (u64)bytes_written;
+        while (node != 0){
+            u64 left = node->string.size - node_pos;
+            if (advance < left){
+                node_pos += advance;
+                break;
+            }
+            advance -= left;
+            node = node->next;
+            node_pos = 0;
+        }
+    }
+
+    return(result);
+}
+
+// NOTE: As on Linux the temporary file is only ever created, never opened
+// through a symlink or an existing file, and a taken name moves on to the next one.
+#define MAC_SAVE_TEMP_ATTEMPTS 16
+
+function i32
+mac_save_open_temp(Arena *scratch, char *target, mode_t mode, char **temp_name_out){
+    i32 result = -1;
+    for (i32 attempt = 0; attempt < MAC_SAVE_TEMP_ATTEMPTS; attempt += 1){
+        char *temp_name = (char*)push_u8_stringf(scratch, "%s.4ed_save_%d_%d", target, (i32)getpid(), attempt).str;
+        result = open(temp_name, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, mode);
+        if (result != -1){
+            *temp_name_out = temp_name;
+            break;
+        }
+        if (errno != EEXIST){
+            break;
+        }
+    }
+    return(result);
+}
+
+function void
+mac_sync_parent_directory(Arena *scratch, char *target){
+    String_Const_u8 directory = string_remove_last_folder(SCu8(target));
+    char *directory_name = ".";
+    if (directory.size > 0){
+        directory_name = (char*)push_string_copy(scratch, directory).str;
+    }
+    i32 fd = open(directory_name, O_RDONLY);
+    if (fd != -1){
+        fsync(fd);
+        close(fd);
+    }
+}
+
 function
 system_save_file_sig(){
     File_Attributes result = {};
+    Temp_Memory temp = begin_temp(scratch);
 
-    i32 fd = open(file_name, O_WRONLY | O_TRUNC | O_CREAT, 00640);
-    if (fd != -1) {
-        do{
-            ssize_t bytes_written = write(fd, data.str, data.size);
-            if (bytes_written == -1){
-                if (errno != EINTR){
-                    // NOTE(yuval): An error occured while writing to the file descriptor
-                    break;
-                }
-            } else{
-                data.size -= bytes_written;
-                data.str += bytes_written;
-            }
-        } while (data.size > 0);
+    // NOTE: Same scheme as the Linux layer, write a temporary file next to the
+    // target and rename it into place, unless a rename would change the file's links,
+    // owner, or group or the directory won't take a new file.
+    char *target = file_name;
+    char *real_name = realpath(file_name, 0);
+    if (real_name != 0){
+        target = (char*)push_string_copy(scratch, SCu8(real_name)).str;
+        free(real_name);
+    }
 
-        if (data.size == 0) {
-            result = mac_file_attributes_from_fd(fd);
+    b32 in_place = false;
+    b32 keep_mode = false;
+    mode_t mode = 00640;
+    struct stat old_stat;
+    if (stat(target, &old_stat) == 0){
+        mode = (old_stat.st_mode & 07777);
+        keep_mode = true;
+        if (old_stat.st_nlink > 1 || old_stat.st_uid != geteuid()){
+            in_place = true;
         }
+    }
+
+    i32 fd = -1;
+    char *temp_name = 0;
+    if (!in_place){
+        fd = mac_save_open_temp(scratch, target, keep_mode?0600:mode, &temp_name);
+        if (fd == -1){
+            in_place = true;
+        }
+        else if (keep_mode){
+            struct stat temp_stat;
+            if (fstat(fd, &temp_stat) != 0 ||
+                (temp_stat.st_gid != old_stat.st_gid && fchown(fd, (uid_t)-1, old_stat.st_gid) != 0) ||
+                fchmod(fd, mode) != 0){
+                close(fd);
+                unlink(temp_name);
+                in_place = true;
+            }
+        }
+    }
 
+    if (in_place){
+        fd = open(target, O_WRONLY | O_TRUNC | O_CREAT, 00640);
+        if (fd != -1){
+            if (mac_write_chunks(fd, data)){
+                result = mac_file_attributes_from_fd(fd);
+            }
+            close(fd);
+        }
+    } else{
+        b32 success = mac_write_chunks(fd, data);
+        if (success){
+            if (fsync(fd) != 0){
+                success = false;
+            }
+        }
+        File_Attributes attributes = {};
+        if (success){
+            attributes = mac_file_attributes_from_fd(fd);
+        }
         close(fd);
+
+        if (success && rename(temp_name, target) == 0){
+            mac_sync_parent_directory(scratch, target);
+            result = attributes;
+        } else{
+            unlink(temp_name);
+        }
+    }
+
+    end_temp(temp);
+    return(result);
+}
+
+function
+system_delete_file_sig(){
+    b32 result = (unlink(file_name) == 0);
+    return(result);
+}
+
+// NOTE: Same as the Linux layer without O_TMPFILE, the scratch file is created
+// 0600 with O_EXCL | O_NOFOLLOW under a fresh name and unlinked right away, so it goes
+// away when it is closed or the process exits.
+#define MAC_SCRATCH_FILE_ATTEMPTS 16
+
+function
+system_scratch_file_open_sig(){
+    Temp_Memory temp = begin_temp(scratch);
+    String_Const_u8 temp_dir = system_get_path(scratch, SystemPath_TempDirectory);
+    i32 fd = -1;
+    for (i32 attempt = 0; fd == -1 && attempt < MAC_SCRATCH_FILE_ATTEMPTS; attempt += 1){
+        local_persist i32 scratch_file_counter = 0;
+        scratch_file_counter += 1;
+        char *file_name = (char*)push_u8_stringf(scratch, "%.*s4coder_scratch_%d_%d",
+                                                 string_expand(temp_dir), (i32)getpid(),
+                                                 scratch_file_counter).str;
+        fd = open(file_name, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+        if (fd != -1){
+            unlink(file_name);
+        }
+        else if (errno != EEXIST){
+            break;
+        }
+    }
+    end_temp(temp);
+    if (fd != -1){
+        *out = mac_to_plat_handle(fd);
+    }
+    return(fd != -1);
+}
+
+function
+system_scratch_file_write_sig(){
+    i32 fd = mac_to_fd(handle);
+    b32 result = true;
+    for (u64 written = 0; written < data.size;){
+        ssize_t n = pwrite(fd, data.str + written, data.size - written, (off_t)(pos + written));
+        if (n > 0){
+            written += (u64)n;
+        }
+        else if (n == -1 && errno == EINTR){
+            continue;
+        }
+        else{
+            result = false;
+            break;
+        }
     }
+    return(result);
+}
 
+function
+system_scratch_file_read_sig(){
+    i32 fd = mac_to_fd(handle);
+    b32 result = true;
+    for (u64 read_size = 0; read_size < size;){
+        ssize_t n = pread(fd, buffer + read_size, size - read_size, (off_t)(pos + read_size));
+        if (n > 0){
+            read_size += (u64)n;
+        }
+        else if (n == -1 && errno == EINTR){
+            continue;
+        }
+        else{
+            result = false;
+            break;
+        }
+    }
     return(result);
 }
 
+function
+system_scratch_file_close_sig(){
+    close(mac_to_fd(handle));
+}
+
 ////////////////////////////////
 
 function inline System_Library
@@ -984,9 +1248,26 @@ graphics_fill_texture_sig(){
 
 ////////////////////////////////
 
+// NOTE: Creates ~/.4coder/font_cache/ if it doesn't exist yet.
+function String_Const_u8
+mac_font_cache_directory(Arena *arena){
+    String_Const_u8 result = {};
+    String_Const_u8 user_dir = system_get_path(arena, SystemPath_UserDirectory);
+    if (user_dir.size > 0){
+        String_Const_u8 cache_dir = push_u8_stringf(arena, "%.*sfont_cache/", string_expand(user_dir));
+        b32 has_user_dir = (mkdir((char*)user_dir.str, 0755) == 0 || errno == EEXIST);
+        if (has_user_dir && (mkdir((char*)cache_dir.str, 0755) == 0 || errno == EEXIST)){
+            result = cache_dir;
+        }
+    }
+
+    return(result);
+}
+
 function
 font_make_face_sig(){
-    Face* result = ft__font_make_face(arena, description, scale_factor);
+    String_Const_u8 cache_dir = mac_font_cache_directory(arena);
+    Face* result = ft__font_make_face(arena, description, scale_factor, cache_dir);
     return(result);
 }
 
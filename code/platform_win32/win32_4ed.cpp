@@ -651,6 +651,8 @@ os_popup_error(char *title, char *message){
     ExitProcess(1);
 }
 
+#include "4ed_font_cache.h"
+#include "4ed_font_cache.cpp"
 #include "4ed_font_provider_freetype.h"
 #include "4ed_font_provider_freetype.cpp"
 
@@ -670,9 +672,29 @@ graphics_fill_texture_sig(){
     return(gl__fill_texture(texture_kind, texture, p, dim, data));
 }
 
+internal String_Const_u8
+win32_font_cache_directory(Arena *arena){
+    String_Const_u8 result = {};
+    String_Const_u8 user_dir = system_get_path(arena, SystemPath_UserDirectory);
+    if (user_dir.size > 0){
+        if (!character_is_slash(string_get_character(user_dir, user_dir.size - 1))){
+            user_dir = push_u8_stringf(arena, "%.*s\\", string_expand(user_dir));
+        }
+        String_Const_u8 cache_dir = push_u8_stringf(arena, "%.*sfont_cache\\", string_expand(user_dir));
+        b32 has_user_dir = (CreateDirectory_utf8(arena, user_dir.str, 0) ||
+                            GetLastError() == ERROR_ALREADY_EXISTS);
+        if (has_user_dir && (CreateDirectory_utf8(arena, cache_dir.str, 0) ||
+                             GetLastError() == ERROR_ALREADY_EXISTS)){
+            result = cache_dir;
+        }
+    }
+    return(result);
+}
+
 internal
 font_make_face_sig(){
-    return(ft__font_make_face(arena, description, scale_factor));
+    String_Const_u8 cache_dir = win32_font_cache_directory(arena);
+    return(ft__font_make_face(arena, description, scale_factor, cache_dir));
 }
 
 //
@@ -2050,6 +2072,17 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdS
         ReleaseDC(win32vars.window_handle, hdc);
 #endif
         
+        // NOTE: Report the cost of frame submission
+        if (target.submit_frame_count >= 120){
+            i32 frame_count = target.submit_frame_count;
+            log_os("render submit: %.3fms cpu/frame, %lluKB/frame over %d frames\n",
+                   (f64)target.submit_time/(1000.0*frame_count),
+                   (unsigned long long)(target.submit_bytes/(KB(1)*frame_count)), frame_count);
+            target.submit_time = 0;
+            target.submit_bytes = 0;
+            target.submit_frame_count = 0;
+        }
+        
         // NOTE(allen): toggle full screen
         if (win32vars.do_toggle){
             win32_toggle_fullscreen();
@@ -171,6 +171,16 @@ system_get_path_sig(){
                 result = w32_override_user_directory;
             }
         }break;
+        
+        case SystemPath_TempDirectory:
+        {
+            DWORD size = GetTempPathW(0, 0);
+            u16 *buffer_u16 = push_array(arena, u16, size);
+            size = GetTempPathW(size, (WCHAR*)buffer_u16);
+            if (size > 0){
+                result = string_u8_from_string_u16(arena, SCu16(buffer_u16, size), StringFill_NullTerminate).string;
+            }
+        }break;
     }
     return(result);
 }
@@ -353,6 +363,23 @@ system_quick_file_attributes_sig(){
     return(result);
 }
 
+internal
+system_file_watch_add_sig(){
+    // NOTE: No directory watches on this platform, the working set polls every file.
+    return(false);
+}
+
+internal
+system_file_watch_remove_sig(){
+}
+
+internal
+system_file_watch_wait_sig(){
+    File_Watch_Changes result = {};
+    system_sleep(timeout_microseconds);
+    return(result);
+}
+
 internal
 system_load_handle_sig(){
     b32 result = false;
@@ -373,16 +400,45 @@ system_load_attributes_sig(){
 internal
 system_load_file_sig(){
     HANDLE file = *(HANDLE*)(&handle);
-    DWORD read_size = 0;
-    b32 result = false;
-    if (ReadFile(file, buffer, size, &read_size, 0)){
-        if (read_size == size){
-            result = true;
+    // NOTE: ReadFile takes a DWORD size, big files are read in pieces.
+    for (;size > 0;){
+        DWORD chunk_size = (DWORD)clamp_top(size, (u64)GB(1));
+        DWORD read_size = 0;
+        if (!ReadFile(file, buffer, chunk_size, &read_size, 0) || read_size == 0){
+            break;
+        }
+        buffer += read_size;
+        size -= read_size;
+    }
+    b32 result = (size == 0);
+    return(result);
+}
+
+internal
+system_load_map_sig(){
+    String_Const_u8 result = {};
+    if (size > 0){
+        HANDLE file = *(HANDLE*)(&handle);
+        HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping != 0){
+            void *memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+            if (memory != 0){
+                result = SCu8((u8*)memory, size);
+            }
+            // NOTE: The view keeps the mapping alive.
+            CloseHandle(mapping);
         }
     }
     return(result);
 }
 
+internal
+system_load_unmap_sig(){
+    if (data.str != 0){
+        UnmapViewOfFile(data.str);
+    }
+}
+
 internal
 system_load_close_sig(){
     b32 result = false;
@@ -393,39 +449,157 @@ system_load_close_sig(){
     return(result);
 }
 
+internal b32
+win32_write_chunks(HANDLE file, List_String_Const_u8 data){
+    b32 result = true;
+    for (Node_String_Const_u8 *node = data.first;
+         node != 0 && result;
+         node = node->next){
+        u8 *ptr = node->string.str;
+        u64 size = node->string.size;
+        for (;size > 0;){
+            DWORD write_size = (DWORD)clamp_top(size, (u64)GB(1));
+            DWORD written = 0;
+            if (!WriteFile(file, ptr, write_size, &written, 0) || written == 0){
+                result = false;
+                break;
+            }
+            ptr += written;
+            size -= written;
+        }
+    }
+    return(result);
+}
+
 internal
 system_save_file_sig(){
     File_Attributes result = {};
+    Temp_Memory temp = begin_temp(scratch);
     
-    HANDLE file = CreateFile_utf8(scratch, (u8*)file_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    // NOTE: Write a temporary file next to the target and move it over the target,
+    // so a crash in the middle of a save leaves the old file alone.  If the temporary
+    // can't be made the file is written in place.
+    u8 *temp_name = push_u8_stringf(scratch, "%s.4ed_save_%u", file_name, (u32)GetCurrentProcessId()).str;
+    HANDLE file = CreateFile_utf8(scratch, temp_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
     
     if (file != INVALID_HANDLE_VALUE){
-        u64 written_total = 0;
-        
-        b32 success = true;
-        for (;written_total < data.size;){
-            DWORD read_size = max_u32;
-            DWORD write_size = 0;
-            if ((data.size - written_total) < max_u32){
-                read_size = (DWORD)data.size;
-            }
-            if (!WriteFile(file, data.str + written_total, read_size, &write_size, 0)){
-                success = false;
-                break;
-            }
-            written_total += write_size;
+        b32 success = win32_write_chunks(file, data);
+        if (success){
+            success = FlushFileBuffers(file);
         }
+        CloseHandle(file);
         
         if (success){
-            result = win32_file_attributes_from_HANDLE(file);
+            success = MoveFileEx_utf8(scratch, temp_name, (u8*)file_name, MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH);
+        }
+        if (success){
+            file = CreateFile_utf8(scratch, (u8*)file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+            if (file != INVALID_HANDLE_VALUE){
+                result = win32_file_attributes_from_HANDLE(file);
+                CloseHandle(file);
+            }
+        }
+        else{
+            DeleteFile_utf8(scratch, temp_name);
+        }
+    }
+    else{
+        file = CreateFile_utf8(scratch, (u8*)file_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+        if (file != INVALID_HANDLE_VALUE){
+            if (win32_write_chunks(file, data)){
+                result = win32_file_attributes_from_HANDLE(file);
+            }
+            CloseHandle(file);
         }
-        
-        CloseHandle(file);
     }
     
+    end_temp(temp);
+    return(result);
+}
+
+internal
+system_delete_file_sig(){
+    b32 result = false;
+    if (DeleteFile_utf8(scratch, (u8*)file_name)){
+        result = true;
+    }
+    return(result);
+}
+
+// NOTE: The scratch file is opened with no sharing and deleted on close, so no
+// one else can open it and it goes away when the handle is closed or the process exits.
+#define WIN32_SCRATCH_FILE_ATTEMPTS 16
+
+internal
+system_scratch_file_open_sig(){
+    Temp_Memory temp = begin_temp(scratch);
+    String_Const_u8 temp_dir = system_get_path(scratch, SystemPath_TempDirectory);
+    HANDLE file = INVALID_HANDLE_VALUE;
+    for (i32 attempt = 0; file == INVALID_HANDLE_VALUE && attempt < WIN32_SCRATCH_FILE_ATTEMPTS; attempt += 1){
+        local_persist i32 scratch_file_counter = 0;
+        scratch_file_counter += 1;
+        u8 *file_name = push_u8_stringf(scratch, "%.*s4coder_scratch_%u_%d",
+                                        string_expand(temp_dir), (u32)GetCurrentProcessId(),
+                                        scratch_file_counter).str;
+        file = CreateFile_utf8(scratch, file_name, GENERIC_READ|GENERIC_WRITE, 0, 0, CREATE_NEW,
+                               FILE_ATTRIBUTE_TEMPORARY|FILE_FLAG_DELETE_ON_CLOSE, 0);
+        if (file == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS){
+            break;
+        }
+    }
+    end_temp(temp);
+    if (file != INVALID_HANDLE_VALUE){
+        *(HANDLE*)out = file;
+    }
+    return(file != INVALID_HANDLE_VALUE);
+}
+
+internal
+system_scratch_file_write_sig(){
+    HANDLE file = *(HANDLE*)(&handle);
+    b32 result = true;
+    for (u64 written = 0; written < data.size;){
+        u64 offset = pos + written;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(offset & max_u32);
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD chunk_size = (DWORD)Min(data.size - written, max_u32);
+        DWORD chunk_written = 0;
+        if (!WriteFile(file, data.str + written, chunk_size, &chunk_written, &overlapped) || chunk_written == 0){
+            result = false;
+            break;
+        }
+        written += chunk_written;
+    }
     return(result);
 }
 
+internal
+system_scratch_file_read_sig(){
+    HANDLE file = *(HANDLE*)(&handle);
+    b32 result = true;
+    for (u64 read_size = 0; read_size < size;){
+        u64 offset = pos + read_size;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(offset & max_u32);
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD chunk_size = (DWORD)Min(size - read_size, max_u32);
+        DWORD chunk_read = 0;
+        if (!ReadFile(file, buffer + read_size, chunk_size, &chunk_read, &overlapped) || chunk_read == 0){
+            result = false;
+            break;
+        }
+        read_size += chunk_read;
+    }
+    return(result);
+}
+
+internal
+system_scratch_file_close_sig(){
+    HANDLE file = *(HANDLE*)(&handle);
+    CloseHandle(file);
+}
+
 ////////////////////////////////
 
 internal ARGB_Color
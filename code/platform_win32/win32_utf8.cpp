@@ -165,6 +165,34 @@ LoadLibrary_utf8String(Arena *scratch, String_Const_u8 name){
     return(result);
 }
 
+function BOOL
+MoveFileEx_utf8(Arena *scratch, u8 *name, u8 *new_name, DWORD flags){
+    Temp_Memory temp = begin_temp(scratch);
+    String_u16 name_16 = string_u16_from_string_u8(scratch, SCu8(name), StringFill_NullTerminate);
+    String_u16 new_name_16 = string_u16_from_string_u8(scratch, SCu8(new_name), StringFill_NullTerminate);
+    BOOL result = MoveFileExW((LPWSTR)name_16.str, (LPWSTR)new_name_16.str, flags);
+    end_temp(temp);
+    return(result);
+}
+
+function BOOL
+DeleteFile_utf8(Arena *scratch, u8 *name){
+    Temp_Memory temp = begin_temp(scratch);
+    String_u16 name_16 = string_u16_from_string_u8(scratch, SCu8(name), StringFill_NullTerminate);
+    BOOL result = DeleteFileW((LPWSTR)name_16.str);
+    end_temp(temp);
+    return(result);
+}
+
+function BOOL
+CreateDirectory_utf8(Arena *scratch, u8 *name, LPSECURITY_ATTRIBUTES security){
+    Temp_Memory temp = begin_temp(scratch);
+    String_u16 name_16 = string_u16_from_string_u8(scratch, SCu8(name), StringFill_NullTerminate);
+    BOOL result = CreateDirectoryW((LPWSTR)name_16.str, security);
+    end_temp(temp);
+    return(result);
+}
+
 #endif
 
 // BOTTOM
@@ -45,6 +45,15 @@ GetFileAttributesEx_utf8String(Arena *scratch, String_Const_u8 file_name, GET_FI
 function HMODULE
 LoadLibrary_utf8String(Arena *scratch, String_Const_u8 file_name);
 
+function BOOL
+MoveFileEx_utf8(Arena *scratch, u8 *name, u8 *new_name, DWORD flags);
+
+function BOOL
+DeleteFile_utf8(Arena *scratch, u8 *name);
+
+function BOOL
+CreateDirectory_utf8(Arena *scratch, u8 *name, LPSECURITY_ATTRIBUTES security);
+
 #endif
 
 // BOTTOM